@@ -0,0 +1,382 @@
+#include "Log.h"
+#include "Utl.h"
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+using namespace std;
+
+#include "BoschCompensation.h"
+
+
+// Host benchmark of the BMP280 / BME280 integer compensation against the
+// datasheets' double versions.
+//
+// The datasheet's worked example is checked exactly, then a sweep over the
+// operating range (-40 to 85 C, 300 to 1100 hPa, 0 to 100 %RH) is compared
+// with double, the error given in the output units.  Calibration and raw
+// reading parsing are checked by packing register images and parsing them
+// back.
+//
+// Note the host has an FPU, so double is far cheaper here than on the
+// RP2040, where each double operation is a software routine.  The integer
+// timings are the ones that carry over.
+
+
+using Cal = BoschCompensation::Calibration;
+
+static const uint32_t PASS_COUNT = 200;
+
+static bool pass_ = true;
+
+static uint64_t NowNs()
+{
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename Fn>
+static uint64_t Time(uint32_t itemsPerPass, Fn fn)
+{
+    uint64_t timeStartNs = NowNs();
+    for (uint32_t pass = 0; pass < PASS_COUNT; ++pass)
+    {
+        fn();
+    }
+    uint64_t durationNs = NowNs() - timeStartNs;
+
+    return durationNs * 1'000 / ((uint64_t)itemsPerPass * PASS_COUNT);
+}
+
+static void Check(const char *what, bool ok)
+{
+    pass_ &= ok;
+
+    Log("  ", what, ": ", ok ? "ok" : "FAIL");
+}
+
+static void Report(const char *title, uint32_t count, uint64_t psInt, uint64_t psDouble, double errMax, double errLimit, const char *unit)
+{
+    bool ok = errMax <= errLimit;
+    pass_ &= ok;
+
+    Log(title);
+    Log("  compared         : ", Commas(count));
+    Log("  int    ns / item : ", (double)psInt / 1000);
+    Log("  double ns / item : ", (double)psDouble / 1000);
+    Log("  error max        : ", errMax, " ", unit, " (limit ", errLimit, ")", ok ? "" : " FAIL");
+    LogNL();
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Datasheet double versions
+/////////////////////////////////////////////////////////////////
+
+static double TemperatureDouble(const Cal &cal, int32_t adcT, double &tFine)
+{
+    double var1 = ((double)adcT / 16384.0 - (double)cal.T1 / 1024.0) * (double)cal.T2;
+    double var2 = ((double)adcT / 131072.0 - (double)cal.T1 / 8192.0) *
+                  ((double)adcT / 131072.0 - (double)cal.T1 / 8192.0) * (double)cal.T3;
+
+    tFine = var1 + var2;
+
+    return (var1 + var2) / 5120.0;
+}
+
+static double PressureDouble(const Cal &cal, int32_t adcP, double tFine)
+{
+    double var1 = tFine / 2.0 - 64000.0;
+    double var2 = var1 * var1 * (double)cal.P6 / 32768.0;
+    var2 = var2 + var1 * (double)cal.P5 * 2.0;
+    var2 = var2 / 4.0 + (double)cal.P4 * 65536.0;
+    var1 = ((double)cal.P3 * var1 * var1 / 524288.0 + (double)cal.P2 * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * (double)cal.P1;
+
+    if (var1 == 0.0)
+    {
+        return 0;
+    }
+
+    double p = 1048576.0 - (double)adcP;
+    p = (p - var2 / 4096.0) * 6250.0 / var1;
+    var1 = (double)cal.P9 * p * p / 2147483648.0;
+    var2 = p * (double)cal.P8 / 32768.0;
+
+    return p + (var1 + var2 + (double)cal.P7) / 16.0;
+}
+
+static double HumidityDouble(const Cal &cal, int32_t adcH, double tFine)
+{
+    double h = tFine - 76800.0;
+    h = ((double)adcH - ((double)cal.H4 * 64.0 + (double)cal.H5 / 16384.0 * h)) *
+        ((double)cal.H2 / 65536.0 * (1.0 + (double)cal.H6 / 67108864.0 * h * (1.0 + (double)cal.H3 / 67108864.0 * h)));
+    h = h * (1.0 - (double)cal.H1 * h / 524288.0);
+
+    return max(0.0, min(100.0, h));
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Calibration
+/////////////////////////////////////////////////////////////////
+
+// BMP280 datasheet 3.12 example, humidity from a BME280
+static Cal MakeCal()
+{
+    Cal cal = {};
+
+    cal.T1 = 27504; cal.T2 = 26435;  cal.T3 = -1000;
+    cal.P1 = 36477; cal.P2 = -10685; cal.P3 = 3024;
+    cal.P4 = 2855;  cal.P5 = 140;    cal.P6 = -7;
+    cal.P7 = 15500; cal.P8 = -14600; cal.P9 = 6000;
+    cal.H1 = 75;    cal.H2 = 362;    cal.H3 = 0;
+    cal.H4 = 313;   cal.H5 = 50;     cal.H6 = 30;
+
+    return cal;
+}
+
+static void PutLE(uint8_t *buf, uint16_t val)
+{
+    buf[0] = (uint8_t)(val & 0xFF);
+    buf[1] = (uint8_t)(val >> 8);
+}
+
+static bool CalEqual(const Cal &a, const Cal &b)
+{
+    return a.T1 == b.T1 && a.T2 == b.T2 && a.T3 == b.T3 &&
+           a.P1 == b.P1 && a.P2 == b.P2 && a.P3 == b.P3 &&
+           a.P4 == b.P4 && a.P5 == b.P5 && a.P6 == b.P6 &&
+           a.P7 == b.P7 && a.P8 == b.P8 && a.P9 == b.P9 &&
+           a.H1 == b.H1 && a.H2 == b.H2 && a.H3 == b.H3 &&
+           a.H4 == b.H4 && a.H5 == b.H5 && a.H6 == b.H6;
+}
+
+// register images as the sensor lays them out, then parsed back
+static void BenchParse()
+{
+    Log("Parsing");
+
+    for (int16_t h4 : { 313, -313 })
+    {
+        Cal cal = MakeCal();
+        cal.H4 = h4;
+        cal.H5 = (int16_t)-h4;
+
+        uint8_t tp[BoschCompensation::CALIB_TP_LEN] = {};
+        const uint16_t tpList[] = {
+            cal.T1, (uint16_t)cal.T2, (uint16_t)cal.T3,
+            cal.P1, (uint16_t)cal.P2, (uint16_t)cal.P3, (uint16_t)cal.P4, (uint16_t)cal.P5,
+            (uint16_t)cal.P6, (uint16_t)cal.P7, (uint16_t)cal.P8, (uint16_t)cal.P9,
+        };
+        for (uint8_t i = 0; i < 12; ++i)
+        {
+            PutLE(&tp[i * 2], tpList[i]);
+        }
+        tp[25] = cal.H1;
+
+        uint8_t h[BoschCompensation::CALIB_H_LEN] = {};
+        PutLE(&h[0], (uint16_t)cal.H2);
+        h[2] = cal.H3;
+        h[3] = (uint8_t)((uint16_t)cal.H4 >> 4);
+        h[4] = (uint8_t)((cal.H4 & 0x0F) | ((cal.H5 & 0x0F) << 4));
+        h[5] = (uint8_t)((uint16_t)cal.H5 >> 4);
+        h[6] = (uint8_t)cal.H6;
+
+        Cal parsed = {};
+        BoschCompensation::ParseCalibrationTP(tp, parsed);
+        BoschCompensation::ParseCalibrationH(h, parsed);
+
+        Check(h4 < 0 ? "calibration, negative H4/H5" : "calibration", CalEqual(cal, parsed));
+    }
+
+    const uint8_t data[] = { 0x65, 0x5A, 0xC0, 0x7E, 0xED, 0x00, 0x6E, 0x8D };
+    BoschCompensation::Raw raw = BoschCompensation::ParseRaw(data, BoschCompensation::DATA_LEN_BME280);
+    Check("raw reading", raw.adcP == 415148 && raw.adcT == 519888 && raw.adcH == 0x6E8D);
+
+    raw = BoschCompensation::ParseRaw(data, BoschCompensation::DATA_LEN_BMP280);
+    Check("raw reading, no humidity", raw.adcH == 0);
+
+    LogNL();
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Compensation
+/////////////////////////////////////////////////////////////////
+
+static void BenchExample(const Cal &cal)
+{
+    Log("Datasheet example");
+
+    int32_t  tFine = 0;
+    int32_t  t     = BoschCompensation::Temperature(cal, 519888, tFine);
+    uint32_t p     = BoschCompensation::Pressure(cal, 415148, tFine);
+
+    Log("  temperature      : ", t / 100.0, " C (tFine ", tFine, ")");
+    Log("  pressure         : ", p / 256.0, " Pa");
+
+    Check("temperature 25.08 C", t == 2508 && tFine == 128422);
+    Check("pressure 100653.27 Pa", fabs(p / 256.0 - 100653.27) < 0.5);
+
+    LogNL();
+}
+
+static void BenchTemperature(const Cal &cal)
+{
+    vector<int32_t> adcList;
+    double errMax = 0;
+
+    for (int32_t adcT = 300'000; adcT < 700'000; adcT += 37)
+    {
+        double tFineD = 0;
+        double tD     = TemperatureDouble(cal, adcT, tFineD);
+        if (tD < -40 || tD > 85)
+        {
+            continue;
+        }
+        adcList.push_back(adcT);
+
+        int32_t tFine = 0;
+        double  t     = BoschCompensation::Temperature(cal, adcT, tFine) / 100.0;
+
+        errMax = max(errMax, fabs(t - tD));
+    }
+
+    volatile int64_t sink = 0;
+    uint64_t psInt = Time((uint32_t)adcList.size(), [&]{
+        int64_t acc = 0;
+        for (int32_t adcT : adcList)
+        {
+            int32_t tFine;
+            acc += BoschCompensation::Temperature(cal, adcT, tFine);
+        }
+        sink = sink + acc;
+    });
+    uint64_t psDouble = Time((uint32_t)adcList.size(), [&]{
+        double acc = 0;
+        for (int32_t adcT : adcList)
+        {
+            double tFine;
+            acc += TemperatureDouble(cal, adcT, tFine);
+        }
+        sink = sink + (int64_t)acc;
+    });
+
+    Report("Temperature", (uint32_t)adcList.size(), psInt, psDouble, errMax, 0.01, "C");
+}
+
+static void BenchPressure(const Cal &cal)
+{
+    struct Item { int32_t adcP; int32_t tFine; double tFineD; };
+    vector<Item> itemList;
+    double errMax = 0;
+
+    for (int32_t adcT : { 380'000, 519'888, 620'000 })
+    {
+        double  tFineD = 0;
+        int32_t tFine  = 0;
+        TemperatureDouble(cal, adcT, tFineD);
+        BoschCompensation::Temperature(cal, adcT, tFine);
+
+        for (int32_t adcP = 100'000; adcP < 900'000; adcP += 41)
+        {
+            double pD = PressureDouble(cal, adcP, tFineD);
+            if (pD < 30'000 || pD > 110'000)
+            {
+                continue;
+            }
+            itemList.push_back({ adcP, tFine, tFineD });
+
+            double p = BoschCompensation::Pressure(cal, adcP, tFine) / 256.0;
+
+            errMax = max(errMax, fabs(p - pD));
+        }
+    }
+
+    volatile int64_t sink = 0;
+    uint64_t psInt = Time((uint32_t)itemList.size(), [&]{
+        int64_t acc = 0;
+        for (const auto &item : itemList)
+        {
+            acc += BoschCompensation::Pressure(cal, item.adcP, item.tFine);
+        }
+        sink = sink + acc;
+    });
+    uint64_t psDouble = Time((uint32_t)itemList.size(), [&]{
+        double acc = 0;
+        for (const auto &item : itemList)
+        {
+            acc += PressureDouble(cal, item.adcP, item.tFineD);
+        }
+        sink = sink + (int64_t)acc;
+    });
+
+    Report("Pressure", (uint32_t)itemList.size(), psInt, psDouble, errMax, 1.0, "Pa");
+}
+
+static void BenchHumidity(const Cal &cal)
+{
+    struct Item { int32_t adcH; int32_t tFine; double tFineD; };
+    vector<Item> itemList;
+    double errMax = 0;
+
+    for (int32_t adcT : { 380'000, 519'888, 620'000 })
+    {
+        double  tFineD = 0;
+        int32_t tFine  = 0;
+        TemperatureDouble(cal, adcT, tFineD);
+        BoschCompensation::Temperature(cal, adcT, tFine);
+
+        for (int32_t adcH = 0; adcH < 65'536; adcH += 7)
+        {
+            double hD = HumidityDouble(cal, adcH, tFineD);
+            if (hD <= 0 || hD >= 100)
+            {
+                continue;
+            }
+            itemList.push_back({ adcH, tFine, tFineD });
+
+            double h = BoschCompensation::Humidity(cal, adcH, tFine) / 1024.0;
+
+            errMax = max(errMax, fabs(h - hD));
+        }
+    }
+
+    volatile int64_t sink = 0;
+    uint64_t psInt = Time((uint32_t)itemList.size(), [&]{
+        int64_t acc = 0;
+        for (const auto &item : itemList)
+        {
+            acc += BoschCompensation::Humidity(cal, item.adcH, item.tFine);
+        }
+        sink = sink + acc;
+    });
+    uint64_t psDouble = Time((uint32_t)itemList.size(), [&]{
+        double acc = 0;
+        for (const auto &item : itemList)
+        {
+            acc += HumidityDouble(cal, item.adcH, item.tFineD);
+        }
+        sink = sink + (int64_t)acc;
+    });
+
+    Report("Humidity", (uint32_t)itemList.size(), psInt, psDouble, errMax, 0.1, "%RH");
+}
+
+int main()
+{
+    Log("BMP280 / BME280 Compensation Host Benchmark");
+    LogNL();
+
+    Cal cal = MakeCal();
+
+    BenchParse();
+    BenchExample(cal);
+    BenchTemperature(cal);
+    BenchPressure(cal);
+    BenchHumidity(cal);
+
+    Log(pass_ ? "PASS" : "FAIL");
+
+    return pass_ ? 0 : 1;
+}
@@ -0,0 +1,322 @@
+#include "Log.h"
+#include "Utl.h"
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+using namespace std;
+
+#include "ClockGovernorPolicy.h"
+
+
+// Host simulation of the ClockGovernor policy against running fixed at the
+// top level.
+//
+// The Evm main loop is modelled in virtual time.  Work arrives on a schedule
+// costing a number of clock cycles, so takes longer at lower levels.  Each
+// pass asks the policy at its start, handles everything queued, and, before
+// sleeping until the next arrival, asks again.  A switch takes effect at
+// once, and costs SWITCH_US of busy time.
+//
+// Each load is run governed and fixed at the top, and compared on MHz*s
+// (clock cycles, the energy proxy), throughput per MHz*s and the latency of
+// work from arriving to being handled.
+//
+// Switches are held as ClockGovernor holds them for what's running, which
+// for a default App is the ADC sampler, once the temperature has been read.
+
+
+using Policy = ClockGovernorPolicy;
+
+static const uint64_t SWITCH_US = 100;
+
+static bool pass_ = true;
+
+static void Check(const char *what, bool ok)
+{
+    pass_ &= ok;
+
+    Log("  ", what, ": ", ok ? "ok" : "FAIL");
+}
+
+// 1500 MHz VCO divided by 12, 15, 20 and 30, as ClockGovernor defaults
+static Policy::Config GetConfig()
+{
+    Policy::Config config;
+
+    config.levelList = {
+        {  50'000, 1'000 },
+        {  75'000, 1'050 },
+        { 100'000, 1'100 },
+        { 125'000, 1'100 },
+    };
+
+    return config;
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Simulation
+/////////////////////////////////////////////////////////////////
+
+struct Arrival
+{
+    uint64_t timeUs;
+    uint32_t kcycles;   // thousands of clock cycles to handle
+};
+
+struct Result
+{
+    double   mhzS;
+    uint64_t handled;
+    uint64_t latencyUsMax;
+    uint64_t latencyUsSum;
+    uint32_t switchCount;
+    vector<uint64_t> timeAtLevelUs;
+};
+
+// the ADC sampler, started by the first temperature read
+static const Policy::Peripherals PERIPHERALS_DEFAULT_APP = { .adcSampler = true };
+
+static Result Run(const vector<Arrival> &arrivalList, uint64_t durationUs, bool governed, const Policy::Peripherals &peripherals = PERIPHERALS_DEFAULT_APP)
+{
+    Result retVal = {};
+
+    Policy policy;
+    policy.SetConfig(GetConfig());
+
+    uint8_t  levelTop   = policy.GetLevelTop();
+    uint64_t timeNowUs  = 0;
+    uint64_t timeBusyUs = 0;
+
+    policy.Reset(timeNowUs, timeBusyUs, levelTop);
+
+    auto Switch = [&](const Policy::Want &want){
+        if (governed && want.reason != Policy::Reason::NONE && Policy::GetHold(peripherals) == Policy::Hold::NONE)
+        {
+            timeNowUs  += SWITCH_US;
+            timeBusyUs += SWITCH_US;
+
+            policy.Apply(timeNowUs, timeBusyUs, want.level);
+
+            ++retVal.switchCount;
+        }
+    };
+
+    deque<Arrival> queue;
+    size_t idx = 0;
+
+    while (timeNowUs < durationUs)
+    {
+        for (; idx < arrivalList.size() && arrivalList[idx].timeUs <= timeNowUs; ++idx)
+        {
+            queue.push_back(arrivalList[idx]);
+        }
+
+        Switch(policy.OnPass(timeNowUs, timeBusyUs, (uint16_t)min(queue.size(), (size_t)UINT16_MAX)));
+
+        // everything queued at the start of the pass
+        uint32_t khz = GetConfig().levelList[policy.GetLevel()].khz;
+        for (size_t count = queue.size(); count; --count)
+        {
+            uint64_t costUs = (uint64_t)queue.front().kcycles * 1'000'000 / khz;
+
+            timeNowUs  += costUs;
+            timeBusyUs += costUs;
+
+            uint64_t latencyUs = timeNowUs - queue.front().timeUs;
+            retVal.latencyUsMax  = max(retVal.latencyUsMax, latencyUs);
+            retVal.latencyUsSum += latencyUs;
+            ++retVal.handled;
+
+            queue.pop_front();
+        }
+
+        for (; idx < arrivalList.size() && arrivalList[idx].timeUs <= timeNowUs; ++idx)
+        {
+            queue.push_back(arrivalList[idx]);
+        }
+
+        if (queue.empty())
+        {
+            uint64_t timeNextUs = idx < arrivalList.size() ? arrivalList[idx].timeUs : durationUs;
+
+            Switch(policy.OnSleep(timeNowUs, timeNextUs - timeNowUs));
+
+            timeNowUs = max(timeNowUs, timeNextUs);
+        }
+    }
+
+    policy.Account(timeNowUs, timeBusyUs);
+
+    retVal.mhzS = policy.GetMhzSeconds();
+    for (uint8_t i = 0; i <= levelTop; ++i)
+    {
+        retVal.timeAtLevelUs.push_back(policy.GetTimeAtLevelUs(i));
+    }
+
+    return retVal;
+}
+
+// Runs both ways and reports, returning the governed result
+static Result Compare(const char *name, const vector<Arrival> &arrivalList, uint64_t durationUs, Result &fixed)
+{
+    Result gov = Run(arrivalList, durationUs, true);
+    fixed      = Run(arrivalList, durationUs, false);
+
+    Log(name);
+    Log("  arrivals           : ", Commas(arrivalList.size()), " over ", Commas(durationUs / 1'000), " ms");
+    LogNNL("  time at level %    :");
+    for (uint64_t us : gov.timeAtLevelUs)
+    {
+        LogNNL(" ", StrUtl::PadLeft(to_string(us * 100 / durationUs), ' ', 3));
+    }
+    LogNL();
+    Log("  switches           : ", Commas(gov.switchCount));
+    Log("  MHz*s governed     : ", gov.mhzS);
+    Log("  MHz*s fixed        : ", fixed.mhzS);
+    Log("  saved %            : ", (uint32_t)(100 - gov.mhzS * 100 / fixed.mhzS));
+    Log("  handled / MHz*s    : ", (double)gov.handled / gov.mhzS, " vs ", (double)fixed.handled / fixed.mhzS);
+    Log("  latency us avg     : ", Commas(gov.latencyUsSum / max(gov.handled, (uint64_t)1)), " vs ", Commas(fixed.latencyUsSum / max(fixed.handled, (uint64_t)1)));
+    Log("  latency us max     : ", Commas(gov.latencyUsMax), " vs ", Commas(fixed.latencyUsMax));
+
+    return gov;
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Loads
+/////////////////////////////////////////////////////////////////
+
+static const uint64_t DURATION_US = 10'000'000;
+
+// A 100 ms tick doing a little, mostly asleep
+static void BenchIdle()
+{
+    vector<Arrival> arrivalList;
+    for (uint64_t us = 0; us < DURATION_US; us += 100'000)
+    {
+        arrivalList.push_back({ us, 50 });
+    }
+
+    Result fixed;
+    Result gov = Compare("Idle tick", arrivalList, DURATION_US, fixed);
+
+    Check("mostly at the bottom       ", gov.timeAtLevelUs[0] * 100 / DURATION_US >= 90);
+    Check("saves half or more         ", gov.mhzS * 2 <= fixed.mhzS);
+    Check("all handled                ", gov.handled == fixed.handled);
+    LogNL();
+}
+
+// A 100 ms tick, and every second a burst of 40 items arriving together
+static void BenchBurst()
+{
+    vector<Arrival> arrivalList;
+    for (uint64_t us = 0; us < DURATION_US; us += 100'000)
+    {
+        arrivalList.push_back({ us, 50 });
+
+        if (us % 1'000'000 == 500'000)
+        {
+            for (uint32_t i = 0; i < 40; ++i)
+            {
+                arrivalList.push_back({ us, 250 });
+            }
+        }
+    }
+
+    Result fixed;
+    Result gov = Compare("Bursts", arrivalList, DURATION_US, fixed);
+
+    // each burst is handled at the top, but for the switch itself
+    Check("burst latency held         ", gov.latencyUsMax <= fixed.latencyUsMax + 2 * SWITCH_US);
+    Check("saves half or more         ", gov.mhzS * 2 <= fixed.mhzS);
+    Check("all handled                ", gov.handled == fixed.handled);
+    LogNL();
+}
+
+// Back to back work, 90% busy at the top
+static void BenchSustained()
+{
+    vector<Arrival> arrivalList;
+    for (uint64_t us = 0; us < DURATION_US; us += 1'000)
+    {
+        arrivalList.push_back({ us, 112 });
+    }
+
+    Result fixed;
+    Result gov = Compare("Sustained", arrivalList, DURATION_US, fixed);
+
+    Check("stays at the top           ", gov.timeAtLevelUs.back() * 100 / DURATION_US >= 95);
+    Check("no thrash                  ", gov.switchCount <= 2);
+    LogNL();
+}
+
+// Load flipping between 10% and 70% at the top every 400 ms, which scaled
+// down is astride the thresholds
+static void BenchHysteresis()
+{
+    vector<Arrival> arrivalList;
+    for (uint64_t us = 0; us < DURATION_US; us += 1'000)
+    {
+        uint32_t kcycles = (us / 400'000) % 2 ? 87 : 12;
+
+        arrivalList.push_back({ us, kcycles });
+    }
+
+    Result fixed;
+    Result gov = Compare("Hysteresis", arrivalList, DURATION_US, fixed);
+
+    const Policy::Config config = GetConfig();
+
+    // going down takes downWindows quiet windows, so at most one step down,
+    // and one back up, each time that passes
+    uint32_t switchMax = (uint32_t)(DURATION_US / (config.downWindows * config.windowUs) * 2);
+
+    Log("  switches max       : ", Commas(switchMax));
+
+    Check("switches bounded           ", gov.switchCount <= switchMax);
+    Check("all handled                ", gov.handled == fixed.handled);
+    LogNL();
+}
+
+// A default App, the idle tick, with what it has running, and then with
+// audio playing as well, which holds switches
+static void BenchHolds()
+{
+    vector<Arrival> arrivalList;
+    for (uint64_t us = 0; us < DURATION_US; us += 100'000)
+    {
+        arrivalList.push_back({ us, 50 });
+    }
+
+    Policy::Peripherals peripheralsAudio = PERIPHERALS_DEFAULT_APP;
+    peripheralsAudio.pwmAudio = true;
+
+    Result gov   = Run(arrivalList, DURATION_US, true);
+    Result audio = Run(arrivalList, DURATION_US, true, peripheralsAudio);
+
+    Log("Holds");
+    Log("  switches default App : ", Commas(gov.switchCount));
+    Log("  switches with audio  : ", Commas(audio.switchCount));
+
+    Check("default App changes level  ", gov.switchCount > 0 && gov.timeAtLevelUs[0] > 0);
+    Check("audio holds switches       ", audio.switchCount == 0);
+    LogNL();
+}
+
+int main()
+{
+    Log("Clock Governor Host Benchmark");
+    LogNL();
+
+    BenchHolds();
+    BenchIdle();
+    BenchBurst();
+    BenchSustained();
+    BenchHysteresis();
+
+    Log(pass_ ? "PASS" : "FAIL");
+
+    return pass_ ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+#include "Log.h"
+#include "Utl.h"
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+using namespace std;
+
+#include "ClockPllTable.h"
+
+
+// Host benchmark of the compile-time pll_sys table against the runtime
+// double search it replaced (adapted from vcocalc.py in pico-sdk).
+//
+// Every entry is checked against the PLL constraints and its frequency
+// recomputed.  Then a sweep of targets across the range, both whole MHz and
+// odd kHz steps, is looked up both ways, for both the default and low power
+// priority.  Both must land on the same frequency.  The settings only differ
+// where several make that frequency, and rounding in the double search had
+// one come out a hair nearer than the other.
+//
+// Note the host has an FPU, so the double search is far cheaper here than on
+// the RP2040, where each double operation is a software routine.
+
+
+using Config = ClockPllTable::Config;
+
+static const uint32_t PASS_COUNT = 20;
+
+static bool pass_ = true;
+
+static uint64_t NowNs()
+{
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename Fn>
+static uint64_t Time(uint32_t itemsPerPass, Fn fn)
+{
+    uint64_t timeStartNs = NowNs();
+    for (uint32_t pass = 0; pass < PASS_COUNT; ++pass)
+    {
+        fn();
+    }
+    uint64_t durationNs = NowNs() - timeStartNs;
+
+    return durationNs / ((uint64_t)itemsPerPass * PASS_COUNT);
+}
+
+static void Check(const char *what, bool ok)
+{
+    pass_ &= ok;
+
+    Log("  ", what, ": ", ok ? "ok" : "FAIL");
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Runtime double search, as Clock did it
+/////////////////////////////////////////////////////////////////
+
+struct SearchResult
+{
+    double   mhz;
+    uint32_t refdiv;
+    uint32_t fbdiv;
+    uint32_t postDiv1;
+    uint32_t postDiv2;
+};
+
+static SearchResult Search(double mhz, bool lowPowerPriority)
+{
+    SearchResult retVal{};
+
+    double bestMargin = mhz;
+
+    for (int refdiv = 1; refdiv <= 2; ++refdiv)
+    {
+        for (int i = 0; i <= 320 - 16; ++i)
+        {
+            int fbdiv = lowPowerPriority ? 16 + i : 320 - i;
+
+            double vco = 12.0 / refdiv * fbdiv;
+            if (vco < 750 || vco > 1600)
+            {
+                continue;
+            }
+
+            for (int pd2 = 1; pd2 <= 7; ++pd2)
+            {
+                for (int pd1 = 1; pd1 <= 7; ++pd1)
+                {
+                    double out    = vco / pd1 / pd2;
+                    double margin = fabs(out - mhz);
+
+                    if (margin < bestMargin)
+                    {
+                        retVal = { out, (uint32_t)refdiv, (uint32_t)fbdiv, (uint32_t)pd1, (uint32_t)pd2 };
+
+                        bestMargin = margin;
+                    }
+                }
+            }
+        }
+    }
+
+    return retVal;
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Benches
+/////////////////////////////////////////////////////////////////
+
+static void BenchTable()
+{
+    Log("Table");
+    Log("  entries          : ", Commas(ClockPllTable::GetCount()));
+    Log("  bytes            : ", Commas(ClockPllTable::GetCount() * 8));
+
+    bool     sorted     = true;
+    bool     valid      = true;
+    bool     lowPowerOk = true;
+    uint32_t exactCount = 0;
+    uint32_t freqHzLast = 0;
+
+    for (uint16_t i = 0; i < ClockPllTable::GetCount(); ++i)
+    {
+        for (bool lowPowerPriority : { false, true })
+        {
+            Config c = ClockPllTable::GetConfig(i, lowPowerPriority);
+
+            uint64_t num = (uint64_t)ClockPllTable::XOSC_HZ * c.fbdiv;
+            uint64_t den = (uint64_t)c.refdiv * c.postDiv1 * c.postDiv2;
+
+            valid &= c.refdiv >= 1 && c.refdiv <= 2;
+            valid &= c.fbdiv >= 16 && c.fbdiv <= 320;
+            valid &= c.postDiv1 >= 1 && c.postDiv1 <= 7;
+            valid &= c.postDiv2 >= 1 && c.postDiv2 <= 7;
+            valid &= c.GetVcoHz() >= 750'000'000 && c.GetVcoHz() <= 1'600'000'000;
+            valid &= c.freqHz == (num + den / 2) / den;
+            valid &= c.exact == (num % den == 0);
+        }
+
+        Config c   = ClockPllTable::GetConfig(i, false);
+        Config cLp = ClockPllTable::GetConfig(i, true);
+
+        sorted     &= i == 0 || c.freqHz > freqHzLast;
+        lowPowerOk &= cLp.freqHz == c.freqHz && cLp.GetVcoHz() <= c.GetVcoHz();
+
+        exactCount += c.exact;
+        freqHzLast  = c.freqHz;
+    }
+
+    Log("  exact            : ", Commas(exactCount));
+    Log("  range            : ", ClockPllTable::GetConfig(0).freqHz, " - ", freqHzLast, " Hz");
+
+    Check("sorted, no duplicates    ", sorted);
+    Check("settings valid           ", valid);
+    Check("low power VCO not higher ", lowPowerOk);
+    LogNL();
+}
+
+static void BenchLookup(bool lowPowerPriority)
+{
+    vector<uint32_t> targetList;
+    for (uint32_t mhz = 16; mhz <= 280; ++mhz)
+    {
+        targetList.push_back(mhz * 1'000'000);
+    }
+    for (uint32_t hz = 14'000'000; hz <= ClockPllTable::FREQ_MAX_HZ; hz += 37'013)
+    {
+        targetList.push_back(hz);
+    }
+
+    uint32_t same       = 0;
+    uint32_t sameFreq   = 0;
+    uint32_t exactAgree = 0;
+    for (uint32_t freqHz : targetList)
+    {
+        SearchResult sr = Search(freqHz / 1'000'000.0, lowPowerPriority);
+
+        Config c;
+        bool   exact = ClockPllTable::Lookup(freqHz, c, lowPowerPriority, true);
+
+        sameFreq += c.freqHz == (uint32_t)llround(sr.mhz * 1'000'000.0);
+        same     += c.refdiv == sr.refdiv && c.fbdiv == sr.fbdiv && c.postDiv1 == sr.postDiv1 && c.postDiv2 == sr.postDiv2;
+
+        exactAgree += exact == (sr.mhz * 1'000'000.0 == freqHz);
+    }
+
+    volatile uint32_t sink = 0;
+    uint64_t nsTable = Time((uint32_t)targetList.size(), [&]{
+        for (uint32_t freqHz : targetList)
+        {
+            Config c;
+            ClockPllTable::Lookup(freqHz, c, lowPowerPriority);
+            sink = sink + c.fbdiv;
+        }
+    });
+    uint64_t nsSearch = Time((uint32_t)targetList.size(), [&]{
+        for (uint32_t freqHz : targetList)
+        {
+            sink = sink + Search(freqHz / 1'000'000.0, lowPowerPriority).fbdiv;
+        }
+    });
+
+    Log(lowPowerPriority ? "Lookup, low power priority" : "Lookup, default");
+    Log("  targets          : ", Commas(targetList.size()));
+    Log("  same frequency   : ", Commas(sameFreq));
+    Log("  same settings    : ", Commas(same));
+    Log("  exact agrees     : ", Commas(exactAgree));
+    Log("  table  ns / item : ", nsTable);
+    Log("  search ns / item : ", Commas(nsSearch));
+
+    Check("same frequency as search ", sameFreq == targetList.size());
+    Check("exact agrees with search ", exactAgree == targetList.size());
+    LogNL();
+}
+
+int main()
+{
+    Log("Clock PLL Table Host Benchmark");
+    LogNL();
+
+    BenchTable();
+    BenchLookup(false);
+    BenchLookup(true);
+
+    Log(pass_ ? "PASS" : "FAIL");
+
+    return pass_ ? 0 : 1;
+}
@@ -0,0 +1,519 @@
+#include "Log.h"
+#include "Utl.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+using namespace std;
+
+#include "SignalCordic.h"
+#include "SignalDecimator.h"
+#include "SignalFilterBiquad.h"
+#include "SignalFilterFIR.h"
+#include "SignalMovingAverage.h"
+
+
+// Host benchmark of the fixed-point DSP kernels against the same done in
+// double.
+//
+// Each kernel is run over the same input, and its output compared with the
+// double version's, the error given in output LSBs.  The double versions
+// use the unquantized coefficients, so the error includes quantizing them.
+//
+// Note the host has an FPU, so double is far cheaper here than on the
+// RP2040, where each double operation is a software routine of tens to
+// hundreds of cycles.  The fixed-point timings are the ones to compare
+// between kernels, the double ones are the floor of what double could be.
+
+
+static const uint32_t SAMPLE_COUNT  = 4'096;
+static const uint32_t PASS_COUNT    = 500;
+static constexpr double SAMPLE_RATE   = 1000.0;
+
+// 31-tap Hamming windowed-sinc low pass, cutoff 0.1 fs
+static const double FIR_COEFF_DOUBLE_LIST[] = {
+    0.00000000, 0.00120143, 0.00278433, 0.00422732,
+    0.00394276, -0.00000000, -0.00825678, -0.01858321,
+    -0.02538982, -0.02123531, 0.00000000, 0.03958811,
+    0.09188888, 0.14509908, 0.18490288, 0.19966067,
+    0.18490288, 0.14509908, 0.09188888, 0.03958811,
+    0.00000000, -0.02123531, -0.02538982, -0.01858321,
+    -0.00825678, -0.00000000, 0.00394276, 0.00422732,
+    0.00278433, 0.00120143, 0.00000000,
+};
+
+inline constexpr Q115 FIR_COEFF_LIST[] = {
+    0.00000000, 0.00120143, 0.00278433, 0.00422732,
+    0.00394276, -0.00000000, -0.00825678, -0.01858321,
+    -0.02538982, -0.02123531, 0.00000000, 0.03958811,
+    0.09188888, 0.14509908, 0.18490288, 0.19966067,
+    0.18490288, 0.14509908, 0.09188888, 0.03958811,
+    0.00000000, -0.02123531, -0.02538982, -0.01858321,
+    -0.00825678, -0.00000000, 0.00394276, 0.00422732,
+    0.00278433, 0.00120143, 0.00000000,
+};
+
+static const uint32_t FIR_TAP_COUNT = sizeof(FIR_COEFF_DOUBLE_LIST) / sizeof(FIR_COEFF_DOUBLE_LIST[0]);
+
+static constexpr double BIQUAD_CUTOFF = 50.0;
+static constexpr double BIQUAD_Q      = 0.7071;
+
+inline constexpr auto BIQUAD_COEFF    = SignalFilterBiquadCoeff::LowPass(SAMPLE_RATE, BIQUAD_CUTOFF, BIQUAD_Q);
+inline constexpr auto BIQUAD_COEFF_HP = SignalFilterBiquadCoeff::HighPass(SAMPLE_RATE, BIQUAD_CUTOFF, BIQUAD_Q);
+
+static const uint16_t AVG_WINDOW = 16;
+static const uint8_t  DEC_FACTOR = 4;
+
+static bool pass_ = true;
+
+static uint64_t NowNs()
+{
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// a few tones and some noise, kept well within 16 bits
+static vector<int16_t> MakeInput()
+{
+    vector<int16_t> retVal(SAMPLE_COUNT);
+
+    uint32_t lcg = 12345;
+    for (uint32_t i = 0; i < SAMPLE_COUNT; ++i)
+    {
+        lcg = lcg * 1664525 + 1013904223;
+        double noise = (double)(int32_t)(lcg >> 16 & 0xFFFF) - 32768.0;
+
+        double t   = (double)i / SAMPLE_RATE;
+        double val = 8000 * sin(2 * M_PI * 20 * t)
+                   + 6000 * sin(2 * M_PI * 180 * t)
+                   + 4000 * sin(2 * M_PI * 400 * t)
+                   + noise / 16;
+
+        retVal[i] = (int16_t)lround(val);
+    }
+
+    return retVal;
+}
+
+template <typename Fn>
+static uint64_t Time(uint32_t itemsPerPass, Fn fn)
+{
+    uint64_t timeStartNs = NowNs();
+    for (uint32_t pass = 0; pass < PASS_COUNT; ++pass)
+    {
+        fn();
+    }
+    uint64_t durationNs = NowNs() - timeStartNs;
+
+    return durationNs * 1'000 / ((uint64_t)itemsPerPass * PASS_COUNT);
+}
+
+static void Report(const char *title, uint64_t psFixed, uint64_t psDouble, double errMax, double errRms, double errLimit)
+{
+    bool ok = errMax <= errLimit;
+    pass_ &= ok;
+
+    Log(title);
+    Log("  fixed  ns / item : ", (double)psFixed / 1000);
+    Log("  double ns / item : ", (double)psDouble / 1000);
+    Log("  error max        : ", errMax, " (limit ", errLimit, ")", ok ? "" : " FAIL");
+    Log("  error rms        : ", errRms);
+    LogNL();
+}
+
+static void Compare(const vector<int16_t> &fixedList, const vector<double> &doubleList, double &errMax, double &errRms)
+{
+    errMax = 0;
+    errRms = 0;
+
+    for (size_t i = 0; i < fixedList.size(); ++i)
+    {
+        double err = fabs((double)fixedList[i] - doubleList[i]);
+
+        errMax  = max(errMax, err);
+        errRms += err * err;
+    }
+
+    errRms = sqrt(errRms / (double)fixedList.size());
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Double References
+////////////////////////////////////////////////////////////////////////////////
+
+static void FirDouble(const vector<int16_t> &in, vector<double> &out)
+{
+    vector<double> hist(FIR_TAP_COUNT, 0.0);
+
+    for (size_t i = 0; i < in.size(); ++i)
+    {
+        for (uint32_t k = FIR_TAP_COUNT - 1; k > 0; --k)
+        {
+            hist[k] = hist[k - 1];
+        }
+        hist[0] = in[i];
+
+        double acc = 0;
+        for (uint32_t k = 0; k < FIR_TAP_COUNT; ++k)
+        {
+            acc += FIR_COEFF_DOUBLE_LIST[k] * hist[k];
+        }
+
+        out[i] = acc;
+    }
+}
+
+static void BiquadDouble(const vector<int16_t> &in, vector<double> &out, bool highPass = false)
+{
+    double w0    = 2 * M_PI * BIQUAD_CUTOFF / SAMPLE_RATE;
+    double alpha = sin(w0) / (2 * BIQUAD_Q);
+    double a0    = 1 + alpha;
+    double b0    = (highPass ? (1 + cos(w0)) : (1 - cos(w0))) / 2 / a0;
+    double b1    = (highPass ? -(1 + cos(w0)) : (1 - cos(w0))) / a0;
+    double b2    = b0;
+    double a1    = -2 * cos(w0) / a0;
+    double a2    = (1 - alpha) / a0;
+
+    double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+    for (size_t i = 0; i < in.size(); ++i)
+    {
+        double x0 = in[i];
+        double y0 = b0 * x0 + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+
+        x2 = x1; x1 = x0;
+        y2 = y1; y1 = y0;
+
+        out[i] = y0;
+    }
+}
+
+static void AverageDouble(const vector<int16_t> &in, vector<double> &out)
+{
+    for (size_t i = 0; i < in.size(); ++i)
+    {
+        double sum = 0;
+        for (uint32_t k = 0; k < AVG_WINDOW; ++k)
+        {
+            sum += i >= k ? in[i - k] : 0;
+        }
+
+        // the fixed version rounds down, so compare like for like
+        out[i] = floor(sum / AVG_WINDOW);
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Benches
+////////////////////////////////////////////////////////////////////////////////
+
+static void BenchFir(const vector<int16_t> &in)
+{
+    vector<int16_t> outFixed(in.size());
+    vector<double>  outDouble(in.size());
+
+    SignalFilterFIR<FIR_COEFF_LIST> fir;
+    fir.Process(in.data(), outFixed.data(), SAMPLE_COUNT);
+    FirDouble(in, outDouble);
+
+    double errMax, errRms;
+    Compare(outFixed, outDouble, errMax, errRms);
+
+    uint64_t psFixed = Time(SAMPLE_COUNT, [&]{
+        fir.Process(in.data(), outFixed.data(), SAMPLE_COUNT);
+    });
+    uint64_t psDouble = Time(SAMPLE_COUNT, [&]{
+        FirDouble(in, outDouble);
+    });
+
+    Report("FIR, 31 tap (per sample)", psFixed, psDouble, errMax, errRms, 4);
+}
+
+static void BenchBiquad(const vector<int16_t> &in)
+{
+    vector<int16_t> outFixed(in.size());
+    vector<double>  outDouble(in.size());
+
+    SignalFilterBiquad<BIQUAD_COEFF> bq;
+    bq.Process(in.data(), outFixed.data(), SAMPLE_COUNT);
+    BiquadDouble(in, outDouble);
+
+    double errMax, errRms;
+    Compare(outFixed, outDouble, errMax, errRms);
+
+    uint64_t psFixed = Time(SAMPLE_COUNT, [&]{
+        bq.Process(in.data(), outFixed.data(), SAMPLE_COUNT);
+    });
+    uint64_t psDouble = Time(SAMPLE_COUNT, [&]{
+        BiquadDouble(in, outDouble);
+    });
+
+    // Q14 coefficients move the response slightly, so allow a little more
+    // than the FIR
+    Report("Biquad low pass, 50 Hz at 1 kHz (per sample)", psFixed, psDouble, errMax, errRms, 8);
+}
+
+// Coefficients summing over 4.0 in magnitude, so summed in 64 bits
+static void BenchBiquadHighPass(const vector<int16_t> &in)
+{
+    vector<int16_t> outFixed(in.size());
+    vector<double>  outDouble(in.size());
+
+    SignalFilterBiquad<BIQUAD_COEFF_HP> bq;
+    bq.Process(in.data(), outFixed.data(), SAMPLE_COUNT);
+    BiquadDouble(in, outDouble, true);
+
+    double errMax, errRms;
+    Compare(outFixed, outDouble, errMax, errRms);
+
+    uint64_t psFixed = Time(SAMPLE_COUNT, [&]{
+        bq.Process(in.data(), outFixed.data(), SAMPLE_COUNT);
+    });
+    uint64_t psDouble = Time(SAMPLE_COUNT, [&]{
+        BiquadDouble(in, outDouble, true);
+    });
+
+    Report("Biquad high pass, 50 Hz at 1 kHz, 64-bit sum (per sample)", psFixed, psDouble, errMax, errRms, 8);
+}
+
+static void BenchAverage(const vector<int16_t> &in)
+{
+    vector<int16_t> outFixed(in.size());
+    vector<double>  outDouble(in.size());
+
+    SignalMovingAverage<AVG_WINDOW> avg;
+    avg.Process(in.data(), outFixed.data(), SAMPLE_COUNT);
+    AverageDouble(in, outDouble);
+
+    double errMax, errRms;
+    Compare(outFixed, outDouble, errMax, errRms);
+
+    uint64_t psFixed = Time(SAMPLE_COUNT, [&]{
+        avg.Process(in.data(), outFixed.data(), SAMPLE_COUNT);
+    });
+    uint64_t psDouble = Time(SAMPLE_COUNT, [&]{
+        AverageDouble(in, outDouble);
+    });
+
+    Report("Moving average, 16 (per sample)", psFixed, psDouble, errMax, errRms, 0);
+}
+
+static void BenchDecimator(const vector<int16_t> &in)
+{
+    vector<int16_t> outFixed(in.size() / DEC_FACTOR + 1);
+    vector<double>  outFull(in.size());
+
+    SignalDecimator<DEC_FACTOR, FIR_COEFF_LIST> dec;
+    uint32_t outCount = dec.Process(in.data(), SAMPLE_COUNT, outFixed.data());
+    outFixed.resize(outCount);
+
+    // every 4th of the full rate filter
+    FirDouble(in, outFull);
+    vector<double> outDouble;
+    for (size_t i = DEC_FACTOR - 1; i < outFull.size(); i += DEC_FACTOR)
+    {
+        outDouble.push_back(outFull[i]);
+    }
+
+    double errMax, errRms;
+    Compare(outFixed, outDouble, errMax, errRms);
+
+    outFixed.resize(in.size() / DEC_FACTOR + 1);
+    uint64_t psFixed = Time(SAMPLE_COUNT, [&]{
+        dec.Process(in.data(), SAMPLE_COUNT, outFixed.data());
+    });
+    uint64_t psDouble = Time(SAMPLE_COUNT, [&]{
+        FirDouble(in, outFull);
+    });
+
+    Report("Decimate 4x, 31 tap (per input sample, double filters all)", psFixed, psDouble, errMax, errRms, 4);
+}
+
+static void BenchSinCos()
+{
+    static const uint32_t COUNT = 4'096;
+
+    // error in units of 2^-30
+    double errMax = 0, errRms = 0;
+    for (uint32_t i = 0; i < COUNT; ++i)
+    {
+        uint32_t angle = i * (0xFFFF'FFFF / COUNT) + i;
+        double   rad   = (double)angle / 4294967296.0 * 2 * M_PI;
+
+        auto sc = SignalCordic::SinCos(angle);
+
+        double errSin = fabs((double)sc.sin - sin(rad) * SignalCordic::ONE_Q230);
+        double errCos = fabs((double)sc.cos - cos(rad) * SignalCordic::ONE_Q230);
+
+        errMax  = max(errMax, max(errSin, errCos));
+        errRms += errSin * errSin + errCos * errCos;
+    }
+    errRms = sqrt(errRms / (2 * COUNT));
+
+    volatile int64_t sink = 0;
+    uint64_t psFixed = Time(COUNT, [&]{
+        int64_t acc = 0;
+        for (uint32_t i = 0; i < COUNT; ++i)
+        {
+            auto sc = SignalCordic::SinCos(i * 1'048'573);
+            acc += sc.sin + sc.cos;
+        }
+        sink = sink + acc;
+    });
+    uint64_t psDouble = Time(COUNT, [&]{
+        double acc = 0;
+        for (uint32_t i = 0; i < COUNT; ++i)
+        {
+            double rad = (double)(i * 1'048'573) / 4294967296.0 * 2 * M_PI;
+            acc += sin(rad) + cos(rad);
+        }
+        sink = sink + (int64_t)acc;
+    });
+
+    Report("CORDIC sin+cos (per pair, error in 2^-30)", psFixed, psDouble, errMax, errRms, 64);
+}
+
+static void BenchAtan2()
+{
+    static const uint32_t COUNT = 4'096;
+
+    // angle error in 32-bit brads, magnitude error in LSBs
+    double errMax = 0, errRms = 0;
+    double magErrMax = 0;
+
+    uint32_t lcg = 999;
+    vector<pair<int32_t, int32_t>> xyList;
+    for (uint32_t i = 0; i < COUNT; ++i)
+    {
+        lcg = lcg * 1664525 + 1013904223;
+        int32_t x = (int32_t)(lcg >> 8) - (1 << 23);
+        lcg = lcg * 1664525 + 1013904223;
+        int32_t y = (int32_t)(lcg >> 8) - (1 << 23);
+
+        // some small too, for the scaling
+        if (i & 1)
+        {
+            x >>= 14;
+            y >>= 14;
+        }
+
+        xyList.push_back({ x, y });
+    }
+
+    for (auto [x, y] : xyList)
+    {
+        if (x == 0 && y == 0)
+        {
+            continue;
+        }
+
+        auto p = SignalCordic::ToPolar(y, x);
+
+        double angleDouble = atan2((double)y, (double)x) / (2 * M_PI) * 4294967296.0;
+        double err = fabs((double)(int32_t)(p.angle - (uint32_t)(int64_t)llround(angleDouble)));
+
+        errMax  = max(errMax, err);
+        errRms += err * err;
+
+        magErrMax = max(magErrMax, fabs((double)p.magnitude - hypot((double)x, (double)y)));
+    }
+    errRms = sqrt(errRms / COUNT);
+
+    volatile int64_t sink = 0;
+    uint64_t psFixed = Time(COUNT, [&]{
+        int64_t acc = 0;
+        for (auto [x, y] : xyList)
+        {
+            acc += SignalCordic::Atan2(y, x);
+        }
+        sink = sink + acc;
+    });
+    uint64_t psDouble = Time(COUNT, [&]{
+        double acc = 0;
+        for (auto [x, y] : xyList)
+        {
+            acc += atan2((double)y, (double)x);
+        }
+        sink = sink + (int64_t)acc;
+    });
+
+    // 2^32 brads to a circle, so 256 is about 0.00002 degrees
+    Report("CORDIC atan2 (error in 32-bit brads)", psFixed, psDouble, errMax, errRms, 256);
+
+    Log("CORDIC magnitude");
+    Log("  error max        : ", magErrMax, " (limit 2)", magErrMax <= 2 ? "" : " FAIL");
+    LogNL();
+    pass_ &= magErrMax <= 2;
+}
+
+static void BenchSqrt()
+{
+    static const uint32_t COUNT = 4'096;
+
+    // exact, so check a spread of values and the edges
+    uint32_t bad = 0;
+    vector<uint32_t> valList = { 0, 1, 2, 3, 4, 0xFFFF'FFFF, 0xFFFE'0001, 0xFFFE'0000 };
+    uint32_t lcg = 4242;
+    for (uint32_t i = 0; i < COUNT; ++i)
+    {
+        lcg = lcg * 1664525 + 1013904223;
+        valList.push_back(lcg >> (i % 32));
+    }
+
+    for (uint32_t val : valList)
+    {
+        uint64_t root = (uint64_t)sqrt((double)val);
+        if (SignalCordic::Sqrt(val) != root)
+        {
+            ++bad;
+        }
+    }
+
+    volatile int64_t sink = 0;
+    uint64_t psFixed = Time((uint32_t)valList.size(), [&]{
+        int64_t acc = 0;
+        for (uint32_t val : valList)
+        {
+            acc += SignalCordic::Sqrt(val);
+        }
+        sink = sink + acc;
+    });
+    uint64_t psDouble = Time((uint32_t)valList.size(), [&]{
+        int64_t acc = 0;
+        for (uint32_t val : valList)
+        {
+            acc += (int64_t)sqrt((double)val);
+        }
+        sink = sink + acc;
+    });
+
+    Report("Integer sqrt (error = count not exact)", psFixed, psDouble, bad, 0, 0);
+}
+
+int main()
+{
+    Log("Fixed-Point DSP Host Benchmark");
+    LogNL();
+
+    // worked out at compile time
+    static_assert(SignalCordic::Sqrt(1'000'000) == 1'000);
+    static_assert(BIQUAD_COEFF.b0.GetValueState() > 0);
+    static_assert(SignalFilterBiquad<BIQUAD_COEFF>::ACC_32);
+    static_assert(SignalFilterBiquad<BIQUAD_COEFF_HP>::ACC_32 == false);
+
+    vector<int16_t> in = MakeInput();
+
+    BenchFir(in);
+    BenchBiquad(in);
+    BenchBiquadHighPass(in);
+    BenchAverage(in);
+    BenchDecimator(in);
+    BenchSinCos();
+    BenchAtan2();
+    BenchSqrt();
+
+    Log(pass_ ? "PASS" : "FAIL");
+
+    return pass_ ? 0 : 1;
+}
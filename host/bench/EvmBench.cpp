@@ -0,0 +1,290 @@
+#include "Evm.h"
+#include "HostSim.h"
+#include "Log.h"
+#include "Timer.h"
+#include "Utl.h"
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+using namespace std;
+
+
+// Host benchmark of the Evm core.
+//
+// Evm runs against the HostSim virtual clock, so sleeping until the next
+// timer costs nothing, and what is measured (in real host time) is purely
+// the scheduling overhead of Evm itself:
+// - per-event work dispatch cost (QueueWork -> MainLoop -> callback), under
+//   different work policies
+// - timer arm and cancel cost with a given number of other live timers
+// - loop overhead per timer dispatch with a given number of live timers
+//
+// Absolute numbers are host numbers, use them to compare changes against
+// each other, not to predict target timing.
+
+
+static const vector<uint32_t> LIVE_TIMER_COUNT_LIST = { 10, 100, 1'000 };
+
+static mt19937 rng_(1);
+
+
+static uint64_t NowNs()
+{
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t RandomInRange(uint64_t low, uint64_t high)
+{
+    return uniform_int_distribution<uint64_t>(low, high)(rng_);
+}
+
+static string NsPer(uint64_t durationNs, uint64_t count)
+{
+    return Commas(count ? durationNs / count : 0);
+}
+
+static vector<unique_ptr<Timer>> MakeLiveTimers(uint32_t count, function<void()> cbFn, bool interval)
+{
+    vector<unique_ptr<Timer>> timerList;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        auto timer = make_unique<Timer>("BENCH_TIMER");
+        timer->SetCallback(cbFn);
+
+        if (interval)
+        {
+            timer->TimeoutIntervalUs(RandomInRange(1'000, 50'000));
+        }
+        else
+        {
+            // far enough in the future to never fire during the benchmark
+            timer->TimeoutInUs(RandomInRange(1'000'000'000, 2'000'000'000));
+        }
+
+        timerList.push_back(move(timer));
+    }
+
+    return timerList;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Work Dispatch
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename FnQueue>
+static void BenchWorkDispatch(const char *title, FnQueue fnQueue)
+{
+    const uint32_t BATCH_COUNT = 20'000;
+    const uint32_t BATCH_SIZE  = 40;
+
+    uint64_t handled = 0;
+
+    uint64_t timeStartNs = NowNs();
+    for (uint32_t batch = 0; batch < BATCH_COUNT; ++batch)
+    {
+        for (uint32_t i = 0; i < BATCH_SIZE; ++i)
+        {
+            fnQueue(handled);
+        }
+
+        fnQueue.Exit();
+
+        Evm::MainLoop();
+    }
+    uint64_t durationNs = NowNs() - timeStartNs;
+
+    Log("Work dispatch (", title, ")");
+    Log("  items      : ", Commas(handled));
+    Log("  ns / item  : ", NsPer(durationNs, handled));
+}
+
+static void BenchWorkDispatch()
+{
+    struct
+    {
+        void operator()(uint64_t &handled)
+        {
+            Evm::QueueWork("BENCH_WORK", [&]{
+                ++handled;
+            });
+        }
+
+        void Exit()
+        {
+            Evm::QueueWork("BENCH_WORK_EXIT", []{
+                Evm::ExitMainLoop();
+            });
+        }
+    } fnSmallCapture;
+
+    struct
+    {
+        void operator()(uint64_t &handled)
+        {
+            uint64_t a = handled, b = 2, c = 3;
+            Evm::QueueWork("BENCH_WORK", [&handled, a, b, c]{
+                handled += 1 + (a & b & c & 0);
+            });
+        }
+
+        void Exit()
+        {
+            Evm::QueueWork("BENCH_WORK_EXIT", []{
+                Evm::ExitMainLoop();
+            });
+        }
+    } fnLargeCapture;
+
+    struct
+    {
+        void operator()(uint64_t &handled)
+        {
+            Evm::QueueLowPriorityWork("BENCH_WORK", [&]{
+                ++handled;
+            });
+        }
+
+        void Exit()
+        {
+            Evm::QueueLowPriorityWork("BENCH_WORK_EXIT", []{
+                Evm::ExitMainLoop();
+            });
+        }
+    } fnLowPriority;
+
+    BenchWorkDispatch("8 byte capture",  fnSmallCapture);
+    BenchWorkDispatch("32 byte capture", fnLargeCapture);
+    BenchWorkDispatch("low priority",    fnLowPriority);
+
+    // the same bursts under other work policies.
+    // the virtual clock does not advance while work runs, so a time budget
+    // here amounts to draining everything queued in a single pass.
+    Evm::WorkPolicy policyDefault = Evm::GetWorkPolicy();
+
+    Evm::WorkPolicy policy = policyDefault;
+    policy.countMax = 16;
+    Evm::SetWorkPolicy(policy);
+    BenchWorkDispatch("count 16",        fnSmallCapture);
+
+    policy = policyDefault;
+    policy.budget    = Evm::WorkPolicy::Budget::TIME_US;
+    policy.timeUsMax = 1'000;
+    Evm::SetWorkPolicy(policy);
+    BenchWorkDispatch("time 1,000 us",   fnSmallCapture);
+
+    Evm::SetWorkPolicy(policyDefault);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Timer Arm / Cancel
+////////////////////////////////////////////////////////////////////////////////
+
+static void BenchTimerArmCancel(uint32_t liveTimerCount)
+{
+    const uint32_t PROBE_COUNT = 64;
+    const uint32_t ROUND_COUNT = 5'000;
+
+    auto liveList  = MakeLiveTimers(liveTimerCount, []{}, false);
+    auto probeList = MakeLiveTimers(PROBE_COUNT,    []{}, false);
+    for (auto &probe : probeList)
+    {
+        probe->Cancel();
+    }
+
+    uint64_t durationArmNs    = 0;
+    uint64_t durationCancelNs = 0;
+
+    for (uint32_t round = 0; round < ROUND_COUNT; ++round)
+    {
+        uint64_t timeoutUs = RandomInRange(1'000'000'000, 2'000'000'000);
+
+        uint64_t timeStartNs = NowNs();
+        for (uint32_t i = 0; i < PROBE_COUNT; ++i)
+        {
+            probeList[i]->TimeoutInUs(timeoutUs + i);
+        }
+        uint64_t timeArmedNs = NowNs();
+        for (uint32_t i = 0; i < PROBE_COUNT; ++i)
+        {
+            probeList[i]->Cancel();
+        }
+        uint64_t timeCanceledNs = NowNs();
+
+        durationArmNs    += timeArmedNs    - timeStartNs;
+        durationCancelNs += timeCanceledNs - timeArmedNs;
+    }
+
+    uint64_t opCount = (uint64_t)PROBE_COUNT * ROUND_COUNT;
+
+    Log("Timer arm/cancel (", liveTimerCount, " live timers)");
+    Log("  ns / arm    : ", NsPer(durationArmNs,    opCount));
+    Log("  ns / cancel : ", NsPer(durationCancelNs, opCount));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Loop Overhead
+////////////////////////////////////////////////////////////////////////////////
+
+static void BenchLoopOverhead(uint32_t liveTimerCount)
+{
+    const uint64_t TARGET_DISPATCH_COUNT = 500'000;
+
+    // scale simulated duration so each scenario dispatches a similar count
+    // of timer events, average interval is ~25ms
+    uint64_t durationSimUs = TARGET_DISPATCH_COUNT * 25'000 / liveTimerCount;
+
+    uint64_t dispatched = 0;
+    auto liveList = MakeLiveTimers(liveTimerCount, [&]{ ++dispatched; }, true);
+
+    Timer timerExit("BENCH_TIMER_EXIT");
+    timerExit.SetCallback([]{
+        Evm::ExitMainLoop();
+    });
+    timerExit.TimeoutInUs(durationSimUs);
+
+    uint64_t timeSimStartUs = HostSim::GetTimeUs();
+    uint64_t timeStartNs    = NowNs();
+    Evm::MainLoop();
+    uint64_t durationNs    = NowNs() - timeStartNs;
+    uint64_t durationSimMs = (HostSim::GetTimeUs() - timeSimStartUs) / 1'000;
+
+    Log("Loop overhead (", liveTimerCount, " live timers)");
+    Log("  simulated ms   : ", Commas(durationSimMs));
+    Log("  dispatched     : ", Commas(dispatched));
+    Log("  ns / dispatch  : ", NsPer(durationNs, dispatched));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Main
+////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+    Evm::DisableAutoLogAsync();
+
+    Log("Evm Host Benchmark");
+    LogNL();
+
+    BenchWorkDispatch();
+    LogNL();
+
+    for (auto liveTimerCount : LIVE_TIMER_COUNT_LIST)
+    {
+        BenchTimerArmCancel(liveTimerCount);
+    }
+    LogNL();
+
+    for (auto liveTimerCount : LIVE_TIMER_COUNT_LIST)
+    {
+        BenchLoopOverhead(liveTimerCount);
+    }
+
+    return 0;
+}
@@ -0,0 +1,437 @@
+#include "Evm.h"
+#include "FilesystemBlockDeviceRam.h"
+#include "FlashKvLog.h"
+#include "FlashWriteBehind.h"
+#include "HostSim.h"
+#include "Log.h"
+#include "Timer.h"
+#include "Utl.h"
+
+#include <cstring>
+#include <map>
+#include <vector>
+using namespace std;
+
+
+// Host benchmark and check of FlashKvLog and FlashWriteBehind, on a RAM
+// block device with the geometry of the on-target KV region (2 x 4 KB
+// blocks, 256 byte pages).
+//
+// - churn, small objects Put over and over, checked after remounting,
+//   reporting erases and the longest operation
+// - Puts of unchanged values, which should program nothing
+// - power lost at every program and erase of a run with compactions,
+//   checking each key is left with its last value or the one in flight
+// - settings updated every 10 ms from an Evm timer, written behind, to
+//   see how many writes coalescing saves
+//
+// Flash time is modeled from W25Q16JV typical figures, on the simulated
+// clock.
+
+
+static const uint32_t ERASE_US          = 45'000;  // per 4 KB sector
+static const uint32_t PAGE_PROG_US      =    400;  // per 256 byte page
+
+static const uint32_t BLOCK_COUNT       = 2;
+static const uint16_t KEY_COUNT         = 8;
+static const uint32_t CHURN_PUTS        = 5'000;
+static const uint32_t POWER_LOSS_PUTS   = 300;
+static const uint32_t UPDATE_MS         = 10;
+static const uint32_t UPDATE_DURATION_MS = 10'000;
+
+static bool pass_ = true;
+
+
+// what's stored, the seq decides the rest, so any value can be checked
+struct Value
+{
+    uint32_t seq = 0;
+    uint8_t  data[56] = {};
+
+    static Value Make(uint32_t seq)
+    {
+        Value retVal;
+
+        retVal.seq = seq;
+        memset(retVal.data, (int)(seq * 7 + 1), sizeof(retVal.data));
+
+        return retVal;
+    }
+
+    bool IsIntact() const
+    {
+        return *this == Make(seq);
+    }
+
+    bool operator==(const Value &) const = default;
+};
+
+
+static void Check(bool ok, const char *what)
+{
+    if (ok == false)
+    {
+        Log("  FAILED: ", what);
+        pass_ = false;
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Devices
+////////////////////////////////////////////////////////////////////////////////
+
+// the RAM device, with programs and erases taking their modeled time on the
+// simulated clock
+static FilesystemBlockDevice MakeTimedBlockDevice(FilesystemBlockDeviceRam &ram)
+{
+    FilesystemBlockDevice retVal = ram.GetBlockDevice();
+
+    auto fnProg  = retVal.fnProg;
+    auto fnErase = retVal.fnErase;
+
+    retVal.fnProg = [=](uint32_t block, uint32_t off, const void *buf, uint32_t size){
+        HostSim::AdvanceUs((uint64_t)PAGE_PROG_US * size / 256);
+
+        return fnProg(block, off, buf, size);
+    };
+    retVal.fnErase = [=](uint32_t block){
+        HostSim::AdvanceUs(ERASE_US);
+
+        return fnErase(block);
+    };
+
+    return retVal;
+}
+
+// the RAM device, which loses power on the given program or erase.  that
+// one is left half done, and nothing after it happens.
+static FilesystemBlockDevice MakeFailingBlockDevice(FilesystemBlockDeviceRam &ram, uint32_t opFail, uint32_t &opCount)
+{
+    FilesystemBlockDevice retVal = ram.GetBlockDevice();
+
+    auto fnProg  = retVal.fnProg;
+    auto fnErase = retVal.fnErase;
+
+    retVal.fnProg = [=, &opCount](uint32_t block, uint32_t off, const void *buf, uint32_t size){
+        ++opCount;
+
+        if (opCount == opFail)
+        {
+            // the first half of the page(s) programmed
+            vector<uint8_t> torn(size, 0xFF);
+            memcpy(torn.data(), buf, size / 2);
+            fnProg(block, off, torn.data(), size);
+        }
+
+        return opCount < opFail && fnProg(block, off, buf, size);
+    };
+    retVal.fnErase = [=, &ram, &opCount](uint32_t block){
+        ++opCount;
+
+        if (opCount == opFail)
+        {
+            // the first half of the block erased
+            FilesystemBlockDevice dev = ram.GetBlockDevice();
+            vector<uint8_t> image = ram.GetImage();
+            memset(&image[block * dev.blockSize], 0xFF, dev.blockSize / 2);
+
+            ram.EraseAll();
+            for (uint32_t b = 0; b < dev.blockCount; ++b)
+            {
+                dev.fnProg(b, 0, &image[b * dev.blockSize], dev.blockSize);
+            }
+        }
+
+        return opCount < opFail && fnErase(block);
+    };
+
+    return retVal;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Churn
+////////////////////////////////////////////////////////////////////////////////
+
+static void Churn()
+{
+    Log("Churn (", KEY_COUNT, " x ", sizeof(Value), " byte values, ", Commas(CHURN_PUTS), " Puts)");
+
+    FilesystemBlockDeviceRam ram(BLOCK_COUNT);
+
+    FlashKvLog kv;
+    Check(kv.Init(MakeTimedBlockDevice(ram)), "Init");
+    kv.ResetStats();
+
+    uint64_t timeStartUs = HostSim::GetTimeUs();
+
+    for (uint32_t i = 0; i < CHURN_PUTS; ++i)
+    {
+        Value v = Value::Make(i);
+
+        Check(kv.Put((uint16_t)(i % KEY_COUNT), &v, sizeof(v)), "Put");
+    }
+
+    uint64_t durationUs = HostSim::GetTimeUs() - timeStartUs;
+
+    // the last Put of each is what's read back, after remounting
+    FlashKvLog kvRemount;
+    Check(kvRemount.Init(ram.GetBlockDevice()), "remount");
+
+    for (uint16_t key = 0; key < KEY_COUNT; ++key)
+    {
+        Value v;
+
+        Check(kvRemount.Get(key, &v, sizeof(v)) && v == Value::Make(CHURN_PUTS - KEY_COUNT + key), "read back");
+    }
+
+    Check(ram.GetProgOverDataCount() == 0, "programs over unerased data");
+
+    const FlashKvLog::Stats &stats = kv.GetStats();
+
+    Log("  appends      : ", Commas(stats.appends));
+    Log("  compactions  : ", Commas(stats.compactions));
+    Log("  erases       : ", Commas(stats.erases), " (", FormatStr("%.1f", (double)CHURN_PUTS / stats.erases), " Puts per erase)");
+    Log("  prog KB      : ", Commas(stats.progBytes / 1024));
+    Log("  flash ms     : ", Commas(durationUs / 1'000));
+    Log("  max op ms    : ", Commas(stats.opUsMax / 1'000));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Unchanged Puts
+////////////////////////////////////////////////////////////////////////////////
+
+static void Unchanged()
+{
+    Log("Unchanged Puts");
+
+    FilesystemBlockDeviceRam ram(BLOCK_COUNT);
+
+    FlashKvLog kv;
+    Check(kv.Init(ram.GetBlockDevice()), "Init");
+
+    Value v = Value::Make(1);
+    Check(kv.Put(1, &v, sizeof(v)), "Put");
+    kv.ResetStats();
+
+    for (uint32_t i = 0; i < 1'000; ++i)
+    {
+        Check(kv.Put(1, &v, sizeof(v)), "Put");
+    }
+
+    Log("  appends      : ", kv.GetStats().appends, " for 1,000 Puts");
+
+    Check(kv.GetStats().appends == 0 && kv.GetStats().progBytes == 0, "unchanged Puts programmed");
+
+    // deleted keys stay deleted
+    Check(kv.Delete(1) && kv.GetSize(1) == -1, "Delete");
+
+    FlashKvLog kvRemount;
+    Check(kvRemount.Init(ram.GetBlockDevice()) && kvRemount.GetSize(1) == -1, "Delete after remount");
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Power Loss
+////////////////////////////////////////////////////////////////////////////////
+
+static void PowerLoss()
+{
+    Log("Power loss at each program and erase of ", POWER_LOSS_PUTS, " Puts");
+
+    // count the operations the run takes
+    uint32_t opTotal = 0;
+    {
+        FilesystemBlockDeviceRam ram(BLOCK_COUNT);
+        FlashKvLog kv;
+        kv.Init(MakeFailingBlockDevice(ram, UINT32_MAX, opTotal));
+        opTotal = 0;
+
+        for (uint32_t i = 0; i < POWER_LOSS_PUTS; ++i)
+        {
+            Value v = Value::Make(i);
+            kv.Put((uint16_t)(i % KEY_COUNT), &v, sizeof(v));
+        }
+    }
+
+    uint32_t recovered = 0;
+
+    for (uint32_t opFail = 1; opFail <= opTotal; ++opFail)
+    {
+        FilesystemBlockDeviceRam ram(BLOCK_COUNT);
+
+        // committed value by key, and the one being written when power went
+        map<uint16_t, uint32_t> committed;
+        uint16_t keyInFlight = 0;
+        uint32_t seqInFlight = 0;
+
+        {
+            uint32_t opCount = 0;
+            FlashKvLog kv;
+            kv.Init(ram.GetBlockDevice());
+            kv.Init(MakeFailingBlockDevice(ram, opFail, opCount));
+
+            for (uint32_t i = 0; i < POWER_LOSS_PUTS; ++i)
+            {
+                Value v = Value::Make(i);
+                keyInFlight = (uint16_t)(i % KEY_COUNT);
+                seqInFlight = i;
+
+                if (kv.Put(keyInFlight, &v, sizeof(v)) == false)
+                {
+                    break;
+                }
+
+                committed[keyInFlight] = i;
+            }
+        }
+
+        // power back
+        FlashKvLog kv;
+        bool ok = kv.Init(ram.GetBlockDevice());
+
+        for (uint16_t key = 0; ok && key < KEY_COUNT; ++key)
+        {
+            Value v;
+            bool found = kv.Get(key, &v, sizeof(v));
+
+            if (found)
+            {
+                bool isCommitted = committed.contains(key) && v.seq == committed[key];
+                bool isInFlight  = key == keyInFlight && v.seq == seqInFlight;
+
+                ok = v.IsIntact() && (isCommitted || isInFlight);
+            }
+            else
+            {
+                ok = committed.contains(key) == false;
+            }
+        }
+
+        // and still usable
+        for (uint32_t i = 0; ok && i < 100; ++i)
+        {
+            Value v = Value::Make(1'000 + i);
+
+            ok = kv.Put((uint16_t)(i % KEY_COUNT), &v, sizeof(v));
+        }
+
+        if (ok)
+        {
+            ++recovered;
+        }
+        else
+        {
+            Log("  FAILED at operation ", opFail);
+            pass_ = false;
+        }
+    }
+
+    Log("  recovered    : ", recovered, " of ", opTotal);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Write Behind
+////////////////////////////////////////////////////////////////////////////////
+
+static void WriteBehind()
+{
+    Log("Write behind (", KEY_COUNT / 2, " settings updated every ", UPDATE_MS, " ms for ", Commas(UPDATE_DURATION_MS), " ms)");
+
+    FilesystemBlockDeviceRam ram(BLOCK_COUNT);
+
+    FlashKvLog kv;
+    Check(kv.Init(MakeTimedBlockDevice(ram)), "Init");
+    kv.ResetStats();
+    FlashWriteBehind::ResetStats();
+
+    uint32_t seq = 0;
+    map<uint16_t, uint32_t> latest;
+
+    Timer timerUpdate("BENCH_TIMER_UPDATE");
+    timerUpdate.SetCallback([&]{
+        Value v = Value::Make(seq);
+        uint16_t key = (uint16_t)(seq % (KEY_COUNT / 2));
+
+        FlashWriteBehind::Queue("kv/" + to_string(key), &v, sizeof(v), [&kv, key](const vector<uint8_t> &data){
+            return kv.Put(key, data.data(), (uint16_t)data.size());
+        });
+
+        // seen straight away, before being written
+        Value vPending;
+        Check(FlashWriteBehind::GetPending("kv/" + to_string(key), &vPending, sizeof(vPending)) && vPending == v, "GetPending");
+
+        latest[key] = seq;
+        ++seq;
+    });
+    timerUpdate.TimeoutIntervalMs(UPDATE_MS);
+
+    // let the queue drain
+    Timer timerDrain("BENCH_TIMER_DRAIN");
+    timerDrain.SetCallback([&]{
+        if (FlashWriteBehind::GetPendingCount() == 0)
+        {
+            timerDrain.Cancel();
+            Evm::ExitMainLoop();
+        }
+    });
+
+    Timer timerStop("BENCH_TIMER_STOP");
+    timerStop.SetCallback([&]{
+        timerUpdate.Cancel();
+        timerDrain.TimeoutIntervalMs(100);
+    });
+    timerStop.TimeoutInMs(UPDATE_DURATION_MS);
+
+    Evm::MainLoop();
+
+    for (const auto &[key, seqLatest] : latest)
+    {
+        Value v;
+
+        Check(kv.Get(key, &v, sizeof(v)) && v == Value::Make(seqLatest), "latest value written");
+    }
+
+    const FlashWriteBehind::Stats &stats = FlashWriteBehind::GetStats();
+
+    Log("  queued       : ", Commas(stats.queued));
+    Log("  coalesced    : ", Commas(stats.coalesced));
+    Log("  written      : ", Commas(stats.written));
+    Log("  failed       : ", Commas(stats.failed));
+    Log("  erases       : ", Commas(kv.GetStats().erases));
+    Log("  max write us : ", Commas(stats.writeUsMax));
+
+    Check(stats.failed == 0 && stats.written < stats.queued / 10, "coalescing");
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Main
+////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+    Evm::DisableAutoLogAsync();
+
+    Log("FlashKvLog Host Benchmark");
+    LogNL();
+
+    Churn();
+    LogNL();
+
+    Unchanged();
+    LogNL();
+
+    PowerLoss();
+    LogNL();
+
+    WriteBehind();
+    LogNL();
+
+    Log(pass_ ? "PASS" : "FAIL");
+
+    return pass_ ? 0 : 1;
+}
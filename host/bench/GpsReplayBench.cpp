@@ -0,0 +1,416 @@
+#include "Log.h"
+#include "NMEAStringMaker.h"
+#include "Shell.h"
+#include "UART.h"
+#include "Utl.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+// expects the above, as where it's used in an application
+#include "GPS.h"
+
+
+// Host benchmark of GPSReader, in CPU time per fix, replaying the same
+// flight as NMEA text and as UBX binary.
+//
+// Each 1 second epoch is what a module puts out for a 3D fix with 20 GPS
+// and 10 BeiDou satellites in view:
+// - NMEA: GGA, GSA, GSV (5 GP, 3 BD), RMC, VTG
+// - UBX:  NAV-PVT, NAV-SAT, NAV-DOP
+//
+// NMEA lines are handed to ReadLine as the line stream would, UBX bytes
+// go through UbxMessageParser::AddBytes in UART sized chunks to ReadUbx.
+//
+// Timed both for acquisition alone and with a Fix3DPlus callback set, as
+// an application tracking position would, after which the last fix from
+// each path is compared.
+//
+// Heap allocations are counted by replacing the global operator new.
+
+
+static const uint32_t EPOCH_COUNT = 3'600;
+static const size_t   CHUNK_SIZE  = 64;
+
+static uint64_t allocCount_ = 0;
+
+void *operator new(size_t size)
+{
+    ++allocCount_;
+
+    void *p = malloc(size ? size : 1);
+    if (p == nullptr)
+    {
+        throw bad_alloc();
+    }
+
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+static uint64_t NowNs()
+{
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Input
+////////////////////////////////////////////////////////////////////////////////
+
+struct Epoch
+{
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+
+    int32_t latDegE7;
+    int32_t lngDegE7;
+    int32_t altitudeMm;
+    int32_t speedMmPerSec;
+    int32_t courseDegE5;
+};
+
+struct Sat
+{
+    uint8_t gnssId;
+    uint8_t id;
+    int8_t  elevation;
+    int16_t azimuth;
+    uint8_t cno;
+};
+
+static Epoch MakeEpoch(uint32_t i)
+{
+    uint32_t secs = 12 * 3600 + i;
+
+    // climbing and drifting east-north-east
+    return {
+        .hour          = (uint8_t)(secs / 3600),
+        .minute        = (uint8_t)(secs / 60 % 60),
+        .second        = (uint8_t)(secs % 60),
+        .latDegE7      = 407412345 + (int32_t)i * 37,
+        .lngDegE7      = -740339778 + (int32_t)i * 91,
+        .altitudeMm    = 120'000 + (int32_t)i * 4'100,
+        .speedMmPerSec = 11'300 + (int32_t)(i % 50) * 10,
+        .courseDegE5   = 6'750'000 + (int32_t)(i % 100) * 1'000,
+    };
+}
+
+static vector<Sat> MakeSatList()
+{
+    vector<Sat> satList;
+
+    for (uint8_t i = 0; i < 20; ++i)
+    {
+        satList.push_back({ UbxNavSat::Block::GNSS_GPS, (uint8_t)(i + 1), (int8_t)(5 + i * 4), (int16_t)(i * 17), (uint8_t)(20 + i) });
+    }
+    for (uint8_t i = 0; i < 10; ++i)
+    {
+        satList.push_back({ UbxNavSat::Block::GNSS_BEIDOU, (uint8_t)(i + 11), (int8_t)(10 + i * 7), (int16_t)(i * 33), (uint8_t)(25 + i) });
+    }
+
+    return satList;
+}
+
+template <typename... Args>
+static string Format(const char *fmt, Args... args)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), fmt, args...);
+
+    return buf;
+}
+
+// ddmm.mmmmm or dddmm.mmmmm
+static string ToNmeaDegMin(int32_t degE7, uint8_t degDigits)
+{
+    uint32_t val = (uint32_t)abs(degE7);
+
+    uint32_t deg         = val / 10'000'000;
+    uint64_t minHundredK = ((uint64_t)(val % 10'000'000) * 60 + 50) / 100;
+
+    return Format(degDigits == 2 ? "%02u%02u.%05u" : "%03u%02u.%05u",
+                  deg, (uint32_t)(minHundredK / 100'000), (uint32_t)(minHundredK % 100'000));
+}
+
+static vector<string> MakeNmeaEpoch(const Epoch &e, const vector<Sat> &satList)
+{
+    vector<string> lineList;
+
+    string time = Format("%02u%02u%02u.000", e.hour, e.minute, e.second);
+    string lat  = ToNmeaDegMin(e.latDegE7, 2);
+    string lng  = ToNmeaDegMin(e.lngDegE7, 3);
+    string ns   = e.latDegE7 < 0 ? "S" : "N";
+    string ew   = e.lngDegE7 < 0 ? "W" : "E";
+
+    string altitude   = Format("%.1f", e.altitudeMm / 1'000.0);
+    string speedKnots = Format("%.3f", e.speedMmPerSec / 514.444);
+    string course     = Format("%.2f", e.courseDegE5 / 100'000.0);
+
+    lineList.push_back(NMEAStringMaker::Make({ "GNGGA", time, lat, ns, lng, ew, "1", "14", "0.9", altitude, "M", "-34.4", "M", "", "" }));
+    lineList.push_back(NMEAStringMaker::Make({ "GNGSA", "A", "3", "01", "02", "03", "04", "05", "06", "07", "08", "09", "10", "11", "12", "1.6", "0.9", "1.3" }));
+
+    for (auto [talker, gnssId] : { pair{ "GP", UbxNavSat::Block::GNSS_GPS }, pair{ "BD", UbxNavSat::Block::GNSS_BEIDOU } })
+    {
+        vector<const Sat *> talkerSatList;
+        for (const auto &sat : satList)
+        {
+            if (sat.gnssId == gnssId)
+            {
+                talkerSatList.push_back(&sat);
+            }
+        }
+
+        size_t lineCount = (talkerSatList.size() + 3) / 4;
+        for (size_t l = 0; l < lineCount; ++l)
+        {
+            vector<string> dataList = {
+                string{talker} + "GSV", to_string(lineCount), to_string(l + 1), to_string(talkerSatList.size())
+            };
+
+            for (size_t j = l * 4; j < min(l * 4 + 4, talkerSatList.size()); ++j)
+            {
+                const Sat &sat = *talkerSatList[j];
+
+                dataList.push_back(Format("%02u", sat.id));
+                dataList.push_back(Format("%02u", sat.elevation));
+                dataList.push_back(Format("%03u", sat.azimuth));
+                dataList.push_back(Format("%02u", sat.cno));
+            }
+
+            lineList.push_back(NMEAStringMaker::Make(dataList));
+        }
+    }
+
+    lineList.push_back(NMEAStringMaker::Make({ "GNRMC", time, "A", lat, ns, lng, ew, speedKnots, course, "180526", "", "", "A", "V" }));
+    lineList.push_back(NMEAStringMaker::Make({ "GNVTG", course, "T", "", "M", speedKnots, "N", Format("%.3f", e.speedMmPerSec * 0.0036), "K", "A" }));
+
+    return lineList;
+}
+
+static void AppendUbx(vector<uint8_t> &stream, uint8_t msgClass, uint8_t msgId, const vector<uint8_t> &payload)
+{
+    vector<uint8_t> msg = { 0xB5, 0x62, msgClass, msgId, (uint8_t)(payload.size() & 0xFF), (uint8_t)(payload.size() >> 8) };
+    msg.insert(msg.end(), payload.begin(), payload.end());
+
+    uint8_t ckA = 0;
+    uint8_t ckB = 0;
+    for (size_t i = 2; i < msg.size(); ++i)
+    {
+        ckA = (uint8_t)(ckA + msg[i]);
+        ckB = (uint8_t)(ckB + ckA);
+    }
+    msg.push_back(ckA);
+    msg.push_back(ckB);
+
+    stream.insert(stream.end(), msg.begin(), msg.end());
+}
+
+template <typename T>
+static void Put(vector<uint8_t> &payload, size_t idx, T val)
+{
+    memcpy(&payload[idx], &val, sizeof(val));
+}
+
+static vector<uint8_t> MakeUbxEpoch(const Epoch &e, const vector<Sat> &satList)
+{
+    vector<uint8_t> stream;
+
+    uint32_t iTOW = (uint32_t)(e.hour * 3600 + e.minute * 60 + e.second) * 1'000;
+
+    vector<uint8_t> pvt(UbxNavPvt::PAYLOAD_BYTES, 0);
+    Put<uint32_t>(pvt,  0, iTOW);
+    Put<uint16_t>(pvt,  4, 2026);
+    pvt[6]  = 5;
+    pvt[7]  = 18;
+    pvt[8]  = e.hour;
+    pvt[9]  = e.minute;
+    pvt[10] = e.second;
+    pvt[11] = UbxNavPvt::VALID_DATE | UbxNavPvt::VALID_TIME | UbxNavPvt::FULLY_RESOLVED;
+    Put<int32_t>(pvt, 16, 0);
+    pvt[20] = UbxNavPvt::FIX_3D;
+    pvt[21] = UbxNavPvt::FLAG_GNSS_FIX_OK;
+    pvt[23] = 14;
+    Put<int32_t>(pvt, 24, e.lngDegE7);
+    Put<int32_t>(pvt, 28, e.latDegE7);
+    Put<int32_t>(pvt, 32, e.altitudeMm - 34'400);
+    Put<int32_t>(pvt, 36, e.altitudeMm);
+    Put<int32_t>(pvt, 60, e.speedMmPerSec);
+    Put<int32_t>(pvt, 64, e.courseDegE5);
+    Put<uint16_t>(pvt, 76, 160);
+    AppendUbx(stream, UbxNavPvt::CLASS, UbxNavPvt::ID, pvt);
+
+    vector<uint8_t> sat(UbxNavSat::PAYLOAD_BYTES + satList.size() * sizeof(UbxNavSat::Block), 0);
+    Put<uint32_t>(sat, 0, iTOW);
+    sat[4] = 1;
+    sat[5] = (uint8_t)satList.size();
+    for (size_t i = 0; i < satList.size(); ++i)
+    {
+        size_t idx = UbxNavSat::PAYLOAD_BYTES + i * sizeof(UbxNavSat::Block);
+        sat[idx + 0] = satList[i].gnssId;
+        sat[idx + 1] = satList[i].id;
+        sat[idx + 2] = satList[i].cno;
+        sat[idx + 3] = (uint8_t)satList[i].elevation;
+        Put<int16_t>(sat, idx + 4, satList[i].azimuth);
+        Put<uint32_t>(sat, idx + 8, i < 14 ? UbxNavSat::Block::FLAG_SV_USED : 0);
+    }
+    AppendUbx(stream, UbxNavSat::CLASS, UbxNavSat::ID, sat);
+
+    vector<uint8_t> dop(UbxNavDop::PAYLOAD_BYTES, 0);
+    Put<uint32_t>(dop, 0, iTOW);
+    Put<uint16_t>(dop, 12, 90);
+    AppendUbx(stream, UbxNavDop::CLASS, UbxNavDop::ID, dop);
+
+    return stream;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Benchmark
+////////////////////////////////////////////////////////////////////////////////
+
+// fnEpoch replays one epoch into the reader
+template <typename Fn>
+static void Bench(const char *title, GPSReader &reader, uint64_t bytesPerEpoch, Fn fnEpoch)
+{
+    uint64_t fixCount = 0;
+    reader.SetCallbackOnFix3DPlus([&](const Fix3DPlus &){ ++fixCount; });
+
+    for (bool withCallback : { false, true })
+    {
+        if (withCallback == false)
+        {
+            reader.UnSetCallbackOnFix3DPlus();
+        }
+        else
+        {
+            reader.SetCallbackOnFix3DPlus([&](const Fix3DPlus &){ ++fixCount; });
+        }
+
+        reader.Reset();
+        fixCount = 0;
+
+        uint64_t fixEpochCount = 0;
+
+        uint64_t allocCountStart = allocCount_;
+        uint64_t durationNs      = 0;
+        for (uint32_t i = 0; i < EPOCH_COUNT; ++i)
+        {
+            HostSim::AdvanceUs(1'000'000);
+
+            uint64_t timeStartNs = NowNs();
+            fnEpoch(i);
+            durationNs += NowNs() - timeStartNs;
+
+            fixEpochCount += reader.HasFix3DPlus();
+        }
+        uint64_t allocs = allocCount_ - allocCountStart;
+
+        Log(title, withCallback ? ", with Fix3DPlus callback" : ", acquisition only");
+        Log("  epochs         : ", Commas(EPOCH_COUNT), " (", Commas(bytesPerEpoch), " bytes each)");
+        Log("  epochs w/ fix  : ", Commas(fixEpochCount));
+        if (withCallback)
+        {
+            Log("  callbacks      : ", Commas(fixCount));
+        }
+        Log("  ns / fix       : ", Commas(durationNs / (fixEpochCount ? fixEpochCount : 1)));
+        Log("  allocs / epoch : ", (double)allocs / EPOCH_COUNT);
+    }
+
+    reader.UnSetCallbackOnFix3DPlus();
+}
+
+static void LogFix(const char *title, const Fix3DPlus &fix)
+{
+    Log(title, ": ", fix.dateTime,
+        " lat ", fix.latDegMillionths, " lng ", fix.lngDegMillionths, " ", fix.maidenheadGrid,
+        " alt ", fix.altitudeM, "m spd ", fix.speedKnots, "kt crs ", fix.courseDegrees,
+        " sats ", fix.satsUsedCount, " hdop ", fix.hdop,
+        " GP ", fix.satDataGPList.size(), " BD ", fix.satDataBDList.size());
+}
+
+int main()
+{
+    Log("GPSReader Replay Benchmark");
+    LogNL();
+
+    vector<Sat> satList = MakeSatList();
+
+    vector<vector<string>>  nmeaEpochList;
+    vector<vector<uint8_t>> ubxEpochList;
+    for (uint32_t i = 0; i < EPOCH_COUNT; ++i)
+    {
+        Epoch e = MakeEpoch(i);
+
+        nmeaEpochList.push_back(MakeNmeaEpoch(e, satList));
+        ubxEpochList.push_back(MakeUbxEpoch(e, satList));
+    }
+
+    uint64_t nmeaBytes = 0;
+    for (const auto &line : nmeaEpochList[0])
+    {
+        nmeaBytes += line.size() + 2;
+    }
+    uint64_t ubxBytes = ubxEpochList[0].size();
+
+    GPSReader readerNmea;
+    readerNmea.DisableVerboseLogging();
+    Bench("NMEA (ReadLine)", readerNmea, nmeaBytes, [&](uint32_t i){
+        for (const auto &line : nmeaEpochList[i])
+        {
+            readerNmea.ReadLine(line);
+        }
+    });
+    LogNL();
+
+    GPSReader readerUbx;
+    readerUbx.DisableVerboseLogging();
+    UbxMessageParser p;
+    Bench("UBX (AddBytes + ReadUbx)", readerUbx, ubxBytes, [&](uint32_t i){
+        const vector<uint8_t> &stream = ubxEpochList[i];
+
+        for (size_t idx = 0; idx < stream.size(); idx += CHUNK_SIZE)
+        {
+            span<const uint8_t> byteList{ &stream[idx], min(CHUNK_SIZE, stream.size() - idx) };
+
+            while (byteList.size())
+            {
+                byteList = byteList.subspan(p.AddBytes(byteList));
+
+                if (p.MessageFound())
+                {
+                    readerUbx.ReadUbx(p);
+
+                    p.Reset();
+                }
+                else if (p.ErrorEncountered())
+                {
+                    p.Reset();
+                }
+            }
+        }
+    });
+    LogNL();
+
+    LogFix("Last NMEA fix", readerNmea.GetFix3DPlus());
+    LogFix("Last UBX  fix", readerUbx.GetFix3DPlus());
+
+    return 0;
+}
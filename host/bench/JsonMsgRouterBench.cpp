@@ -0,0 +1,237 @@
+#include "JSON.h"
+#include "JSONMsgRouter.h"
+#include "Log.h"
+#include "Utl.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+
+// Host benchmark of JSON message routing, in messages per second.
+//
+// Compares the old JSONMsgRouter::OnLine, which parsed into a fresh
+// 5000 byte DynamicJsonDocument, compared the type against each registered
+// handler in turn, allocated another document for the reply, and measured
+// then serialized it into a std::string, against the current one, with
+// both a std::string and a std::string_view receive callback.
+//
+// Handlers are registered for a realistic number of types, and the
+// messages routed are a mix of ones replied to by their handler and ones
+// auto-ACKed.  Heap allocations are counted by replacing the global
+// operator new.  On target, json.bench and usb.cdc0.json.bench do the same
+// without and with the USB CDC transport.
+
+
+static const uint32_t MSG_COUNT     = 200'000;
+static const uint32_t HANDLER_COUNT = 40;
+
+static const vector<string> MSG_LIST = {
+    R"({"type":"REQ_PING"})",
+    R"({"type":"REQ_TYPE_39","a":1,"b":"two","c":[3,4,5]})",
+    R"({"type":"REQ_TYPE_20","value":12345})",
+    R"({"type":"REQ_PINGX"})",
+};
+
+static uint64_t allocCount_ = 0;
+
+void *operator new(size_t size)
+{
+    ++allocCount_;
+
+    void *p = malloc(size ? size : 1);
+    if (p == nullptr)
+    {
+        throw bad_alloc();
+    }
+
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+static uint64_t NowNs()
+{
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// The router as it was, for comparison
+////////////////////////////////////////////////////////////////////////////////
+
+class JSONMsgRouterOld
+{
+    static const uint8_t OBSERVED_EMPTY_MESSAGE_SIZE = 4;
+
+    using Handler = function<void(const JsonObject &in, JsonObject &out)>;
+
+    struct HandlerData
+    {
+        string  type;
+        Handler cbHandle;
+    };
+
+public:
+
+    void RegisterHandler(string type, Handler cbHandle)
+    {
+        handlerDataList_.push_back({type, cbHandle});
+    }
+
+    void OnLine(const string &jsonStr, function<void(const string &)> cbFnOnReceive)
+    {
+        auto [ok, inJsonDoc] = JSON::DeSerialize(jsonStr);
+        auto inJson = inJsonDoc.as<JsonObject>();
+
+        if (ok && inJson.containsKey("type"))
+        {
+            const char *typeStr = inJson["type"];
+
+            auto outJsonDoc = JSON::GetObj();
+            auto outJson = outJsonDoc.to<JsonObject>();
+
+            bool replySent = false;
+            bool handled   = false;
+
+            for (auto &[type, cbHandle] : handlerDataList_)
+            {
+                if (type == typeStr)
+                {
+                    cbHandle(inJson, outJson);
+
+                    size_t size = measureJson(outJsonDoc);
+                    if (size > OBSERVED_EMPTY_MESSAGE_SIZE)
+                    {
+                        cbFnOnReceive(JSON::Serialize(outJsonDoc));
+
+                        replySent = true;
+                    }
+
+                    handled = true;
+                    break;
+                }
+            }
+
+            if (handled && replySent == false)
+            {
+                outJson["type"] = "ACK";
+                outJson["inType"] = inJson["type"];
+                cbFnOnReceive(JSON::Serialize(outJsonDoc));
+            }
+        }
+    }
+
+private:
+
+    vector<HandlerData> handlerDataList_;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Benchmark
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename Fn>
+static void RegisterHandlers(Fn fnRegister)
+{
+    // the registration order puts the common types late, as in an
+    // application whose own handlers come after the library's
+    for (uint32_t i = 0; i < HANDLER_COUNT; ++i)
+    {
+        fnRegister("REQ_TYPE_" + to_string(i), [](const JsonObject &in, JsonObject &out){});
+    }
+
+    fnRegister("REQ_PING", [](const JsonObject &in, JsonObject &out){
+        out["type"] = "REP_PING";
+        out["timeNow"] = 1234567890123ull;
+    });
+
+    fnRegister("REQ_PINGX", [](const JsonObject &in, JsonObject &out){
+        out["type"] = "REP_PINGX";
+        out["timeNow"] = 1234567890123ull;
+    });
+}
+
+template <typename Fn>
+static void Bench(const char *title, Fn fnRoute, const uint64_t &replyBytes)
+{
+    uint64_t allocCountStart = allocCount_;
+
+    uint64_t timeStartNs = NowNs();
+    for (uint32_t i = 0; i < MSG_COUNT; ++i)
+    {
+        fnRoute(MSG_LIST[i % MSG_LIST.size()]);
+    }
+    uint64_t durationNs = NowNs() - timeStartNs;
+
+    uint64_t allocs = allocCount_ - allocCountStart;
+
+    Log(title);
+    Log("  messages     : ", Commas(MSG_COUNT));
+    Log("  ns / msg     : ", durationNs / MSG_COUNT);
+    Log("  msgs / s     : ", Commas(durationNs ? (uint64_t)MSG_COUNT * 1'000'000'000 / durationNs : 0));
+    Log("  allocs / msg : ", (double)allocs / MSG_COUNT);
+    Log("  reply bytes  : ", Commas(replyBytes));
+}
+
+int main()
+{
+    Log("JSONMsgRouter Host Benchmark");
+    LogNL();
+
+    uint64_t replyBytes = 0;
+
+    {
+        JSONMsgRouterOld router;
+        RegisterHandlers([&](string type, auto cbHandle){ router.RegisterHandler(type, cbHandle); });
+
+        auto fnOnReceive = [&](const string &jsonStr){ replyBytes += jsonStr.size(); };
+
+        replyBytes = 0;
+        Bench("Old (linear scan, heap documents, std::string reply)", [&](const string &msg){
+            router.OnLine(msg, fnOnReceive);
+        }, replyBytes);
+    }
+    LogNL();
+
+    RegisterHandlers([&](string type, auto cbHandle){ JSONMsgRouter::RegisterHandler(type, cbHandle); });
+
+    {
+        JSONMsgRouter::Iface iface;
+        iface.SetOnReceiveCallback([&](const string &jsonStr){ replyBytes += jsonStr.size(); });
+
+        replyBytes = 0;
+        Bench("Current, std::string receive callback", [&](const string &msg){
+            iface.Route(msg);
+        }, replyBytes);
+    }
+    LogNL();
+
+    {
+        JSONMsgRouter::Iface iface;
+        iface.SetOnReceiveViewCallback([&](string_view jsonStr){ replyBytes += jsonStr.size(); });
+
+        replyBytes = 0;
+        Bench("Current, std::string_view receive callback", [&](const string &msg){
+            iface.Route(msg);
+        }, replyBytes);
+    }
+    LogNL();
+
+    Log("Pool heap fallbacks: ", JSON::GetPoolHeapFallbackCount());
+
+    return 0;
+}
@@ -0,0 +1,309 @@
+#include "LineStreamDistributor.h"
+#include "Log.h"
+#include "Utl.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+
+// Host benchmark of line assembly and distribution, on the NMEA captures
+// in src/GPS/test.
+//
+// Compares the old LineStreamDistributor, which copied its whole
+// id -> callback map (std::functions included) for every line and grew a
+// std::string by push_back, against the current one, with callbacks taking
+// either a const std::string & or a std::string_view.
+//
+// Input is fed in UART-burst sized chunks to a handful of listeners, the
+// way the GPS and shell see it.  Heap allocations are counted by replacing
+// the global operator new.
+
+
+static const uint32_t PASS_COUNT     = 200;
+static const uint32_t CHUNK_SIZE     = 32;
+static const uint32_t LISTENER_COUNT = 3;
+static const uint16_t MAX_LINE_LEN   = 200;
+
+static const vector<string> FILE_LIST = {
+    "gps.coldstart.txt",
+    "gps.warmstart.txt",
+    "TestInputsFor2MinLock.txt",
+};
+
+static uint64_t allocCount_ = 0;
+
+void *operator new(size_t size)
+{
+    ++allocCount_;
+
+    void *p = malloc(size ? size : 1);
+    if (p == nullptr)
+    {
+        throw bad_alloc();
+    }
+
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+static bool pass_ = true;
+
+static void Check(const char *what, bool ok)
+{
+    pass_ &= ok;
+
+    Log("  ", what, ": ", ok ? "ok" : "FAIL");
+}
+
+static uint64_t NowNs()
+{
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// The distributor as it was, for comparison
+////////////////////////////////////////////////////////////////////////////////
+
+class LineStreamDistributorOld
+{
+public:
+
+    void AddLineStreamCallback(uint8_t id, function<void(const string &line)> cbFn)
+    {
+        id__data_[id] = Data{cbFn, true};
+    }
+
+    void AddData(span<const uint8_t> data)
+    {
+        if (id__data_.empty()) { return; }
+
+        for (size_t i = 0; i < data.size(); ++i)
+        {
+            char c = (char)data[i];
+
+            if (c == '\n' || c == '\r' || inputStream_.size() == MAX_LINE_LEN)
+            {
+                bool wasMaxLine = inputStream_.size() == MAX_LINE_LEN;
+
+                auto tmp = id__data_;
+                for (auto &[id, data] : tmp)
+                {
+                    if (inputStream_.size() || data.hideBlankLines == false)
+                    {
+                        data.cbFn(inputStream_);
+                    }
+                }
+
+                inputStream_.clear();
+
+                if (wasMaxLine)
+                {
+                    for (; i < data.size(); ++i)
+                    {
+                        if (data[i] == '\n')
+                        {
+                            break;
+                        }
+                    }
+                }
+            }
+            else if ((isprint(c) || c == ' ' || c == '\t'))
+            {
+                inputStream_.push_back(c);
+            }
+        }
+    }
+
+
+private:
+
+    struct Data
+    {
+        function<void(const string &)> cbFn;
+        bool hideBlankLines = true;
+    };
+
+    unordered_map<uint8_t, Data> id__data_;
+    string inputStream_;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Benchmark
+////////////////////////////////////////////////////////////////////////////////
+
+static vector<uint8_t> LoadInput()
+{
+    vector<uint8_t> byteList;
+
+    for (const auto &fileName : FILE_LIST)
+    {
+        string path = string(PICO_INF_GPS_TEST_DIR) + "/" + fileName;
+
+        ifstream file(path, ios::binary);
+        if (!file)
+        {
+            Log("Could not open ", path);
+            exit(1);
+        }
+
+        byteList.insert(byteList.end(), istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    }
+
+    return byteList;
+}
+
+template <typename Dist>
+static void Bench(const char *title, const vector<uint8_t> &input, Dist &dist, const uint64_t &lineCount, const uint64_t &checksum)
+{
+    uint64_t allocCountStart = allocCount_;
+
+    uint64_t timeStartNs = NowNs();
+    for (uint32_t pass = 0; pass < PASS_COUNT; ++pass)
+    {
+        for (size_t i = 0; i < input.size(); i += CHUNK_SIZE)
+        {
+            size_t len = input.size() - i < CHUNK_SIZE ? input.size() - i : CHUNK_SIZE;
+
+            dist.AddData({ &input[i], len });
+        }
+    }
+    uint64_t durationNs = NowNs() - timeStartNs;
+
+    uint64_t allocs = allocCount_ - allocCountStart;
+    uint64_t lines  = lineCount / LISTENER_COUNT;
+
+    Log(title);
+    Log("  lines         : ", Commas(lines));
+    Log("  ns / line     : ", lines ? durationNs / lines : 0);
+    Log("  lines / s     : ", Commas(durationNs ? lines * 1'000'000'000 / durationNs : 0));
+    Log("  allocs / line : ", lines ? (double)allocs / (double)lines : 0.0);
+    Log("  checksum      : ", checksum);
+}
+
+// Callbacks removing themselves, and adding others, while being called.
+// Removed ones aren't called again, added ones start with the next line.
+static void CheckCallbackChanges()
+{
+    Log("Callback changes during distribution");
+
+    LineStreamDistributor dist(UART::UART_1, MAX_LINE_LEN, "CHECK");
+
+    // all but the reserved id 0
+    uint8_t addCount = 0;
+    vector<uint8_t> idList;
+    while (true)
+    {
+        auto [ok, id] = dist.AddLineStreamViewCallback([](string_view){});
+        if (ok == false)
+        {
+            break;
+        }
+
+        idList.push_back(id);
+        ++addCount;
+    }
+    for (uint8_t id : idList)
+    {
+        dist.RemoveLineStreamCallback(id);
+    }
+    Check("capacity 31 + reserved    ", addCount == 31 && dist.GetCallbackCount() == 0);
+
+    uint32_t onceCount  = 0;
+    uint32_t addedCount = 0;
+    uint8_t  idOnce     = 0;
+
+    auto [ok, id] = dist.AddLineStreamViewCallback([&](string_view){
+        ++onceCount;
+
+        dist.RemoveLineStreamCallback(idOnce);
+        dist.AddLineStreamViewCallback([&](string_view){ ++addedCount; });
+    });
+    idOnce = id;
+
+    const string text = "a\nb\nc\n";
+    dist.AddData({ (const uint8_t *)text.data(), text.size() });
+
+    Check("removed not called again  ", ok && onceCount == 1);
+    Check("added from the next line  ", addedCount == 2);
+    Check("count                     ", dist.GetCallbackCount() == 1);
+    LogNL();
+}
+
+int main()
+{
+    Log("LineStreamDistributor Host Benchmark");
+    LogNL();
+
+    vector<uint8_t> input = LoadInput();
+    Log("Input: ", Commas(input.size()), " bytes x ", PASS_COUNT, " passes, ", CHUNK_SIZE, " byte chunks, ", LISTENER_COUNT, " listeners");
+    LogNL();
+
+    // listeners do a token amount of work, looking at the talker id
+    uint64_t lineCount = 0;
+    uint64_t checksum  = 0;
+    auto fnLine = [&](string_view line) {
+        ++lineCount;
+        checksum += line.size() > 5 ? (uint8_t)line[3] + line.size() : line.size();
+    };
+
+    {
+        LineStreamDistributorOld dist;
+        for (uint8_t id = 1; id <= LISTENER_COUNT; ++id)
+        {
+            dist.AddLineStreamCallback(id, [&](const string &line){ fnLine(line); });
+        }
+
+        lineCount = checksum = 0;
+        Bench("Old (map copy per line, std::string)", input, dist, lineCount, checksum);
+    }
+    LogNL();
+
+    {
+        LineStreamDistributor dist(UART::UART_1, MAX_LINE_LEN, "BENCH");
+        for (uint8_t id = 1; id <= LISTENER_COUNT; ++id)
+        {
+            dist.AddLineStreamCallback([&](const string &line){ fnLine(line); });
+        }
+
+        lineCount = checksum = 0;
+        Bench("Current, const std::string & callbacks", input, dist, lineCount, checksum);
+    }
+    LogNL();
+
+    {
+        LineStreamDistributor dist(UART::UART_1, MAX_LINE_LEN, "BENCH");
+        for (uint8_t id = 1; id <= LISTENER_COUNT; ++id)
+        {
+            dist.AddLineStreamViewCallback(fnLine);
+        }
+
+        lineCount = checksum = 0;
+        Bench("Current, std::string_view callbacks", input, dist, lineCount, checksum);
+    }
+    LogNL();
+
+    CheckCallbackChanges();
+
+    Log(pass_ ? "PASS" : "FAIL");
+
+    return pass_ ? 0 : 1;
+}
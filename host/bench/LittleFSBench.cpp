@@ -0,0 +1,334 @@
+#include "FilesystemBlockDeviceRam.h"
+#include "FilesystemLittleFS.h"
+#include "Flashable.h"
+#include "HostSim.h"
+#include "Log.h"
+#include "Utl.h"
+
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+// Host benchmark of FilesystemLittleFS on a RAM block device with the
+// geometry of the on-target flash (16 x 4 KB blocks, 256 byte pages).
+//
+// Runs workloads typical of the target:
+// - Flashable churn, small objects Put over and over
+// - an append-only log, a record written and the file closed each time
+// - listing a directory of small files
+//
+// across combinations of cache size, lookahead size and block cycles, and
+// reports the block device operations each causes.
+//
+// Flash time is modeled from typical figures for the W25Q16JV the Pico
+// uses, and advanced on the simulated clock, so FilesystemLittleFS's busy
+// time is what the target would spend with interrupts off.  Wear is the
+// most erases of any one block.
+//
+// Usage: LittleFSBench [<image file to save the last filesystem to>]
+
+
+static const uint32_t ERASE_US          = 45'000;  // per 4 KB sector
+static const uint32_t PAGE_PROG_US      =    400;  // per 256 byte page
+static const uint32_t READ_NS_PER_BYTE  =     60;  // XIP, uncached
+
+static const uint32_t FLASHABLE_COUNT   = 8;
+static const uint32_t FLASHABLE_PUTS    = 1'000;
+static const uint32_t LOG_RECORDS       = 2'000;
+static const uint32_t LOG_RECORD_SIZE   = 48;
+static const uint32_t LOG_MAX_SIZE      = 8 * 1024;
+static const uint32_t DIR_FILE_COUNT    = 24;
+static const uint32_t DIR_LISTS         = 500;
+
+static bool pass_ = true;
+
+
+struct Settings
+{
+    uint32_t seq = 0;
+    uint8_t  data[60] = {};
+};
+
+struct Workload
+{
+    const char     *name;
+    function<bool()> fn;
+};
+
+struct Result
+{
+    FilesystemLittleFS::Config cfg;
+    const char *workload = "";
+
+    FilesystemLittleFS::Stats stats;
+    uint32_t eraseMaxBlock = 0;
+    uint64_t modelUs       = 0;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Workloads
+////////////////////////////////////////////////////////////////////////////////
+
+static bool FlashableChurn()
+{
+    vector<Flashable<Settings>> objList;
+    for (uint32_t i = 0; i < FLASHABLE_COUNT; ++i)
+    {
+        objList.emplace_back((int32_t)(100 + i));
+    }
+
+    for (uint32_t i = 0; i < FLASHABLE_PUTS; ++i)
+    {
+        Flashable<Settings> &obj = objList[i % FLASHABLE_COUNT];
+
+        obj.seq = i;
+        memset(obj.data, (int)(i & 0xFF), sizeof(obj.data));
+
+        if (obj.Put() == false)
+        {
+            return false;
+        }
+    }
+
+    // the last Put of each is what's read back
+    for (uint32_t i = 0; i < FLASHABLE_COUNT; ++i)
+    {
+        Flashable<Settings> obj((int32_t)(100 + i));
+
+        uint32_t seqExpected = FLASHABLE_PUTS - FLASHABLE_COUNT + i;
+
+        if (obj.Get() == false || obj.seq != seqExpected || obj.data[0] != (uint8_t)seqExpected)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool AppendLog()
+{
+    static const char *PATH = "log.txt";
+
+    uint32_t size = 0;
+
+    for (uint32_t i = 0; i < LOG_RECORDS; ++i)
+    {
+        if (size + LOG_RECORD_SIZE > LOG_MAX_SIZE)
+        {
+            FilesystemLittleFS::Remove(PATH);
+            size = 0;
+        }
+
+        string record = FormatStr("%08u ", i);
+        record.resize(LOG_RECORD_SIZE - 1, 'x');
+        record += '\n';
+
+        auto f = FilesystemLittleFS::GetFile(PATH);
+        if (f.Open(LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND) == false)
+        {
+            return false;
+        }
+
+        bool ok = f.Write(record);
+        f.Close();
+
+        if (ok == false)
+        {
+            return false;
+        }
+
+        size += LOG_RECORD_SIZE;
+    }
+
+    FilesystemLittleFS::DirEnt dirEnt;
+
+    return FilesystemLittleFS::Stat(PATH, dirEnt) && dirEnt.size == size;
+}
+
+static bool DirList()
+{
+    FilesystemLittleFS::MkDir("/d");
+
+    for (uint32_t i = 0; i < DIR_FILE_COUNT; ++i)
+    {
+        if (FilesystemLittleFS::Write("/d/f" + to_string(i), "value " + to_string(i)) == false)
+        {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < DIR_LISTS; ++i)
+    {
+        vector<FilesystemLittleFS::DirEnt> dirEntList;
+
+        if (FilesystemLittleFS::List("/d", dirEntList) == false || dirEntList.size() != DIR_FILE_COUNT)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Harness
+////////////////////////////////////////////////////////////////////////////////
+
+// the RAM device, with programs and erases taking their modeled time on the
+// simulated clock
+static FilesystemBlockDevice MakeTimedBlockDevice(FilesystemBlockDeviceRam &ram)
+{
+    FilesystemBlockDevice retVal = ram.GetBlockDevice();
+
+    auto fnProg  = retVal.fnProg;
+    auto fnErase = retVal.fnErase;
+
+    retVal.fnProg = [=](uint32_t block, uint32_t off, const void *buf, uint32_t size){
+        HostSim::AdvanceUs((uint64_t)PAGE_PROG_US * size / 256);
+
+        return fnProg(block, off, buf, size);
+    };
+    retVal.fnErase = [=](uint32_t block){
+        HostSim::AdvanceUs(ERASE_US);
+
+        return fnErase(block);
+    };
+
+    return retVal;
+}
+
+static Result Run(FilesystemBlockDeviceRam &ram, const FilesystemLittleFS::Config &cfg, const Workload &workload)
+{
+    Result retVal;
+
+    retVal.cfg      = cfg;
+    retVal.workload = workload.name;
+
+    // fresh filesystem each time
+    ram.EraseAll();
+    if (FilesystemLittleFS::Init(MakeTimedBlockDevice(ram), cfg) == false)
+    {
+        Log("Init failed");
+        pass_ = false;
+
+        return retVal;
+    }
+    FilesystemLittleFS::ResetStats();
+
+    if (workload.fn() == false)
+    {
+        Log("Workload ", workload.name, " FAILED");
+        pass_ = false;
+    }
+
+    retVal.stats = FilesystemLittleFS::GetStats();
+    for (auto eraseCount : FilesystemLittleFS::GetEraseCountList())
+    {
+        retVal.eraseMaxBlock = max(retVal.eraseMaxBlock, eraseCount);
+    }
+    retVal.modelUs = retVal.stats.busyUs + retVal.stats.readBytes * READ_NS_PER_BYTE / 1'000;
+
+    if (ram.GetProgOverDataCount())
+    {
+        Log("Programs over unerased data: ", ram.GetProgOverDataCount());
+        pass_ = false;
+    }
+
+    return retVal;
+}
+
+static void LogHeader()
+{
+    Log(" cache  look cycles | erases  wear    prog KB    read KB |  flash ms  max op ms");
+    Log("--------------------+-------------------------------------+--------------------");
+}
+
+static void LogResult(const Result &r)
+{
+    Log(FormatStr("%6u", r.cfg.cacheSize),
+        FormatStr("%6u", r.cfg.lookaheadSize),
+        FormatStr("%7d", r.cfg.blockCycles),
+        " |",
+        FormatStr("%7u", r.stats.erases),
+        FormatStr("%6u", r.eraseMaxBlock),
+        FormatStr("%11s", Commas(r.stats.progBytes / 1024).c_str()),
+        FormatStr("%11s", Commas(r.stats.readBytes / 1024).c_str()),
+        " |",
+        FormatStr("%10s", Commas(r.modelUs / 1'000).c_str()),
+        FormatStr("%11s", Commas(r.stats.busyUsMax / 1'000).c_str()));
+}
+
+int main(int argc, char *argv[])
+{
+    Log("LittleFS Host Benchmark");
+    LogNL();
+
+    vector<Workload> workloadList = {
+        { "Flashable churn (8 objects, 1,000 Puts)",           FlashableChurn },
+        { "Append log (2,000 x 48 byte records, close each)", AppendLog      },
+        { "Directory listing (24 files, 500 lists)",          DirList        },
+    };
+
+    vector<FilesystemLittleFS::Config> cfgList;
+    for (uint32_t cacheSize : { 128u, 256u, 512u, 1024u })
+    {
+        for (uint32_t lookaheadSize : { 16u, 64u })
+        {
+            for (int32_t blockCycles : { 16, 32, 500 })
+            {
+                cfgList.push_back({ cacheSize, lookaheadSize, blockCycles });
+            }
+        }
+    }
+
+    FilesystemBlockDeviceRam ram;
+
+    for (const auto &workload : workloadList)
+    {
+        Log(workload.name);
+        LogHeader();
+
+        vector<Result> resultList;
+        for (const auto &cfg : cfgList)
+        {
+            resultList.push_back(Run(ram, cfg, workload));
+            LogResult(resultList.back());
+        }
+        LogNL();
+
+        const Result *fastest = &resultList[0];
+        const Result *leastWear = &resultList[0];
+        for (const auto &r : resultList)
+        {
+            if (r.modelUs < fastest->modelUs)
+            {
+                fastest = &r;
+            }
+            if (r.eraseMaxBlock < leastWear->eraseMaxBlock)
+            {
+                leastWear = &r;
+            }
+        }
+
+        Log("Fastest:");
+        LogResult(*fastest);
+        Log("Least wear:");
+        LogResult(*leastWear);
+        LogNL();
+    }
+
+    if (argc >= 2)
+    {
+        Log("Saving image to ", argv[1], ": ", ram.SaveImage(argv[1]) ? "OK" : "FAILED");
+    }
+
+    Log(pass_ ? "PASS" : "FAIL");
+
+    return pass_ ? 0 : 1;
+}
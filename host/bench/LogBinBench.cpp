@@ -0,0 +1,118 @@
+#include "Log.h"
+#include "LogBin.h"
+#include "Utl.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+using namespace std;
+
+
+// Host benchmark of the binary log hot path.
+//
+// Compares what Log("a ", x, " b ", y) spends formatting (one FormatStrC,
+// ie snprintf, per value, the UART send excluded) against LogBin with the
+// same values, which only copies them into the ring.
+//
+// Then records one of each kind of argument and writes the ring, sync
+// record first, to LogBinBench.bin, to be decoded against this executable:
+//   utl/LogBinDecoder.py --bin build-host/LogBinBench LogBinBench.bin
+
+
+static const uint32_t CALL_COUNT = 2'000'000;
+
+static uint64_t NowNs()
+{
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void Report(const char *title, uint64_t durationNs)
+{
+    Log(title);
+    Log("  calls      : ", Commas(CALL_COUNT));
+    Log("  ns / call  : ", (double)durationNs / CALL_COUNT);
+}
+
+static void BenchFormat()
+{
+    char buf[64];
+    uint64_t checksum = 0;
+
+    uint64_t timeStartNs = NowNs();
+    for (uint32_t i = 0; i < CALL_COUNT; ++i)
+    {
+        checksum += (uint64_t)FormatStrC(buf, sizeof(buf), "%u", i).second;
+        checksum += (uint64_t)FormatStrC(buf, sizeof(buf), "%u", CALL_COUNT).second;
+    }
+    uint64_t durationNs = NowNs() - timeStartNs;
+
+    Report("Log formatting (2 x uint32_t)", durationNs);
+    Log("  checksum   : ", checksum);
+}
+
+static void BenchLogBin()
+{
+    uint8_t buf[512];
+
+    uint64_t timeStartNs = NowNs();
+    for (uint32_t i = 0; i < CALL_COUNT; ++i)
+    {
+        LogBin("a %u b %u", i, CALL_COUNT);
+
+        // keep the ring from filling, as a reader would
+        if ((i & 0x0F) == 0x0F)
+        {
+            LogBinRead(buf, sizeof(buf));
+        }
+    }
+    uint64_t durationNs = NowNs() - timeStartNs;
+
+    Report("LogBin (2 x uint32_t, including draining)", durationNs);
+    Log("  dropped    : ", Commas(LogBinGetDroppedCount()));
+}
+
+static void WriteSample()
+{
+    LogBinClear();
+
+    LogBin("LogBinBench sample");
+    LogBin("u32 %u, i32 %d, hex 0x%08X", 123456789u, -42, 0xDEADBEEF);
+    LogBin("u64 %" PRIu64 ", i64 %" PRId64, (uint64_t)12345678901234ull, (int64_t)-12345678901234ll);
+    LogBin("double %.3f, char %c, str %s", 3.14159, 'x', "in the ELF");
+    LogBin("bool %u, i8 %d, u16 %u, %%", true, (int8_t)-5, (uint16_t)65535);
+
+    FILE *fp = fopen("LogBinBench.bin", "wb");
+    if (fp)
+    {
+        uint8_t buf[64];
+
+        uint8_t len = LogBinMakeSyncRecord(buf, sizeof(buf));
+        fwrite(buf, 1, len, fp);
+
+        uint32_t lenRead;
+        while ((lenRead = LogBinRead(buf, sizeof(buf))))
+        {
+            fwrite(buf, 1, lenRead, fp);
+        }
+
+        fclose(fp);
+
+        Log("Sample written to LogBinBench.bin");
+    }
+}
+
+int main()
+{
+    Log("LogBin Host Benchmark");
+    LogNL();
+
+    BenchFormat();
+    LogNL();
+
+    BenchLogBin();
+    LogNL();
+
+    WriteSample();
+
+    return 0;
+}
@@ -0,0 +1,225 @@
+#include "Log.h"
+#include "NMEAStringParser.h"
+#include "NMEATokenizer.h"
+#include "Shell.h"
+#include "UART.h"
+#include "Utl.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+// expects the above, as where it's used in an application
+#include "GPS.h"
+
+
+// Host benchmark of NMEA sentence handling, on the captures in src/GPS/test.
+//
+// Compares the old tokenizing, NMEAStringParser::IsValid followed by
+// GetLineDataPartList (which validates again and Splits into strings) and
+// atoi/atof on the fields, against NMEATokenizer with ToUInt/ToFixed.
+//
+// Then times the whole of GPSReader::ReadLine, which is built on the
+// latter.
+//
+// Heap allocations are counted by replacing the global operator new.
+
+
+static const uint32_t PASS_COUNT = 200;
+
+static const vector<string> FILE_LIST = {
+    "gps.coldstart.txt",
+    "TestInputsFor2MinLock.txt",
+};
+
+static uint64_t allocCount_ = 0;
+
+void *operator new(size_t size)
+{
+    ++allocCount_;
+
+    void *p = malloc(size ? size : 1);
+    if (p == nullptr)
+    {
+        throw bad_alloc();
+    }
+
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+static uint64_t NowNs()
+{
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static vector<string> LoadInput()
+{
+    vector<string> lineList;
+
+    for (const auto &fileName : FILE_LIST)
+    {
+        string path = string(PICO_INF_GPS_TEST_DIR) + "/" + fileName;
+
+        ifstream file(path, ios::binary);
+        if (!file)
+        {
+            Log("Could not open ", path);
+            exit(1);
+        }
+
+        string line;
+        while (getline(file, line))
+        {
+            while (line.size() && (line.back() == '\r' || line.back() == '\n'))
+            {
+                line.pop_back();
+            }
+
+            if (line.size())
+            {
+                lineList.push_back(line);
+            }
+        }
+    }
+
+    return lineList;
+}
+
+template <typename Fn>
+static void Bench(const char *title, const vector<string> &lineList, Fn fnLine)
+{
+    uint64_t checksum = 0;
+
+    uint64_t allocCountStart = allocCount_;
+
+    uint64_t timeStartNs = NowNs();
+    for (uint32_t pass = 0; pass < PASS_COUNT; ++pass)
+    {
+        for (const auto &line : lineList)
+        {
+            checksum += fnLine(line);
+        }
+    }
+    uint64_t durationNs = NowNs() - timeStartNs;
+
+    uint64_t allocs = allocCount_ - allocCountStart;
+    uint64_t lines  = (uint64_t)lineList.size() * PASS_COUNT;
+
+    Log(title);
+    Log("  lines         : ", Commas(lines));
+    Log("  ns / line     : ", durationNs / lines);
+    Log("  lines / s     : ", Commas(durationNs ? lines * 1'000'000'000 / durationNs : 0));
+    Log("  allocs / line : ", (double)allocs / (double)lines);
+    Log("  checksum      : ", checksum);
+}
+
+int main()
+{
+    Log("NMEA Host Benchmark");
+    LogNL();
+
+    vector<string> lineList = LoadInput();
+    Log("Input: ", Commas(lineList.size()), " lines x ", PASS_COUNT, " passes");
+    LogNL();
+
+    // both sides total up the field count, the integer part of every
+    // numeric field, and the valid line count
+    Bench("Old (IsValid + GetLineDataPartList, atoi/atof)", lineList, [](const string &line){
+        uint64_t retVal = 0;
+
+        if (NMEAStringParser::IsValid(line))
+        {
+            vector<string> linePartList = NMEAStringParser::GetLineDataPartList(line);
+
+            retVal += 1 + linePartList.size();
+            for (size_t i = 1; i < linePartList.size(); ++i)
+            {
+                retVal += (uint64_t)(int64_t)atof(linePartList[i].c_str());
+            }
+        }
+
+        return retVal;
+    });
+    LogNL();
+
+    NMEATokenizer nmea;
+    Bench("NMEATokenizer (ToFixed)", lineList, [&](const string &line){
+        uint64_t retVal = 0;
+
+        if (nmea.Tokenize(line))
+        {
+            retVal += 1 + nmea.GetFieldCount();
+            for (uint8_t i = 1; i < nmea.GetFieldCount(); ++i)
+            {
+                int32_t val = 0;
+                if (NMEATokenizer::ToFixed(nmea.GetField(i), 0, val))
+                {
+                    retVal += (uint64_t)(int64_t)val;
+                }
+            }
+        }
+
+        return retVal;
+    });
+    LogNL();
+
+    // feed the bytes through, with the line endings, as from a UART
+    string stream;
+    for (const auto &line : lineList)
+    {
+        stream += line + "\r\n";
+    }
+    {
+        uint64_t sentences = 0;
+
+        uint64_t allocCountStart = allocCount_;
+        uint64_t timeStartNs = NowNs();
+        for (uint32_t pass = 0; pass < PASS_COUNT; ++pass)
+        {
+            for (char c : stream)
+            {
+                sentences += nmea.Feed(c);
+            }
+        }
+        uint64_t durationNs = NowNs() - timeStartNs;
+
+        uint64_t lines = (uint64_t)lineList.size() * PASS_COUNT;
+
+        Log("NMEATokenizer, byte fed");
+        Log("  lines         : ", Commas(lines));
+        Log("  ns / line     : ", durationNs / lines);
+        Log("  lines / s     : ", Commas(durationNs ? lines * 1'000'000'000 / durationNs : 0));
+        Log("  allocs / line : ", (double)(allocCount_ - allocCountStart) / (double)lines);
+        Log("  sentences     : ", Commas(sentences));
+    }
+    LogNL();
+
+    // the simulated clock moves on between lines, as fix state is
+    // timestamped, and the checksum counts lines seen with a 3D fix
+    GPSReader reader;
+    reader.DisableVerboseLogging();
+    Bench("GPSReader::ReadLine", lineList, [&](const string &line){
+        HostSim::AdvanceUs(100'000);
+
+        reader.ReadLine(line);
+
+        return (uint64_t)reader.HasFix3D();
+    });
+
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include "Log.h"
+#include "Utl.h"
+
+#include <cstring>
+#include <vector>
+using namespace std;
+
+// the I2C here is the register file stand-in in fake/
+#include "si5351.h"
+
+
+// Host check of Si5351 prepared frequency switches.
+//
+// Two devices are brought up the same way, then one is switched with
+// set_freq, and the other with prepare_freq and set_freq_prepared.  Their
+// whole register files have to come out the same, and the clock's recorded
+// frequency too.
+//
+// Switches are from a frequency running on CLK0, to each of the 4 WSPR
+// tones above it (1.46 Hz apart), and on to the next frequency in the list,
+// which changes the multisynth divider and, at the bottom, the R divider.
+//
+// The I2C transactions each way are counted.
+//
+// Exits non-zero on any mismatch.
+
+
+static const uint8_t  ADDR_SET      = 0x60;
+static const uint8_t  ADDR_PREPARED = 0x61;
+static const uint32_t XO_FREQ       = 26'000'000;
+
+// Hz
+static const vector<uint64_t> FREQ_LIST = {
+         8'000,
+        10'000,
+        50'000,
+       137'500,
+       475'700,
+     1'836'600,
+     3'568'600,
+     7'038'600,
+    10'138'700,
+    14'095'600,
+    18'104'600,
+    21'094'600,
+    24'924'600,
+    28'124'600,
+    50'293'000,
+    70'091'000,
+    99'000'000,
+};
+
+// Hz * 100
+static const uint64_t TONE_SPACING = 146;
+
+static bool pass_ = true;
+
+static void Check(const char *what, bool ok)
+{
+    pass_ &= ok;
+
+    if (!ok)
+    {
+        Log("  ", what, ": FAIL");
+    }
+}
+
+struct Counts
+{
+    uint32_t switches = 0;
+    uint32_t reads    = 0;
+    uint32_t writes   = 0;
+};
+
+static Counts countsSet_;
+static Counts countsPrepared_;
+
+// Switches both devices from where they are to freq, each its own way, and
+// compares the result
+static void Switch(Si5351 &radioSet, Si5351 &radioPrepared, uint64_t freq)
+{
+    uint32_t readCount  = I2C::GetReadCount();
+    uint32_t writeCount = I2C::GetWriteCount();
+
+    radioSet.set_freq(freq, SI5351_CLK0);
+
+    ++countsSet_.switches;
+    countsSet_.reads  += I2C::GetReadCount()  - readCount;
+    countsSet_.writes += I2C::GetWriteCount() - writeCount;
+
+    // prepared ahead of time, not counted
+    Si5351MsRegBlock block;
+    Check("prepare_freq", radioPrepared.prepare_freq(freq, SI5351_CLK0, &block) == 0);
+
+    readCount  = I2C::GetReadCount();
+    writeCount = I2C::GetWriteCount();
+
+    Check("set_freq_prepared", radioPrepared.set_freq_prepared(SI5351_CLK0, block) == 0);
+
+    ++countsPrepared_.switches;
+    countsPrepared_.reads  += I2C::GetReadCount()  - readCount;
+    countsPrepared_.writes += I2C::GetWriteCount() - writeCount;
+
+    bool same = memcmp(I2C::GetRegList(ADDR_SET), I2C::GetRegList(ADDR_PREPARED), 256) == 0;
+    if (!same)
+    {
+        for (uint16_t reg = 0; reg < 256; ++reg)
+        {
+            uint8_t valSet      = I2C::GetRegList(ADDR_SET)[reg];
+            uint8_t valPrepared = I2C::GetRegList(ADDR_PREPARED)[reg];
+
+            if (valSet != valPrepared)
+            {
+                Log("  ", Commas(freq / SI5351_FREQ_MULT), " Hz reg ", reg, ": set_freq ", valSet, ", prepared ", valPrepared);
+            }
+        }
+    }
+
+    Check("registers", same);
+    Check("clk_freq", radioSet.clk_freq[SI5351_CLK0] == radioPrepared.clk_freq[SI5351_CLK0]);
+}
+
+static void CheckFreqList()
+{
+    for (size_t i = 0; i < FREQ_LIST.size(); ++i)
+    {
+        uint64_t freq = FREQ_LIST[i] * SI5351_FREQ_MULT;
+
+        I2C::Reset();
+
+        Si5351 radioSet(ADDR_SET);
+        Si5351 radioPrepared(ADDR_PREPARED);
+
+        for (Si5351 *radio : { &radioSet, &radioPrepared })
+        {
+            radio->init(SI5351_CRYSTAL_LOAD_8PF, XO_FREQ, 0);
+            radio->set_freq(freq, SI5351_CLK0);
+        }
+
+        bool passBefore = pass_;
+
+        for (uint64_t tone = 1; tone <= 4; ++tone)
+        {
+            Switch(radioSet, radioPrepared, freq + tone * TONE_SPACING);
+        }
+
+        if (i + 1 < FREQ_LIST.size())
+        {
+            Switch(radioSet, radioPrepared, FREQ_LIST[i + 1] * SI5351_FREQ_MULT);
+        }
+
+        Log(StrUtl::PadLeft(Commas(FREQ_LIST[i]), ' ', 10), " Hz: ", pass_ == passBefore ? "ok" : "FAIL");
+    }
+}
+
+int main()
+{
+    Log("Si5351 Prepared Switch Host Check");
+    LogNL();
+
+    CheckFreqList();
+    LogNL();
+
+    for (auto [name, counts] : { pair{ "set_freq         ", countsSet_ }, pair{ "set_freq_prepared", countsPrepared_ } })
+    {
+        Log(name, ": ", Commas(counts.switches), " switches, ",
+            (double)counts.reads  / counts.switches, " reads, ",
+            (double)counts.writes / counts.switches, " writes per switch");
+    }
+    LogNL();
+
+    Log(pass_ ? "PASS" : "FAIL");
+
+    return pass_ ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+#include "Log.h"
+#include "Utl.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+using namespace std;
+
+#include "SignalMixer.h"
+#include "SignalOscillator.h"
+#include "SignalSourceSineWave.h"
+
+
+// Host benchmark of SignalOscillator sample generation at audio rates.
+//
+// Compares a sample at a time through GetNextSample(), as the design was,
+// against FillBuffer() with the signal source called through the pointer
+// set at runtime, and inlined as a template parameter.  All must give the
+// same samples.
+//
+// Then times mixing several oscillators into a buffer of PWM levels, as
+// PWMAudio would be fed.
+
+
+static const uint32_t SAMPLE_RATE    = 44'100;
+static const uint32_t BLOCK_SIZE     = 256;
+static const uint32_t BLOCK_COUNT    = 20'000;
+static const uint8_t  MIX_COUNT      = 4;
+
+static uint64_t NowNs()
+{
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void Configure(SignalOscillator &o, double frequency, int8_t phaseOffset = 0)
+{
+    o.SetSignalSource(SignalSourceSineWave::GetSample);
+    o.SetSampleRate((uint16_t)SAMPLE_RATE);
+    o.SetFrequency(frequency);
+    o.SetPhaseOffset(phaseOffset);
+    o.Reset();
+}
+
+template <typename Fn>
+static uint64_t Bench(const char *title, Fn fnBlock)
+{
+    uint64_t checksum = 0;
+
+    uint64_t timeStartNs = NowNs();
+    for (uint32_t block = 0; block < BLOCK_COUNT; ++block)
+    {
+        checksum += fnBlock();
+    }
+    uint64_t durationNs = NowNs() - timeStartNs;
+
+    uint64_t samples = (uint64_t)BLOCK_COUNT * BLOCK_SIZE;
+    uint64_t samplesPerSec = durationNs ? samples * 1'000'000'000 / durationNs : 0;
+
+    Log(title);
+    Log("  samples       : ", Commas(samples));
+    Log("  ns / sample   : ", (double)durationNs / (double)samples);
+    Log("  samples / s   : ", Commas(samplesPerSec));
+    Log("  x 44.1 kHz    : ", samplesPerSec / SAMPLE_RATE);
+    Log("  checksum      : ", checksum);
+
+    return checksum;
+}
+
+static uint64_t Sum(const int8_t *buf)
+{
+    uint64_t retVal = 0;
+
+    for (uint32_t i = 0; i < BLOCK_SIZE; ++i)
+    {
+        retVal += (uint8_t)buf[i];
+    }
+
+    return retVal;
+}
+
+int main()
+{
+    Log("Signal Host Benchmark");
+    LogNL();
+
+    bool ok = true;
+
+    // same output, sample for sample, however it's generated
+    {
+        SignalOscillator o1, o2, o3;
+        Configure(o1, 440.0, 17);
+        Configure(o2, 440.0, 17);
+        Configure(o3, 440.0, 17);
+
+        int8_t buf2[BLOCK_SIZE];
+        int8_t buf3[BLOCK_SIZE];
+
+        uint32_t mismatchCount = 0;
+        for (uint32_t block = 0; block < 100; ++block)
+        {
+            o2.FillBuffer(buf2, BLOCK_SIZE);
+            o3.FillBuffer<SignalSourceSineWave::GetSample>(buf3, BLOCK_SIZE);
+
+            for (uint32_t i = 0; i < BLOCK_SIZE; ++i)
+            {
+                int8_t sample = o1.GetNextSample();
+
+                mismatchCount += sample != buf2[i] || sample != buf3[i];
+            }
+        }
+
+        Log("Block against per-sample output: ", mismatchCount, " mismatches");
+        LogNL();
+
+        ok = mismatchCount == 0;
+    }
+
+    int8_t buf[BLOCK_SIZE];
+
+    SignalOscillator o;
+    Configure(o, 440.0);
+    uint64_t checksum1 = Bench("GetNextSample, source through pointer", [&]{
+        for (uint32_t i = 0; i < BLOCK_SIZE; ++i)
+        {
+            buf[i] = o.GetNextSample();
+        }
+
+        return Sum(buf);
+    });
+    LogNL();
+
+    Configure(o, 440.0);
+    uint64_t checksum2 = Bench("FillBuffer, source through pointer", [&]{
+        o.FillBuffer(buf, BLOCK_SIZE);
+
+        return Sum(buf);
+    });
+    LogNL();
+
+    Configure(o, 440.0);
+    uint64_t checksum3 = Bench("FillBuffer<SignalSourceSineWave::GetSample>", [&]{
+        o.FillBuffer<SignalSourceSineWave::GetSample>(buf, BLOCK_SIZE);
+
+        return Sum(buf);
+    });
+    LogNL();
+
+    ok = ok && checksum1 == checksum2 && checksum1 == checksum3;
+
+    // a chord, as PWM levels
+    SignalOscillator oList[MIX_COUNT];
+    const double FREQ_LIST[MIX_COUNT] = { 261.63, 329.63, 392.00, 523.25 };
+    for (uint8_t i = 0; i < MIX_COUNT; ++i)
+    {
+        Configure(oList[i], FREQ_LIST[i]);
+    }
+
+    int16_t  mix[BLOCK_SIZE];
+    uint16_t levelList[BLOCK_SIZE];
+    Bench("Mix of 4, MixIntoBuffer<> + ToLevels", [&]{
+        SignalMixer::Clear(mix, BLOCK_SIZE);
+        for (auto &oMix : oList)
+        {
+            oMix.MixIntoBuffer<SignalSourceSineWave::GetSample>(mix, BLOCK_SIZE);
+        }
+        SignalMixer::ToLevels(mix, levelList, BLOCK_SIZE, MIX_COUNT);
+
+        uint64_t retVal = 0;
+        for (uint16_t level : levelList)
+        {
+            ok = ok && level <= 255;
+
+            retVal += level;
+        }
+
+        return retVal;
+    });
+    LogNL();
+
+    Log(ok ? "PASS" : "FAIL");
+
+    return ok ? 0 : 1;
+}
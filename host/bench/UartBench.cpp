@@ -0,0 +1,150 @@
+#include "ByteRing.h"
+#include "KMessagePassing.h"
+#include "Log.h"
+#include "Utl.h"
+
+#include <chrono>
+#include <cstring>
+using namespace std;
+
+
+// Host benchmark of the UART async output queueing.
+//
+// Compares the old path, a KMessagePipe<char> with one queue operation per
+// byte on each side, against the ByteRing, written in log-line sized chunks
+// and drained the way the UART IRQ does (contiguous Peek / Consume).
+//
+// Only the queueing is measured, there is no hardware here, and the host
+// queue shim has no real critical sections, so the gap on target (where
+// each FreeRTOS queue op enters and exits a critical section) is wider.
+
+
+static const uint32_t TOTAL_BYTES = 50'000'000;
+static const uint32_t CHUNK_SIZE  = 64;
+static const uint32_t QUEUE_SIZE  = 4096;
+static const uint32_t FIFO_SIZE   = 32;    // bytes the IRQ drains per visit
+
+static uint64_t NowNs()
+{
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void Report(const char *title, uint64_t durationNs, uint64_t checksum)
+{
+    uint64_t bytesPerSec = durationNs ? (uint64_t)TOTAL_BYTES * 1'000'000'000 / durationNs : 0;
+
+    Log(title);
+    Log("  bytes      : ", Commas(TOTAL_BYTES));
+    Log("  ns / byte  : ", (double)durationNs / TOTAL_BYTES);
+    Log("  bytes / s  : ", Commas(bytesPerSec));
+    Log("  checksum   : ", checksum);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// KMessagePipe, byte at a time
+////////////////////////////////////////////////////////////////////////////////
+
+static void BenchPipe()
+{
+    static KMessagePipe<char, QUEUE_SIZE> pipe;
+
+    char chunk[CHUNK_SIZE];
+    memset(chunk, 'a', CHUNK_SIZE);
+
+    uint64_t checksum = 0;
+
+    uint64_t timeStartNs = NowNs();
+    for (uint32_t sent = 0; sent < TOTAL_BYTES; sent += CHUNK_SIZE)
+    {
+        pipe.Put(chunk, CHUNK_SIZE, 0);
+
+        // drain as the IRQ would, a FIFO's worth at a time
+        while (pipe.Count())
+        {
+            for (uint32_t i = 0; i < FIFO_SIZE; ++i)
+            {
+                char ch;
+                if (!pipe.Get(ch, 0))
+                {
+                    break;
+                }
+
+                checksum += (uint8_t)ch;
+            }
+        }
+    }
+    uint64_t durationNs = NowNs() - timeStartNs;
+
+    Report("KMessagePipe<char> (byte at a time)", durationNs, checksum);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// ByteRing, bulk
+////////////////////////////////////////////////////////////////////////////////
+
+static void BenchRing()
+{
+    alignas(QUEUE_SIZE) static uint8_t buf[QUEUE_SIZE];
+    static ByteRing<QUEUE_SIZE> ring(buf);
+
+    uint8_t chunk[CHUNK_SIZE];
+    memset(chunk, 'a', CHUNK_SIZE);
+
+    uint64_t checksum = 0;
+
+    uint64_t timeStartNs = NowNs();
+    for (uint32_t sent = 0; sent < TOTAL_BYTES; sent += CHUNK_SIZE)
+    {
+        ring.Write(chunk, CHUNK_SIZE);
+
+        // drain as the IRQ would, a FIFO's worth at a time
+        while (ring.Count())
+        {
+            uint32_t fifoSpace = FIFO_SIZE;
+            while (fifoSpace)
+            {
+                auto [ptr, len] = ring.Peek();
+                if (len == 0)
+                {
+                    break;
+                }
+
+                if (len > fifoSpace)
+                {
+                    len = fifoSpace;
+                }
+
+                for (uint32_t i = 0; i < len; ++i)
+                {
+                    checksum += ptr[i];
+                }
+
+                ring.Consume(len);
+                fifoSpace -= len;
+            }
+        }
+    }
+    uint64_t durationNs = NowNs() - timeStartNs;
+
+    Report("ByteRing (bulk write, contiguous drain)", durationNs, checksum);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Main
+////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+    Log("UART Output Host Benchmark");
+    LogNL();
+
+    BenchPipe();
+    LogNL();
+
+    BenchRing();
+
+    return 0;
+}
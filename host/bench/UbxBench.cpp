@@ -0,0 +1,426 @@
+#include "Log.h"
+#include "UART.h"
+#include "Utl.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+using namespace std;
+
+// expects the above, as where it's used in an application
+#include "UbxMessage.h"
+
+
+// Host benchmark of UBX message parsing and decoding.
+//
+// A module putting out NAV-PVT, NAV-SAT (for 30 satellites) and TIM-TP at
+// 10 Hz is simulated by a synthetic byte stream of those, with an ACK and
+// some line noise mixed in.
+//
+// Compares the old UbxMessageParser, which grew a vector per message,
+// erased from its front while hunting for the header, and was decoded by
+// copying into a message object, against the fixed buffer parser with the
+// payload read in place through UbxView, fed both a byte at a time and in
+// chunks as the UART hands them over.
+//
+// Heap allocations are counted by replacing the global operator new.
+
+
+static const uint32_t PASS_COUNT = 20'000;
+static const size_t   CHUNK_SIZE = 64;
+
+static uint64_t allocCount_ = 0;
+
+void *operator new(size_t size)
+{
+    ++allocCount_;
+
+    void *p = malloc(size ? size : 1);
+    if (p == nullptr)
+    {
+        throw bad_alloc();
+    }
+
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+static uint64_t NowNs()
+{
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// The parser as it was, for comparison
+////////////////////////////////////////////////////////////////////////////////
+
+class UbxMessageParserOld
+{
+    enum class State : uint8_t
+    {
+        LOOKING_FOR_HEADER = 0,
+        LOOKING_FOR_CLASS,
+        LOOKING_FOR_ID,
+        LOOKING_FOR_LEN,
+        LOOKING_FOR_CHECKSUM,
+        FOUND,
+        ERR,
+    };
+
+public:
+
+    void Reset()
+    {
+        buf_.clear();
+        stopAtSize_ = 0;
+
+        state_ = State::LOOKING_FOR_HEADER;
+    }
+
+    void AddByte(uint8_t b)
+    {
+        if (state_ == State::FOUND)
+        {
+            state_ = State::ERR;
+        }
+        else if (state_ == State::LOOKING_FOR_HEADER)
+        {
+            buf_.push_back(b);
+
+            if (buf_.size() != 1)
+            {
+                if (buf_[0] == 0xB5 && buf_[1] == 0x62)
+                {
+                    state_ = State::LOOKING_FOR_CLASS;
+                }
+                else
+                {
+                    buf_.erase(buf_.begin());
+                }
+            }
+        }
+        else if (state_ == State::LOOKING_FOR_CLASS || state_ == State::LOOKING_FOR_ID)
+        {
+            buf_.push_back(b);
+
+            state_ = state_ == State::LOOKING_FOR_CLASS ? State::LOOKING_FOR_ID : State::LOOKING_FOR_LEN;
+        }
+        else if (state_ == State::LOOKING_FOR_LEN)
+        {
+            buf_.push_back(b);
+
+            if (buf_.size() == 6)
+            {
+                uint16_t lenBigEndian;
+                char *p = (char *)&lenBigEndian;
+                p[0] = (char)buf_[5];
+                p[1] = (char)buf_[4];
+
+                stopAtSize_ = (uint16_t)(buf_.size() + ntohs(lenBigEndian) + 2);
+
+                state_ = State::LOOKING_FOR_CHECKSUM;
+            }
+        }
+        else if (state_ == State::LOOKING_FOR_CHECKSUM)
+        {
+            buf_.push_back(b);
+
+            if (buf_.size() == stopAtSize_)
+            {
+                uint8_t ckA = 0;
+                uint8_t ckB = 0;
+
+                size_t idxChecksumStart = buf_.size() - 2;
+                for (size_t i = 2; i < idxChecksumStart; ++i)
+                {
+                    ckA = (uint8_t)(ckA + buf_[i]);
+                    ckB = (uint8_t)(ckB + ckA);
+                }
+
+                state_ = (ckA == buf_[idxChecksumStart] && ckB == buf_[idxChecksumStart + 1]) ? State::FOUND : State::ERR;
+            }
+        }
+    }
+
+    bool ErrorEncountered() const { return state_ == State::ERR; }
+    bool MessageFound() const { return state_ == State::FOUND; }
+
+    const vector<uint8_t> &GetData() const { return buf_; }
+
+private:
+
+    vector<uint8_t> buf_;
+    uint16_t stopAtSize_ = 0;
+
+    State state_ = State::LOOKING_FOR_HEADER;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Input
+////////////////////////////////////////////////////////////////////////////////
+
+static void AppendUbx(vector<uint8_t> &stream, uint8_t msgClass, uint8_t msgId, const vector<uint8_t> &payload)
+{
+    vector<uint8_t> msg = { 0xB5, 0x62, msgClass, msgId, (uint8_t)(payload.size() & 0xFF), (uint8_t)(payload.size() >> 8) };
+    msg.insert(msg.end(), payload.begin(), payload.end());
+
+    uint8_t ckA = 0;
+    uint8_t ckB = 0;
+    for (size_t i = 2; i < msg.size(); ++i)
+    {
+        ckA = (uint8_t)(ckA + msg[i]);
+        ckB = (uint8_t)(ckB + ckA);
+    }
+    msg.push_back(ckA);
+    msg.push_back(ckB);
+
+    stream.insert(stream.end(), msg.begin(), msg.end());
+}
+
+template <typename T>
+static void Put(vector<uint8_t> &payload, size_t idx, T val)
+{
+    memcpy(&payload[idx], &val, sizeof(val));
+}
+
+static vector<uint8_t> MakeStream(uint32_t &msgCount)
+{
+    vector<uint8_t> stream;
+
+    msgCount = 0;
+
+    // one second at 10 Hz
+    for (uint32_t epoch = 0; epoch < 10; ++epoch)
+    {
+        uint32_t iTOW = 345'600'000 + epoch * 100;
+
+        vector<uint8_t> pvt(UbxNavPvt::PAYLOAD_BYTES, 0);
+        Put<uint32_t>(pvt,  0, iTOW);
+        Put<uint16_t>(pvt,  4, 2026);
+        pvt[20] = UbxNavPvt::FIX_3D;
+        pvt[23] = 14;
+        Put<int32_t>(pvt, 24, -771'234'567);
+        Put<int32_t>(pvt, 28, 389'876'543);
+        Put<int32_t>(pvt, 36, 123'456);
+        AppendUbx(stream, UbxNavPvt::CLASS, UbxNavPvt::ID, pvt);
+        ++msgCount;
+
+        vector<uint8_t> sat(UbxNavSat::PAYLOAD_BYTES + 30 * sizeof(UbxNavSat::Block), 0);
+        Put<uint32_t>(sat, 0, iTOW);
+        sat[4] = 1;
+        sat[5] = 30;
+        for (uint8_t i = 0; i < 30; ++i)
+        {
+            size_t idx = UbxNavSat::PAYLOAD_BYTES + i * sizeof(UbxNavSat::Block);
+            sat[idx + 0] = i % 3 ? UbxNavSat::Block::GNSS_GPS : UbxNavSat::Block::GNSS_GLONASS;
+            sat[idx + 1] = (uint8_t)(i + 1);
+            sat[idx + 2] = (uint8_t)(20 + i);
+            sat[idx + 3] = (uint8_t)(i * 3);
+            Put<int16_t>(sat, idx + 4, (int16_t)(i * 12));
+            Put<uint32_t>(sat, idx + 8, i < 14 ? UbxNavSat::Block::FLAG_SV_USED : 0);
+        }
+        AppendUbx(stream, UbxNavSat::CLASS, UbxNavSat::ID, sat);
+        ++msgCount;
+
+        vector<uint8_t> tp(UbxTimTp::PAYLOAD_BYTES, 0);
+        Put<uint32_t>(tp, 0, iTOW + 100);
+        Put<uint16_t>(tp, 12, 2400);
+        AppendUbx(stream, UbxTimTp::CLASS, UbxTimTp::ID, tp);
+        ++msgCount;
+
+        // noise between messages
+        stream.push_back(0x00);
+        stream.push_back(0xB5);
+        stream.push_back(0x13);
+    }
+
+    AppendUbx(stream, UbxAckAck::CLASS, UbxAckAck::ID, { 0x06, 0x01 });
+    ++msgCount;
+
+    return stream;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Benchmark
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename Fn>
+static void Bench(const char *title, const vector<uint8_t> &stream, uint32_t msgCount, Fn fnPass)
+{
+    uint64_t checksum = 0;
+
+    uint64_t allocCountStart = allocCount_;
+
+    uint64_t timeStartNs = NowNs();
+    for (uint32_t pass = 0; pass < PASS_COUNT; ++pass)
+    {
+        checksum += fnPass(stream);
+    }
+    uint64_t durationNs = NowNs() - timeStartNs;
+
+    uint64_t allocs = allocCount_ - allocCountStart;
+    uint64_t msgs   = (uint64_t)msgCount * PASS_COUNT;
+    uint64_t bytes  = (uint64_t)stream.size() * PASS_COUNT;
+
+    Log(title);
+    Log("  messages     : ", Commas(msgs));
+    Log("  ns / msg     : ", durationNs / msgs);
+    Log("  ns / byte    : ", (double)durationNs / (double)bytes);
+    Log("  allocs / msg : ", (double)allocs / (double)msgs);
+    Log("  checksum     : ", checksum);
+}
+
+int main()
+{
+    Log("UBX Host Benchmark");
+    LogNL();
+
+    uint32_t msgCount = 0;
+    vector<uint8_t> stream = MakeStream(msgCount);
+    Log("Input: ", msgCount, " messages, ", Commas(stream.size()), " bytes (1 sec at 10 Hz) x ", PASS_COUNT, " passes");
+    LogNL();
+
+    // both sides total up the latitude, satellites used, and pulse week,
+    // and ACKed class/id of every message, as a decoder would read them
+    UbxMessageParserOld pOld;
+    Bench("Old (vector buffer, copy out to decode)", stream, msgCount, [&](const vector<uint8_t> &stream){
+        uint64_t retVal = 0;
+
+        for (uint8_t b : stream)
+        {
+            pOld.AddByte(b);
+
+            if (pOld.MessageFound())
+            {
+                // as UbxMsg<T>(parser) did
+                vector<uint8_t> msg = pOld.GetData();
+                const uint8_t *p = &msg[6];
+
+                if (msg[2] == UbxNavPvt::CLASS && msg[3] == UbxNavPvt::ID)
+                {
+                    retVal += (uint32_t)*(const int32_t *)&p[28];
+                }
+                else if (msg[2] == UbxNavSat::CLASS && msg[3] == UbxNavSat::ID)
+                {
+                    for (uint8_t i = 0; i < p[5]; ++i)
+                    {
+                        retVal += (*(const uint32_t *)&p[8 + i * 12 + 8] & UbxNavSat::Block::FLAG_SV_USED) ? 1 : 0;
+                    }
+                }
+                else if (msg[2] == UbxTimTp::CLASS && msg[3] == UbxTimTp::ID)
+                {
+                    retVal += *(const uint16_t *)&p[12];
+                }
+                else if (msg[2] == UbxAckAck::CLASS && msg[3] == UbxAckAck::ID)
+                {
+                    retVal += (uint16_t)(p[0] << 8 | p[1]);
+                }
+
+                pOld.Reset();
+            }
+            else if (pOld.ErrorEncountered())
+            {
+                pOld.Reset();
+            }
+        }
+
+        return retVal;
+    });
+    LogNL();
+
+    // decode whatever was found, by type, in place
+    UbxMessageParser p;
+    auto fnDecode = [](const UbxMessageParser &p){
+        uint64_t retVal = 0;
+
+        if (UbxView<UbxNavPvt> pvt(p); pvt.Ok())
+        {
+            retVal += (uint32_t)(int32_t)pvt->lat;
+        }
+        else if (UbxView<UbxNavSat> sat(p); sat.Ok())
+        {
+            for (uint16_t i = 0; i < sat.GetBlockCount(); ++i)
+            {
+                retVal += (sat.GetBlock(i).flags & UbxNavSat::Block::FLAG_SV_USED) ? 1 : 0;
+            }
+        }
+        else if (UbxView<UbxTimTp> tp(p); tp.Ok())
+        {
+            retVal += tp->week;
+        }
+        else if (UbxView<UbxAckAck> ack(p); ack.Ok())
+        {
+            retVal += ack->GetClassId();
+        }
+
+        return retVal;
+    };
+
+    Bench("UbxMessageParser::AddByte + UbxView", stream, msgCount, [&](const vector<uint8_t> &stream){
+        uint64_t retVal = 0;
+
+        for (uint8_t b : stream)
+        {
+            p.AddByte(b);
+
+            if (p.MessageFound())
+            {
+                retVal += fnDecode(p);
+
+                p.Reset();
+            }
+            else if (p.ErrorEncountered())
+            {
+                p.Reset();
+            }
+        }
+
+        return retVal;
+    });
+    LogNL();
+
+    // as handed over by the UART, in chunks
+    Bench("UbxMessageParser::AddBytes (64 byte chunks) + UbxView", stream, msgCount, [&](const vector<uint8_t> &stream){
+        uint64_t retVal = 0;
+
+        for (size_t idx = 0; idx < stream.size(); idx += CHUNK_SIZE)
+        {
+            span<const uint8_t> byteList{ &stream[idx], min(CHUNK_SIZE, stream.size() - idx) };
+
+            while (byteList.size())
+            {
+                byteList = byteList.subspan(p.AddBytes(byteList));
+
+                if (p.MessageFound())
+                {
+                    retVal += fnDecode(p);
+
+                    p.Reset();
+                }
+                else if (p.ErrorEncountered())
+                {
+                    p.Reset();
+                }
+            }
+        }
+
+        return retVal;
+    });
+
+    return 0;
+}
@@ -0,0 +1,419 @@
+#include "BitField.h"
+#include "Log.h"
+#include "Utl.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+using namespace std;
+
+// expects the above, as where it's used in an application
+#include "WSPREncoder.h"
+
+
+// Host check and benchmark of WSPR type 1 message encoding.
+//
+// The encoder is first checked against known channel symbol vectors (as
+// given by wsprcode), then against the encoder as it was, on a spread of
+// callsigns, grids and powers.
+//
+// The old encoder re-derived the interleave position of each symbol by
+// scanning the 8-bit bit-reversals, counted parity a bit at a time, and
+// stored tones through BitField accessors.  The new one uses compile-time
+// interleave and sync tables, word-folded parity, and writes each tone once
+// to byte-wide storage.
+//
+// Exits non-zero on any mismatch.
+
+
+static const uint32_t PASS_COUNT = 2'000;
+
+static uint64_t NowNs()
+{
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// The encoder as it was, for comparison
+////////////////////////////////////////////////////////////////////////////////
+
+class WSPREncoderOld
+{
+public:
+
+    static void EncodeType1(const string &callsign, const string &grid, uint8_t powerDbm)
+    {
+        const char *call = callsign.c_str();
+
+        char c6[6];
+        for (uint8_t i = 0; i < 6; i++) c6[i] = ' ';
+
+        uint32_t offset = 0;
+        if (isdigit(call[1]) && !isdigit(call[2])) offset = 1;
+        for (uint32_t i = 0; i < strlen(call); i++) c6[offset + i] = call[i];
+
+        uint32_t c;
+        c  = (uint32_t)chval1(c6[0]); c *= 36;
+        c += (uint32_t)chval1(c6[1]); c *= 10;
+        c += (uint32_t)chval1(c6[2]); c *= 27;
+        c += (uint32_t)chval2(c6[3]); c *= 27;
+        c += (uint32_t)chval2(c6[4]); c *= 27;
+        c += (uint32_t)chval2(c6[5]);
+
+        const char *g4 = grid.c_str();
+        int g = (179 - 10 * (g4[0] - 'A') - (g4[2] - '0')) * 180 + (10 * (g4[1] - 'A')) + (g4[3] - '0');
+        int p = powerDbm + 64;
+
+        BitFieldOwned<50> bf;
+        bf.SetBitRangeAt(0,  c, 28);
+        bf.SetBitRangeAt(28, g, 15);
+        bf.SetBitRangeAt(43, p, 7);
+
+        EncodeTones(bf);
+    }
+
+    static uint8_t GetToneValForSymbol(uint8_t idx)
+    {
+        uint8_t val;
+        bfToneNumList_.GetBitRangeAt((uint16_t)(idx * 2), val, 2);
+
+        return val;
+    }
+
+private:
+
+    static int chval1(int ch)
+    {
+        if (isdigit(ch)) return ch - '0';
+        if (isalpha(ch)) return 10 + toupper(ch) - 'A';
+        if (ch == ' ') return 36;
+
+        return 0;
+    }
+
+    static int chval2(int ch)
+    {
+        if (isalpha(ch)) return toupper(ch) - 'A';
+        if (ch == ' ') return 26;
+
+        return 0;
+    }
+
+    static void EncodeTones(BitField &bitFieldOf50Bits)
+    {
+        uint32_t acc     = 0;
+        uint8_t  idxTone = 0;
+
+        for (uint8_t i = 0; i < 162; ++i)
+        {
+            uint8_t val;
+            bfSync_.GetBitAt(i, val);
+
+            SetToneVal(i, val);
+        }
+
+        for (uint8_t i = 0; i < 50; ++i)
+        {
+            acc <<= 1;
+
+            uint8_t bitVal;
+            bitFieldOf50Bits.GetBitAt(i, bitVal);
+
+            if (bitVal)
+            {
+                acc |= 1;
+            }
+
+            IncrToneVal(GetRdx(idxTone++), (uint8_t)(2 * parity(acc & 0xf2d05351L)));
+            IncrToneVal(GetRdx(idxTone++), (uint8_t)(2 * parity(acc & 0xe4613c47L)));
+        }
+
+        for (uint8_t i = 0; i < 31; ++i)
+        {
+            acc <<= 1;
+
+            IncrToneVal(GetRdx(idxTone++), (uint8_t)(2 * parity(acc & 0xf2d05351L)));
+            IncrToneVal(GetRdx(idxTone++), (uint8_t)(2 * parity(acc & 0xe4613c47L)));
+        }
+    }
+
+    static void SetToneVal(uint8_t idx, uint8_t val)
+    {
+        bfToneNumList_.SetBitRangeAt((uint16_t)(idx * 2), val, 2);
+    }
+
+    static void IncrToneVal(uint8_t idx, uint8_t val)
+    {
+        uint16_t bitIdx = (uint16_t)(idx * 2);
+
+        uint8_t valCurr;
+        bfToneNumList_.GetBitRangeAt(bitIdx, valCurr, 2);
+
+        valCurr = (uint8_t)(valCurr + val);
+
+        bfToneNumList_.SetBitRangeAt(bitIdx, valCurr, 2);
+    }
+
+    static int32_t parity(uint32_t x)
+    {
+        int32_t even = 0;
+        while (x)
+        {
+            even = 1 - even;
+            x = x & (x - 1);
+        }
+        return even;
+    }
+
+    static uint8_t GetRdx(uint8_t idx)
+    {
+        uint8_t i = 0;
+
+        for (uint16_t j = 0; j < 255; j++)
+        {
+            uint8_t indexTemp = (uint8_t)j;
+            uint8_t rev       = 0;
+
+            for (uint8_t k = 0; k < 8; k++)
+            {
+                if (indexTemp & 0x01)
+                {
+                    rev = (uint8_t)(rev | (1 << (7 - k)));
+                }
+                indexTemp = (uint8_t)(indexTemp >> 1);
+            }
+
+            if (rev < 162)
+            {
+                if (i == idx)
+                {
+                    return rev;
+                }
+                else
+                {
+                    i++;
+                }
+            }
+        }
+
+        return 0;
+    }
+
+    inline static const uint8_t syncBitList_[21] = {
+        0b11000000, 0b10001110, 0b00100101, 0b11100000, 0b00100101, 0b00000010, 0b11001101,
+        0b00011010, 0b00011010, 0b10101001, 0b00101100, 0b01101010, 0b00100000, 0b10010011,
+        0b10110011, 0b01000111, 0b00000101, 0b00110000, 0b00011010, 0b11000110, 0b00000000,
+    };
+    inline static const BitField bfSync_{(uint8_t *)syncBitList_, 21};
+
+    inline static uint8_t  toneNumListBuf_[41];
+    inline static BitField bfToneNumList_{toneNumListBuf_, 41};
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Checks
+////////////////////////////////////////////////////////////////////////////////
+
+struct KnownVector
+{
+    const char *callsign;
+    const char *grid;
+    uint8_t     powerDbm;
+    const char *toneList;
+};
+
+// channel symbols, as from wsprcode
+static const vector<KnownVector> KNOWN_VECTOR_LIST = {
+    { "K1ABC", "FN42", 37,
+      "330020001020131222100323133220200032012322002232110233210221321222033030301210212"
+      "032132003323032203020201023021112330231212221332000010320132222202332323320031222" },
+    { "KD2KDD", "FN20", 10,
+      "330202023022313000100303331000222012210320222230310233030001303002031010123030210"
+      "230112023303232223200203223221310330213012023312000212120330202000310301300211200" },
+    { "G4JNT", "IO90", 30,
+      "332200001222333022100121133220200030012100002012112033030201121020213010301012032"
+      "010110221123012223200023201001112112031230003312222012120310022222130121320031222" },
+    { "Q07ABC", "AA00", 0,
+      "312000201220331000102123133000202030010322000210112213012001321000231012103212010"
+      "030312221301210001000223021001130130231210001312000010320330000222130321122233022" },
+};
+
+struct Input
+{
+    string  callsign;
+    string  grid;
+    uint8_t powerDbm;
+};
+
+// 1x and 2x callsigns of every length, over a spread of grids and powers
+static vector<Input> MakeInputList()
+{
+    static const vector<string> CALLSIGN_LIST = {
+        "K1A", "K1AB", "K1ABC", "W9XYZ", "KD2KDD", "VE3ABC", "G4JNT", "Q07ABC", "0Q1AZZ",
+    };
+
+    static const vector<uint8_t> POWER_DBM_LIST = { 0, 3, 7, 10, 13, 17, 20, 23, 27, 30, 33, 37, 40, 43, 47, 50, 53, 57, 60 };
+
+    vector<Input> retVal;
+
+    uint32_t seed = 1;
+    for (const auto &callsign : CALLSIGN_LIST)
+    {
+        for (uint8_t i = 0; i < 20; ++i)
+        {
+            seed = seed * 1'103'515'245 + 12'345;
+
+            string grid;
+            grid += (char)('A' + (seed >> 8)  % 18);
+            grid += (char)('A' + (seed >> 13) % 18);
+            grid += (char)('0' + (seed >> 18) % 10);
+            grid += (char)('0' + (seed >> 23) % 10);
+
+            retVal.push_back({ callsign, grid, POWER_DBM_LIST[(seed >> 27) % POWER_DBM_LIST.size()] });
+        }
+    }
+
+    return retVal;
+}
+
+static string GetToneList()
+{
+    string retVal;
+
+    for (uint8_t i = 0; i < WSPREncoder::SYMBOL_COUNT; ++i)
+    {
+        retVal += (char)('0' + WSPREncoder::GetToneValForSymbol(i));
+    }
+
+    return retVal;
+}
+
+static string GetToneListOld()
+{
+    string retVal;
+
+    for (uint8_t i = 0; i < WSPREncoder::SYMBOL_COUNT; ++i)
+    {
+        retVal += (char)('0' + WSPREncoderOld::GetToneValForSymbol(i));
+    }
+
+    return retVal;
+}
+
+static bool CheckKnownVectors()
+{
+    bool retVal = true;
+
+    for (const auto &kv : KNOWN_VECTOR_LIST)
+    {
+        WSPREncoder::EncodeType1(kv.callsign, kv.grid, kv.powerDbm);
+        string toneList = GetToneList();
+
+        WSPREncoderOld::EncodeType1(kv.callsign, kv.grid, kv.powerDbm);
+        string toneListOld = GetToneListOld();
+
+        bool ok = toneList == kv.toneList && toneListOld == kv.toneList;
+
+        Log("  ", kv.callsign, " ", kv.grid, " ", kv.powerDbm, " : ", ok ? "ok" : "MISMATCH");
+        if (!ok)
+        {
+            Log("    expected : ", kv.toneList);
+            Log("    new      : ", toneList);
+            Log("    old      : ", toneListOld);
+
+            retVal = false;
+        }
+    }
+
+    return retVal;
+}
+
+static bool CheckAgainstOld(const vector<Input> &inputList)
+{
+    uint32_t mismatchCount = 0;
+
+    for (const auto &input : inputList)
+    {
+        WSPREncoder::EncodeType1(input.callsign, input.grid, input.powerDbm);
+        WSPREncoderOld::EncodeType1(input.callsign, input.grid, input.powerDbm);
+
+        if (GetToneList() != GetToneListOld())
+        {
+            Log("  MISMATCH ", input.callsign, " ", input.grid, " ", input.powerDbm);
+
+            ++mismatchCount;
+        }
+    }
+
+    Log("  ", inputList.size(), " inputs, ", mismatchCount, " mismatches");
+
+    return mismatchCount == 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Benchmark
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename Fn>
+static void Bench(const char *title, const vector<Input> &inputList, uint32_t passCount, Fn fnEncode)
+{
+    uint64_t checksum = 0;
+
+    uint64_t timeStartNs = NowNs();
+    for (uint32_t pass = 0; pass < passCount; ++pass)
+    {
+        for (const auto &input : inputList)
+        {
+            checksum += fnEncode(input);
+        }
+    }
+    uint64_t durationNs = NowNs() - timeStartNs;
+
+    uint64_t encodes = (uint64_t)inputList.size() * passCount;
+
+    Log(title);
+    Log("  encodes      : ", Commas(encodes));
+    Log("  ns / encode  : ", durationNs / encodes);
+    Log("  checksum     : ", checksum);
+}
+
+int main()
+{
+    Log("WSPR Encoder Host Check and Benchmark");
+    LogNL();
+
+    bool ok = true;
+
+    Log("Known vectors");
+    ok &= CheckKnownVectors();
+    LogNL();
+
+    vector<Input> inputList = MakeInputList();
+
+    Log("New against old");
+    ok &= CheckAgainstOld(inputList);
+    LogNL();
+
+    // both sides read back a couple of tones, so the encode isn't elided
+    Bench("Old (GetRdx scan, bitwise parity, BitField)", inputList, PASS_COUNT / 20, [](const Input &input){
+        WSPREncoderOld::EncodeType1(input.callsign, input.grid, input.powerDbm);
+
+        return (uint64_t)WSPREncoderOld::GetToneValForSymbol(0) + WSPREncoderOld::GetToneValForSymbol(161);
+    });
+    LogNL();
+
+    Bench("New (interleave table, folded parity)", inputList, PASS_COUNT, [](const Input &input){
+        WSPREncoder::EncodeType1(input.callsign, input.grid, input.powerDbm);
+
+        return (uint64_t)WSPREncoder::GetToneValForSymbol(0) + WSPREncoder::GetToneValForSymbol(161);
+    });
+    LogNL();
+
+    Log(ok ? "PASS" : "FAIL");
+
+    return ok ? 0 : 1;
+}
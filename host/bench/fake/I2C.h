@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+
+// Host stand-in for I2C, for benches of device drivers.
+//
+// Each address is a device with a 256-byte register file, which writes go
+// into and reads come from, with no bus in between.  Transactions are
+// counted, per direction, across all devices.
+//
+// Only the calls the drivers built on the host make are here.
+class I2C
+{
+public:
+
+    enum class Instance : uint8_t
+    {
+        I2C0 = 0,
+        I2C1 = 1,
+    };
+
+    I2C(uint8_t addr, Instance instance = Instance::I2C0)
+    : addr_(addr)
+    {
+        // Nothing to do
+    }
+
+    uint8_t ReadReg8(uint8_t reg, bool stop = true)
+    {
+        ++readCount_;
+
+        return GetRegList(addr_)[reg];
+    }
+
+    uint32_t WriteReg8(uint8_t reg, uint8_t val, bool stop = true)
+    {
+        return WriteReg(reg, &val, 1, stop);
+    }
+
+    uint32_t WriteReg(uint8_t reg, uint8_t *buf, uint32_t bufSize, bool stop = true)
+    {
+        ++writeCount_;
+
+        uint8_t *regList = GetRegList(addr_);
+        for (uint32_t i = 0; i < bufSize; ++i)
+        {
+            regList[(uint8_t)(reg + i)] = buf[i];
+        }
+
+        return bufSize;
+    }
+
+
+public:
+
+    static bool IsAlive(uint8_t addr, Instance instance = Instance::I2C0)
+    {
+        return true;
+    }
+
+    static uint8_t *GetRegList(uint8_t addr)
+    {
+        return regFileList_[addr & 0x7F];
+    }
+
+    static void Reset()
+    {
+        memset(regFileList_, 0, sizeof(regFileList_));
+
+        readCount_  = 0;
+        writeCount_ = 0;
+    }
+
+    static uint32_t GetReadCount()  { return readCount_;  }
+    static uint32_t GetWriteCount() { return writeCount_; }
+
+
+private:
+
+    uint8_t addr_ = 0;
+
+    inline static uint8_t  regFileList_[128][256] = {};
+    inline static uint32_t readCount_             = 0;
+    inline static uint32_t writeCount_            = 0;
+};
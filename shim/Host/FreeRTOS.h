@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+
+// Minimal single-threaded stand-in for the FreeRTOS kernel, enough to
+// compile and run the Evm core (KMessagePipe / KSemaphore) on a host.
+//
+// Ticks are microseconds on the host (see the host KTime), and any
+// operation which would block instead advances the HostSim virtual clock
+// by the timeout and fails, as nothing else could ever wake it.
+
+
+typedef uint32_t TickType_t;
+typedef long     BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFUL)
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE  ((BaseType_t)1)
+#define pdPASS  (pdTRUE)
+#define pdFAIL  (pdFALSE)
+
+#define errQUEUE_EMPTY ((BaseType_t)0)
+#define errQUEUE_FULL  ((BaseType_t)0)
+
+#define portYIELD_FROM_ISR(x) ((void)(x))
+#define taskYIELD()
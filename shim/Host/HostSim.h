@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+
+// Simulated platform state for host (non-Pico) builds.
+//
+// PAL.Micros() reads the virtual clock held here.
+//
+// The kernel shim advances the clock whenever the caller would otherwise
+// block (eg Evm sleeping until its next timer), so timer-heavy code runs
+// as fast as the host can execute it while still seeing correct relative
+// timing between events.
+//
+// ISR context can also be simulated, so code paths which branch on
+// PAL.InIsrReal() can be exercised.
+class HostSim
+{
+public:
+
+    static uint64_t GetTimeUs()
+    {
+        return timeUs_;
+    }
+
+    static void SetTimeUs(uint64_t timeUs)
+    {
+        timeUs_ = timeUs;
+    }
+
+    static void AdvanceUs(uint64_t durationUs)
+    {
+        timeUs_ += durationUs;
+    }
+
+    static bool InIsr()
+    {
+        return inIsr_;
+    }
+
+    static void SetInIsr(bool tf)
+    {
+        inIsr_ = tf;
+    }
+
+
+private:
+
+    inline static uint64_t timeUs_ = 0;
+    inline static bool     inIsr_  = false;
+};
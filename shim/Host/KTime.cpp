@@ -0,0 +1,46 @@
+#include "KTime.h"
+#include "Timeline.h"
+
+#include "FreeRTOS.Wrapped.h"
+
+#include <cmath>
+using namespace std;
+
+#include "StrictMode.h"
+
+
+// Host kernel shim ticks are microseconds, so unlike the target there is
+// no truncation to the 1ms FreeRTOS tick.
+
+KTime::KTime(uint64_t us)
+{
+    us_ = us;
+}
+
+KTime::operator uint32_t()
+{
+    uint32_t ticks = portMAX_DELAY;
+    if (us_ < portMAX_DELAY)
+    {
+        ticks = (uint32_t)round((double)us_ * scalingFactor_);
+    }
+
+    return ticks;
+}
+
+void KTime::SetScalingFactor(double scalingFactor)
+{
+    Timeline::Global().Event("KTIME_SET_SCALING_FACTOR");
+    
+    scalingFactor_ = scalingFactor;
+
+    for (auto &cb : cbList_)
+    {
+        cb();
+    }
+}
+
+void KTime::RegisterCallbackScalingFactorChange(function<void()> cb)
+{
+    cbList_.push_back(cb);
+}
@@ -0,0 +1,133 @@
+#include "PAL.h"
+#include "Log.h"
+#include "Timeline.h"
+
+#include <cstdlib>
+#include <vector>
+#include <string>
+using namespace std;
+
+#include "StrictMode.h"
+
+
+// Host implementation of the platform, time comes from the HostSim
+// virtual clock rather than the RP2040 timer.
+
+string PlatformAbstractionLayer::GetAddress()
+{
+    return "0x0000000000000000";
+}
+
+uint64_t PlatformAbstractionLayer::Millis()
+{
+    return Micros() / 1000;
+}
+
+uint64_t PlatformAbstractionLayer::Micros()
+{
+    return HostSim::GetTimeUs();
+}
+
+void PlatformAbstractionLayer::Delay(uint64_t ms)
+{
+    DelayUs(ms * 1000);
+}
+
+void PlatformAbstractionLayer::DelayUs(uint64_t us)
+{
+    HostSim::AdvanceUs(us);
+}
+
+void PlatformAbstractionLayer::DelayBusy(uint64_t ms)
+{
+    DelayBusyUs(ms * 1000);
+}
+
+void PlatformAbstractionLayer::DelayBusyUs(uint64_t us)
+{
+    HostSim::AdvanceUs(us);
+}
+
+void PlatformAbstractionLayer::EnableForcedInIsrYes(bool force)
+{
+    static uint32_t nestLevel = 0;
+
+    if (force)
+    {
+        ++nestLevel;
+        
+        forceInIsrYes_ = true;
+    }
+    else
+    {
+        if (nestLevel)
+        {
+            --nestLevel;
+        }
+
+        if (nestLevel == 0)
+        {
+            forceInIsrYes_ = false;
+        }
+    }
+}
+
+void PlatformAbstractionLayer::SchedulerLock()
+{
+    // single-threaded host
+}
+
+void PlatformAbstractionLayer::SchedulerUnlock()
+{
+    // single-threaded host
+}
+
+void PlatformAbstractionLayer::YieldToAll()
+{
+    // single-threaded host
+}
+
+void PlatformAbstractionLayer::RegisterOnFatalHandler(const char *title, function<void()> cbFnOnFatal)
+{
+    fatalHandlerDataList_.emplace_back(FatalHandlerData{
+        .title = title,
+        .cbFnOnFatal = cbFnOnFatal,
+    });
+}
+
+void PlatformAbstractionLayer::Fatal(const char *title)
+{
+    LogNL();
+    Log("Fatal error from ", title);
+
+    Timeline::Global().ReportNow("Fatal Error");
+
+    for (auto &fh : fatalHandlerDataList_)
+    {
+        Log("Handler: ", fh.title);
+        fh.cbFnOnFatal();
+    }
+
+    exit(1);
+}
+
+void PlatformAbstractionLayer::Reset()
+{
+    exit(0);
+}
+
+void PlatformAbstractionLayer::Init()
+{
+    Timeline::Global().Event("PAL::Init");
+}
+
+void PlatformAbstractionLayer::SetupShell()
+{
+}
+
+void PlatformAbstractionLayer::SetupJSON()
+{
+}
+
+
+PlatformAbstractionLayer PAL;
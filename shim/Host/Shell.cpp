@@ -0,0 +1,85 @@
+#include "Shell.h"
+#include "Utl.h"
+
+using namespace std;
+
+#include "StrictMode.h"
+
+
+// Host shell, commands can be registered and evaluated but there is no
+// interactive terminal.
+
+void Shell::Init()
+{
+}
+
+void Shell::DisplayOn()
+{
+}
+
+void Shell::SetupJSON()
+{
+}
+
+bool Shell::Eval(string cmd)
+{
+    bool retVal = false;
+
+    vector<string> argList = Split(cmd, " ");
+    if (argList.size())
+    {
+        string name = argList[0];
+        argList.erase(argList.begin());
+
+        auto it = cmdLookup_.find(name);
+        if (it != cmdLookup_.end())
+        {
+            CmdData &cd = it->second;
+
+            if (cd.cmdOptions.argCount == -1 || (size_t)cd.cmdOptions.argCount == argList.size())
+            {
+                cd.cbFn_(argList);
+
+                retVal = true;
+            }
+        }
+    }
+
+    return retVal;
+}
+
+bool Shell::AddCommand(string name, function<void(vector<string> argList)> cbFn)
+{
+    return AddCommand(name, cbFn, {});
+}
+
+bool Shell::AddCommand(string name, function<void(vector<string> argList)> cbFn, CmdOptions cmdOptions)
+{
+    cmdLookup_[name] = CmdData{
+        .cmdOptions = cmdOptions,
+        .cbFn_      = cbFn,
+    };
+
+    return true;
+}
+
+bool Shell::RemoveCommand(string name)
+{
+    return cmdLookup_.erase(name) != 0;
+}
+
+void Shell::ShowHelp(string prefix)
+{
+    for (auto &[name, cd] : cmdLookup_)
+    {
+        if (name.starts_with(prefix))
+        {
+            Log(name, ": ", cd.cmdOptions.help);
+        }
+    }
+}
+
+bool Shell::RepeatPriorCommand()
+{
+    return false;
+}
@@ -0,0 +1,58 @@
+#include "UART.h"
+
+#include <cstdio>
+#include <vector>
+using namespace std;
+
+#include "StrictMode.h"
+
+
+// Host UART, all output goes to stdout regardless of target.
+
+static vector<UART> uartStack_ = { UART::UART_0 };
+
+void UartInit()
+{
+}
+
+void UartSetupShell()
+{
+}
+
+void UartPush(UART uart)
+{
+    uartStack_.push_back(uart);
+}
+
+void UartPop()
+{
+    if (uartStack_.size() > 1)
+    {
+        uartStack_.pop_back();
+    }
+}
+
+UART UartCurrent()
+{
+    return uartStack_.back();
+}
+
+void UartOut(char c)
+{
+    fputc(c, stdout);
+}
+
+void UartOut(const char *str)
+{
+    fputs(str, stdout);
+}
+
+void UartSend(const uint8_t *buf, uint16_t bufLen)
+{
+    fwrite(buf, 1, bufLen, stdout);
+}
+
+void UartSend(const vector<uint8_t> &byteList)
+{
+    UartSend(byteList.data(), (uint16_t)byteList.size());
+}
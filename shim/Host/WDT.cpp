@@ -0,0 +1,37 @@
+#include "WDT.h"
+
+#include "StrictMode.h"
+
+
+// No watchdog on the host
+
+void Watchdog::SetTimeout(uint32_t timeoutMs)
+{
+    timeoutMs_ = timeoutMs;
+}
+
+uint32_t Watchdog::GetTimeout()
+{
+    return timeoutMs_;
+}
+
+void Watchdog::Start()
+{
+}
+
+void Watchdog::Stop()
+{
+}
+
+void Watchdog::Feed()
+{
+}
+
+bool Watchdog::CausedReboot()
+{
+    return false;
+}
+
+void Watchdog::SetupShell()
+{
+}
@@ -0,0 +1,23 @@
+#include "Work.h"
+
+using namespace std;
+
+#include "StrictMode.h"
+
+
+// There is no background Work thread on the host, run jobs inline.
+
+void Work::Queue(const char *label, function<void()> &&fn)
+{
+    (void)label;
+
+    fn();
+}
+
+void Work::Report()
+{
+}
+
+void Work::SetupShell()
+{
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+
+typedef unsigned int uint;
+
+enum gpio_irq_level
+{
+    GPIO_IRQ_LEVEL_LOW  = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL  = 0x4u,
+    GPIO_IRQ_EDGE_RISE  = 0x8u,
+};
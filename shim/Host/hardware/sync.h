@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+
+// no interrupts on the host, locking is a no-op
+inline uint32_t save_and_disable_interrupts()
+{
+    return 0;
+}
+
+inline void restore_interrupts(uint32_t)
+{
+}
+
+// one core on the host
+inline uint32_t get_core_num()
+{
+    return 0;
+}
+
+// spin locks, as above nothing to contend with
+typedef volatile uint32_t spin_lock_t;
+
+inline int spin_lock_claim_unused(bool)
+{
+    return 0;
+}
+
+inline spin_lock_t *spin_lock_instance(uint32_t)
+{
+    static spin_lock_t lock = 0;
+
+    return &lock;
+}
+
+inline uint32_t spin_lock_blocking(spin_lock_t *)
+{
+    return 0;
+}
+
+inline void spin_unlock(spin_lock_t *, uint32_t)
+{
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+
+inline uint32_t get_rand_32()
+{
+    return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+inline uint64_t get_rand_64()
+{
+    return ((uint64_t)get_rand_32() << 32) | get_rand_32();
+}
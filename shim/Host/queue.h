@@ -0,0 +1,133 @@
+#pragma once
+
+#include "FreeRTOS.h"
+#include "HostSim.h"
+
+#include <cstring>
+
+
+struct StaticQueue_t
+{
+    uint8_t     *storage  = nullptr;
+    UBaseType_t  length   = 0;
+    UBaseType_t  itemSize = 0;
+    UBaseType_t  head     = 0;
+    UBaseType_t  count    = 0;
+};
+
+typedef StaticQueue_t *QueueHandle_t;
+
+
+inline QueueHandle_t xQueueCreateStatic(UBaseType_t    length,
+                                        UBaseType_t    itemSize,
+                                        uint8_t       *storage,
+                                        StaticQueue_t *q)
+{
+    q->storage  = storage;
+    q->length   = length;
+    q->itemSize = itemSize;
+    q->head     = 0;
+    q->count    = 0;
+
+    return q;
+}
+
+inline void vQueueDelete(QueueHandle_t)
+{
+    // storage is static, nothing to do
+}
+
+inline void HostQueueBlock(TickType_t ticks)
+{
+    // nothing else runs to unblock us, so let the timeout elapse
+    if (ticks != portMAX_DELAY)
+    {
+        HostSim::AdvanceUs(ticks);
+    }
+}
+
+inline BaseType_t xQueueSendToBack(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    if (q->count == q->length)
+    {
+        HostQueueBlock(ticks);
+
+        return errQUEUE_FULL;
+    }
+
+    UBaseType_t idx = (q->head + q->count) % q->length;
+    memcpy(&q->storage[idx * q->itemSize], item, q->itemSize);
+    ++q->count;
+
+    return pdPASS;
+}
+
+inline BaseType_t xQueueSendToBackFromISR(QueueHandle_t q, const void *item, BaseType_t *woken)
+{
+    *woken = pdFALSE;
+
+    return xQueueSendToBack(q, item, 0);
+}
+
+inline BaseType_t xQueueOverwrite(QueueHandle_t q, const void *item)
+{
+    if (q->count == q->length)
+    {
+        q->count = 0;
+    }
+
+    return xQueueSendToBack(q, item, 0);
+}
+
+inline BaseType_t xQueueOverwriteFromISR(QueueHandle_t q, const void *item, BaseType_t *woken)
+{
+    *woken = pdFALSE;
+
+    return xQueueOverwrite(q, item);
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks)
+{
+    if (q->count == 0)
+    {
+        HostQueueBlock(ticks);
+
+        return pdFALSE;
+    }
+
+    memcpy(item, &q->storage[q->head * q->itemSize], q->itemSize);
+    q->head = (q->head + 1) % q->length;
+    --q->count;
+
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceiveFromISR(QueueHandle_t q, void *item, BaseType_t *woken)
+{
+    *woken = pdFALSE;
+
+    return xQueueReceive(q, item, 0);
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t q)
+{
+    return q->count;
+}
+
+inline UBaseType_t uxQueueMessagesWaitingFromISR(const QueueHandle_t q)
+{
+    return q->count;
+}
+
+inline UBaseType_t uxQueueSpacesAvailable(const QueueHandle_t q)
+{
+    return q->length - q->count;
+}
+
+inline BaseType_t xQueueReset(QueueHandle_t q)
+{
+    q->head  = 0;
+    q->count = 0;
+
+    return pdPASS;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+
+struct StaticSemaphore_t
+{
+    UBaseType_t count    = 0;
+    UBaseType_t maxCount = 0;
+};
+
+typedef StaticSemaphore_t *SemaphoreHandle_t;
+
+
+inline SemaphoreHandle_t xSemaphoreCreateCountingStatic(UBaseType_t        maxCount,
+                                                        UBaseType_t        initialCount,
+                                                        StaticSemaphore_t *sem)
+{
+    sem->count    = initialCount;
+    sem->maxCount = maxCount;
+
+    return sem;
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t)
+{
+    // storage is static, nothing to do
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    if (sem->count == 0)
+    {
+        HostQueueBlock(ticks);
+
+        return pdFALSE;
+    }
+
+    --sem->count;
+
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreTakeFromISR(SemaphoreHandle_t sem, BaseType_t *woken)
+{
+    *woken = pdFALSE;
+
+    return xSemaphoreTake(sem, 0);
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem->count == sem->maxCount)
+    {
+        return pdFALSE;
+    }
+
+    ++sem->count;
+
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *woken)
+{
+    *woken = pdFALSE;
+
+    return xSemaphoreGive(sem);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+
+// single-threaded host, there is nothing to suspend
+inline void vTaskSuspendAll()
+{
+}
+
+inline BaseType_t xTaskResumeAll()
+{
+    return pdFALSE;
+}
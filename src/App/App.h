@@ -1,13 +1,23 @@
 #pragma once
 
 #include "ADCInternal.h"
+#include "ADCSampler.h"
 #if PICO_INF_ENABLE_BLE == 1
 #include "Ble.h"
 #endif
 #include "Clock.h"
+#include "ClockGovernor.h"
 #include "Evm.h"
+#include "FilesystemBlockDeviceFlash.h"
 #include "FilesystemLittleFS.h"
+#if PICO_INF_ENABLE_KV == 1
+#include "FlashKvLog.h"
+#endif
+#include "FlashWriteBehind.h"
 #include "Flashable.h"
+#if PICO_INF_ENABLE_KV == 1
+#include "FlashableKv.h"
+#endif
 #include "I2C.h"
 #if PICO_INF_ENABLE_JERRYSCRIPT == 1
 #include "JerryScriptIntegration.h"
@@ -17,9 +27,11 @@
 #include "KStats.h"
 #include "KTask.h"
 #include "Log.h"
+#include "LogBin.h"
 #include "PAL.h"
 #include "Pin.h"
 #include "PWM.h"
+#include "PWMAudio.h"
 #include "PeripheralControl.h"
 #include "Sensor.h"
 #include "Shell.h"
@@ -51,6 +63,9 @@ public:
             PlatformAbstractionLayer::Init();
             LogNL();
             FilesystemLittleFS::Init();
+#if PICO_INF_ENABLE_KV == 1
+            FlashKvLog::Global().Init(FilesystemBlockDeviceFlash::GetKvBlockDevice());
+#endif
             LogNL();
             NukeAppStorageFlashIfFirmwareChanged();
 
@@ -67,12 +82,18 @@ public:
 
             // Shell
             ADC::SetupShell();
+            ADCSampler::SetupShell();
 #if PICO_INF_ENABLE_BLE == 1
             Ble::SetupShell();
 #endif
             Clock::SetupShell();
+            ClockGovernor::SetupShell();
             Evm::SetupShell();
             FilesystemLittleFS::SetupShell();
+#if PICO_INF_ENABLE_KV == 1
+            FlashKvLog::SetupShell();
+#endif
+            FlashWriteBehind::SetupShell();
             I2C::SetupShell0();
 #if PICO_INF_ENABLE_JERRYSCRIPT == 1
             JerryScriptIntegration::SetupShell();
@@ -80,9 +101,13 @@ public:
             JSONMsgRouter::SetupShell();
             KStats::SetupShell();
             LogSetupShell();
+#if PICO_INF_ENABLE_LOG_BIN == 1
+            LogBinSetupShell();
+#endif
             PlatformAbstractionLayer::SetupShell();
             Pin::SetupShell();
             PWM::SetupShell();
+            PWMAudio::SetupShell();
             PeripheralControl::SetupShell();
             Sensor::SetupShell();
             Shell::Init();
@@ -186,6 +211,9 @@ private:
                 Log("  New version: ", version);
 
                 FilesystemLittleFS::NukeFilesystem();
+#if PICO_INF_ENABLE_KV == 1
+                FlashKvLog::Global().Format();
+#endif
 
                 LogNL();
 
@@ -197,6 +225,9 @@ private:
             Log("INF: Firmware first run, formatting app flash storage");
 
             FilesystemLittleFS::NukeFilesystem();
+#if PICO_INF_ENABLE_KV == 1
+            FlashKvLog::Global().Format();
+#endif
 
             LogNL();
 
@@ -5,6 +5,7 @@
 #include "TimeClass.h"
 #include "Timeline.h"
 
+#include <algorithm>
 #include <vector>
 using namespace std;
 
@@ -28,9 +29,9 @@ uint64_t Evm::GetDurationUsToNextTimerTimeout(uint8_t expectedStackDepth)
 {
     uint64_t sleepUs;
 
-    if (!timerList_.empty())
+    if (!timerList_.Empty())
     {
-        Timer *timer = *timerList_.begin();
+        Timer *timer = timerList_.Front();
 
         uint64_t timeNow = PAL.Micros();
 
@@ -129,20 +130,38 @@ void Evm::MainLoop()
 
     while (mainLoopStackDepth_ == expectedStackDepth)
     {
+        if (fnOnPass_)
+        {
+            fnOnPass_();
+        }
+
         uint64_t timeStart = PAL.Micros();
 
-        stats_.HANDLED_WORK += ServiceWork();
-        stats_.HANDLED_WORK += ServiceLowPriorityWork();
+        uint32_t handledWork = ServiceWork();
         uint64_t timePostIsr = PAL.Micros();
-        stats_.HANDLED_TIMED += ServiceTimers();
+        uint32_t handledTimed = ServiceTimers();
         uint64_t timePostTimed = PAL.Micros();
 
+        stats_.HANDLED_WORK  += handledWork;
+        stats_.HANDLED_TIMED += handledTimed;
+        load_.handled        += handledWork + handledTimed;
+
         // Determine whether to keep processing or if sleep is an option
-        if (fnWorkList_.Count() == 0 && fnLowPriorityWorkList_.Count() == 0)
+        if (workHigh_.Count() == 0 && workLow_.Count() == 0)
         {
             // is there time to sleep?
             uint64_t timeToSleep = GetDurationUsToNextTimerTimeout(expectedStackDepth);
             if (timeToSleep)
+            {
+                if (fnOnSleep_)
+                {
+                    fnOnSleep_(timeToSleep);
+
+                    // it may have taken a while, eg switching clocks
+                    timeToSleep = GetDurationUsToNextTimerTimeout(expectedStackDepth);
+                }
+            }
+            if (timeToSleep)
             {
                 uint64_t timeToWake = PAL.Micros() + timeToSleep;
                 sem_.Take(timeToSleep);
@@ -171,6 +190,9 @@ void Evm::MainLoop()
         stats_.TIME_IN_WORK  += timePostIsr   - timeStart;
         stats_.TIME_IN_TIMED += timePostTimed - timePostIsr;
         stats_.TIME_IN_SLEEP += timePostSleep - timePostTimed;
+
+        load_.timeBusyUs  += timePostTimed - timeStart;
+        load_.timeSleepUs += timePostSleep - timePostTimed;
     }
 }
 
@@ -179,6 +201,22 @@ void Evm::ExitMainLoop()
     --mainLoopStackDepth_;
 }
 
+const Evm::Load &Evm::GetLoad()
+{
+    return load_;
+}
+
+uint16_t Evm::GetWorkDepth()
+{
+    return (uint16_t)(workHigh_.Count() + workLow_.Count());
+}
+
+void Evm::SetLoadHooks(FnOnPass fnOnPass, FnOnSleep fnOnSleep)
+{
+    fnOnPass_  = fnOnPass;
+    fnOnSleep_ = fnOnSleep;
+}
+
 uint8_t Evm::GetStackDepth()
 {
     return mainLoopStackDepth_;
@@ -189,156 +227,241 @@ uint8_t Evm::GetStackDepth()
 // Interrupts
 //////////////////////////////////////////////////////////////////////
 
-void Evm::QueueWork(const char *label, FnWork &fnWork)
-{
-    Evm::QueueWorkInternal(label, fnWork);
-}
-
 void Evm::QueueWork(const char *label, FnWork &&fnWork)
-{
-    Evm::QueueWorkInternal(label, fnWork);
-}
-
-void Evm::QueueWorkInternal(const char *label, FnWork &fnWork)
 {
     timeline_.Event(label);
 
-    // Caution must be used when sending work.
-    //
-    // Lambdas must capture only [this], a single reference, or
-    // some 4-byte-or-less value.
-    //
-    // This functionality relies on small-buffer-optimization to work,
-    // and so must not trigger dynamic memory allocation in either the
-    // lambda or the function<> object.
+    // The work is moved into the queue and out again, so anything can be
+    // captured by value, so long as it fits in WORK_CAPTURE_SIZE (checked
+    // at compile time).
     //
-    // The work queue byte-wise copying a function<> object and so any
-    // allocations will be ultimately a use-after-free operation.
-    //
-    // An example of this limit being broken was evm.delaybusy capturing
-    // a uint64_t by value and it coming out garbage on the other side.
-    //
-    // (The exact limits have not been not exhaustively tested, eg, can
-    // you capture 4 1-byte values? Is the limit actually 4?)
-    fnWorkList_.Put(fnWork);
-    sem_.Give();
+    // Only wake the main loop when the queue goes from empty to not, if
+    // there was already work queued, a wakeup is already pending.
+    bool wasEmpty = false;
+    bool queued   = workHigh_.queue.Emplace(&wasEmpty, label, (uint32_t)PAL.Micros(), move(fnWork));
+
+    if (queued == false)
+    {
+        timeline_.Event("EVM_WORK_QUEUE_FULL");
+
+        if (PAL.InIsr())
+        {
+            // can't wait, counted, and logged by the main loop
+            ++stats_.WORK_DROPPED;
+        }
+        else
+        {
+            // as the put blocked when the queue was a message pipe, wait
+            // for the main loop to make room rather than lose the work
+            while (queued == false)
+            {
+                PAL.Delay(1);
+
+                queued = workHigh_.queue.Emplace(&wasEmpty, label, (uint32_t)PAL.Micros(), move(fnWork));
+            }
+        }
+    }
+
+    if (queued && wasEmpty)
+    {
+        sem_.Give();
+    }
 }
 
 uint32_t Evm::ServiceWork()
 {
-    const uint8_t MAX_EVENTS_HANDLED = 4;
-    
-    uint8_t remainingEvents = MAX_EVENTS_HANDLED;
-    
-    while (fnWorkList_.Count() && remainingEvents)
+    const WorkPolicy &policy = workPolicy_;
+
+    // work dropped from ISRs with the queue full, once each time it happens
+    uint32_t workDropped = stats_.WORK_DROPPED;
+    if (workDropped != workDroppedLogged_)
     {
-        FnWork fnWork;
-        fnWorkList_.Get(fnWork);
-        
-        // Execute
-        timeline_.Event("EVM_WORK_START");
-        fnWork();
-        timeline_.Event("EVM_WORK_END");
- 
-        // Keep track of remaining events willing to handle
-        --remainingEvents;
+        Log("EVM: work queue full, ", Commas(workDropped - workDroppedLogged_), " dropped from ISRs (", Commas(workDropped), " in all)");
+
+        workDroppedLogged_ = workDropped;
     }
-    
-    // Return number handled
-    return MAX_EVENTS_HANDLED - remainingEvents;
-}
 
-//////////////////////////////////////////////////////////////////////
-// Interrupts (missable)
-//////////////////////////////////////////////////////////////////////
+    // translate the policy into a count and time limit, only one of which
+    // is really in effect
+    uint32_t countMax       = UINT32_MAX;
+    uint64_t timeDeadlineUs = UINT64_MAX;
+    if (policy.budget == WorkPolicy::Budget::COUNT)
+    {
+        countMax = policy.countMax;
+    }
+    else
+    {
+        timeDeadlineUs = PAL.Micros() + policy.timeUsMax;
+    }
 
-void Evm::QueueLowPriorityWork(const char *label, FnWork &fnWork)
-{
-    Evm::QueueLowPriorityWorkInternal(label, fnWork);
-}
+    uint32_t handled = 0;
 
-void Evm::QueueLowPriorityWork(const char *label, FnWork &&fnWork)
-{
-    Evm::QueueLowPriorityWorkInternal(label, fnWork);
-}
+    // low priority work which has waited too long goes first
+    uint32_t handledAged = 0;
+    if (policy.agingUs)
+    {
+        handledAged = ServiceWorkSource(workLow_, true, countMax, timeDeadlineUs, policy.agingUs, stats_.LATENCY_LOW_PRIO_AGED);
+        handled += handledAged;
+    }
 
-void Evm::QueueLowPriorityWorkInternal(const char *label, FnWork &fnWork)
-{
-    timeline_.Event(label);
+    uint32_t handledHigh = ServiceWorkSource(workHigh_, false, countMax,               timeDeadlineUs, 0, stats_.LATENCY_WORK);
+    uint32_t handledLow  = ServiceWorkSource(workLow_,  true,  countMax - handledAged, timeDeadlineUs, 0, stats_.LATENCY_LOW_PRIO);
+    handled += handledHigh + handledLow;
 
-    // if full, drop the oldest to make room for newest
-    if (fnLowPriorityWorkList_.IsFull())
+    // left work queued because of the budget, either the time ran out or a
+    // queue's count was used up
+    bool exhaustedTime  = PAL.Micros() >= timeDeadlineUs;
+    bool exhaustedCount = (handledHigh >= countMax && workHigh_.Count()) ||
+                          (handledAged + handledLow >= countMax && workLow_.Count());
+    if ((exhaustedTime && (workHigh_.Count() || workLow_.Count())) || exhaustedCount)
     {
-        WorkData tmp;
-        fnLowPriorityWorkList_.Get(tmp, 0);
+        ++stats_.WORK_BUDGET_EXHAUSTED;
     }
 
-    fnLowPriorityWorkList_.Put(WorkData{label, fnWork});
-    sem_.Give();
+    // Return number handled
+    return handled;
 }
 
-uint32_t Evm::ClearLowPriorityWorkByLabel(const char *label)
+// Service work from the source until out of work, countMax items have been
+// serviced, or timeDeadlineUs is reached.
+// If agedUs is non-zero, stop at the first item which has waited less
+// than that.
+uint32_t Evm::ServiceWorkSource(WorkSource &source,
+                                bool        lowPriority,
+                                uint32_t    countMax,
+                                uint64_t    timeDeadlineUs,
+                                uint32_t    agedUs,
+                                Latency    &latency)
 {
-    uint32_t numDeleted = 0;
-
-    IrqLock lock;
-    PAL.SchedulerLock();
+    uint32_t handled = 0;
 
-    // get a list of the work you want to keep
-    vector<WorkData> wdListKeep;
-    while (fnLowPriorityWorkList_.Count())
+    while (handled < countMax)
     {
-        WorkData wd;
-        fnLowPriorityWorkList_.Get(wd, 0);
+        uint64_t timeNow = PAL.Micros();
+        if (timeNow >= timeDeadlineUs)
+        {
+            break;
+        }
+
+        if (source.batchIdx == source.batchCount)
+        {
+            source.batchIdx   = 0;
+            source.batchCount = (uint8_t)source.queue.GetBulk(source.batch, WORK_BATCH_SIZE);
+
+            if (source.batchCount == 0)
+            {
+                break;
+            }
+        }
+
+        WorkData &workDataNext = source.batch[source.batchIdx];
+
+        uint32_t latencyUs = (uint32_t)timeNow - workDataNext.timeQueuedUs;
+        if (latencyUs < agedUs)
+        {
+            break;
+        }
+
+        // take ownership before executing, the work may itself run a nested
+        // MainLoop which carries on servicing this source
+        WorkData workData = move(workDataNext);
+        ++source.batchIdx;
+
+        // cleared while waiting in the batch
+        if (!workData.fnWork)
+        {
+            continue;
+        }
+
+        latency.Add(latencyUs);
 
-        if (wd.label != label)
+        // Execute
+        if (lowPriority)
         {
-            wdListKeep.push_back(wd);
+            MaybeEvent("EVM_LOW_PRIO_WORK_START");
+            timeline_.Event(workData.label);
+            workData.fnWork();
+            MaybeEvent("EVM_LOW_PRIO_WORK_END");
         }
         else
         {
-            ++numDeleted;
+            timeline_.Event("EVM_WORK_START");
+            workData.fnWork();
+            timeline_.Event("EVM_WORK_END");
         }
+
+        ++handled;
     }
 
-    // should be empty but why not
-    fnLowPriorityWorkList_.Flush();
+    return handled;
+}
+
+static string WorkPolicyToString(const Evm::WorkPolicy &policy)
+{
+    string retVal;
 
-    // re-populate
-    for (auto &wd : wdListKeep)
+    if (policy.budget == Evm::WorkPolicy::Budget::COUNT)
     {
-        fnLowPriorityWorkList_.Put(wd, 0);
+        retVal = "count " + to_string(policy.countMax);
+    }
+    else
+    {
+        retVal = "time " + Commas(policy.timeUsMax) + " us";
     }
 
-    PAL.SchedulerUnlock();
+    retVal += ", aging " + Commas(policy.agingUs) + " us";
 
-    return numDeleted;
+    return retVal;
 }
 
-uint32_t Evm::ServiceLowPriorityWork()
+void Evm::SetWorkPolicy(const WorkPolicy &workPolicy)
 {
-    const uint8_t MAX_EVENTS_HANDLED = 4;
-    
-    uint8_t remainingEvents = MAX_EVENTS_HANDLED;
-    
-    while (fnLowPriorityWorkList_.Count() && remainingEvents)
+    workPolicy_ = workPolicy;
+}
+
+const Evm::WorkPolicy &Evm::GetWorkPolicy()
+{
+    return workPolicy_;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Interrupts (missable)
+//////////////////////////////////////////////////////////////////////
+
+void Evm::QueueLowPriorityWork(const char *label, FnWork &&fnWork)
+{
+    timeline_.Event(label);
+
+    // if full, drop the oldest to make room for newest
+    bool wasEmpty = false;
+    workLow_.queue.EmplaceDropOldest(&wasEmpty, label, (uint32_t)PAL.Micros(), move(fnWork));
+
+    if (wasEmpty)
     {
-        WorkData workData;
-        fnLowPriorityWorkList_.Get(workData);
-        FnWork &fnWork = workData.fnWork;
-        
-        // Execute
-        MaybeEvent("EVM_LOW_PRIO_WORK_START");
-        timeline_.Event(workData.label);
-        fnWork();
-        MaybeEvent("EVM_LOW_PRIO_WORK_END");
- 
-        // Keep track of remaining events willing to handle
-        --remainingEvents;
+        sem_.Give();
     }
-    
-    // Return number handled
-    return MAX_EVENTS_HANDLED - remainingEvents;
+}
+
+uint32_t Evm::ClearLowPriorityWorkByLabel(const char *label)
+{
+    uint32_t count = workLow_.queue.RemoveIf([&](const WorkData &wd){
+        return wd.label == label;
+    });
+
+    // already taken from the queue but not yet serviced, the empty slot
+    // is skipped when reached
+    for (uint8_t i = workLow_.batchIdx; i < workLow_.batchCount; ++i)
+    {
+        WorkData &wd = workLow_.batch[i];
+
+        if (wd.label == label && wd.fnWork)
+        {
+            wd.fnWork.Reset();
+            ++count;
+        }
+    }
+
+    return count;
 }
 
 
@@ -349,17 +472,17 @@ uint32_t Evm::ServiceLowPriorityWork()
 
 void Evm::RegisterTimer(Timer *timer)
 {
-    timerList_.insert(timer);
+    timerList_.Insert(timer);
 }
 
 void Evm::DeRegisterTimer(Timer *timer)
 {
-    timerList_.erase(timer);
+    timerList_.Erase(timer);
 }
 
 bool Evm::IsTimerRegistered(const Timer *timer)
 {
-    return timerList_.contains((Timer *)timer);
+    return timerList_.Contains(timer);
 }
 
 uint32_t Evm::ServiceTimers()
@@ -367,19 +490,19 @@ uint32_t Evm::ServiceTimers()
     const uint8_t MAX_EVENTS_HANDLED = 1;
     uint8_t remainingEvents = MAX_EVENTS_HANDLED;
     
-    if (!timerList_.empty())
+    if (!timerList_.Empty())
     {
         bool   keepGoing = true;
         Timer *timer     = NULL;
         
         do {
-            timer = *timerList_.begin();
+            timer = timerList_.Front();
             
             // check if the timer expiry is in the past
             if (timer->GetTimeoutAtUs() <= PAL.Micros())
             {
                 // drop this element from the list
-                timerList_.erase(timer);
+                timerList_.Erase(timer);
                 
                 // invoke the IdleTimeEventHandler
                 MaybeEvent("EVM_TIMED_START");
@@ -394,7 +517,7 @@ uint32_t Evm::ServiceTimers()
             {
                 keepGoing = false;
             }
-        } while (keepGoing && !timerList_.empty());
+        } while (keepGoing && !timerList_.Empty());
     }
 
     // Return events handled
@@ -425,7 +548,7 @@ void Evm::DumpStats()
         StatsSnapshot &ss = statsHistory_[i];
 
         Log("Stats from ", Time::GetNotionalTimeAtSystemUs(ss.snapshotTime));
-        DumpStats(ss.stats, STATS_INTERVAL_MS * 1'000);
+        DumpStats(ss.stats, STATS_INTERVAL_MS * 1'000, ss.workPolicy);
         LogNL();
     }
 
@@ -437,8 +560,10 @@ void Evm::DumpStats()
     }
     uint64_t durationCurrentStats = timeNow - currentStatsStartedAt;
 
+    CaptureQueueDepthStats();
+
     Log("Current Stats: ", Time::GetNotionalTimeAtSystemUs(timeNow));
-    DumpStats(stats_, durationCurrentStats);
+    DumpStats(stats_, durationCurrentStats, workPolicy_);
     LogNL();
 }
 
@@ -455,11 +580,26 @@ Evm::Stats Evm::GetStatsDelta(Stats &s1, Stats &s2)
     s.TIME_IN_SLEEP          = s1.TIME_IN_SLEEP          - s2.TIME_IN_SLEEP;
     s.COUNT_LATENT_WAKE      = s1.COUNT_LATENT_WAKE      - s2.COUNT_LATENT_WAKE;
     s.TIME_SUM_LATENT        = s1.TIME_SUM_LATENT        - s2.TIME_SUM_LATENT;
+    s.WORK_BUDGET_EXHAUSTED  = s1.WORK_BUDGET_EXHAUSTED  - s2.WORK_BUDGET_EXHAUSTED;
+    s.WORK_DROPPED           = s1.WORK_DROPPED           - s2.WORK_DROPPED;
+
+    // not cumulative, take the later
+    s.WORK_DEPTH_MAX         = s1.WORK_DEPTH_MAX;
+    s.LOW_PRIO_DEPTH_MAX     = s1.LOW_PRIO_DEPTH_MAX;
+    s.LATENCY_WORK           = s1.LATENCY_WORK;
+    s.LATENCY_LOW_PRIO       = s1.LATENCY_LOW_PRIO;
+    s.LATENCY_LOW_PRIO_AGED  = s1.LATENCY_LOW_PRIO_AGED;
 
     return s;
 }
 
-void Evm::DumpStats(Stats &stats, uint32_t duration)
+void Evm::CaptureQueueDepthStats()
+{
+    stats_.WORK_DEPTH_MAX     = workHigh_.queue.GetHighWaterMark();
+    stats_.LOW_PRIO_DEPTH_MAX = workLow_.queue.GetHighWaterMark();
+}
+
+void Evm::DumpStats(Stats &stats, uint32_t duration, const WorkPolicy &workPolicy)
 {
     auto fnFormat = [](uint32_t val){
         return StrUtl::PadLeft(Commas(val), ' ', 9);
@@ -508,6 +648,20 @@ void Evm::DumpStats(Stats &stats, uint32_t duration)
     Log("TIME_SUM_LATENT       : ", fnFormat(stats.TIME_SUM_LATENT),        " (", pctLatent,           " %)");
     Log("LOOPS                 : ", fnFormat(stats.LOOPS));
     Log("Unaccounted Time      : ", fnFormat(timeUnaccountedFor));
+
+    auto fnLatency = [&](const char *name, const Latency &latency){
+        uint32_t avg = latency.COUNT ? latency.SUM_US / latency.COUNT : 0;
+        Log(name, fnFormat(latency.COUNT), " (avg ", Commas(avg), " us, max ", Commas(latency.MAX_US), " us)");
+    };
+
+    Log("WORK_POLICY           : ", WorkPolicyToString(workPolicy));
+    Log("WORK_BUDGET_EXHAUSTED : ", fnFormat(stats.WORK_BUDGET_EXHAUSTED));
+    Log("WORK_DROPPED          : ", fnFormat(stats.WORK_DROPPED));
+    Log("WORK_DEPTH_MAX        : ", fnFormat(stats.WORK_DEPTH_MAX),          " (of ", (uint32_t)MAX_WORK_ITEMS, ")");
+    Log("LOW_PRIO_DEPTH_MAX    : ", fnFormat(stats.LOW_PRIO_DEPTH_MAX),      " (of ", (uint32_t)MAX_WORK_ITEMS, ")");
+    fnLatency("LATENCY_WORK          : ", stats.LATENCY_WORK);
+    fnLatency("LATENCY_LOW_PRIO      : ", stats.LATENCY_LOW_PRIO);
+    fnLatency("LATENCY_LOW_PRIO_AGED : ", stats.LATENCY_LOW_PRIO_AGED);
 }
 
 
@@ -525,9 +679,17 @@ void Evm::DebugTimer(const char *str)
     uint64_t timeNowUs = PAL.Micros();
     Log("Current time - ", Time::GetNotionalTimeAtSystemUs(timeNowUs), " - ", Commas(timeNowUs));
 
-    Log("Timers pending: ", timerList_.size());
+    Log("Timers pending: ", timerList_.Size());
     LogNL();
-    for (auto &timer : timerList_)
+
+    // show in expiry order regardless of how they are stored
+    vector<Timer *> timerListSorted;
+    timerList_.ForEach([&](Timer *timer){
+        timerListSorted.push_back(timer);
+    });
+    sort(timerListSorted.begin(), timerListSorted.end(), CmpTimer{});
+
+    for (auto &timer : timerListSorted)
     {
         timer->Print(timeNowUs);
         LogNL();
@@ -709,11 +871,12 @@ void Evm::TestTimer()
 // Storage
 //////////////////////////////////////////////////////////////////////
 
-KMessagePipe<Evm::FnWork,   Evm::MAX_WORK_ITEMS> Evm::fnWorkList_;
-KMessagePipe<Evm::WorkData, Evm::MAX_WORK_ITEMS> Evm::fnLowPriorityWorkList_;
+Evm::WorkSource Evm::workHigh_;
+Evm::WorkSource Evm::workLow_;
+Evm::WorkPolicy Evm::workPolicy_;
 
 KSemaphore Evm::sem_;
-multiset<Timer *, Evm::CmpTimer> Evm::timerList_;
+TimerList Evm::timerList_;
 
 Evm::Stats Evm::stats_;
 CircularBuffer<Evm::StatsSnapshot> Evm::statsHistory_;
@@ -747,13 +910,17 @@ void Evm::Init()
 
     timerStats_.SetCallback([]{
         // capture existing stats
+        CaptureQueueDepthStats();
         statsHistory_.PushBack({
             .snapshotTime = PAL.Micros(),
+            .workPolicy = workPolicy_,
             .stats = stats_,
         });
 
         // reset current stats
         stats_ = Stats{};
+        workHigh_.queue.ResetHighWaterMark();
+        workLow_.queue.ResetHighWaterMark();
     });
     timerStats_.SetSnapToMs(STATS_INTERVAL_MS);
     timerStats_.TimeoutIntervalMs(STATS_INTERVAL_MS);
@@ -799,6 +966,10 @@ void Evm::SetupShell()
         SetTimelineVerbose(verbose);
     }, { .argCount = 1, .help = "set whether timeline includes detailed events" });
 
+    Shell::AddCommand("evm.t.dump", [&](vector<string> argList){
+        timeline_.Dump();
+    }, { .argCount = 0, .help = "Evm Timeline binary dump, see utl/TimelineToTrace.py" });
+
     Shell::AddCommand("evm.stack", [&](vector<string> argList){
         Log("Stack Depth: ", mainLoopStackDepth_);
     }, { .argCount = 0, .help = "" });
@@ -817,6 +988,34 @@ void Evm::SetupShell()
         LogModeAsync();
     }, { .argCount = 0, .help = "" });
 
+    Shell::AddCommand("evm.work.policy", [&](vector<string> argList){
+        WorkPolicy policy = workPolicy_;
+
+        if (argList.size() >= 2)
+        {
+            uint32_t val = (uint32_t)atol(argList[1].c_str());
+
+            if (argList[0] == "count")
+            {
+                policy.budget   = WorkPolicy::Budget::COUNT;
+                policy.countMax = (uint16_t)val;
+            }
+            else if (argList[0] == "time")
+            {
+                policy.budget    = WorkPolicy::Budget::TIME_US;
+                policy.timeUsMax = val;
+            }
+            else if (argList[0] == "aging")
+            {
+                policy.agingUs = val;
+            }
+
+            SetWorkPolicy(policy);
+        }
+
+        Log("Work Policy: ", WorkPolicyToString(policy));
+    }, { .argCount = -1, .help = "see/set work policy [count <n> | time <us> | aging <us>]" });
+
     Shell::AddCommand("evm.timer.debug", [&](vector<string> argList){
         DebugTimer("evm.timer.debug");
     }, { .argCount = 0, .help = "" });
@@ -899,15 +1098,16 @@ void Evm::SetupShell()
         Timer *timerSearch = (Timer *)atoi(argList[0].c_str());
 
         bool found = false;
-        for (auto &timer : timerList_)
-        {
+        timerList_.ForEach([&](Timer *timer){
             if (timer == timerSearch)
             {
-                timer->Cancel();
                 found = true;
-
-                break;
             }
+        });
+
+        if (found)
+        {
+            timerSearch->Cancel();
         }
 
         if (found) { Log("Timer ", timerSearch, " found and dereigistered"); }
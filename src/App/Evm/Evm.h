@@ -3,15 +3,17 @@
 #include "PAL.h"
 #include "Log.h"
 #include "Timer.h"
+#include "TimerList.h"
 #include "TimerSequence.h"
 #include "Pin.h"
 #include "HeapAllocators.h"
+#include "InplaceFunction.h"
 #include "KMessagePassing.h"
 #include "Container.h"
 #include "WDT.h"
+#include "WorkQueue.h"
 
 #include <cstdint>
-#include <set>
 #include <functional>
 
 
@@ -31,10 +33,35 @@ public:
     static void ExitMainLoop();
     static uint8_t GetStackDepth();
 
+    // Running totals for the main loop, never reset, for anything working
+    // out how busy it is over windows of its own
+    struct Load
+    {
+        uint64_t timeBusyUs;    // servicing work and timers
+        uint64_t timeSleepUs;
+        uint64_t handled;       // work items and timers
+    };
+    static const Load &GetLoad();
+
+    // Queued work, high and low priority
+    static uint16_t GetWorkDepth();
+
+    // For anything adjusting to how busy the main loop is, eg clock scaling.
+    // Called from the main loop, at the start of each pass before
+    // servicing, and just before sleeping, with for how long.
+    using FnOnPass  = std::function<void()>;
+    using FnOnSleep = std::function<void(uint64_t sleepUs)>;
+    static void SetLoadHooks(FnOnPass fnOnPass, FnOnSleep fnOnSleep);
+
 private:
     inline static bool autoLogAsync_ = true;
     inline static uint8_t mainLoopStackDepth_ = 0;
 
+    inline static Load load_ = { 0, 0, 0 };
+
+    inline static FnOnPass  fnOnPass_;
+    inline static FnOnSleep fnOnSleep_;
+
     static uint64_t GetDurationUsToNextTimerTimeout(uint8_t expectedStackDepth);
 
 
@@ -43,31 +70,89 @@ private:
     //////////////////////////////////////////////////////////////////////
 
 public:
-    using FnWork = std::function<void()>;
+    // Work is stored inline in the queue, no allocation takes place.
+    // Lambda captures larger than this fail to compile.
+    static const size_t WORK_CAPTURE_SIZE = 32;
+    using FnWork = InplaceFunction<void(), WORK_CAPTURE_SIZE>;
+
+    // How much queued work the main loop services in one pass before it
+    // looks at timers again.
+    //
+    // Budgets:
+    // - COUNT   - up to countMax items from each queue per pass
+    // - TIME_US - items from both queues until timeUsMax has elapsed,
+    //             checked between items, so a long item can overrun
+    //
+    // Low priority work is serviced after high priority work, from what is
+    // left of the budget.  Low priority work which has waited agingUs or
+    // longer is instead serviced ahead of high priority work, so a steady
+    // stream of high priority work can't starve it.  0 disables aging.
+    struct WorkPolicy
+    {
+        enum class Budget : uint8_t
+        {
+            COUNT,
+            TIME_US,
+        };
+
+        Budget   budget    = Budget::COUNT;
+        uint16_t countMax  = 4;
+        uint32_t timeUsMax = 1'000;
+        uint32_t agingUs   = 50'000;
+    };
+
 private:
     struct WorkData
     {
         const char *label = nullptr;
+        uint32_t timeQueuedUs = 0;
         FnWork fnWork;
     };
     static const uint8_t MAX_WORK_ITEMS = 50;
 
+    // Work is taken from the queue several items at a time, with a single
+    // lock, and held here until serviced.  Items not serviced because the
+    // budget ran out stay here, in order, for the next pass.
+    static const uint8_t WORK_BATCH_SIZE = 8;
+    struct WorkSource
+    {
+        WorkQueue<WorkData, MAX_WORK_ITEMS> queue;
+
+        WorkData batch[WORK_BATCH_SIZE];
+        uint8_t  batchIdx   = 0;
+        uint8_t  batchCount = 0;
+
+        uint16_t Count() const
+        {
+            return (uint16_t)(queue.Count() + (batchCount - batchIdx));
+        }
+    };
+
 public:
-    static void QueueWork(const char *label, FnWork &fnWork);
+    // If the queue is full, waits for room, or from an ISR, where it
+    // can't, the work is dropped and counted (WORK_DROPPED)
     static void QueueWork(const char *label, FnWork &&fnWork);
-    static void QueueLowPriorityWork(const char *label, FnWork &fnWork);
     static void QueueLowPriorityWork(const char *label, FnWork &&fnWork);
     static uint32_t ClearLowPriorityWorkByLabel(const char *label);
 
+    static void SetWorkPolicy(const WorkPolicy &workPolicy);
+    static const WorkPolicy &GetWorkPolicy();
+
 private:
-    static void QueueWorkInternal(const char *label, FnWork &fnWork);
+    struct Latency;
+
     static uint32_t ServiceWork();
-    static void QueueLowPriorityWorkInternal(const char *label, FnWork &fnWork);
-    static uint32_t ServiceLowPriorityWork();
+    static uint32_t ServiceWorkSource(WorkSource &source,
+                                      bool        lowPriority,
+                                      uint32_t    countMax,
+                                      uint64_t    timeDeadlineUs,
+                                      uint32_t    agedUs,
+                                      Latency    &latency);
 
 private:
-    static KMessagePipe<FnWork,   MAX_WORK_ITEMS> fnWorkList_;
-    static KMessagePipe<WorkData, MAX_WORK_ITEMS> fnLowPriorityWorkList_;
+    static WorkSource workHigh_;
+    static WorkSource workLow_;
+    static WorkPolicy workPolicy_;
     static KSemaphore sem_;
 
 
@@ -89,55 +174,7 @@ private:
 
 
 private:
-    class CmpTimer
-    {
-    public:
-        // never let different objects compare equivalent.
-        // meaning, if both set to expire at the same time, then
-        // fine, but decide one is "less" than the other by looking
-        // at seqno value.  otherwise the insert/delete api
-        // for multiset winds up operating on groups at a time
-        // when all I want is individual object access.
-        bool operator()(Timer * const &t1, Timer * const &t2) const
-        {
-            bool retVal;
-
-            if (t1 == t2)
-            {
-                retVal = false;
-            }
-            else
-            {
-                if (t1->GetTimeoutAtUs() < t2->GetTimeoutAtUs())
-                {
-                    retVal = true;
-                }
-                else if (t1->GetTimeoutAtUs() == t2->GetTimeoutAtUs())
-                {
-                    // in a scenario where two timers are both set to go off at the
-                    // same time, we want the one which was scheduled first to be
-                    // fired first.
-                    // This is helpful in a scenario where there are zero-length
-                    // timers, we don't want one to starve out another.
-                    if (t1->GetSeqNo() < t2->GetSeqNo())
-                    {
-                        retVal = true;
-                    }
-                    else
-                    {
-                        retVal = false;
-                    }
-                }
-                else    // t1->GetTimeoutAtUs() > t2->GetTimeoutAtUs()
-                {
-                    retVal = false;
-                }
-            }
-            
-            return retVal;
-        }
-    };
-    static std::multiset<Timer *, CmpTimer> timerList_;
+    static TimerList timerList_;
 
 
     //////////////////////////////////////////////////////////////////////
@@ -150,6 +187,20 @@ private:
     static const uint32_t STATS_INTERVAL_MS = 5'000;
     static const uint32_t STATS_HISTORY_COUNT = 2;
 
+    struct Latency
+    {
+        uint32_t COUNT  = 0;
+        uint32_t SUM_US = 0;
+        uint32_t MAX_US = 0;
+
+        void Add(uint32_t us)
+        {
+            ++COUNT;
+            SUM_US += us;
+            if (us > MAX_US) { MAX_US = us; }
+        }
+    };
+
     struct Stats
     {
         uint32_t HANDLED_WORK = 0;
@@ -165,21 +216,34 @@ private:
         uint32_t TIME_SUM_LATENT   = 0;
 
         uint32_t LOOPS = 0;
+
+        uint32_t WORK_BUDGET_EXHAUSTED = 0;
+        uint32_t WORK_DROPPED          = 0;     // from ISRs, queue full
+
+        uint16_t WORK_DEPTH_MAX     = 0;
+        uint16_t LOW_PRIO_DEPTH_MAX = 0;
+
+        Latency LATENCY_WORK;
+        Latency LATENCY_LOW_PRIO;
+        Latency LATENCY_LOW_PRIO_AGED;
     };
 
     struct StatsSnapshot
     {
         uint64_t snapshotTime = 0;
+        WorkPolicy workPolicy;
         Stats stats;
     };
 
     static Stats stats_;
+    inline static uint32_t workDroppedLogged_ = 0;
     static CircularBuffer<StatsSnapshot> statsHistory_;
     static Timer timerStats_;
 
     static void DumpStats();
     static Stats GetStatsDelta(Stats &s1, Stats &s2);
-    static void DumpStats(Stats &stats, uint32_t duration);
+    static void DumpStats(Stats &stats, uint32_t duration, const WorkPolicy &workPolicy);
+    static void CaptureQueueDepthStats();
     static const Stats &GetStats();
 
     static Timer timerWatchdog_;
@@ -278,7 +278,7 @@ void Timer::Print(uint64_t timeNowUs) const
 
     Log("name_                   : ", name_);
     Log("isInterval_             : ", isInterval_);
-    Log("ptr                     : ", Commas((uint32_t)this));
+    Log("ptr                     : ", Commas((uint32_t)(uintptr_t)this));
     Log("id_                     : ", id_);
     Log("seqNo_                  : ", Commas(seqNo_));
     Log("snapToUs_               : ", Commas(snapToUs_));
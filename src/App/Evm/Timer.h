@@ -9,6 +9,8 @@
 
 class Timer
 {
+    friend class TimerListHeap;
+
 public:
 
     /////////////////////////////////////////////////////////////////
@@ -135,5 +137,13 @@ private:
     uint64_t registeredAtUs_ = 0;
     uint64_t durationUs_     = 0;
     uint64_t timeoutCount_   = 0;
+
+    // intrusive links for when Evm keeps timers in a TimerListHeap.
+    // prev is the parent when this is the leftmost child, otherwise the
+    // sibling to the left.
+    Timer *heapPrev_    = nullptr;
+    Timer *heapChild_   = nullptr;
+    Timer *heapSibling_ = nullptr;
+    bool   heapLinked_  = false;
 };
 
@@ -0,0 +1,350 @@
+#pragma once
+
+#include "Timer.h"
+
+#include <cstdint>
+#include <functional>
+#include <set>
+
+
+// Evm keeps its pending timers ordered by expiry, tie-broken by the order
+// of registration (seqNo), so that timers due at the same time fire
+// earliest-scheduler-first.
+//
+// Two interchangeable implementations are available, selected at build
+// time by PICO_INF_EVM_TIMER_HEAP:
+// - TimerListHeap     - intrusive pairing heap, links live in the Timer
+//                       itself, no heap allocation on arm/cancel (default)
+// - TimerListMultiset - the original std::multiset, one allocated tree node
+//                       per registration
+
+
+class CmpTimer
+{
+public:
+    // never let different objects compare equivalent.
+    // meaning, if both set to expire at the same time, then
+    // fine, but decide one is "less" than the other by looking
+    // at seqno value.  otherwise the insert/delete api
+    // for multiset winds up operating on groups at a time
+    // when all I want is individual object access.
+    bool operator()(const Timer *t1, const Timer *t2) const
+    {
+        bool retVal;
+
+        if (t1 == t2)
+        {
+            retVal = false;
+        }
+        else
+        {
+            if (t1->GetTimeoutAtUs() < t2->GetTimeoutAtUs())
+            {
+                retVal = true;
+            }
+            else if (t1->GetTimeoutAtUs() == t2->GetTimeoutAtUs())
+            {
+                // in a scenario where two timers are both set to go off at the
+                // same time, we want the one which was scheduled first to be
+                // fired first.
+                // This is helpful in a scenario where there are zero-length
+                // timers, we don't want one to starve out another.
+                if (t1->GetSeqNo() < t2->GetSeqNo())
+                {
+                    retVal = true;
+                }
+                else
+                {
+                    retVal = false;
+                }
+            }
+            else    // t1->GetTimeoutAtUs() > t2->GetTimeoutAtUs()
+            {
+                retVal = false;
+            }
+        }
+
+        return retVal;
+    }
+};
+
+
+class TimerListMultiset
+{
+public:
+
+    void Insert(Timer *timer)
+    {
+        list_.insert(timer);
+    }
+
+    void Erase(Timer *timer)
+    {
+        list_.erase(timer);
+    }
+
+    bool Contains(const Timer *timer) const
+    {
+        return list_.contains((Timer *)timer);
+    }
+
+    bool Empty() const
+    {
+        return list_.empty();
+    }
+
+    uint32_t Size() const
+    {
+        return (uint32_t)list_.size();
+    }
+
+    // earliest-expiring timer, only valid when not empty
+    Timer *Front() const
+    {
+        return *list_.begin();
+    }
+
+    // visits in expiry order
+    void ForEach(std::function<void(Timer *timer)> fn) const
+    {
+        for (auto timer : list_)
+        {
+            fn(timer);
+        }
+    }
+
+
+private:
+
+    std::multiset<Timer *, CmpTimer> list_;
+};
+
+
+// Pairing heap, with the node links embedded in each Timer.
+//
+// Insert is O(1), Front is O(1), Contains is O(1).
+// Erase (of the front on expiry, or of any timer on cancel) is amortized
+// O(log n), and is done by relinking pointers only.
+class TimerListHeap
+{
+public:
+
+    void Insert(Timer *timer)
+    {
+        // an interval timer which re-arms itself as an interval from
+        // within its own callback gets registered twice, unlink first
+        // so the heap can't be corrupted.
+        // (unlinking does not depend on the expiry, which may have changed)
+        if (timer->heapLinked_)
+        {
+            Erase(timer);
+        }
+
+        timer->heapPrev_    = nullptr;
+        timer->heapChild_   = nullptr;
+        timer->heapSibling_ = nullptr;
+        timer->heapLinked_  = true;
+
+        root_ = root_ ? Link(root_, timer) : timer;
+
+        ++size_;
+    }
+
+    void Erase(Timer *timer)
+    {
+        if (!timer->heapLinked_)
+        {
+            return;
+        }
+
+        if (timer == root_)
+        {
+            root_ = MergePairs(timer->heapChild_);
+        }
+        else
+        {
+            // detach from the parent (if leftmost child) or left sibling
+            Timer *prev = timer->heapPrev_;
+            if (prev->heapChild_ == timer)
+            {
+                prev->heapChild_ = timer->heapSibling_;
+            }
+            else
+            {
+                prev->heapSibling_ = timer->heapSibling_;
+            }
+
+            if (timer->heapSibling_)
+            {
+                timer->heapSibling_->heapPrev_ = prev;
+            }
+
+            // re-home the children of the removed timer
+            Timer *sub = MergePairs(timer->heapChild_);
+            if (sub)
+            {
+                root_ = Link(root_, sub);
+            }
+        }
+
+        timer->heapPrev_    = nullptr;
+        timer->heapChild_   = nullptr;
+        timer->heapSibling_ = nullptr;
+        timer->heapLinked_  = false;
+
+        --size_;
+    }
+
+    bool Contains(const Timer *timer) const
+    {
+        return timer->heapLinked_;
+    }
+
+    bool Empty() const
+    {
+        return root_ == nullptr;
+    }
+
+    uint32_t Size() const
+    {
+        return size_;
+    }
+
+    // earliest-expiring timer, only valid when not empty
+    Timer *Front() const
+    {
+        return root_;
+    }
+
+    // visits in heap order, not expiry order
+    void ForEach(std::function<void(Timer *timer)> fn) const
+    {
+        Timer *timer = root_;
+
+        while (timer)
+        {
+            fn(timer);
+
+            if (timer->heapChild_)
+            {
+                timer = timer->heapChild_;
+            }
+            else
+            {
+                // climb until there is a sibling to move on to
+                while (timer && !timer->heapSibling_)
+                {
+                    timer = GetParent(timer);
+                }
+
+                if (timer)
+                {
+                    timer = timer->heapSibling_;
+                }
+            }
+        }
+    }
+
+
+private:
+
+    static bool Less(const Timer *t1, const Timer *t2)
+    {
+        return CmpTimer{}(t1, t2);
+    }
+
+    // both must be roots, the loser becomes the leftmost child of the winner.
+    // the winner's prev/sibling links are left for the caller to set.
+    static Timer *Link(Timer *t1, Timer *t2)
+    {
+        Timer *winner = t1;
+        Timer *loser  = t2;
+        if (Less(t2, t1))
+        {
+            winner = t2;
+            loser  = t1;
+        }
+
+        loser->heapPrev_    = winner;
+        loser->heapSibling_ = winner->heapChild_;
+        if (winner->heapChild_)
+        {
+            winner->heapChild_->heapPrev_ = loser;
+        }
+        winner->heapChild_ = loser;
+
+        return winner;
+    }
+
+    // standard two-pass merge of a sibling list into a single tree,
+    // done iteratively, re-using the sibling links as the work list.
+    static Timer *MergePairs(Timer *first)
+    {
+        if (!first)
+        {
+            return nullptr;
+        }
+
+        // first pass, left to right, link pairs and stack the results
+        Timer *stack = nullptr;
+        while (first)
+        {
+            Timer *t1 = first;
+            Timer *t2 = t1->heapSibling_;
+
+            Timer *merged;
+            if (t2)
+            {
+                first  = t2->heapSibling_;
+                merged = Link(t1, t2);
+            }
+            else
+            {
+                first  = nullptr;
+                merged = t1;
+            }
+
+            merged->heapSibling_ = stack;
+            stack = merged;
+        }
+
+        // second pass, right to left, fold the stack into one tree
+        Timer *root = stack;
+        stack = stack->heapSibling_;
+        while (stack)
+        {
+            Timer *next = stack->heapSibling_;
+            root = Link(root, stack);
+            stack = next;
+        }
+
+        root->heapPrev_    = nullptr;
+        root->heapSibling_ = nullptr;
+
+        return root;
+    }
+
+    static Timer *GetParent(const Timer *timer)
+    {
+        // walk left across siblings until reaching the leftmost child
+        while (timer->heapPrev_ && timer->heapPrev_->heapChild_ != timer)
+        {
+            timer = timer->heapPrev_;
+        }
+
+        return timer->heapPrev_;
+    }
+
+
+private:
+
+    Timer    *root_ = nullptr;
+    uint32_t  size_ = 0;
+};
+
+
+#if PICO_INF_EVM_TIMER_HEAP == 1
+using TimerList = TimerListHeap;
+#else
+using TimerList = TimerListMultiset;
+#endif
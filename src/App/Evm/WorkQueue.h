@@ -0,0 +1,219 @@
+#pragma once
+
+#include "PAL.h"
+
+#include <cstdint>
+#include <new>
+#include <utility>
+
+
+// Fixed-capacity FIFO of move-only objects (eg InplaceFunction), safe to
+// use from ISRs.
+//
+// Unlike KMessagePipe, elements are not byte-copied through a kernel
+// queue.  They are move-constructed into place and destroyed on removal,
+// so they may own resources.
+//
+// Each operation is a short interrupt-locked section rather than a kernel
+// queue call.
+template <typename T, uint16_t SIZE>
+class WorkQueue
+{
+public:
+
+    WorkQueue() = default;
+
+    ~WorkQueue()
+    {
+        Flush();
+    }
+
+    WorkQueue(const WorkQueue &)            = delete;
+    WorkQueue &operator=(const WorkQueue &) = delete;
+
+    // returns false if full, in which case val is left untouched.
+    // wasEmpty reports whether this was the first element queued, which is
+    // the only time a sleeping consumer needs waking.
+    bool Put(T &&val, bool *wasEmpty = nullptr)
+    {
+        return Emplace(wasEmpty, std::move(val));
+    }
+
+    // as Put, but constructs the element in place from args
+    template <typename ...Args>
+    bool Emplace(bool *wasEmpty, Args &&...args)
+    {
+        IrqLock lock;
+
+        if (count_ == SIZE)
+        {
+            return false;
+        }
+
+        if (wasEmpty)
+        {
+            *wasEmpty = count_ == 0;
+        }
+
+        new (Slot((uint16_t)((head_ + count_) % SIZE))) T{std::forward<Args>(args)...};
+        ++count_;
+
+        if (count_ > countMax_)
+        {
+            countMax_ = count_;
+        }
+
+        return true;
+    }
+
+    // as Put, but when full the oldest element is discarded to make room
+    void PutDropOldest(T &&val, bool *wasEmpty = nullptr)
+    {
+        EmplaceDropOldest(wasEmpty, std::move(val));
+    }
+
+    template <typename ...Args>
+    void EmplaceDropOldest(bool *wasEmpty, Args &&...args)
+    {
+        IrqLock lock;
+
+        if (count_ == SIZE)
+        {
+            Slot(head_)->~T();
+            head_ = (uint16_t)((head_ + 1) % SIZE);
+            --count_;
+        }
+
+        Emplace(wasEmpty, std::forward<Args>(args)...);
+    }
+
+    bool Get(T &val)
+    {
+        IrqLock lock;
+
+        if (count_ == 0)
+        {
+            return false;
+        }
+
+        T *slot = Slot(head_);
+        val = std::move(*slot);
+        slot->~T();
+
+        head_ = (uint16_t)((head_ + 1) % SIZE);
+        --count_;
+
+        return true;
+    }
+
+    // move up to countMax elements, oldest first, into the caller's array
+    // in a single locked section.  returns the number moved.
+    uint16_t GetBulk(T *valList, uint16_t countMax)
+    {
+        IrqLock lock;
+
+        uint16_t countGet = count_ < countMax ? count_ : countMax;
+        for (uint16_t i = 0; i < countGet; ++i)
+        {
+            T *slot = Slot(head_);
+            valList[i] = std::move(*slot);
+            slot->~T();
+
+            head_ = (uint16_t)((head_ + 1) % SIZE);
+        }
+        count_ = (uint16_t)(count_ - countGet);
+
+        return countGet;
+    }
+
+    // remove every element matching the predicate, preserving the order of
+    // those which remain.  returns the number removed.
+    template <typename Pred>
+    uint16_t RemoveIf(Pred pred)
+    {
+        IrqLock lock;
+
+        uint16_t countKeep = 0;
+        for (uint16_t i = 0; i < count_; ++i)
+        {
+            T *slot = Slot((uint16_t)((head_ + i) % SIZE));
+
+            if (pred(*slot))
+            {
+                slot->~T();
+            }
+            else
+            {
+                if (countKeep != i)
+                {
+                    T *slotKeep = Slot((uint16_t)((head_ + countKeep) % SIZE));
+                    new (slotKeep) T(std::move(*slot));
+                    slot->~T();
+                }
+
+                ++countKeep;
+            }
+        }
+
+        uint16_t countRemoved = (uint16_t)(count_ - countKeep);
+        count_ = countKeep;
+
+        return countRemoved;
+    }
+
+    uint16_t Count() const
+    {
+        // read fresh, may be changed by an ISR between calls
+        return *(const volatile uint16_t *)&count_;
+    }
+
+    bool IsFull() const
+    {
+        return count_ == SIZE;
+    }
+
+    // greatest count seen since the last reset
+    uint16_t GetHighWaterMark() const
+    {
+        return *(const volatile uint16_t *)&countMax_;
+    }
+
+    void ResetHighWaterMark()
+    {
+        IrqLock lock;
+
+        countMax_ = count_;
+    }
+
+    void Flush()
+    {
+        IrqLock lock;
+
+        while (count_)
+        {
+            Slot(head_)->~T();
+            head_ = (uint16_t)((head_ + 1) % SIZE);
+            --count_;
+        }
+
+        head_ = 0;
+    }
+
+
+private:
+
+    T *Slot(uint16_t idx)
+    {
+        return (T *)&buf_[idx * sizeof(T)];
+    }
+
+
+private:
+
+    alignas(T) uint8_t buf_[SIZE * sizeof(T)];
+
+    uint16_t head_  = 0;
+    uint16_t count_ = 0;
+
+    uint16_t countMax_ = 0;
+};
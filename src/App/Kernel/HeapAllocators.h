@@ -123,7 +123,7 @@ struct IsrPoolHeapAllocator
         if (!found)
         {
             LogModeSync();
-            Log("ERR: IsrPoolHeapAllocator Dealloc(", (uint32_t)p, ", ", n, ", ", POOL_SIZE, ")");
+            Log("ERR: IsrPoolHeapAllocator Dealloc(", (uint32_t)(uintptr_t)p, ", ", n, ", ", POOL_SIZE, ")");
             Validate();
         }
     }
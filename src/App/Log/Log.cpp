@@ -206,6 +206,9 @@ void Log(unsigned int val)
     LogNL();
 }
 
+// uint32_t and int32_t are distinct from unsigned int and int on the target,
+// but are the same types on a 64-bit host build
+#if PICO_INF_HOST_BUILD != 1
 void LogNNL(uint32_t val)
 {
     FormatAndUartSend("%u", val);
@@ -216,6 +219,7 @@ void Log(uint32_t val)
     LogNNL(val);
     LogNL();
 }
+#endif
 
 void LogNNL(uint16_t val)
 {
@@ -264,6 +268,7 @@ void Log(int val)
     LogNL();
 }
 
+#if PICO_INF_HOST_BUILD != 1
 void LogNNL(int32_t val)
 {
     FormatAndUartSend("%i", val);
@@ -274,6 +279,7 @@ void Log(int32_t val)
     LogNNL(val);
     LogNL();
 }
+#endif
 
 void LogNNL(int16_t val)
 {
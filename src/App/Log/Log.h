@@ -210,13 +210,13 @@ extern void LogNNL();
 template <typename T>
 void LogNNL(T *val)
 {
-    LogNNL((uint32_t)val);
+    LogNNL((uint32_t)(uintptr_t)val);
 }
 
 template <typename T>
 void Log(T *val)
 {
-    Log((uint32_t)val);
+    Log((uint32_t)(uintptr_t)val);
     LogNL();
 }
 
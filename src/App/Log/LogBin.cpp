@@ -0,0 +1,207 @@
+#include "ByteRing.h"
+#include "Log.h"
+#include "LogBin.h"
+#include "PAL.h"
+#include "Shell.h"
+#include "Timeline.h"
+#include "Utl.h"
+
+#include <cinttypes>
+using namespace std;
+
+#include "StrictMode.h"
+
+
+#if PICO_INF_ENABLE_LOG_BIN == 1
+
+////////////////////////////////////////////////////////////////////////////////
+// Ring
+//
+// Writers (tasks and ISRs alike) are serialized by interrupt locking just
+// long enough to copy in a whole record, which keeps records contiguous and
+// in time order.  The one reader is lock-free against them.
+////////////////////////////////////////////////////////////////////////////////
+
+static const uint32_t LOG_BIN_RING_SIZE = 4096;
+
+static uint8_t LOG_BIN_BUF[LOG_BIN_RING_SIZE];
+static ByteRing<LOG_BIN_RING_SIZE> ring_(LOG_BIN_BUF);
+
+static uint32_t dropped_ = 0;
+
+// matched by content in the ELF by the decoder, keep in step with it
+static const char LOG_BIN_SYNC_FMT[] = "LogBin sync, %u dropped, %u bytes";
+
+
+static void LogBinMakeHeader(uint8_t *buf, const char *fmt, uint32_t timeUs, uint8_t argLen)
+{
+    uint32_t fmtAddr = (uint32_t)(uintptr_t)fmt;
+
+    memcpy(&buf[0], &fmtAddr, 4);
+    memcpy(&buf[4], &timeUs,  4);
+    buf[8] = argLen;
+}
+
+void LogBinWrite(const char *fmt, uint8_t *rec, uint8_t argLen)
+{
+    uint32_t recLen = LOG_BIN_HEADER_LEN + argLen;
+
+    IrqLock lock;
+
+    if (ring_.Space() >= recLen)
+    {
+        // timestamped inside the lock, so records are in time order
+        LogBinMakeHeader(rec, fmt, (uint32_t)PAL.Micros(), argLen);
+
+        ring_.Write(rec, recLen);
+    }
+    else
+    {
+        ++dropped_;
+    }
+}
+
+uint32_t LogBinRead(uint8_t *buf, uint32_t bufLen)
+{
+    return ring_.Read(buf, bufLen);
+}
+
+uint32_t LogBinCount()
+{
+    return ring_.Count();
+}
+
+uint32_t LogBinGetDroppedCount()
+{
+    return dropped_;
+}
+
+void LogBinClear()
+{
+    IrqLock lock;
+
+    ring_.Flush();
+
+    dropped_ = 0;
+}
+
+uint8_t LogBinMakeSyncRecord(uint8_t *buf, uint8_t bufLen)
+{
+    uint8_t retVal = 0;
+
+    const uint8_t ARG_LEN = 8;
+
+    if (bufLen >= LOG_BIN_HEADER_LEN + ARG_LEN)
+    {
+        uint32_t dropped = dropped_;
+        uint32_t count   = ring_.Count();
+
+        LogBinMakeHeader(buf, LOG_BIN_SYNC_FMT, (uint32_t)PAL.Micros(), ARG_LEN);
+        memcpy(&buf[LOG_BIN_HEADER_LEN + 0], &dropped, 4);
+        memcpy(&buf[LOG_BIN_HEADER_LEN + 4], &count,   4);
+
+        retVal = LOG_BIN_HEADER_LEN + ARG_LEN;
+    }
+
+    return retVal;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Dump
+////////////////////////////////////////////////////////////////////////////////
+
+// one line of "LOGBIN:<hex>" per chunk, which the decoder picks out of
+// whatever else is in the console capture
+static void LogBinDumpChunk(const uint8_t *buf, uint32_t bufLen)
+{
+    static const char *HEX = "0123456789ABCDEF";
+
+    char line[7 + 2 * 32 + 1] = "LOGBIN:";
+    uint32_t idx = 7;
+
+    for (uint32_t i = 0; i < bufLen; ++i)
+    {
+        line[idx++] = HEX[buf[i] >> 4];
+        line[idx++] = HEX[buf[i] & 0x0F];
+    }
+    line[idx] = '\0';
+
+    Log(line);
+}
+
+static void LogBinDump()
+{
+    uint8_t buf[32];
+
+    // the sync record goes first, and the dropped count with it is reset
+    uint8_t len;
+    {
+        IrqLock lock;
+
+        len = LogBinMakeSyncRecord(buf, sizeof(buf));
+        dropped_ = 0;
+    }
+    LogBinDumpChunk(buf, len);
+
+    // only what is there now, records arriving meanwhile wait for next time
+    uint32_t remaining = ring_.Count();
+    while (remaining)
+    {
+        uint32_t lenRead = LogBinRead(buf, remaining < sizeof(buf) ? remaining : (uint32_t)sizeof(buf));
+        LogBinDumpChunk(buf, lenRead);
+
+        remaining -= lenRead;
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Shell
+////////////////////////////////////////////////////////////////////////////////
+
+void LogBinSetupShell()
+{
+    Timeline::Global().Event("LogBinSetupShell");
+
+    Shell::AddCommand("log.bin.dump", [](vector<string>){
+        LogBinDump();
+    }, { .help = "dump binary log as hex, decode with utl/LogBinDecoder.py" });
+
+    Shell::AddCommand("log.bin.stats", [](vector<string>){
+        Log("Binary log");
+        Log("- queued  : ", Commas(ring_.Count()), " of ", Commas(ring_.Capacity()), " bytes (max ", Commas(ring_.GetHighWaterMark()), ")");
+        Log("- dropped : ", Commas(dropped_), " records");
+    }, { .help = "binary log stats" });
+
+    Shell::AddCommand("log.bin.clear", [](vector<string>){
+        LogBinClear();
+        ring_.ResetHighWaterMark();
+    }, { .help = "discard binary log" });
+
+    Shell::AddCommand("log.bin.test", [](vector<string>){
+        LogBin("log.bin.test");
+        LogBin("u32 %u, i32 %d, hex 0x%08X", 123456789u, -42, 0xDEADBEEF);
+        LogBin("u64 %" PRIu64 ", i64 %" PRId64, (uint64_t)12345678901234ull, (int64_t)-12345678901234ll);
+        LogBin("double %.3f, char %c, str %s", 3.14159, 'x', "in flash");
+        Log("Recorded, see log.bin.dump");
+    }, { .help = "record a few test entries" });
+
+    Shell::AddCommand("log.bin.bench", [](vector<string> argList){
+        uint32_t count = argList.size() ? (uint32_t)atoi(argList[0].c_str()) : 1'000;
+
+        uint32_t droppedBefore = dropped_;
+
+        uint64_t timeStart = PAL.Micros();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            LogBin("log.bin.bench %u %u", i, count);
+        }
+        uint64_t timeDiff = PAL.Micros() - timeStart;
+
+        Log("LogBin x ", Commas(count), ": ", Commas(timeDiff), " us, ", count ? (double)timeDiff * 1'000.0 / count : 0.0, " ns/call");
+        Log("Dropped: ", Commas(dropped_ - droppedBefore), ", see log.bin.clear");
+    }, { .argCount = -1, .help = "time <count=1000> LogBin calls of 2 args" });
+}
+
+#endif
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Deferred-format binary logging
+//
+// LogBin(fmt, args...) does no formatting on target.  It records the
+// address of fmt, a timestamp, and the raw bytes of the arguments into a
+// RAM ring, which costs little more than the copy, and is safe from ISRs.
+//
+// The ring is drained to the console as hex (log.bin.dump) and formatted on
+// the host by utl/LogBinDecoder.py, which looks the format strings (and any
+// %s arguments) up in the ELF of the build that produced them.
+//
+// So:
+// - fmt must be a string literal, it is recorded by address
+// - %s arguments must also be in flash (literals, const tables), never
+//   stack or heap strings
+// - arguments are arithmetic, enum, or pointer types only
+//
+// printf conventions for the format, eg "%" PRIu64 for 64-bit values.
+//
+// Record layout, little-endian, unaligned:
+//   uint32_t fmt address
+//   uint32_t time (us, low 32 bits)
+//   uint8_t  byte count of args
+//   args, each as
+//     - 4 bytes for integers (and bool, enums) up to 32 bits
+//     - 8 bytes for 64-bit integers
+//     - 8 bytes for floating point (as double)
+//     - pointer size for pointers
+//
+// When the ring is full new records are dropped (and counted), records
+// already recorded are never overwritten.
+//
+// Only built with PICO_INF_ENABLE_LOG_BIN=1, otherwise LogBin calls do
+// nothing and the ring takes no RAM.
+////////////////////////////////////////////////////////////////////////////////
+
+extern void LogBinSetupShell();
+
+static const uint8_t LOG_BIN_HEADER_LEN = 9;
+
+// called by LogBin, with the args already packed in rec after room for
+// the header, which is filled in here.  interrupt-locked internally.
+extern void LogBinWrite(const char *fmt, uint8_t *rec, uint8_t argLen);
+
+// consumer side, a single reader (eg the shell) only
+extern uint32_t LogBinRead(uint8_t *buf, uint32_t bufLen);
+extern uint32_t LogBinCount();
+extern uint32_t LogBinGetDroppedCount();
+extern void     LogBinClear();
+
+// a record with no ring behind it, for the start of a dump, which the
+// decoder uses to line up the addresses it sees with the ELF
+extern uint8_t LogBinMakeSyncRecord(uint8_t *buf, uint8_t bufLen);
+
+
+template <typename T>
+constexpr uint8_t LogBinArgSize()
+{
+    using U = std::decay_t<T>;
+
+    static_assert(std::is_arithmetic_v<U> || std::is_enum_v<U> || std::is_pointer_v<U> || std::is_null_pointer_v<U>,
+                  "LogBin: only arithmetic, enum, and pointer arguments can be recorded");
+
+    if constexpr (std::is_floating_point_v<U>)
+    {
+        return sizeof(double);
+    }
+    else if constexpr (std::is_pointer_v<U> || std::is_null_pointer_v<U>)
+    {
+        return sizeof(uintptr_t);
+    }
+    else if constexpr (sizeof(U) == 8)
+    {
+        return 8;
+    }
+    else
+    {
+        return 4;
+    }
+}
+
+template <typename T>
+inline uint8_t *LogBinPack(uint8_t *p, T val)
+{
+    using U = std::decay_t<T>;
+
+    if constexpr (std::is_floating_point_v<U>)
+    {
+        double v = (double)val;
+        memcpy(p, &v, sizeof(v));
+    }
+    else if constexpr (std::is_pointer_v<U> || std::is_null_pointer_v<U>)
+    {
+        uintptr_t v = (uintptr_t)val;
+        memcpy(p, &v, sizeof(v));
+    }
+    else if constexpr (sizeof(U) == 8)
+    {
+        memcpy(p, &val, sizeof(val));
+    }
+    else if constexpr (std::is_signed_v<U> && !std::is_enum_v<U>)
+    {
+        // sign-extended, so %d sees the right value whatever the width
+        int32_t v = (int32_t)val;
+        memcpy(p, &v, sizeof(v));
+    }
+    else
+    {
+        uint32_t v = (uint32_t)val;
+        memcpy(p, &v, sizeof(v));
+    }
+
+    return p + LogBinArgSize<T>();
+}
+
+template <typename ...Args>
+inline void LogBin(const char *fmt, Args ...args)
+{
+    static constexpr uint32_t ARG_LEN = (0u + ... + LogBinArgSize<Args>());
+    static_assert(ARG_LEN <= 255, "LogBin: too many argument bytes for one record");
+
+#if PICO_INF_ENABLE_LOG_BIN == 1
+    // the record is built whole so it goes into the ring in one copy
+    uint8_t rec[LOG_BIN_HEADER_LEN + ARG_LEN];
+
+    uint8_t *p = &rec[LOG_BIN_HEADER_LEN];
+    ((p = LogBinPack(p, args)), ...);
+    (void)p;
+
+    LogBinWrite(fmt, rec, (uint8_t)ARG_LEN);
+#else
+    (void)fmt;
+    ((void)args, ...);
+#endif
+}
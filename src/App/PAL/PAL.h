@@ -2,9 +2,14 @@
 
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "hardware/sync.h"
 
+#if PICO_INF_HOST_BUILD == 1
+#include "HostSim.h"
+#endif
+
 
 class PlatformAbstractionLayer
 {
@@ -30,10 +35,14 @@ public:
     inline __attribute__((always_inline))
     static bool InIsrReal()
     {
+#if PICO_INF_HOST_BUILD == 1
+        return HostSim::InIsr();
+#else
         // taken from https://github.com/FreeRTOS/FreeRTOS-Kernel/blob/7284d84dc88c5aaf2dc8337044177728b8bdae2d/portable/ThirdParty/GCC/RP2040/include/portmacro.h#L146
         uint32_t ulIPSR;
         __asm volatile ( "mrs %0, IPSR" : "=r" ( ulIPSR )::);
         return (uint8_t)ulIPSR > 0;
+#endif
     }
     inline __attribute__((always_inline))
     static uint32_t IrqLock()
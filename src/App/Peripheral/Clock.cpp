@@ -1,6 +1,8 @@
 #include "Clock.h"
+#include "ClockPllTable.h"
 #include "KTime.h"
 #include "Log.h"
+#include "PAL.h"
 #include "Pin.h"
 #include "Shell.h"
 #include "Timeline.h"
@@ -25,10 +27,10 @@
 #include "pico/stdlib.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <string>
 #include <vector>
-#include <unordered_map>
 #include <utility>
 using namespace std;
 
@@ -41,8 +43,7 @@ using namespace std;
 
 static bool verbose_ = false;
 
-struct PllConfig;
-static unordered_map<double, PllConfig> freq__data;
+static Clock::Stats stats_ = {};
 
 
 /////////////////////////////////////////////////////////////////
@@ -779,166 +780,107 @@ static void SetClockInitial()
     GoToInitialState();
 }
 
-struct PllConfig
+// Retunes pll_sys in place, for when clk_sys, clk_peri and clk_adc are all
+// already running straight from it, as they are once any PLL frequency has
+// been set.  Nothing is measured or captured, just registers, so this is
+// cheap enough to do around every burst of work.
+//
+// clk_sys steps over to clk_ref (XOSC) on its glitchless mux for the
+// duration, and clk_peri and clk_adc, which have no glitchless mux, are
+// stopped.  If only the post dividers change, the PLL stays locked and
+// they're rewritten, otherwise it's relocked for the new VCO.
+//
+// Returns false, having done nothing, if the clocks aren't arranged so.
+static bool SetPllSysFast(const ClockPllTable::Config &pc)
 {
-    double mhz;
-    uint refdiv;
-    uint fbdiv;
-    uint vco_freq;
-    uint post_div1;
-    uint post_div2;
+    static const uint32_t DIV_ONE = 1 << CLOCKS_CLK_SYS_DIV_INT_LSB;
 
-    void Print()
+    clock_hw_t *sys  = &clocks_hw->clk[clk_sys];
+    clock_hw_t *peri = &clocks_hw->clk[clk_peri];
+    clock_hw_t *adc  = &clocks_hw->clk[clk_adc];
+
+    bool pllOn = (pll_sys->pwr & (PLL_PWR_PD_BITS | PLL_PWR_VCOPD_BITS | PLL_PWR_POSTDIVPD_BITS)) == 0 &&
+                 (pll_sys->cs & PLL_CS_LOCK_BITS);
+
+    bool sysOk = (sys->ctrl & CLOCKS_CLK_SYS_CTRL_SRC_BITS) == CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLKSRC_CLK_SYS_AUX &&
+                 (sys->ctrl & CLOCKS_CLK_SYS_CTRL_AUXSRC_BITS) == (CLOCKS_CLK_SYS_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS << CLOCKS_CLK_SYS_CTRL_AUXSRC_LSB) &&
+                 sys->div == DIV_ONE;
+
+    bool periOk = (peri->ctrl & CLOCKS_CLK_PERI_CTRL_ENABLE_BITS) &&
+                  (peri->ctrl & CLOCKS_CLK_PERI_CTRL_AUXSRC_BITS) == (CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS << CLOCKS_CLK_PERI_CTRL_AUXSRC_LSB);
+
+    bool adcOk = (adc->ctrl & CLOCKS_CLK_ADC_CTRL_ENABLE_BITS) &&
+                 (adc->ctrl & CLOCKS_CLK_ADC_CTRL_AUXSRC_BITS) == (CLOCKS_CLK_ADC_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS << CLOCKS_CLK_ADC_CTRL_AUXSRC_LSB) &&
+                 adc->div == DIV_ONE;
+
+    bool retVal = pllOn && sysOk && periOk && adcOk;
+
+    if (retVal)
     {
-        Log("MHz      : ", mhz);
-        Log("refdiv   : ", refdiv);
-        Log("vco_freq : ", Commas(vco_freq));
-        Log("post_div1: ", post_div1);
-        Log("post_div2: ", post_div2);
+        uint32_t prim    = ((uint32_t)pc.postDiv1 << PLL_PRIM_POSTDIV1_LSB) | ((uint32_t)pc.postDiv2 << PLL_PRIM_POSTDIV2_LSB);
+        bool     sameVco = (pll_sys->cs & PLL_CS_REFDIV_BITS) == pc.refdiv &&
+                           (pll_sys->fbdiv_int & PLL_FBDIV_INT_BITS) == pc.fbdiv;
 
-        // Log(mhz, ", ", fbdiv, ", ", post_div1, ", ", post_div2, ", ", refdiv);
-    }
-};
+        if (sameVco && (pll_sys->prim & (PLL_PRIM_POSTDIV1_BITS | PLL_PRIM_POSTDIV2_BITS)) == prim)
+        {
+            ++stats_.switchesNone;
+        }
+        else
+        {
+            {
+                IrqLock lock;
 
-// 15.3 MHz is the lowest you can go with a PLL
-// 280  MHz is the fastest you can go without some kind of hang I haven't researched
-// 
-// adapted from vcocalc.py in pico-sdk
-static PllConfig GetPllConfigForFreq(double mhz, bool lowPowerPriority, bool mustBeExact)
-{
-    PllConfig retVal;
+                // clk_sys over to clk_ref
+                hw_clear_bits(&sys->ctrl, CLOCKS_CLK_SYS_CTRL_SRC_BITS);
+                while (!(sys->selected & (1u << CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLK_REF))) {}
 
-    static const double XOSC_FREQ_MHZ = 12;
+                // stop the others, which takes a couple of their (faster) cycles
+                hw_clear_bits(&peri->ctrl, CLOCKS_CLK_PERI_CTRL_ENABLE_BITS);
+                hw_clear_bits(&adc->ctrl,  CLOCKS_CLK_ADC_CTRL_ENABLE_BITS);
+                busy_wait_at_least_cycles(3);
 
-    Range<uint16_t> fbdiv_range = lowPowerPriority ? Range<uint16_t>(16, 320) : Range<uint16_t>(320, 16);
-    Range<uint8_t> postdiv_range(1, 7);
+                if (sameVco)
+                {
+                    pll_sys->prim = prim;
+                }
+                else
+                {
+                    pll_init(pll_sys, pc.refdiv, pc.GetVcoHz(), pc.postDiv1, pc.postDiv2);
+                }
 
-    uint16_t ref_min = 5;
-    uint16_t refdiv_min = 1;
-    uint16_t refdiv_max = 63;
-    Range refdiv_range = Range(refdiv_min,
-                                max(refdiv_min,
-                                    min(refdiv_max, (uint16_t)(XOSC_FREQ_MHZ / ref_min))));
+                hw_set_bits(&peri->ctrl, CLOCKS_CLK_PERI_CTRL_ENABLE_BITS);
+                hw_set_bits(&adc->ctrl,  CLOCKS_CLK_ADC_CTRL_ENABLE_BITS);
 
-    uint16_t vco_min =  750;
-    uint16_t vco_max = 1600;
+                // clk_sys back over to pll_sys
+                hw_set_bits(&sys->ctrl, CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLKSRC_CLK_SYS_AUX);
+                while (!(sys->selected & (1u << CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLKSRC_CLK_SYS_AUX))) {}
+            }
 
-    // Log("fbdiv_range  : ", fbdiv_range.GetStart(), " - ", fbdiv_range.GetEnd());
-    // Log("postdiv_range: ", postdiv_range.GetStart(), " - ", postdiv_range.GetEnd());
-    // Log("refdiv_range : ", refdiv_range.GetStart(), " - ", refdiv_range.GetEnd());
-    // LogNL();
+            clock_set_reported_hz(clk_sys,  pc.freqHz);
+            clock_set_reported_hz(clk_peri, pc.freqHz);
+            clock_set_reported_hz(clk_adc,  pc.freqHz);
 
-    double best_margin = mhz;
+            // uart divisors are worked out from clk_peri
+            if (UartIsEnabled(UART::UART_0)) { UartEnable(UART::UART_0); }
+            if (UartIsEnabled(UART::UART_1)) { UartEnable(UART::UART_1); }
 
-    for (uint16_t refdiv : refdiv_range)
-    {
-        for (uint16_t fbdiv : fbdiv_range)
-        {
-            double vco = XOSC_FREQ_MHZ / refdiv * fbdiv;
-            // Log(vco, " = ", XOSC_FREQ_MHZ, " / ", refdiv, " * ", fbdiv);
+            KTime::SetScalingFactor((double)pc.freqHz / 125'000'000.0);
 
-            if (vco < vco_min || vco > vco_max)
+            if (sameVco)
             {
-                continue;
+                ++stats_.switchesPostDiv;
             }
-
-            // pd1 is inner loop so that we prefer higher ratios of pd1:pd2
-            for (uint8_t pd2 : postdiv_range)
+            else
             {
-                for (uint8_t pd1 : postdiv_range)
-                {
-                    double out = vco / pd1 / pd2;
-                    // Log(out, " = ", vco, " / ", pd1, " / ", pd2);
-
-                    double margin = fabs(out - mhz);
-                    if (margin < best_margin)
-                    {
-                        retVal.mhz = out;
-                        retVal.refdiv = refdiv;
-                        retVal.fbdiv = fbdiv;
-                        retVal.vco_freq = (uint16_t)(XOSC_FREQ_MHZ / refdiv * fbdiv) * MHZ;
-                        retVal.post_div1 = pd1;
-                        retVal.post_div2 = pd2;
-
-                        best_margin = margin;
-                        // Log("Got a new best (margin ", margin, " MHz diff)");
-                        // retVal.Print();
-                    }
-                }
+                ++stats_.switchesRelock;
             }
         }
     }
 
-    if (retVal.mhz != mhz && mustBeExact)
-    {
-        retVal = PllConfig{};
-    }
-
     return retVal;
 }
 
 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
 static void DoNothing() { Log("DoNothing"); }
 static void DoNothingSilent() { }
 
@@ -1151,11 +1093,24 @@ static void PrintCount()
 //    clk_usb   48,000,000  PLL_USB
 //    clk_adc   48,000,000  PLL_SYS
 //    clk_rtc       46,000  XOSC
+//
+// Moving between PLL frequencies takes the fast path where it can, which is
+// any time but the first after 6 or 12 MHz (or other clock changes).
 void Clock::SetClockMHz(double mhz, bool lowPowerPriority, bool mustBeExact)
 {
-    Timeline::Global().Event("SET_CLOCK_MHZ");
+    SetClockKHz((uint32_t)round(mhz * 1'000), lowPowerPriority, mustBeExact);
+}
+
+bool Clock::SetClockKHz(uint32_t khz, bool lowPowerPriority, bool mustBeExact)
+{
+    Timeline::Global().Event("SET_CLOCK_KHZ");
+
+    bool retVal = true;
+    bool fast   = false;
+
+    uint64_t timeStartUs = PAL.Micros();
 
-    if (mhz == 6)
+    if (khz == 6'000)
     {
         // set up new state
         State newState;
@@ -1197,7 +1152,7 @@ void Clock::SetClockMHz(double mhz, bool lowPowerPriority, bool mustBeExact)
         // apply
         SetState(newState);
     }
-    else if (mhz == 12)
+    else if (khz == 12'000)
     {
         // set up new state
         State newState;
@@ -1239,19 +1194,25 @@ void Clock::SetClockMHz(double mhz, bool lowPowerPriority, bool mustBeExact)
     }
     else 
     {
-        // Figure out PLL configuration to get to requested MHz
-        PllConfig pc;
-        
-        if (freq__data.contains(mhz))
+        // Figure out PLL configuration to get to requested kHz
+        ClockPllTable::Config pc;
+
+        if (ClockPllTable::Lookup(khz * 1'000, pc, lowPowerPriority, mustBeExact) == false)
         {
-            pc = freq__data[mhz];
+            Log("SetClockKHz ERR: Could not set frequency ", khz, " kHz");
+
+            retVal = false;
         }
-        else
+        else if (SetPllSysFast(pc))
         {
-            pc = GetPllConfigForFreq(mhz, lowPowerPriority, mustBeExact);
-        }
+            fast = true;
 
-        if (pc.refdiv != 0)
+            if (verbose_)
+            {
+                PrintAll();
+            }
+        }
+        else
         {
             // set up new state
             State newState;
@@ -1260,17 +1221,17 @@ void Clock::SetClockMHz(double mhz, bool lowPowerPriority, bool mustBeExact)
             PllState psSys = GetPllState(pll_sys);
             psSys.on = true;
             psSys.pllData.refdiv = pc.refdiv;
-            psSys.pllData.vco_freq = pc.vco_freq;
-            psSys.pllData.post_div1 = pc.post_div1;
-            psSys.pllData.post_div2 = pc.post_div2;
+            psSys.pllData.vco_freq = pc.GetVcoHz();
+            psSys.pllData.post_div1 = pc.postDiv1;
+            psSys.pllData.post_div2 = pc.postDiv2;
             newState.pllStateList.push_back(psSys);
 
             // change clk_sys to be driven by pll_sys
             ClockState csSys = OverlayClockState(clk_sys, {
                 .src     = CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLKSRC_CLK_SYS_AUX,
                 .auxsrc  = CLOCKS_CLK_SYS_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS,
-                .freqSrc = (uint32_t)mhz * MHZ,
-                .freq    = (uint32_t)mhz * MHZ,
+                .freqSrc = pc.freqHz,
+                .freq    = pc.freqHz,
             });
             newState.clockStateList.push_back(csSys);
 
@@ -1278,8 +1239,8 @@ void Clock::SetClockMHz(double mhz, bool lowPowerPriority, bool mustBeExact)
             ClockState csPeri = OverlayClockState(clk_peri, {
                 .src     = 0,
                 .auxsrc  = CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS,
-                .freqSrc = (uint32_t)mhz * MHZ,
-                .freq    = (uint32_t)mhz * MHZ,
+                .freqSrc = pc.freqHz,
+                .freq    = pc.freqHz,
             });
             newState.clockStateList.push_back(csPeri);
 
@@ -1287,19 +1248,45 @@ void Clock::SetClockMHz(double mhz, bool lowPowerPriority, bool mustBeExact)
             ClockState csAdc = OverlayClockState(clk_adc, {
                 .src     = 0,
                 .auxsrc  = CLOCKS_CLK_ADC_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS,
-                .freqSrc = (uint32_t)mhz * MHZ,
-                .freq    = (uint32_t)mhz * MHZ,
+                .freqSrc = pc.freqHz,
+                .freq    = pc.freqHz,
             });
             newState.clockStateList.push_back(csAdc);
 
             // apply
             SetState(newState);
         }
+    }
+
+    if (retVal)
+    {
+        uint32_t durationUs = (uint32_t)(PAL.Micros() - timeStartUs);
+
+        if (fast)
+        {
+            stats_.fastUsMax = max(stats_.fastUsMax, durationUs);
+        }
         else
         {
-            Log("SetClockMHz ERR: Could not set frequency ", mhz);
+            ++stats_.switchesSlow;
+            stats_.slowUsMax = max(stats_.slowUsMax, durationUs);
         }
     }
+
+    return retVal;
+}
+
+uint32_t Clock::GetClockKHz()
+{
+    return clock_get_hz(clk_sys) / 1'000;
+}
+
+void Clock::SetVoltageMv(uint16_t mv)
+{
+    mv = clamp(mv, (uint16_t)850, (uint16_t)1300);
+
+    // handles increments of 50mV starting at 0.85V
+    vreg_set_voltage((vreg_voltage)(VREG_VOLTAGE_0_85 + (mv - 850) / 50));
 }
 
 static bool usbEnabled_ = true;
@@ -1334,14 +1321,14 @@ bool Clock::IsEnabledUSB()
     return usbEnabled_;
 }
 
-void Clock::PrepareClockMHz(double mhz, bool lowPowerPriority, bool mustBeExact)
+void Clock::PrepareClockMHz(double, bool, bool)
 {
-    if (mhz != 6 && mhz != 12)
-    {
-        PllConfig pc = GetPllConfigForFreq(mhz, lowPowerPriority, mustBeExact);
+    // nothing to prepare, the PLL settings are worked out at compile time
+}
 
-        freq__data[mhz] = pc;
-    }
+const Clock::Stats &Clock::GetStats()
+{
+    return stats_;
 }
 
 
@@ -1470,23 +1457,35 @@ void Clock::SetupShell()
         PrintAll();
     }, { .argCount = -1, .help = "Set <x> MHz, <y> lowPowerPriority, <z> mustBeExact" });
 
-    Shell::AddCommand("clk.prep", [](vector<string> argList) {
-        double mhz              = atof(argList[0].c_str());
-        bool   lowPowerPriority = false;
-        bool   mustBeExact      = false;
+    Shell::AddCommand("clk.pll", [](vector<string> argList) {
+        uint32_t khz              = (uint32_t)round(atof(argList[0].c_str()) * 1'000);
+        bool     lowPowerPriority = false;
 
         if (argList.size() >= 2)
         {
             lowPowerPriority = atoi(argList[1].c_str());
         }
 
-        if (argList.size() >= 3)
-        {
-            mustBeExact = atoi(argList[2].c_str());
-        }
-
-        PrepareClockMHz(mhz, lowPowerPriority, mustBeExact);
-    }, { .argCount = -1, .help = "Prepare <x> MHz, <y> lowPowerPriority, <z> mustBeExact" });
+        ClockPllTable::Config pc;
+        bool exact = ClockPllTable::Lookup(khz * 1'000, pc, lowPowerPriority, true);
+
+        Log("freq     : ", Commas(pc.freqHz), " Hz", exact ? " (exact)" : "");
+        Log("refdiv   : ", pc.refdiv);
+        Log("fbdiv    : ", pc.fbdiv);
+        Log("vco_freq : ", Commas(pc.GetVcoHz()));
+        Log("post_div1: ", pc.postDiv1);
+        Log("post_div2: ", pc.postDiv2);
+    }, { .argCount = -1, .help = "Show pll_sys settings for <x> MHz, <y> lowPowerPriority" });
+
+    Shell::AddCommand("clk.stats", [](vector<string> argList) {
+        Log("Fast switches : ", Commas(stats_.switchesPostDiv + stats_.switchesRelock),
+            " (", Commas(stats_.switchesPostDiv), " post div only, ",
+            Commas(stats_.switchesRelock), " relocked, ",
+            Commas(stats_.switchesNone), " already there)");
+        Log("Slow switches : ", Commas(stats_.switchesSlow));
+        Log("Fast us max   : ", Commas(stats_.fastUsMax));
+        Log("Slow us max   : ", Commas(stats_.slowUsMax));
+    }, { .argCount = 0, .help = "frequency switching stats" });
 
     Shell::AddCommand("clk.usb", [](vector<string> argList) {
         if (atoi(argList[0].c_str()))
@@ -1681,12 +1680,7 @@ void Clock::SetupShell()
 
         Log("req ", argList[0], ", got ", v);
 
-        // handles increments of 0.05 starting at 0.85
-        uint8_t vregVal = VREG_VOLTAGE_0_85 + (uint8_t)((v - 0.85) / 0.05);
-
-        Log("vregVal: ", ToBin(vregVal));
-
-        vreg_set_voltage((vreg_voltage)vregVal);
+        SetVoltageMv((uint16_t)round(v * 1'000));
     }, { .argCount = 1, .help = "set vreg to 0.85 <= x <= 1.30" });
 }
 
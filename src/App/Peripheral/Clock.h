@@ -1,20 +1,37 @@
 #pragma once
 
+#include <cstdint>
+
 
 class Clock
 {
 public:
+    struct Stats
+    {
+        uint32_t switchesNone;      // fast, already there
+        uint32_t switchesPostDiv;   // fast, pll_sys stayed locked
+        uint32_t switchesRelock;    // fast, pll_sys relocked
+        uint32_t switchesSlow;      // full state change
+        uint32_t fastUsMax;
+        uint32_t slowUsMax;
+    };
+
     static void SetClockMHz(double mhz,
                             bool   lowPowerPriority = false,
                             bool   mustBeExact      = false);
+    static bool SetClockKHz(uint32_t khz,
+                            bool     lowPowerPriority = false,
+                            bool     mustBeExact      = false);
+    static uint32_t GetClockKHz();
+    static void SetVoltageMv(uint16_t mv);  // core, 850 - 1300 in 50mV steps
     static void EnableUSB();
     static void DisableUSB(); // saves 4mA
     static bool IsEnabledUSB();
-    static void PrepareClockMHz(double mhz, bool lowPowerPriority = false, bool mustBeExact = false);
+    static void PrepareClockMHz(double mhz, bool lowPowerPriority = false, bool mustBeExact = false);   // no longer needed
+    static const Stats &GetStats();
     static void PrintAll();
     static void SetVerbose(bool verbose);
 
     static void Init();
     static void SetupShell();
 };
-
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+
+// Every frequency pll_sys can make from the 12 MHz crystal, up to 280 MHz,
+// worked out at compile time and kept sorted with the settings which make
+// it.  Looking one up is a binary search for the nearest.
+//
+// The constraints are those of vcocalc.py in pico-sdk: a reference of at
+// least 5 MHz (refdiv 1-2), fbdiv 16-320 keeping the VCO within
+// 750-1600 MHz, and post dividers 1-7.
+//
+// Most frequencies can be made more than one way, so two are kept.  By
+// default the highest VCO, for the least jitter, otherwise the lowest, for
+// the least power.  Between otherwise equal settings the smaller refdiv
+// wins, then the smaller post_div2.
+//
+// 15.3 MHz is the lowest a PLL can go.
+// 280  MHz is the fastest before some kind of hang, not researched.
+class ClockPllTable
+{
+public:
+
+    static const uint32_t XOSC_HZ     = 12'000'000;
+    static const uint32_t FREQ_MAX_HZ = 280'000'000;
+
+    struct Config
+    {
+        uint32_t freqHz;    // rounded to the Hz
+        bool     exact;     // no rounding was needed
+        uint8_t  refdiv;
+        uint16_t fbdiv;
+        uint8_t  postDiv1;
+        uint8_t  postDiv2;
+
+        uint32_t GetVcoHz() const
+        {
+            return XOSC_HZ / refdiv * fbdiv;
+        }
+
+        bool operator==(const Config &) const = default;
+    };
+
+    // Gets the nearest frequency to freqHz, the lower of two equally near.
+    // With mustBeExact, returns false unless that is exactly freqHz.
+    static bool Lookup(uint32_t freqHz, Config &config, bool lowPowerPriority = false, bool mustBeExact = false)
+    {
+        auto it = std::lower_bound(entryList_.begin(), entryList_.end(), freqHz, [](const Entry &entry, uint32_t freqHz){
+            return entry.freqHz < freqHz;
+        });
+
+        if (it == entryList_.end())
+        {
+            --it;
+        }
+        else if (it != entryList_.begin() && freqHz - (it - 1)->freqHz <= it->freqHz - freqHz)
+        {
+            --it;
+        }
+
+        config = GetConfig(*it, lowPowerPriority);
+
+        return mustBeExact == false || (config.exact && config.freqHz == freqHz);
+    }
+
+    static uint16_t GetCount()
+    {
+        return ENTRY_COUNT;
+    }
+
+    static Config GetConfig(uint16_t idx, bool lowPowerPriority = false)
+    {
+        return GetConfig(entryList_[idx], lowPowerPriority);
+    }
+
+
+private:
+
+    // checked against the generated table at compile time
+    static const uint16_t ENTRY_COUNT = 2'245;
+
+    static const uint16_t FBDIV_MIN = 16;
+    static const uint16_t FBDIV_MAX = 320;
+    static const uint8_t  REFDIV_MAX = 2;
+    static const uint8_t  POSTDIV_MAX = 7;
+    static const uint32_t VCO_MIN_HZ = 750'000'000;
+    static const uint32_t VCO_MAX_HZ = 1'600'000'000;
+
+    static const uint16_t CANDIDATE_COUNT_MAX = REFDIV_MAX * (FBDIV_MAX - FBDIV_MIN + 1) * POSTDIV_MAX * POSTDIV_MAX;
+
+    // 8 bytes, the frequency, then both ways of making it
+    struct Entry
+    {
+        uint32_t freqHz;
+
+        uint32_t refdiv            : 2;
+        uint32_t fbdiv             : 9;
+        uint32_t postDiv1          : 3;
+        uint32_t postDiv2          : 3;
+        uint32_t fbdivLowPower     : 9;
+        uint32_t postDiv1LowPower  : 3;
+        uint32_t postDiv2LowPower  : 3;
+    };
+
+    // frequency is XOSC_HZ * fbdiv / (refdiv * postDiv1 * postDiv2), kept
+    // as the fraction so equal frequencies compare equal
+    struct Candidate
+    {
+        uint64_t num;
+        uint16_t den;
+        uint8_t  refdiv;
+        uint16_t fbdiv;
+        uint8_t  postDiv1;
+        uint8_t  postDiv2;
+
+        constexpr bool IsSameFreq(const Candidate &other) const
+        {
+            return num * other.den == other.num * den;
+        }
+    };
+
+    using CandidateList = std::array<Candidate, CANDIDATE_COUNT_MAX>;
+
+    static Config GetConfig(const Entry &entry, bool lowPowerPriority)
+    {
+        Config retVal = {
+            .freqHz   = entry.freqHz,
+            .exact    = false,
+            .refdiv   = (uint8_t)entry.refdiv,
+            .fbdiv    = (uint16_t)(lowPowerPriority ? entry.fbdivLowPower : entry.fbdiv),
+            .postDiv1 = (uint8_t)(lowPowerPriority ? entry.postDiv1LowPower  : entry.postDiv1),
+            .postDiv2 = (uint8_t)(lowPowerPriority ? entry.postDiv2LowPower  : entry.postDiv2),
+        };
+
+        retVal.exact = ((uint64_t)XOSC_HZ * retVal.fbdiv) % (retVal.refdiv * retVal.postDiv1 * retVal.postDiv2) == 0;
+
+        return retVal;
+    }
+
+    // Fills the list with every usable setting, sorted by frequency and
+    // then preference, and returns how many.
+    static constexpr uint16_t MakeCandidateList(CandidateList &list)
+    {
+        uint16_t count = 0;
+
+        for (uint8_t refdiv = 1; refdiv <= REFDIV_MAX; ++refdiv)
+        {
+            for (uint16_t fbdiv = FBDIV_MIN; fbdiv <= FBDIV_MAX; ++fbdiv)
+            {
+                uint64_t vcoHz = (uint64_t)XOSC_HZ * fbdiv / refdiv;
+
+                if (vcoHz < VCO_MIN_HZ || vcoHz > VCO_MAX_HZ)
+                {
+                    continue;
+                }
+
+                for (uint8_t pd2 = 1; pd2 <= POSTDIV_MAX; ++pd2)
+                {
+                    for (uint8_t pd1 = 1; pd1 <= POSTDIV_MAX; ++pd1)
+                    {
+                        uint16_t den = (uint16_t)(refdiv * pd1 * pd2);
+
+                        if ((uint64_t)XOSC_HZ * fbdiv > (uint64_t)FREQ_MAX_HZ * den)
+                        {
+                            continue;
+                        }
+
+                        list[count] = {
+                            .num      = (uint64_t)XOSC_HZ * fbdiv,
+                            .den      = den,
+                            .refdiv   = refdiv,
+                            .fbdiv    = fbdiv,
+                            .postDiv1 = pd1,
+                            .postDiv2 = pd2,
+                        };
+                        ++count;
+                    }
+                }
+            }
+        }
+
+        std::sort(list.begin(), list.begin() + count, [](const Candidate &a, const Candidate &b){
+            uint64_t aFreq = a.num * b.den;
+            uint64_t bFreq = b.num * a.den;
+
+            if (aFreq      != bFreq)      { return aFreq      < bFreq;      }
+            if (a.refdiv   != b.refdiv)   { return a.refdiv   < b.refdiv;   }
+            if (a.fbdiv    != b.fbdiv)    { return a.fbdiv    > b.fbdiv;    }
+            if (a.postDiv2 != b.postDiv2) { return a.postDiv2 < b.postDiv2; }
+
+            return a.postDiv1 < b.postDiv1;
+        });
+
+        return count;
+    }
+
+    // not constexpr, so reaching it fails the build
+    static void ErrEntryCountMismatch();
+
+    static constexpr std::array<Entry, ENTRY_COUNT> MakeEntryList()
+    {
+        std::array<Entry, ENTRY_COUNT> retVal{};
+
+        CandidateList list{};
+        uint16_t      count = MakeCandidateList(list);
+
+        uint16_t idx = 0;
+        for (uint16_t i = 0; i < count; ++idx)
+        {
+            // first is preferred, lowest VCO is the first at the lowest fbdiv
+            // for the same refdiv
+            const Candidate &first    = list[i];
+            const Candidate *lowPower = &first;
+
+            for (; i < count && list[i].IsSameFreq(first); ++i)
+            {
+                if (list[i].refdiv == first.refdiv && list[i].fbdiv < lowPower->fbdiv)
+                {
+                    lowPower = &list[i];
+                }
+            }
+
+            if (idx == ENTRY_COUNT)
+            {
+                ErrEntryCountMismatch();
+            }
+
+            Entry &entry = retVal[idx];
+            entry.freqHz           = (uint32_t)((first.num + first.den / 2) / first.den);
+            entry.refdiv           = first.refdiv;
+            entry.fbdiv            = first.fbdiv;
+            entry.postDiv1         = first.postDiv1;
+            entry.postDiv2         = first.postDiv2;
+            entry.fbdivLowPower    = lowPower->fbdiv;
+            entry.postDiv1LowPower = lowPower->postDiv1;
+            entry.postDiv2LowPower = lowPower->postDiv2;
+        }
+
+        if (idx != ENTRY_COUNT)
+        {
+            ErrEntryCountMismatch();
+        }
+
+        return retVal;
+    }
+
+
+private:
+
+    static const std::array<Entry, ENTRY_COUNT> entryList_;
+};
+
+inline constexpr std::array<ClockPllTable::Entry, ClockPllTable::ENTRY_COUNT> ClockPllTable::entryList_ = ClockPllTable::MakeEntryList();
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+
+// The storage FilesystemLittleFS sits on.
+//
+// Geometry as littlefs wants it, and the operations on it.  Offsets are
+// within a block, and littlefs keeps reads and programs to multiples of
+// readSize and progSize, and erases to whole blocks.
+//
+// Each operation returns false on error.
+//
+// Implementations:
+// - FilesystemBlockDeviceFlash, the top of the RP2040's flash
+// - FilesystemBlockDeviceRam, in RAM, optionally saved to a file, for
+//   benchmarking off-target
+struct FilesystemBlockDevice
+{
+    using FnRead  = std::function<bool(uint32_t block, uint32_t off, void *buf, uint32_t size)>;
+    using FnProg  = std::function<bool(uint32_t block, uint32_t off, const void *buf, uint32_t size)>;
+    using FnErase = std::function<bool(uint32_t block)>;
+    using FnSync  = std::function<bool()>;
+
+    uint32_t readSize   = 1;
+    uint32_t progSize   = 256;
+    uint32_t blockSize  = 4096;
+    uint32_t blockCount = 0;
+
+    FnRead  fnRead;
+    FnProg  fnProg;
+    FnErase fnErase;
+    FnSync  fnSync;     // optional
+};
@@ -0,0 +1,78 @@
+#include "FilesystemBlockDeviceFlash.h"
+#include "PAL.h"
+
+#include "hardware/flash.h"
+
+#include <cstring>
+using namespace std;
+
+#include "StrictMode.h"
+
+
+// Pico flash:
+// #define FLASH_PAGE_SIZE (1u << 8)        //   256
+// #define FLASH_SECTOR_SIZE (1u << 12)     //  4096
+// #define FLASH_BLOCK_SIZE (1u << 16)      // 65536
+
+// must erase multiples of sectors (4096)
+// must program multiples of pages ( 256)
+
+static const uint32_t FS_SIZE = 16 * FLASH_SECTOR_SIZE;  // 65,536
+// file system offset in flash
+static const uint32_t FS_BASE = PICO_FLASH_SIZE_BYTES - FS_SIZE;
+
+#if PICO_INF_ENABLE_KV == 1
+static const uint32_t KV_SIZE = 2 * FLASH_SECTOR_SIZE;   //  8,192
+static const uint32_t KV_BASE = FS_BASE - KV_SIZE;
+#endif
+
+
+// took pico flash operation code from here:
+// https://github.com/lurk101/littlefs-lib/blob/master/pico_hal.c
+
+FilesystemBlockDevice FilesystemBlockDeviceFlash::GetBlockDevice()
+{
+    return MakeBlockDevice(FS_BASE, FS_SIZE / FLASH_SECTOR_SIZE);
+}
+
+#if PICO_INF_ENABLE_KV == 1
+FilesystemBlockDevice FilesystemBlockDeviceFlash::GetKvBlockDevice()
+{
+    return MakeBlockDevice(KV_BASE, KV_SIZE / FLASH_SECTOR_SIZE);
+}
+#endif
+
+FilesystemBlockDevice FilesystemBlockDeviceFlash::MakeBlockDevice(uint32_t base, uint32_t blockCount)
+{
+    FilesystemBlockDevice retVal;
+
+    retVal.readSize   = 1;
+    retVal.progSize   = FLASH_PAGE_SIZE;
+    retVal.blockSize  = FLASH_SECTOR_SIZE;
+    retVal.blockCount = blockCount;
+
+    retVal.fnRead = [base](uint32_t block, uint32_t off, void *buf, uint32_t size){
+        // read flash via XIP mapped space
+        memcpy(buf, (const void *)(base + XIP_NOCACHE_NOALLOC_BASE + (block * FLASH_SECTOR_SIZE) + off), size);
+
+        return true;
+    };
+
+    retVal.fnProg = [base](uint32_t block, uint32_t off, const void *buf, uint32_t size){
+        IrqLock lock;
+        uint32_t p = base + (block * FLASH_SECTOR_SIZE) + off;
+        flash_range_program(p, (const uint8_t *)buf, size);
+
+        return true;
+    };
+
+    retVal.fnErase = [base](uint32_t block){
+        IrqLock lock;
+        uint32_t p = base + block * FLASH_SECTOR_SIZE;
+        flash_range_erase(p, FLASH_SECTOR_SIZE);
+
+        return true;
+    };
+
+    return retVal;
+}
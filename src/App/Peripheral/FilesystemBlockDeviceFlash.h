@@ -0,0 +1,27 @@
+#pragma once
+
+#include "FilesystemBlockDevice.h"
+
+
+// Regions at the top of the RP2040's flash:
+// - the filesystem, the top 64 KB
+// - the FlashKvLog store, the 8 KB below that, only when built with
+//   PICO_INF_ENABLE_KV=1, as it's taken from the space left for the
+//   application image
+//
+// Reads are through the XIP window, bypassing the cache.  Programs and
+// erases run with interrupts off, as XIP can't be used while they're in
+// progress.
+class FilesystemBlockDeviceFlash
+{
+public:
+
+    static FilesystemBlockDevice GetBlockDevice();
+#if PICO_INF_ENABLE_KV == 1
+    static FilesystemBlockDevice GetKvBlockDevice();
+#endif
+
+private:
+
+    static FilesystemBlockDevice MakeBlockDevice(uint32_t base, uint32_t blockCount);
+};
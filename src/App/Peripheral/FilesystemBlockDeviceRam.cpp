@@ -0,0 +1,155 @@
+#include "FilesystemBlockDeviceRam.h"
+
+#include <cstdio>
+#include <cstring>
+using namespace std;
+
+#include "StrictMode.h"
+
+
+FilesystemBlockDeviceRam::FilesystemBlockDeviceRam(uint32_t blockCount,
+                                                   uint32_t blockSize,
+                                                   uint32_t progSize,
+                                                   uint32_t readSize)
+: readSize_(readSize)
+, progSize_(progSize)
+, blockSize_(blockSize)
+, blockCount_(blockCount)
+, image_(blockCount * blockSize, 0xFF)
+{
+    // Nothing to do
+}
+
+FilesystemBlockDevice FilesystemBlockDeviceRam::GetBlockDevice()
+{
+    FilesystemBlockDevice retVal;
+
+    retVal.readSize   = readSize_;
+    retVal.progSize   = progSize_;
+    retVal.blockSize  = blockSize_;
+    retVal.blockCount = blockCount_;
+
+    retVal.fnRead = [this](uint32_t block, uint32_t off, void *buf, uint32_t size){
+        return Read(block, off, buf, size);
+    };
+    retVal.fnProg = [this](uint32_t block, uint32_t off, const void *buf, uint32_t size){
+        return Prog(block, off, buf, size);
+    };
+    retVal.fnErase = [this](uint32_t block){
+        return Erase(block);
+    };
+
+    return retVal;
+}
+
+void FilesystemBlockDeviceRam::EraseAll()
+{
+    memset(image_.data(), 0xFF, image_.size());
+}
+
+bool FilesystemBlockDeviceRam::LoadImage(const string &path)
+{
+    bool retVal = false;
+
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (fp)
+    {
+        vector<uint8_t> image(image_.size());
+
+        size_t bytesRead = fread(image.data(), 1, image.size(), fp);
+
+        // exactly the right size
+        if (bytesRead == image.size() && fgetc(fp) == EOF)
+        {
+            image_ = image;
+
+            retVal = true;
+        }
+
+        fclose(fp);
+    }
+
+    return retVal;
+}
+
+bool FilesystemBlockDeviceRam::SaveImage(const string &path) const
+{
+    bool retVal = false;
+
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (fp)
+    {
+        retVal = fwrite(image_.data(), 1, image_.size(), fp) == image_.size();
+
+        retVal = fclose(fp) == 0 && retVal;
+    }
+
+    return retVal;
+}
+
+const vector<uint8_t> &FilesystemBlockDeviceRam::GetImage() const
+{
+    return image_;
+}
+
+uint32_t FilesystemBlockDeviceRam::GetProgOverDataCount() const
+{
+    return progOverDataCount_;
+}
+
+bool FilesystemBlockDeviceRam::Read(uint32_t block, uint32_t off, void *buf, uint32_t size)
+{
+    bool retVal = InRange(block, off, size) && off % readSize_ == 0 && size % readSize_ == 0;
+
+    if (retVal)
+    {
+        memcpy(buf, &image_[block * blockSize_ + off], size);
+    }
+
+    return retVal;
+}
+
+bool FilesystemBlockDeviceRam::Prog(uint32_t block, uint32_t off, const void *buf, uint32_t size)
+{
+    bool retVal = InRange(block, off, size) && off % progSize_ == 0 && size % progSize_ == 0;
+
+    if (retVal)
+    {
+        uint8_t       *dst = &image_[block * blockSize_ + off];
+        const uint8_t *src = (const uint8_t *)buf;
+
+        bool overData = false;
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            // bits which would need setting back to 1, 0xFF being a byte
+            // left as it is
+            overData |= src[i] != 0xFF && (dst[i] & src[i]) != src[i];
+
+            dst[i] &= src[i];
+        }
+
+        if (overData)
+        {
+            ++progOverDataCount_;
+        }
+    }
+
+    return retVal;
+}
+
+bool FilesystemBlockDeviceRam::Erase(uint32_t block)
+{
+    bool retVal = InRange(block, 0, blockSize_);
+
+    if (retVal)
+    {
+        memset(&image_[block * blockSize_], 0xFF, blockSize_);
+    }
+
+    return retVal;
+}
+
+bool FilesystemBlockDeviceRam::InRange(uint32_t block, uint32_t off, uint32_t size) const
+{
+    return block < blockCount_ && off <= blockSize_ && size <= blockSize_ - off;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "FilesystemBlockDevice.h"
+
+#include <string>
+#include <vector>
+
+
+// A block device held in RAM, behaving as NOR flash does.
+//
+// Erasing sets a block to 0xFF, and programming can only clear bits, so
+// a program over bytes which weren't erased is applied the way flash
+// would (ANDed in).  Where that leaves the data other than what was
+// written, it's counted.  Programming 0xFF over data, eg to add to a
+// partly programmed page, changes nothing, as on flash.
+//
+// The image can be loaded from and saved to a file, eg to keep a
+// filesystem across host runs, or inspect one.
+//
+// Defaults to the geometry of FilesystemBlockDeviceFlash.
+//
+// For the host build only (see host/CMakeLists.txt), it isn't part of the
+// firmware library.
+class FilesystemBlockDeviceRam
+{
+public:
+
+    FilesystemBlockDeviceRam(uint32_t blockCount = 16,
+                             uint32_t blockSize  = 4096,
+                             uint32_t progSize   = 256,
+                             uint32_t readSize   = 1);
+
+    // Bound to this object, which must outlive its use
+    FilesystemBlockDevice GetBlockDevice();
+
+    // Every block erased
+    void EraseAll();
+
+    // false if the file can't be read, or is the wrong size
+    bool LoadImage(const std::string &path);
+    bool SaveImage(const std::string &path) const;
+
+    const std::vector<uint8_t> &GetImage() const;
+
+    // programs which couldn't write what was asked, as the bytes weren't
+    // erased
+    uint32_t GetProgOverDataCount() const;
+
+
+private:
+
+    bool Read(uint32_t block, uint32_t off, void *buf, uint32_t size);
+    bool Prog(uint32_t block, uint32_t off, const void *buf, uint32_t size);
+    bool Erase(uint32_t block);
+
+    bool InRange(uint32_t block, uint32_t off, uint32_t size) const;
+
+
+private:
+
+    uint32_t readSize_;
+    uint32_t progSize_;
+    uint32_t blockSize_;
+    uint32_t blockCount_;
+
+    std::vector<uint8_t> image_;
+
+    uint32_t progOverDataCount_ = 0;
+};
@@ -1,3 +1,4 @@
+#include "FilesystemBlockDeviceFlash.h"
 #include "FilesystemLittleFS.h"
 #include "PAL.h"
 #include "Shell.h"
@@ -6,8 +7,7 @@
 
 #include "lfs.h"
 
-#include "hardware/flash.h"
-
+#include <cassert>
 using namespace std;
 
 #include "StrictMode.h"
@@ -59,6 +59,7 @@ static void LfsInfoToDirEnt(lfs_info &info, FilesystemLittleFS::DirEnt &dirEnt)
 
 inline static lfs_t      lfs_;
 inline static lfs_config lfsCfg_;
+inline static bool       mounted_ = false;
 
 
 static bool LfsMount()
@@ -97,6 +98,8 @@ static bool LfsMount()
         retVal = true;
     }
 
+    mounted_ = retVal;
+
     return retVal;
 }
 
@@ -114,6 +117,8 @@ static bool LfsUnMount()
         retVal = true;
     }
 
+    mounted_ = false;
+
     return retVal;
 }
 
@@ -161,54 +166,47 @@ static bool LfsFormat()
 
 
 /////////////////////////////////////////////////////////////////
-// Hook into RPi Pico Flash
+// Hook into Block Device
 /////////////////////////////////////////////////////////////////
 
 
 /*
 
-// Pico flash:
-// #define FLASH_PAGE_SIZE (1u << 8)        //   256
-// #define FLASH_SECTOR_SIZE (1u << 12)     //  4096
-// #define FLASH_BLOCK_SIZE (1u << 16)      // 65536
-
-// must erase multiples of sectors (4096)
-// must program multiples of pages ( 256)
-
 how to make files inlined?
 "non-inlined files take up at minimum one block"
 
 Inline files live in metadata, and size must be:
-- <= cache_size   = CACHE_SIZE_READ_WRITE(1024)
+- <= cache_size   = Config.cacheSize (512 by default)
 - <= attr_max     = LFS_ATTR_MAX(1022) (when zero) = 1022
 - <= block_size/8 = FLASH_SECTOR_SIZE(4096)/8 = 512
 - therefore, the max size of an inline file is 512, which is fine
 
 */
 
-static const uint32_t FS_SIZE = 16 * FLASH_SECTOR_SIZE;  // 65,536
-// file system offset in flash
-static const uint32_t FS_BASE = PICO_FLASH_SIZE_BYTES - FS_SIZE;
-
-static const uint32_t ERASE_CYCLES_BEFORE_METADATA_MOVE = 32;
+inline static FilesystemBlockDevice blockDevice_;
 
 // littlefs needs a read cache, a program cache, and one additional
-// cache per-file(!).
-// Must be a multiple of the read and program sizes,
-// and a factor of the block size
-static const uint32_t CACHE_SIZE_READ_WRITE = 512;
-inline static uint8_t readBuf_[CACHE_SIZE_READ_WRITE];
-inline static uint8_t writeBuf_[CACHE_SIZE_READ_WRITE];
+// cache per-file(!), the last allocated by littlefs on open.
+inline static vector<uint8_t> readBuf_;
+inline static vector<uint8_t> writeBuf_;
+inline static vector<uint8_t> lookaheadBuf_;
 
-static const uint32_t CACHE_SIZE_LOOKAHEAD = 32;
-inline static uint8_t lookaheadBuf_[CACHE_SIZE_LOOKAHEAD];
+inline static FilesystemLittleFS::Stats stats_;
+inline static vector<uint32_t>          eraseCountList_;
 
 
+static void AccumulateBusyUs(uint64_t timeStartUs)
+{
+    uint32_t durationUs = (uint32_t)(PAL.Micros() - timeStartUs);
 
-// took pico flash operation code from here:
-// https://github.com/lurk101/littlefs-lib/blob/master/pico_hal.c
+    stats_.busyUs += durationUs;
+    if (durationUs > stats_.busyUsMax)
+    {
+        stats_.busyUsMax = durationUs;
+    }
+}
 
-static int FlashRead(const lfs_config *c,
+static int BlockRead(const lfs_config *c,
                      lfs_block_t       block,
                      lfs_off_t         off,
                      void             *buffer,
@@ -218,13 +216,20 @@ static int FlashRead(const lfs_config *c,
 
     assert(block < lfsCfg_.block_count);
     assert(off + size <= lfsCfg_.block_size);
-    // read flash via XIP mapped space
-    memcpy(buffer, (const void *)(FS_BASE + XIP_NOCACHE_NOALLOC_BASE + (block * lfsCfg_.block_size) + off), size);
 
-    return LFS_ERR_OK;
+    ++stats_.reads;
+    stats_.readBytes += size;
+
+    bool ok = blockDevice_.fnRead(block, off, buffer, size);
+    if (!ok)
+    {
+        ++stats_.errors;
+    }
+
+    return ok ? LFS_ERR_OK : LFS_ERR_IO;
 }
 
-static int FlashProg(const lfs_config *c,
+static int BlockProg(const lfs_config *c,
                      lfs_block_t       block,
                      lfs_off_t         off,
                      const void       *buffer,
@@ -234,31 +239,55 @@ static int FlashProg(const lfs_config *c,
 
     assert(block < lfsCfg_.block_count);
 
-    IrqLock lock;
-    uint32_t p = (uint32_t)FS_BASE + (block * lfsCfg_.block_size) + off;
-    flash_range_program(p, (const uint8_t *)buffer, size);
+    ++stats_.progs;
+    stats_.progBytes += size;
 
-    return LFS_ERR_OK;
+    uint64_t timeStartUs = PAL.Micros();
+    bool ok = blockDevice_.fnProg(block, off, buffer, size);
+    AccumulateBusyUs(timeStartUs);
+
+    if (!ok)
+    {
+        ++stats_.errors;
+    }
+
+    return ok ? LFS_ERR_OK : LFS_ERR_IO;
 }
 
-static int FlashErase(const lfs_config *c, lfs_block_t block)
+static int BlockErase(const lfs_config *c, lfs_block_t block)
 {
     // Log("Erase block ", block);
 
     assert(block < lfsCfg_.block_count);
-    
-    IrqLock lock;
-    uint32_t p = (uint32_t)FS_BASE + block * lfsCfg_.block_size;
-    flash_range_erase(p, lfsCfg_.block_size);
 
-    return LFS_ERR_OK;
+    ++stats_.erases;
+    ++eraseCountList_[block];
+
+    uint64_t timeStartUs = PAL.Micros();
+    bool ok = blockDevice_.fnErase(block);
+    AccumulateBusyUs(timeStartUs);
+
+    if (!ok)
+    {
+        ++stats_.errors;
+    }
+
+    return ok ? LFS_ERR_OK : LFS_ERR_IO;
 }
 
-static int FlashSync(const lfs_config *c)
+static int BlockSync(const lfs_config *c)
 {
     // Log("Sync");
 
-    return LFS_ERR_OK;
+    ++stats_.syncs;
+
+    bool ok = blockDevice_.fnSync ? blockDevice_.fnSync() : true;
+    if (!ok)
+    {
+        ++stats_.errors;
+    }
+
+    return ok ? LFS_ERR_OK : LFS_ERR_IO;
 }
 
 
@@ -542,38 +571,94 @@ bool FilesystemLittleFS::Remove(const string &path)
 /////////////////////////////////////////////////////////////////
 
 void FilesystemLittleFS::Init()
+{
+    Init(FilesystemBlockDeviceFlash::GetBlockDevice());
+}
+
+bool FilesystemLittleFS::Init(const FilesystemBlockDevice &blockDevice)
+{
+    return Init(blockDevice, Config{});
+}
+
+bool FilesystemLittleFS::Init(const FilesystemBlockDevice &blockDevice, const Config &cfg)
 {
     Timeline::Global().Event("FilesystemLittleFS::Init");
 
+    if (cfg.cacheSize == 0 ||
+        cfg.cacheSize % blockDevice.readSize ||
+        cfg.cacheSize % blockDevice.progSize ||
+        blockDevice.blockSize % cfg.cacheSize ||
+        cfg.lookaheadSize == 0 ||
+        cfg.lookaheadSize % 8)
+    {
+        Log("LFS ERR: Init invalid cache (", cfg.cacheSize, ") or lookahead (", cfg.lookaheadSize, ") size");
+
+        return false;
+    }
+
+    if (mounted_)
+    {
+        LfsUnMount();
+    }
+
+    blockDevice_ = blockDevice;
+
+    readBuf_.assign(cfg.cacheSize, 0);
+    writeBuf_.assign(cfg.cacheSize, 0);
+    lookaheadBuf_.assign(cfg.lookaheadSize, 0);
+
+    ResetStats();
+
     lfsCfg_ = {
-        .read  = FlashRead,
-        .prog  = FlashProg,
-        .erase = FlashErase,
-        .sync  = FlashSync,
+        .read  = BlockRead,
+        .prog  = BlockProg,
+        .erase = BlockErase,
+        .sync  = BlockSync,
 
-        .read_size = 1,
-        .prog_size = FLASH_PAGE_SIZE,
+        .read_size = blockDevice_.readSize,
+        .prog_size = blockDevice_.progSize,
 
-        .block_size   = FLASH_SECTOR_SIZE,
-        .block_count  = FS_SIZE / FLASH_SECTOR_SIZE,
-        .block_cycles = ERASE_CYCLES_BEFORE_METADATA_MOVE,
+        .block_size   = blockDevice_.blockSize,
+        .block_count  = blockDevice_.blockCount,
+        .block_cycles = cfg.blockCycles,
 
-        .cache_size = CACHE_SIZE_READ_WRITE,
+        .cache_size = cfg.cacheSize,
 
-        .lookahead_size = CACHE_SIZE_LOOKAHEAD,
+        .lookahead_size = cfg.lookaheadSize,
 
-        .read_buffer = readBuf_,
-        .prog_buffer = writeBuf_,
+        .read_buffer = readBuf_.data(),
+        .prog_buffer = writeBuf_.data(),
 
-        .lookahead_buffer = lookaheadBuf_,
+        .lookahead_buffer = lookaheadBuf_.data(),
 
         .attr_max   = 0,
         .inline_max = 0,
     };
 
     // mount filesystem
-    Log("Mounting LittleFS (", Commas(FS_SIZE / 1024), " KB)");
-    LfsMount();
+    Log("Mounting LittleFS (", Commas(blockDevice_.blockSize * blockDevice_.blockCount / 1024), " KB)");
+    return LfsMount();
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Public Interface - Block Device Stats
+/////////////////////////////////////////////////////////////////
+
+const FilesystemLittleFS::Stats &FilesystemLittleFS::GetStats()
+{
+    return stats_;
+}
+
+const vector<uint32_t> &FilesystemLittleFS::GetEraseCountList()
+{
+    return eraseCountList_;
+}
+
+void FilesystemLittleFS::ResetStats()
+{
+    stats_ = Stats{};
+    eraseCountList_.assign(blockDevice_.blockCount, 0);
 }
 
 void FilesystemLittleFS::SetupShell()
@@ -590,6 +675,24 @@ void FilesystemLittleFS::SetupShell()
         Log("Timeline now ", showTimeline_ ? "on" : "off");
     }, { .argCount = 1, .help = "timeline on/off" });
 
+    Shell::AddCommand("lfs.stats", [](vector<string> argList){
+        const Stats &stats = GetStats();
+
+        Log("Reads      : ", Commas(stats.reads), " (", Commas(stats.readBytes), " bytes)");
+        Log("Programs   : ", Commas(stats.progs), " (", Commas(stats.progBytes), " bytes)");
+        Log("Erases     : ", Commas(stats.erases));
+        Log("Syncs      : ", Commas(stats.syncs));
+        Log("Errors     : ", Commas(stats.errors));
+        Log("Busy us    : ", Commas(stats.busyUs), " (max ", Commas(stats.busyUsMax), ")");
+
+        LogNNL("Erases/blk : ");
+        Log(GetEraseCountList());
+    }, { .argCount = 0, .help = "block device operation stats" });
+
+    Shell::AddCommand("lfs.stats.reset", [](vector<string> argList){
+        ResetStats();
+    }, { .argCount = 0, .help = "reset block device operation stats" });
+
     Shell::AddCommand("lfs.format", [](vector<string> argList){
         Timeline t;
         t.Event("start");
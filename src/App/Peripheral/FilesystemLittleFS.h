@@ -1,5 +1,6 @@
 #pragma once
 
+#include "FilesystemBlockDevice.h"
 #include "FilesystemLittleFSFile.h"
 
 #include <string>
@@ -14,10 +15,66 @@ public:
     // Init
     /////////////////////////////////////////////////////////////////
 
+    // littlefs tuning, see lfs_config.  The defaults are what flash has
+    // always been mounted with, LittleFSBench compares others.
+    struct Config
+    {
+        // the read and program caches, and each open file's, are this
+        // size.  a multiple of the program size, and a factor of the block
+        // size.  files no larger than this, and an eighth of a block, are
+        // kept inline in their directory's metadata.
+        uint32_t cacheSize = 512;
+
+        // bytes of the block allocation bitmap scanned ahead, 8 blocks
+        // each, a multiple of 8
+        uint32_t lookaheadSize = 32;
+
+        // erases of a metadata block before it is moved, for wear
+        // leveling, -1 to never move
+        int32_t blockCycles = 32;
+    };
+
+    // Mount on flash, formatting if needed
     static void Init();
+
+    // Mount on the given device, formatting if needed.  Anything already
+    // mounted is unmounted first.
+    static bool Init(const FilesystemBlockDevice &blockDevice);
+    static bool Init(const FilesystemBlockDevice &blockDevice, const Config &cfg);
+
     static void SetupShell();
 
 
+public:
+
+    /////////////////////////////////////////////////////////////////
+    // Block Device Stats
+    /////////////////////////////////////////////////////////////////
+
+    // Operations on the block device by littlefs, since Init or ResetStats.
+    // Time is only of programs and erases, as those are what block.
+    struct Stats
+    {
+        uint32_t reads     = 0;
+        uint64_t readBytes = 0;
+        uint32_t progs     = 0;
+        uint64_t progBytes = 0;
+        uint32_t erases    = 0;
+        uint32_t syncs     = 0;
+        uint32_t errors    = 0;
+
+        uint64_t busyUs    = 0;
+        uint32_t busyUsMax = 0;
+    };
+
+    static const Stats &GetStats();
+
+    // per block
+    static const std::vector<uint32_t> &GetEraseCountList();
+
+    static void ResetStats();
+
+
 public:
 
     /////////////////////////////////////////////////////////////////
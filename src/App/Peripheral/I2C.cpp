@@ -1,6 +1,7 @@
 #include "I2C.h"
 #include "KTime.h"
 #include "Log.h"
+#include "PAL.h"
 #include "Shell.h"
 #include "Timeline.h"
 #include "Utl.h"
@@ -8,6 +9,7 @@
 #include "hardware/gpio.h"
 #include "hardware/i2c.h"
 
+#include <algorithm>
 #include <cstring>
 #include <string>
 using namespace std;
@@ -168,10 +170,10 @@ bool I2C::IsAlive()
     // instead we read register 0 and upon success call the endpoint alive.
 
     uint8_t byte;
-    int ret = i2c_read_blocking_until(i2c_, addr_, &byte, 1, false, make_timeout_time_ms(TIMEOUT_MS));
-    AnalyzeRetVal(ret);
+    I2CEngine::Result result = GetEngine().Transfer(addr_, nullptr, 0, &byte, 1);
+    AnalyzeResult(result);
 
-    return ret >= 0;
+    return result.status == I2CEngine::Status::OK;
 }
 
 uint8_t I2C::GetAddr()
@@ -215,12 +217,25 @@ uint32_t I2C::ReadReg(uint8_t reg, uint8_t *buf, uint32_t bufSize, bool stop)
 
     if (buf && bufSize)
     {
-        int retWrite = i2c_write_blocking_until(i2c_, addr_, &reg, 1, true, make_timeout_time_ms(TIMEOUT_MS));
-        AnalyzeRetVal(retWrite);
+        if (stop && bufSize <= I2CEngine::MAX_READ)
+        {
+            // register write and data read as one transaction, with a
+            // repeated start between
+            I2CEngine::Result result = GetEngine().Transfer(addr_, &reg, 1, buf, (uint8_t)bufSize);
+            AnalyzeResult(result);
 
-        if (retWrite >= 0)
+            retVal = result.readLen;
+        }
+        else
         {
-            retVal = ReadRaw(buf, bufSize, stop);
+            int retWrite = RunDirect([&]{
+                return i2c_write_blocking_until(i2c_, addr_, &reg, 1, true, make_timeout_time_ms(TIMEOUT_MS));
+            });
+
+            if (retWrite >= 0)
+            {
+                retVal = ReadRaw(buf, bufSize, stop);
+            }
         }
     }
 
@@ -233,12 +248,23 @@ uint32_t I2C::ReadRaw(uint8_t *buf, uint32_t bufSize, bool stop)
 
     if (buf && bufSize)
     {
-        int retRead = i2c_read_blocking_until(i2c_, addr_, buf, (size_t)bufSize, !stop, make_timeout_time_ms(TIMEOUT_MS));
-        AnalyzeRetVal(retRead);
+        if (stop && bufSize <= I2CEngine::MAX_READ)
+        {
+            I2CEngine::Result result = GetEngine().Transfer(addr_, nullptr, 0, buf, (uint8_t)bufSize);
+            AnalyzeResult(result);
 
-        if (retRead >= 0)
+            retVal = result.readLen;
+        }
+        else
         {
-            retVal = (uint32_t)retRead;
+            int retRead = RunDirect([&]{
+                return i2c_read_blocking_until(i2c_, addr_, buf, (size_t)bufSize, !stop, make_timeout_time_ms(TIMEOUT_MS));
+            });
+
+            if (retRead >= 0)
+            {
+                retVal = (uint32_t)retRead;
+            }
         }
     }
 
@@ -288,25 +314,139 @@ uint32_t I2C::WriteRaw(uint8_t *buf, uint32_t bufSize, bool stop)
 
     if (buf && bufSize >= 1)
     {
-        int ret = i2c_write_blocking_until(i2c_, buf[0], (uint8_t *)&buf[1], bufSize - 1, !stop, make_timeout_time_ms(TIMEOUT_MS));
-        AnalyzeRetVal(ret);
+        uint32_t writeLen = bufSize - 1;
+
+        if (stop && writeLen >= 1 && writeLen <= I2CEngine::MAX_WRITE)
+        {
+            I2CEngine::Result result = GetEngine().Transfer(buf[0], &buf[1], (uint8_t)writeLen, nullptr, 0);
+            AnalyzeResult(result);
 
-        if (ret >= 0)
+            if (result.status == I2CEngine::Status::OK)
+            {
+                retVal = writeLen;
+            }
+        }
+        else
         {
-            retVal = (uint32_t)ret;
+            int ret = RunDirect([&]{
+                return i2c_write_blocking_until(i2c_, buf[0], (uint8_t *)&buf[1], writeLen, !stop, make_timeout_time_ms(TIMEOUT_MS));
+            });
+
+            if (ret >= 0)
+            {
+                retVal = (uint32_t)ret;
+            }
         }
     }
 
     return retVal;
 }
 
+bool I2C::ReadRegAsync(uint8_t reg, uint8_t len, FnDone fnDone)
+{
+    return WriteReadAsync(&reg, 1, len, fnDone);
+}
+
+bool I2C::WriteRegAsync(uint8_t reg, const uint8_t *buf, uint8_t len, FnDone fnDone)
+{
+    bool retVal = false;
+
+    if (len + 1 <= I2CEngine::MAX_WRITE && (buf || len == 0))
+    {
+        uint8_t bufLocal[I2CEngine::MAX_WRITE];
+
+        bufLocal[0] = reg;
+        if (len)
+        {
+            memcpy(&bufLocal[1], buf, len);
+        }
+
+        retVal = WriteReadAsync(bufLocal, (uint8_t)(len + 1), 0, fnDone);
+    }
+
+    return retVal;
+}
+
+bool I2C::WriteReadAsync(const uint8_t *writeBuf, uint8_t writeLen, uint8_t readLen, FnDone fnDone)
+{
+    uint8_t instanceIdx = GetInstanceIdx();
+
+    return GetEngine().Queue(addr_, writeBuf, writeLen, readLen, [=](const I2CEngine::Result &result){
+        Record(instanceIdx, result.addr, ToRetVal(result), result.queueUs, result.busUs);
+
+        if (fnDone)
+        {
+            fnDone(result.status == I2CEngine::Status::OK, result.readBuf, result.readLen);
+        }
+    });
+}
+
+
+
+
+
+uint8_t I2C::GetInstanceIdx()
+{
+    return i2c_ == i2c0 ? 0 : 1;
+}
+
+I2CEngine &I2C::GetEngine()
+{
+    return I2CEngine::Get(GetInstanceIdx());
+}
+
+// For what the engine can't express, the pico-sdk blocking call, once
+// anything queued ahead is done
+int I2C::RunDirect(function<int()> fn)
+{
+    int retVal = 0;
+
+    uint64_t timeQueuedUs  = PAL.Micros();
+    uint64_t timeStartedUs = 0;
+    uint64_t timeDoneUs    = 0;
+
+    GetEngine().Direct([&]{
+        timeStartedUs = PAL.Micros();
+        retVal = fn();
+        timeDoneUs = PAL.Micros();
+    });
+
+    AnalyzeRetVal(retVal, (uint32_t)(timeStartedUs - timeQueuedUs), (uint32_t)(timeDoneUs - timeStartedUs));
+
+    return retVal;
+}
+
+void I2C::AnalyzeResult(const I2CEngine::Result &result)
+{
+    AnalyzeRetVal(ToRetVal(result), result.queueUs, result.busUs);
+}
 
+void I2C::AnalyzeRetVal(int retVal, uint32_t queueUs, uint32_t busUs)
+{
+    Record(GetInstanceIdx(), addr_, retVal, queueUs, busUs);
 
+    retValLast_ = retVal;
+}
 
+int I2C::ToRetVal(const I2CEngine::Result &result)
+{
+    int retVal = PICO_OK;
 
-void I2C::AnalyzeRetVal(int retVal)
+    if (result.status == I2CEngine::Status::ABORT)
+    {
+        retVal = PICO_ERROR_GENERIC;
+    }
+    else if (result.status == I2CEngine::Status::TIMEOUT)
+    {
+        retVal = PICO_ERROR_TIMEOUT;
+    }
+
+    return retVal;
+}
+
+void I2C::Record(uint8_t instanceIdx, uint8_t addr, int retVal, uint32_t queueUs, uint32_t busUs)
 {
-    Stats &stats = stats_[i2c_ == i2c0 ? 0 : 1];
+    Stats &stats = stats_[instanceIdx];
 
     if (retVal == PICO_ERROR_GENERIC)
     {
@@ -325,7 +465,27 @@ void I2C::AnalyzeRetVal(int retVal)
         ++stats.PICO_OK;
     }
 
-    retValLast_ = retVal;
+    if (retVal >= 0 || stats.deviceStatsMap.contains(addr))
+    {
+        DeviceStats &deviceStats = stats.deviceStatsMap[addr];
+
+        if (retVal >= 0)
+        {
+            ++deviceStats.ok;
+        }
+        else if (retVal == PICO_ERROR_TIMEOUT)
+        {
+            ++deviceStats.timeouts;
+        }
+        else
+        {
+            ++deviceStats.errors;
+        }
+
+        deviceStats.queueUsMax  = max(deviceStats.queueUsMax, queueUs);
+        deviceStats.busUsMax    = max(deviceStats.busUsMax, busUs);
+        deviceStats.busUsTotal += busUs;
+    }
 }
 
 int I2C::GetRetValLast()
@@ -392,9 +552,10 @@ void I2C::Init0()
     {
         didOnce = true;
 
+        // once the bus is idle, and quietly, as clock scaling may do this
+        // often
         KTime::RegisterCallbackScalingFactorChange([]{
-            Log("I2C::Init0 re-init due to clock change");
-            Init0();
+            I2CEngine::Get(0).Direct([]{ Init0(); });
         });
     }
 }
@@ -415,9 +576,10 @@ void I2C::Init1()
     {
         didOnce = true;
 
+        // once the bus is idle, and quietly, as clock scaling may do this
+        // often
         KTime::RegisterCallbackScalingFactorChange([]{
-            Log("I2C::Init1 re-init due to clock change");
-            Init1();
+            I2CEngine::Get(1).Direct([]{ Init1(); });
         });
     }
 }
@@ -625,5 +787,17 @@ void I2C::Stats::Print()
     Log("PICO_ERROR_GENERIC: ", Commas(PICO_ERROR_GENERIC));
     Log("PICO_ERROR_TIMEOUT: ", Commas(PICO_ERROR_TIMEOUT));
     Log("PICO_ERROR_OTHER  : ", Commas(PICO_ERROR_OTHER));
+
+    for (const auto &[addr, deviceStats] : deviceStatsMap)
+    {
+        uint64_t count = deviceStats.ok + deviceStats.errors + deviceStats.timeouts;
+
+        Log("  ", ToHex(addr), ": ok ", Commas(deviceStats.ok),
+            ", err ", Commas(deviceStats.errors),
+            ", timeout ", Commas(deviceStats.timeouts),
+            ", bus us avg ", Commas(count ? deviceStats.busUsTotal / count : 0),
+            " max ", Commas(deviceStats.busUsMax),
+            ", queue us max ", Commas(deviceStats.queueUsMax));
+    }
 }
 
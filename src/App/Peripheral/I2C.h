@@ -1,8 +1,12 @@
 #pragma once
 
+#include "I2CEngine.h"
+
 #include "hardware/i2c.h"
 
 #include <cstdint>
+#include <functional>
+#include <map>
 #include <vector>
 
 
@@ -29,10 +33,22 @@ public:
     uint32_t WriteReg(uint8_t reg, uint8_t *buf, uint32_t bufSize, bool stop = true);
     uint32_t WriteRaw(uint8_t *buf, uint32_t bufSize, bool stop = true);
 
+    // Queued on the instance's I2CEngine, fnDone called from Evm when done,
+    // with what was read if ok.  Sizes are limited to what the engine takes.
+    // false if it couldn't be queued.
+    using FnDone = std::function<void(bool ok, const uint8_t *buf, uint8_t len)>;
+    bool ReadRegAsync(uint8_t reg, uint8_t len, FnDone fnDone);
+    bool WriteRegAsync(uint8_t reg, const uint8_t *buf, uint8_t len, FnDone fnDone = nullptr);
+    bool WriteReadAsync(const uint8_t *writeBuf, uint8_t writeLen, uint8_t readLen, FnDone fnDone);
+
 private:
 
-    void AnalyzeRetVal(int retVal);
-    int  GetRetValLast();
+    uint8_t    GetInstanceIdx();
+    I2CEngine &GetEngine();
+    int        RunDirect(std::function<int()> fn);
+    void       AnalyzeResult(const I2CEngine::Result &result);
+    void       AnalyzeRetVal(int retVal, uint32_t queueUs = 0, uint32_t busUs = 0);
+    int        GetRetValLast();
 
 
 private:
@@ -56,6 +72,16 @@ private:
 
     static const uint32_t TIMEOUT_MS = 5;
 
+    struct DeviceStats
+    {
+        uint64_t ok;
+        uint64_t errors;
+        uint64_t timeouts;
+        uint32_t queueUsMax;
+        uint32_t busUsMax;
+        uint64_t busUsTotal;
+    };
+
     struct Stats
     {
         uint64_t PICO_OK;
@@ -63,9 +89,16 @@ private:
         uint64_t PICO_ERROR_TIMEOUT;
         uint64_t PICO_ERROR_OTHER;
 
+        // only devices which have answered at least once, so a scan
+        // doesn't fill it
+        std::map<uint8_t, DeviceStats> deviceStatsMap;
+
         void Print();
     };
 
+    static int  ToRetVal(const I2CEngine::Result &result);
+    static void Record(uint8_t instanceIdx, uint8_t addr, int retVal, uint32_t queueUs, uint32_t busUs);
+
     inline static Stats stats_[2];
 };
 
@@ -0,0 +1,502 @@
+#include "Evm.h"
+#include "I2CEngine.h"
+#include "PAL.h"
+
+#include "hardware/i2c.h"
+#include "hardware/irq.h"
+
+#include <algorithm>
+#include <cstring>
+using namespace std;
+
+#include "StrictMode.h"
+
+
+// depth of each of the controller's FIFOs
+static const uint8_t FIFO_DEPTH = 16;
+
+// TX_EMPTY fires at or below this many commands left to send
+static const uint8_t TX_THRESHOLD = 4;
+
+static i2c_hw_t *GetHw(uint8_t instance)
+{
+    return i2c_get_hw(instance == 0 ? i2c0 : i2c1);
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Construction
+/////////////////////////////////////////////////////////////////
+
+I2CEngine &I2CEngine::Get(uint8_t instance)
+{
+    static I2CEngine engine0(0);
+    static I2CEngine engine1(1);
+
+    return instance == 0 ? engine0 : engine1;
+}
+
+I2CEngine::I2CEngine(uint8_t instance)
+: instance_(instance)
+, timer_(instance == 0 ? "TIMER_I2C0_ENGINE" : "TIMER_I2C1_ENGINE")
+{
+    timer_.SetCallback([this]{
+        CheckTimeout();
+    });
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Queueing
+/////////////////////////////////////////////////////////////////
+
+bool I2CEngine::Queue(uint8_t addr, const uint8_t *writeBuf, uint8_t writeLen, uint8_t readLen, FnDone fnDone)
+{
+    if (writeLen > MAX_WRITE || readLen > MAX_READ || writeLen + readLen == 0 || (writeLen && writeBuf == nullptr))
+    {
+        return false;
+    }
+
+    Reclaim();
+    if (IsFull())
+    {
+        return false;
+    }
+
+    Job &job = GetJob(seqTail_);
+
+    job.sync     = false;
+    job.addr     = addr;
+    job.writeLen = writeLen;
+    job.readLen  = readLen;
+    if (writeLen)
+    {
+        memcpy(job.writeBuf, writeBuf, writeLen);
+    }
+    job.fnDone = fnDone;
+
+    Publish();
+
+    return true;
+}
+
+I2CEngine::Result I2CEngine::Transfer(uint8_t addr, const uint8_t *writeBuf, uint8_t writeLen, uint8_t *readBuf, uint8_t readLen)
+{
+    if (writeLen > MAX_WRITE || readLen > MAX_READ || writeLen + readLen == 0 ||
+        (writeLen && writeBuf == nullptr) || (readLen && readBuf == nullptr))
+    {
+        return { Status::ABORT, addr, readBuf, 0, 0, 0 };
+    }
+
+    WaitForRoom();
+
+    Job &job = GetJob(seqTail_);
+
+    job.sync     = true;
+    job.addr     = addr;
+    job.writeLen = writeLen;
+    job.readLen  = readLen;
+    if (writeLen)
+    {
+        memcpy(job.writeBuf, writeBuf, writeLen);
+    }
+    job.fnDone = nullptr;
+
+    Publish();
+
+    // nothing else times the job out while blocked here
+    while (job.state != State::DONE)
+    {
+        CheckTimeout();
+    }
+
+    Result retVal = MakeResult(job);
+
+    if (retVal.readLen)
+    {
+        memcpy(readBuf, job.readBuf, retVal.readLen);
+    }
+    retVal.readBuf = readBuf;
+
+    job.state = State::FREE;
+    Reclaim();
+
+    return retVal;
+}
+
+void I2CEngine::Direct(function<void()> fn)
+{
+    while (IsIdle() == false)
+    {
+        CheckTimeout();
+    }
+
+    // only this thread starts jobs, so the controller stays idle
+    fn();
+}
+
+uint8_t I2CEngine::GetPendingCount()
+{
+    return (uint8_t)(seqTail_ - seqFree_);
+}
+
+bool I2CEngine::IsIdle()
+{
+    return jobActive_ == nullptr && seqStart_ == seqTail_;
+}
+
+void I2CEngine::SetTimeoutMs(uint32_t timeoutMs)
+{
+    timeoutMs_ = timeoutMs;
+}
+
+I2CEngine::Job &I2CEngine::GetJob(uint32_t seq)
+{
+    return jobList_[seq % QUEUE_DEPTH];
+}
+
+// Slots handed back out of order (blocking transfers finishing behind an
+// async job not yet called back) are passed over once what's before them
+// is done too.
+void I2CEngine::Reclaim()
+{
+    while (seqFree_ != seqStart_ && GetJob(seqFree_).state == State::FREE)
+    {
+        ++seqFree_;
+    }
+}
+
+bool I2CEngine::IsFull()
+{
+    return seqTail_ - seqFree_ >= QUEUE_DEPTH;
+}
+
+// Blocking callers can't wait on Evm to hand completions back, so do it
+// here, which frees up their slots.
+void I2CEngine::WaitForRoom()
+{
+    Reclaim();
+    while (IsFull())
+    {
+        CheckTimeout();
+        ProcessCompletions();
+        Reclaim();
+    }
+}
+
+void I2CEngine::Publish()
+{
+    Job &job = GetJob(seqTail_);
+
+    job.cmdIdx       = 0;
+    job.readIdx      = 0;
+    job.aborted      = false;
+    job.status       = Status::OK;
+    job.timeQueuedUs = PAL.Micros();
+    job.state        = State::QUEUED;
+
+    if (irqInit_ == false)
+    {
+        uint irq = instance_ == 0 ? I2C0_IRQ : I2C1_IRQ;
+
+        irq_set_exclusive_handler(irq, instance_ == 0 ? OnInterrupt0 : OnInterrupt1);
+        irq_set_enabled(irq, true);
+
+        irqInit_ = true;
+    }
+
+    {
+        IrqLock lock;
+
+        seqTail_ = seqTail_ + 1;
+
+        if (jobActive_ == nullptr)
+        {
+            StartNext();
+        }
+    }
+
+    if (timer_.IsPending() == false)
+    {
+        timer_.TimeoutIntervalMs(timeoutMs_);
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Bus, from the IRQ or with it locked out
+/////////////////////////////////////////////////////////////////
+
+void I2CEngine::StartNext()
+{
+    i2c_hw_t *hw = GetHw(instance_);
+
+    if (seqStart_ == seqTail_)
+    {
+        hw->intr_mask = 0;
+
+        return;
+    }
+
+    Job &job = GetJob(seqStart_);
+    seqStart_ = seqStart_ + 1;
+
+    jobActive_ = &job;
+    job.state = State::ACTIVE;
+    job.timeStartedUs = PAL.Micros();
+
+    // the target can only be changed while disabled, which also clears
+    // anything left over from the last job
+    hw->enable = 0;
+    hw->tar    = job.addr;
+    hw->rx_tl  = 0;
+    hw->tx_tl  = TX_THRESHOLD;
+    hw->enable = I2C_IC_ENABLE_ENABLE_BITS;
+    (void)hw->clr_intr;
+
+    hw->intr_mask = I2C_IC_INTR_MASK_M_TX_ABRT_BITS |
+                    I2C_IC_INTR_MASK_M_STOP_DET_BITS |
+                    I2C_IC_INTR_MASK_M_RX_FULL_BITS |
+                    I2C_IC_INTR_MASK_M_TX_EMPTY_BITS;
+
+    FillTx(job);
+}
+
+// Each byte to write and each byte to read is a command.  The first read
+// after a write restarts, the last command stops.  Reads aren't sent ahead
+// of room to receive them.
+void I2CEngine::FillTx(Job &job)
+{
+    i2c_hw_t *hw = GetHw(instance_);
+
+    uint8_t cmdCount = job.writeLen + job.readLen;
+    bool    blocked  = false;
+
+    while (job.cmdIdx < cmdCount && hw->txflr < FIFO_DEPTH)
+    {
+        uint32_t cmd = 0;
+
+        if (job.cmdIdx < job.writeLen)
+        {
+            cmd = job.writeBuf[job.cmdIdx];
+        }
+        else
+        {
+            uint8_t readsSent = job.cmdIdx - job.writeLen;
+            if (readsSent - job.readIdx >= FIFO_DEPTH)
+            {
+                blocked = true;
+
+                break;
+            }
+
+            cmd = I2C_IC_DATA_CMD_CMD_BITS;
+            if (job.writeLen && job.cmdIdx == job.writeLen)
+            {
+                cmd |= I2C_IC_DATA_CMD_RESTART_BITS;
+            }
+        }
+
+        if (job.cmdIdx == cmdCount - 1)
+        {
+            cmd |= I2C_IC_DATA_CMD_STOP_BITS;
+        }
+
+        hw->data_cmd = cmd;
+        ++job.cmdIdx;
+    }
+
+    // nothing more to send until there's room to receive
+    if (job.cmdIdx == cmdCount || blocked)
+    {
+        hw_clear_bits(&hw->intr_mask, I2C_IC_INTR_MASK_M_TX_EMPTY_BITS);
+    }
+    else
+    {
+        hw_set_bits(&hw->intr_mask, I2C_IC_INTR_MASK_M_TX_EMPTY_BITS);
+    }
+}
+
+void I2CEngine::DrainRx(Job &job)
+{
+    i2c_hw_t *hw = GetHw(instance_);
+
+    while (hw->rxflr)
+    {
+        uint8_t b = (uint8_t)hw->data_cmd;
+
+        if (job.readIdx < job.readLen)
+        {
+            job.readBuf[job.readIdx] = b;
+            ++job.readIdx;
+        }
+    }
+}
+
+void I2CEngine::Finish(Job &job, Status status)
+{
+    job.status     = status;
+    job.timeDoneUs = PAL.Micros();
+    job.state      = State::DONE;
+
+    jobActive_ = nullptr;
+
+    if (job.sync == false)
+    {
+        Evm::QueueWork("I2CEngine::Done", [this]{
+            ProcessCompletions();
+        });
+    }
+
+    StartNext();
+}
+
+void I2CEngine::OnInterrupt()
+{
+    i2c_hw_t *hw = GetHw(instance_);
+
+    Job *job = jobActive_;
+    if (job == nullptr)
+    {
+        hw->intr_mask = 0;
+
+        return;
+    }
+
+    uint32_t stat = hw->intr_stat;
+
+    // the controller flushes its TX FIFO and stops the bus
+    if (stat & I2C_IC_INTR_STAT_R_TX_ABRT_BITS)
+    {
+        job->aborted = true;
+        (void)hw->clr_tx_abrt;
+
+        hw_clear_bits(&hw->intr_mask, I2C_IC_INTR_MASK_M_TX_EMPTY_BITS);
+    }
+
+    if (stat & I2C_IC_INTR_STAT_R_RX_FULL_BITS)
+    {
+        DrainRx(*job);
+    }
+
+    if (job->aborted == false &&
+        (stat & (I2C_IC_INTR_STAT_R_TX_EMPTY_BITS | I2C_IC_INTR_STAT_R_RX_FULL_BITS)))
+    {
+        FillTx(*job);
+    }
+
+    if (stat & I2C_IC_INTR_STAT_R_STOP_DET_BITS)
+    {
+        (void)hw->clr_stop_det;
+
+        DrainRx(*job);
+
+        bool ok = job->aborted == false && job->readIdx == job->readLen;
+
+        Finish(*job, ok ? Status::OK : Status::ABORT);
+    }
+}
+
+void I2CEngine::OnInterrupt0()
+{
+    Get(0).OnInterrupt();
+}
+
+void I2CEngine::OnInterrupt1()
+{
+    Get(1).OnInterrupt();
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Completion and Timeout, on Evm
+/////////////////////////////////////////////////////////////////
+
+// In the order queued, up to the first job not done.  Blocking jobs are
+// handed back by the caller waiting on them.
+void I2CEngine::ProcessCompletions()
+{
+    while (seqFree_ != seqStart_)
+    {
+        Job &job = GetJob(seqFree_);
+
+        if (job.state == State::DONE && job.sync == false)
+        {
+            // the slot is handed back before calling back, as the callback
+            // may well queue more, or even come back in here
+            Result result = MakeResult(job);
+
+            uint8_t readBuf[MAX_READ];
+            memcpy(readBuf, job.readBuf, result.readLen);
+            result.readBuf = readBuf;
+
+            FnDone fnDone = move(job.fnDone);
+            job.fnDone = nullptr;
+
+            job.state = State::FREE;
+            ++seqFree_;
+
+            if (fnDone)
+            {
+                fnDone(result);
+            }
+        }
+        else if (job.state == State::FREE)
+        {
+            ++seqFree_;
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+I2CEngine::Result I2CEngine::MakeResult(const Job &job) const
+{
+    return {
+        .status  = job.status,
+        .addr    = job.addr,
+        .readBuf = job.readBuf,
+        .readLen = job.status == Status::OK ? job.readLen : (uint8_t)0,
+        .queueUs = (uint32_t)(job.timeStartedUs - job.timeQueuedUs),
+        .busUs   = (uint32_t)(job.timeDoneUs - job.timeStartedUs),
+    };
+}
+
+void I2CEngine::CheckTimeout()
+{
+    {
+        IrqLock lock;
+
+        Job *job = jobActive_;
+        if (job && PAL.Micros() - job->timeStartedUs >= (uint64_t)timeoutMs_ * 1'000)
+        {
+            // eg a device stretching the clock forever, let go of the bus
+            i2c_hw_t *hw = GetHw(instance_);
+
+            hw->intr_mask = 0;
+            hw_set_bits(&hw->enable, I2C_IC_ENABLE_ABORT_BITS);
+
+            // the abort ends with TX_ABRT, and the bit clearing itself, only
+            // once the byte in flight is done.  Wait, so what it raises is
+            // cleared here and not taken by the next job.
+            uint64_t timeStartUs = PAL.Micros();
+            while ((hw->enable & I2C_IC_ENABLE_ABORT_BITS) &&
+                   (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) == 0 &&
+                   PAL.Micros() - timeStartUs < ABORT_WAIT_US)
+            {
+            }
+            (void)hw->clr_tx_abrt;
+            (void)hw->clr_stop_det;
+            (void)hw->clr_intr;
+
+            Finish(*job, Status::TIMEOUT);
+        }
+    }
+
+    if (jobActive_ == nullptr && seqStart_ == seqTail_)
+    {
+        timer_.Cancel();
+    }
+}
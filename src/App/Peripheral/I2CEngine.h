@@ -0,0 +1,164 @@
+#pragma once
+
+#include "Timer.h"
+
+#include <cstdint>
+#include <functional>
+
+
+// Queued, interrupt-driven I2C transactions on one controller.
+//
+// A transaction is an optional write and an optional read, to one address,
+// the read following the write with a repeated start, then a stop.  That
+// covers a register read (write the register, read the data) in one job.
+//
+// Transactions are queued from the Evm thread, and carried out one after
+// another by the controller's IRQ, which feeds the TX FIFO with commands
+// and drains the RX FIFO as the bus gets to them.  The next queued one is
+// started from the IRQ as soon as the last stops, so a batch runs back to
+// back.  Completions are handed to their callback from Evm, in the order
+// queued.
+//
+// A transaction not finished in time is aborted, checked by an Evm timer
+// while any are outstanding.
+//
+// Transfer() is the blocking form, queued the same way, spinning until
+// done.  Direct() runs a blocking pico-sdk transfer once the queue is
+// empty, for the odd case the queue can't express (eg no stop at the end).
+class I2CEngine
+{
+public:
+
+    static const uint8_t QUEUE_DEPTH = 16;
+    static const uint8_t MAX_WRITE   = 32;
+    static const uint8_t MAX_READ    = 32;
+
+    enum class Status : uint8_t
+    {
+        OK,
+        ABORT,      // eg address or data NAK, arbitration lost
+        TIMEOUT,
+    };
+
+    struct Result
+    {
+        Status         status;
+        uint8_t        addr;
+        const uint8_t *readBuf;
+        uint8_t        readLen;
+
+        // from queued to started, and started to done
+        uint32_t queueUs;
+        uint32_t busUs;
+    };
+
+    using FnDone = std::function<void(const Result &result)>;
+
+
+public:
+
+    static I2CEngine &Get(uint8_t instance);
+
+    // false if the queue is full, the sizes are too large, or there's
+    // nothing to do
+    bool Queue(uint8_t addr, const uint8_t *writeBuf, uint8_t writeLen, uint8_t readLen, FnDone fnDone);
+
+    // Blocking.  readBuf gets what was read, if ok.
+    Result Transfer(uint8_t addr, const uint8_t *writeBuf, uint8_t writeLen, uint8_t *readBuf, uint8_t readLen);
+
+    // Waits for the queue to empty, then calls fn, during which nothing new
+    // will start
+    void Direct(std::function<void()> fn);
+
+    uint8_t GetPendingCount();
+
+    // Nothing on the bus, nor queued to go on it
+    bool IsIdle();
+
+    void SetTimeoutMs(uint32_t timeoutMs);
+
+
+private:
+
+    // the longest to wait for an abort to finish the byte in flight, a few
+    // bytes at 100kHz
+    static const uint32_t ABORT_WAIT_US = 1'000;
+
+    enum class State : uint8_t
+    {
+        FREE,
+        QUEUED,
+        ACTIVE,
+        DONE,
+    };
+
+    struct Job
+    {
+        volatile State state = State::FREE;
+
+        bool sync = false;
+
+        uint8_t addr     = 0;
+        uint8_t writeLen = 0;
+        uint8_t readLen  = 0;
+        uint8_t writeBuf[MAX_WRITE];
+        uint8_t readBuf[MAX_READ];
+
+        FnDone fnDone;
+
+        // worked on by the IRQ
+        uint8_t cmdIdx  = 0;
+        uint8_t readIdx = 0;
+        bool    aborted = false;
+
+        uint64_t timeQueuedUs  = 0;
+        uint64_t timeStartedUs = 0;
+        uint64_t timeDoneUs    = 0;
+
+        Status status = Status::OK;
+    };
+
+    I2CEngine(uint8_t instance);
+
+    Job &GetJob(uint32_t seq);
+    void Reclaim();
+    bool IsFull();
+    void Publish();
+    void WaitForRoom();
+
+    void StartNext();
+    void FillTx(Job &job);
+    void DrainRx(Job &job);
+    void Finish(Job &job, Status status);
+
+    void ProcessCompletions();
+    Result MakeResult(const Job &job) const;
+
+    void CheckTimeout();
+
+    void OnInterrupt();
+    static void OnInterrupt0();
+    static void OnInterrupt1();
+
+
+private:
+
+    uint8_t instance_;
+
+    Job jobList_[QUEUE_DEPTH];
+
+    // sequence numbers, slots taken modulo the depth.
+    // free <= start <= tail, jobs before start have been started
+    uint32_t          seqFree_  = 0;
+    volatile uint32_t seqStart_ = 0;
+    volatile uint32_t seqTail_  = 0;
+
+    // set and cleared by the IRQ, or with it locked out
+    Job *volatile jobActive_ = nullptr;
+
+    bool irqInit_ = false;
+
+    uint32_t timeoutMs_ = 5;
+
+    Timer timer_;
+};
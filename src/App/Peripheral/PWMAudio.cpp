@@ -0,0 +1,361 @@
+#include "Evm.h"
+#include "Log.h"
+#include "PAL.h"
+#include "PWMAudio.h"
+#include "Shell.h"
+#include "SignalMixer.h"
+#include "SignalOscillator.h"
+#include "SignalSourceSineWave.h"
+#include "Timeline.h"
+#include "Utl.h"
+
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pwm.h"
+#include "pico/stdlib.h"
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "StrictMode.h"
+
+
+PWMAudio::PWMAudio(uint8_t pin)
+: pin_(pin)
+, slice_((uint8_t)pwm_gpio_to_slice_num(pin_))
+{
+    // Nothing to do
+}
+
+PWMAudio::~PWMAudio()
+{
+    Stop();
+}
+
+bool PWMAudio::Start(uint32_t sampleRate, FnFill fnFill)
+{
+    Stop();
+
+    if (sampleRate == 0)
+    {
+        return false;
+    }
+
+    // PWM counter clock divider, 8.4 fixed point, between 1 and 255 15/16
+    uint64_t clockSys = clock_get_hz(clk_sys);
+    uint64_t div16    = ((clockSys * 16) + ((uint64_t)LEVEL_COUNT * sampleRate / 2)) / ((uint64_t)LEVEL_COUNT * sampleRate);
+    if (div16 < 16 || div16 > 0xFFF)
+    {
+        return false;
+    }
+
+    // find a free slot for the IRQ to look at
+    uint8_t instIdx = MAX_INSTANCES;
+    for (uint8_t i = 0; i < MAX_INSTANCES; ++i)
+    {
+        if (instList_[i] == nullptr)
+        {
+            instIdx = i;
+
+            break;
+        }
+    }
+    if (instIdx == MAX_INSTANCES)
+    {
+        return false;
+    }
+
+    for (auto &dmaChannel : dmaChannelList_)
+    {
+        dmaChannel = (int8_t)dma_claim_unused_channel(false);
+    }
+    if (dmaChannelList_[0] == -1 || dmaChannelList_[1] == -1)
+    {
+        Stop();
+
+        return false;
+    }
+
+    static bool irqInit = false;
+    if (!irqInit)
+    {
+        irq_add_shared_handler(DMA_IRQ_0, DmaInterruptHandler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+
+        irqInit = true;
+    }
+
+    fnFill_     = fnFill;
+    sampleRate_ = (uint32_t)(clockSys * 16 / (LEVEL_COUNT * div16));
+    stats_      = Stats{};
+
+    // both buffers full before starting
+    Fill(0);
+    Fill(1);
+
+    gpio_set_function(pin_, GPIO_FUNC_PWM);
+
+    pwm_config pwmCfg = pwm_get_default_config();
+    pwm_config_set_wrap(&pwmCfg, LEVEL_COUNT - 1);
+    pwm_config_set_clkdiv_int_frac(&pwmCfg, (uint8_t)(div16 >> 4), (uint8_t)(div16 & 0xF));
+    pwm_init(slice_, &pwmCfg, false);
+    pwm_set_both_levels(slice_, LEVEL_COUNT / 2, LEVEL_COUNT / 2);
+
+    // each a buffer of levels into the slice's compare register, paced by
+    // the slice wrapping, then on to the other buffer
+    for (uint8_t i = 0; i < 2; ++i)
+    {
+        uint dmaChannel      = (uint)dmaChannelList_[i];
+        uint dmaChannelOther = (uint)dmaChannelList_[i ^ 1];
+
+        dma_channel_config cfg = dma_channel_get_default_config(dmaChannel);
+        channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+        channel_config_set_read_increment(&cfg, true);
+        channel_config_set_write_increment(&cfg, false);
+        channel_config_set_dreq(&cfg, pwm_get_dreq(slice_));
+        channel_config_set_chain_to(&cfg, dmaChannelOther);
+
+        dma_channel_configure(dmaChannel,
+                              &cfg,
+                              &pwm_hw->slice[slice_].cc,
+                              bufList_[i],
+                              BUF_SAMPLES,
+                              false);
+
+        dma_channel_set_irq0_enabled(dmaChannel, true);
+    }
+
+    {
+        IrqLock lock;
+
+        instList_[instIdx] = this;
+        instIdx_ = instIdx;
+        startId_ = ++startCount_;
+        running_ = true;
+    }
+
+    dma_channel_start((uint)dmaChannelList_[0]);
+    pwm_set_enabled(slice_, true);
+
+    return true;
+}
+
+void PWMAudio::Stop()
+{
+    {
+        IrqLock lock;
+
+        for (auto &inst : instList_)
+        {
+            if (inst == this)
+            {
+                inst = nullptr;
+            }
+        }
+
+        instIdx_ = MAX_INSTANCES;
+        running_ = false;
+    }
+
+    if (dmaChannelList_[0] != -1 && dmaChannelList_[1] != -1)
+    {
+        pwm_set_enabled(slice_, false);
+    }
+
+    // unchain before aborting, else an abort can set off the other channel
+    for (auto &dmaChannel : dmaChannelList_)
+    {
+        if (dmaChannel != -1)
+        {
+            dma_channel_set_irq0_enabled((uint)dmaChannel, false);
+
+            dma_channel_config cfg = dma_get_channel_config((uint)dmaChannel);
+            channel_config_set_chain_to(&cfg, (uint)dmaChannel);
+            dma_channel_set_config((uint)dmaChannel, &cfg, false);
+        }
+    }
+    for (auto &dmaChannel : dmaChannelList_)
+    {
+        if (dmaChannel != -1)
+        {
+            dma_channel_abort((uint)dmaChannel);
+            dma_channel_acknowledge_irq0((uint)dmaChannel);
+            dma_channel_unclaim((uint)dmaChannel);
+
+            dmaChannel = -1;
+        }
+    }
+
+    needsFill_[0] = false;
+    needsFill_[1] = false;
+}
+
+bool PWMAudio::IsRunning() const
+{
+    return running_;
+}
+
+uint32_t PWMAudio::GetSampleRate() const
+{
+    return sampleRate_;
+}
+
+const PWMAudio::Stats &PWMAudio::GetStats() const
+{
+    return stats_;
+}
+
+bool PWMAudio::IsAnyRunning()
+{
+    bool retVal = false;
+
+    for (PWMAudio *inst : instList_)
+    {
+        retVal |= inst != nullptr;
+    }
+
+    return retVal;
+}
+
+// From the DMA IRQ.
+// The other buffer is already playing, by chaining.  Point this one's
+// channel back at the start of its buffer, ready for when it's chained to
+// next, and have it refilled in the meantime.
+void PWMAudio::OnDmaComplete(uint8_t bufIdx)
+{
+    dma_channel_set_read_addr((uint)dmaChannelList_[bufIdx], bufList_[bufIdx], false);
+
+    ++stats_.buffersPlayed;
+
+    // the buffer now playing was never refilled
+    if (needsFill_[bufIdx ^ 1])
+    {
+        ++stats_.underruns;
+    }
+
+    needsFill_[bufIdx] = true;
+
+    // by slot and start, not this, which may be deleted before it runs
+    Evm::QueueWork("PWMAudio::Fill", [instIdx = instIdx_, startId = startId_, bufIdx]{
+        PWMAudio *inst = instList_[instIdx];
+
+        if (inst && inst->startId_ == startId && inst->running_ && inst->needsFill_[bufIdx])
+        {
+            inst->Fill(bufIdx);
+        }
+    });
+}
+
+void PWMAudio::Fill(uint8_t bufIdx)
+{
+    uint64_t timeStartUs = PAL.Micros();
+
+    fnFill_(bufList_[bufIdx], BUF_SAMPLES);
+
+    needsFill_[bufIdx] = false;
+
+    stats_.fillUsMax = max(stats_.fillUsMax, (uint32_t)(PAL.Micros() - timeStartUs));
+}
+
+void PWMAudio::DmaInterruptHandler()
+{
+    for (PWMAudio *inst : instList_)
+    {
+        if (inst == nullptr)
+        {
+            continue;
+        }
+
+        for (uint8_t i = 0; i < 2; ++i)
+        {
+            uint dmaChannel = (uint)inst->dmaChannelList_[i];
+
+            if (dma_channel_get_irq0_status(dmaChannel))
+            {
+                dma_channel_acknowledge_irq0(dmaChannel);
+
+                inst->OnDmaComplete(i);
+            }
+        }
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Shell
+////////////////////////////////////////////////////////////////////////////////
+
+void PWMAudio::SetupShell()
+{
+    Timeline::Global().Event("PWMAudio::SetupShell");
+
+    static const uint32_t SAMPLE_RATE = 44'100;
+
+    static PWMAudio        *audio = nullptr;
+    static SignalOscillator oList[2];
+    static uint8_t          oCount = 0;
+
+    Shell::AddCommand("pwm.audio.tone", [](vector<string> argList){
+        if (argList.size() < 2 || argList.size() > 3)
+        {
+            Log("Invalid arguments");
+
+            return;
+        }
+
+        uint8_t pin = (uint8_t)atoi(argList[0].c_str());
+
+        delete audio;
+        audio = new PWMAudio(pin);
+
+        oCount = (uint8_t)(argList.size() - 1);
+        for (uint8_t i = 0; i < oCount; ++i)
+        {
+            oList[i].SetSampleRate((uint16_t)SAMPLE_RATE);
+            oList[i].SetFrequency(atof(argList[1 + i].c_str()));
+            oList[i].Reset();
+        }
+
+        bool ok = audio->Start(SAMPLE_RATE, [](uint16_t *levelList, uint16_t count){
+            int16_t mix[BUF_SAMPLES];
+
+            SignalMixer::Clear(mix, count);
+            for (uint8_t i = 0; i < oCount; ++i)
+            {
+                oList[i].MixIntoBuffer<SignalSourceSineWave::GetSample>(mix, count);
+            }
+            SignalMixer::ToLevels(mix, levelList, count, oCount);
+        });
+
+        if (ok)
+        {
+            Log("Playing on pin ", pin, " at ", Commas(audio->GetSampleRate()), " samples/sec");
+        }
+        else
+        {
+            Log("Could not start");
+        }
+    }, { .argCount = -1, .help = "pwm audio <pin> <hz> [<hz2>] sine, mixed if 2" });
+
+    Shell::AddCommand("pwm.audio.stop", [](vector<string> argList){
+        if (audio)
+        {
+            audio->Stop();
+        }
+    }, { .argCount = 0, .help = "stop pwm audio" });
+
+    Shell::AddCommand("pwm.audio.stats", [](vector<string> argList){
+        if (audio)
+        {
+            const Stats &stats = audio->GetStats();
+
+            Log("Running       : ", audio->IsRunning());
+            Log("Sample rate   : ", Commas(audio->GetSampleRate()));
+            Log("Buffers played: ", Commas(stats.buffersPlayed));
+            Log("Underruns     : ", Commas(stats.underruns));
+            Log("Fill us max   : ", Commas(stats.fillUsMax));
+        }
+    }, { .argCount = 0, .help = "pwm audio stats" });
+}
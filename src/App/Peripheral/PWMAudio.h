@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+
+// Audio out of a PWM pin, fed by DMA.
+//
+// The pin's PWM slice counts to 256, so samples are 8-bit levels (0-255,
+// 128 being silence), with its clock divided so it wraps at the sample
+// rate.  Each wrap paces the DMA to write the next level.
+//
+// Two buffers play alternately, on two DMA channels chained to each other,
+// so there is no gap between them.  As each finishes, its refill is queued
+// to Evm, where the fill function has the duration of the other buffer to
+// run in (5.8 ms at 44.1 kHz).  A buffer which hasn't been refilled by the
+// time it comes round again plays its old contents, and is counted as an
+// underrun.
+//
+// The fill function is called with the buffer to fill, with levels as from
+// SignalMixer::ToLevels.
+//
+// The other channel of the same slice gets the same levels, the DMA writes
+// being 16-bit, so it can't be used for anything else while playing.
+class PWMAudio
+{
+public:
+
+    static const uint16_t BUF_SAMPLES = 256;
+    static const uint16_t LEVEL_COUNT = 256;
+
+    using FnFill = std::function<void(uint16_t *levelList, uint16_t count)>;
+
+    struct Stats
+    {
+        uint32_t buffersPlayed = 0;
+        uint32_t underruns     = 0;
+        uint32_t fillUsMax     = 0;
+    };
+
+public:
+
+    PWMAudio(uint8_t pin);
+    ~PWMAudio();
+
+    // false if the rate can't be made from the system clock, or DMA
+    // channels aren't available
+    bool Start(uint32_t sampleRate, FnFill fnFill);
+    void Stop();
+    bool IsRunning() const;
+
+    // as made by the clock divider, which is 8.4 fixed point
+    uint32_t GetSampleRate() const;
+
+    const Stats &GetStats() const;
+
+    // whether any instance is playing, its rate being set by clk_sys
+    static bool IsAnyRunning();
+
+
+public:
+
+    static void SetupShell();
+
+
+private:
+
+    void OnDmaComplete(uint8_t bufIdx);
+    void Fill(uint8_t bufIdx);
+
+    static void DmaInterruptHandler();
+
+
+private:
+
+    static const uint8_t MAX_INSTANCES = 2;
+    inline static PWMAudio *instList_[MAX_INSTANCES] = {};
+
+    // each Start gets a new one, so refills queued before a Stop, maybe of
+    // an instance since deleted, find it gone or changed and do nothing
+    inline static uint32_t startCount_ = 0;
+    uint8_t  instIdx_ = MAX_INSTANCES;
+    uint32_t startId_ = 0;
+
+    uint8_t pin_;
+    uint8_t slice_;
+
+    bool     running_    = false;
+    uint32_t sampleRate_ = 0;
+
+    FnFill fnFill_;
+
+    int8_t   dmaChannelList_[2] = { -1, -1 };
+    uint16_t bufList_[2][BUF_SAMPLES];
+
+    // set by the DMA IRQ when a buffer has played, cleared once refilled
+    volatile bool needsFill_[2] = { false, false };
+
+    Stats stats_;
+};
@@ -1,3 +1,4 @@
+#include "ByteRing.h"
 #include "Evm.h"
 #include "DataStreamDistributor.h"
 #include "IDMaker.h"
@@ -9,7 +10,9 @@
 #include "Timeline.h"
 #include "UART.h"
 #include "USB.h"
+#include "Utl.h"
 
+#include "hardware/dma.h"
 #include "hardware/irq.h"
 #include "hardware/uart.h"
 #include "pico/stdlib.h"
@@ -34,20 +37,99 @@ static USB_CDC *cdc0 = USB::GetCdcInstance(0);
 // UART Input / Output state
 ////////////////////////////////////////////////////////////////////////////////
 
-static const uint16_t UART_OUTPUT_PIPE_SIZE   = 5000;
-static const uint16_t UART_INPUT_PIPE_SIZE    = 1002;
+// power of 2, see UartTx
+static const uint32_t UART_OUTPUT_RING_SIZE   = 4096;
+// power of 2, see UartRx
+static const uint32_t UART_INPUT_RING_SIZE    = 1024;
 static const uint16_t UART_INPUT_MAX_LINE_LEN = 1000;
 static const uint16_t UART_USB_INPUT_MAX_LINE_LEN = 5000;
 static const uint16_t UART_USB_OUTPUT_BUF_SIZE = 5000;
 
-static KMessagePipe<char, UART_OUTPUT_PIPE_SIZE> UART_0_OUTPUT_PIPE;
-static KMessagePipe<char, UART_INPUT_PIPE_SIZE>  UART_0_INPUT_PIPE;
+// Output for a hardware UART.
+//
+// UartSend copies into the ring in bulk, and either the UART IRQ drains it
+// into the TX FIFO, or a DMA channel paced by the UART TX DREQ does.
+//
+// The ring storage is aligned to its size so a single DMA transfer can
+// read across the wrap (the channel wraps its read address at the ring
+// size), there is no need to split or chain transfers.
+struct UartTx
+{
+    UartTx(uart_inst_t *uartIn, uint8_t *buf)
+    : uart(uartIn)
+    , ring(buf)
+    {
+        // nothing to do
+    }
+
+    uart_inst_t *uart;
+    ByteRing<UART_OUTPUT_RING_SIZE> ring;
+
+    UartTxMode mode = UartTxMode::IRQ;
+
+    int               dmaChannel  = -1;
+    volatile uint32_t dmaInFlight = 0;
+
+    // stats
+    uint32_t bytesSent     = 0;
+    uint32_t producerWaits = 0;
+    uint32_t dmaTransfers  = 0;
+};
+
+// Input from a hardware UART.
+//
+// Received bytes land in the ring, either copied there from the RX FIFO by
+// the UART IRQ, or written there directly by a DMA channel paced by the
+// UART RX DREQ (the ring storage is aligned to its size so the channel can
+// wrap its write address).
+//
+// The ring is then distributed in place, as views onto the ring storage,
+// from Evm low priority work (IRQ) or a polling timer (DMA).
+//
+// In DMA mode nothing stops the channel overwriting bytes not yet
+// distributed, the ring must be drained faster than it takes to receive
+// UART_INPUT_RING_SIZE bytes.
+struct UartRx
+{
+    UartRx(uart_inst_t *uartIn, uint8_t *buf, DataStreamDistributor &distIn)
+    : uart(uartIn)
+    , ring(buf)
+    , dist(distIn)
+    {
+        // nothing to do
+    }
+
+    uart_inst_t *uart;
+    ByteRing<UART_INPUT_RING_SIZE> ring;
+    DataStreamDistributor &dist;
+
+    UartRxMode mode = UartRxMode::IRQ;
+
+    int dmaChannel = -1;
+
+    // bumped on flush, so distribution can tell the ring was flushed
+    // from within a callback
+    uint32_t flushSeqNo = 0;
+
+    // stats
+    uint32_t bytesReceived = 0;
+    uint32_t bytesDropped  = 0;
+};
+
+alignas(UART_OUTPUT_RING_SIZE) static uint8_t UART_0_OUTPUT_BUF[UART_OUTPUT_RING_SIZE];
+alignas(UART_OUTPUT_RING_SIZE) static uint8_t UART_1_OUTPUT_BUF[UART_OUTPUT_RING_SIZE];
+
+alignas(UART_INPUT_RING_SIZE) static uint8_t UART_0_INPUT_BUF[UART_INPUT_RING_SIZE];
+alignas(UART_INPUT_RING_SIZE) static uint8_t UART_1_INPUT_BUF[UART_INPUT_RING_SIZE];
+
+static UartTx UART_0_TX(uart0, UART_0_OUTPUT_BUF);
 static DataStreamDistributor UART_0_INPUT_DATA_STREAM_DISTRIBUTOR(UART::UART_0);
+static UartRx UART_0_RX(uart0, UART_0_INPUT_BUF, UART_0_INPUT_DATA_STREAM_DISTRIBUTOR);
 static LineStreamDistributor UART_0_INPUT_LINE_STREAM_DISTRIBUTOR(UART::UART_0, UART_INPUT_MAX_LINE_LEN, "UART_0_LINE_STREAM_DISTRIBUTOR");
 
-static KMessagePipe<char, UART_OUTPUT_PIPE_SIZE> UART_1_OUTPUT_PIPE;
-static KMessagePipe<char, UART_INPUT_PIPE_SIZE>  UART_1_INPUT_PIPE;
+static UartTx UART_1_TX(uart1, UART_1_OUTPUT_BUF);
 static DataStreamDistributor UART_1_INPUT_DATA_STREAM_DISTRIBUTOR(UART::UART_1);
+static UartRx UART_1_RX(uart1, UART_1_INPUT_BUF, UART_1_INPUT_DATA_STREAM_DISTRIBUTOR);
 static LineStreamDistributor UART_1_INPUT_LINE_STREAM_DISTRIBUTOR(UART::UART_1, UART_INPUT_MAX_LINE_LEN, "UART_1_LINE_STREAM_DISTRIBUTOR");
 
 static DataStreamDistributor UART_USB_INPUT_DATA_STREAM_DISTRIBUTOR(UART::UART_USB);
@@ -58,15 +140,124 @@ static LineStreamDistributor UART_USB_INPUT_LINE_STREAM_DISTRIBUTOR(UART::UART_U
 // UART Output
 ////////////////////////////////////////////////////////////////////////////////
 
-static KMessagePipe<char, UART_OUTPUT_PIPE_SIZE> &UartGetPipe()
+static UartTx &UartGetTx(UART uart)
 {
-    KMessagePipe<char, UART_OUTPUT_PIPE_SIZE> *ptr = &UART_0_OUTPUT_PIPE;
+    return uart == UART::UART_1 ? UART_1_TX : UART_0_TX;
+}
 
-    UART uart = UartCurrent();
+// IRQ mode, feed the TX FIFO from the ring until either runs out.
+// called from the UART IRQ.
+static void UartTxFillFifo(UartTx &tx)
+{
+    while (uart_is_writable(tx.uart))
+    {
+        auto [buf, bufLen] = tx.ring.Peek();
+        if (bufLen == 0)
+        {
+            break;
+        }
 
-    if      (uart == UART::UART_1)   { ptr = &UART_1_OUTPUT_PIPE; }
-    
-    return *ptr;
+        uint32_t len = 0;
+        while (len < bufLen && uart_is_writable(tx.uart))
+        {
+            uart_putc_raw(tx.uart, (char)buf[len]);
+            ++len;
+        }
+
+        tx.ring.Consume(len);
+        tx.bytesSent += len;
+    }
+
+    // clear "tell me when to feed the next byte" interrupt
+    if (tx.ring.Count() == 0)
+    {
+        uart_get_hw(tx.uart)->icr = UART_UARTICR_TXIC_BITS;
+    }
+}
+
+// DMA mode, start a transfer of everything in the ring if one isn't
+// already running.
+// called with interrupts locked out, or from the DMA IRQ.
+static void UartTxDmaStart(UartTx &tx)
+{
+    if (tx.dmaInFlight)
+    {
+        return;
+    }
+
+    uint32_t count = tx.ring.Count();
+    if (count == 0)
+    {
+        return;
+    }
+
+    tx.dmaInFlight = count;
+    ++tx.dmaTransfers;
+
+    dma_channel_set_read_addr((uint)tx.dmaChannel, &tx.ring.GetBuf()[tx.ring.GetReadIdx()], false);
+    dma_channel_set_trans_count((uint)tx.dmaChannel, count, true);
+}
+
+static void UartTxDmaInterruptHandler()
+{
+    for (UartTx *tx : { &UART_0_TX, &UART_1_TX })
+    {
+        if (tx->dmaChannel != -1 && dma_channel_get_irq0_status((uint)tx->dmaChannel))
+        {
+            dma_channel_acknowledge_irq0((uint)tx->dmaChannel);
+
+            tx->ring.Consume(tx->dmaInFlight);
+            tx->bytesSent += tx->dmaInFlight;
+            tx->dmaInFlight = 0;
+
+            // keep going with whatever was written in the meantime
+            UartTxDmaStart(*tx);
+        }
+    }
+}
+
+// get data which has just been written to the ring moving
+static void UartTxKick(UartTx &tx)
+{
+    if (tx.mode == UartTxMode::DMA)
+    {
+        IrqLock lock;
+
+        UartTxDmaStart(tx);
+    }
+    else
+    {
+        irq_set_pending(tx.uart == uart0 ? UART0_IRQ : UART1_IRQ);
+    }
+}
+
+// Write the whole buffer into the ring, waiting for space as required.
+//
+// The ring is single-producer, so tasks are kept from interleaving their
+// writes with the scheduler lock (ISRs never write to the ring, they use
+// the synchronous path).
+static void UartTxWrite(UartTx &tx, const uint8_t *buf, uint32_t bufLen)
+{
+    while (bufLen)
+    {
+        PAL.SchedulerLock();
+        uint32_t len = tx.ring.Write(buf, bufLen);
+        PAL.SchedulerUnlock();
+
+        if (len)
+        {
+            UartTxKick(tx);
+
+            buf    += len;
+            bufLen -= len;
+        }
+        else
+        {
+            // full, wait for the hardware to drain some
+            ++tx.producerWaits;
+            PAL.Delay(1);
+        }
+    }
 }
 
 
@@ -74,90 +265,123 @@ static KMessagePipe<char, UART_OUTPUT_PIPE_SIZE> &UartGetPipe()
 // UART Input Handling
 ////////////////////////////////////////////////////////////////////////////////
 
-// https://stackoverflow.com/questions/76367736/uart-tx-produce-endless-interrupts-how-to-acknowlage-the-interrupt
-// https://forums.raspberrypi.com/viewtopic.php?t=343110
-static void UartInterruptHandlerUartX(const char                                *workLabel,
-                                      uart_inst_t                               *uart,
-                                      KMessagePipe<char, UART_OUTPUT_PIPE_SIZE> &pipeOut,
-                                      KMessagePipe<char, UART_INPUT_PIPE_SIZE>  &pipeIn,
-                                      DataStreamDistributor                     &distIn)
+static UartRx &UartGetRx(UART uart)
 {
-    // do some writing
-    while (pipeOut.Count() && uart_is_writable(uart))
+    return uart == UART::UART_1 ? UART_1_RX : UART_0_RX;
+}
+
+// DMA mode, make whatever the channel has written since last time readable
+static void UartRxDmaSync(UartRx &rx)
+{
+    static const uint32_t MASK = UART_INPUT_RING_SIZE - 1;
+
+    // the channel's write address is where the next byte will land
+    uint32_t addrDma = (uint32_t)dma_channel_hw_addr((uint)rx.dmaChannel)->write_addr;
+    uint32_t addrBuf = (uint32_t)(uintptr_t)rx.ring.GetBuf();
+    uint32_t idxDma  = (addrDma - addrBuf) & MASK;
+
+    uint32_t len = (idxDma - rx.ring.GetWriteIdx()) & MASK;
+    rx.ring.Produce(len);
+    rx.bytesReceived += len;
+}
+
+// Hand everything in the ring to the listeners, in place.
+// At most two views, before and after the wrap, plus whatever arrives
+// while distributing.
+static void UartRxDistribute(UartRx &rx)
+{
+    if (rx.mode == UartRxMode::DMA)
     {
-        char ch;
-        if (pipeOut.Get(ch))
-        {
-            uart_putc_raw(uart, ch);
-        }
+        UartRxDmaSync(rx);
     }
 
-    // clear "tell me when to feed the next byte" interrupt
-    if (pipeOut.Count() == 0)
+    while (true)
     {
-        uart_get_hw(uart)->icr = UART_UARTICR_TXIC_BITS ;
+        auto [buf, bufLen] = rx.ring.Peek();
+        if (bufLen == 0)
+        {
+            break;
+        }
+
+        uint32_t flushSeqNo = rx.flushSeqNo;
+
+        rx.dist.Distribute({ buf, bufLen });
+
+        // a listener may have cleared the buffer, in which case what it
+        // saw is already gone
+        if (rx.flushSeqNo == flushSeqNo)
+        {
+            rx.ring.Consume(bufLen);
+        }
     }
+}
 
-    // do some reading
+// IRQ mode, empty the RX FIFO into the ring.
+// called from the UART IRQ.
+static void UartRxDrainFifo(const char *workLabel, UartRx &rx)
+{
     bool dataReady = false;
-    while (uart_is_readable(uart))
+
+    while (uart_is_readable(rx.uart))
     {
-        uint8_t ch = uart_getc(uart);
+        // a FIFO's worth at a time
+        uint8_t buf[32];
+        uint32_t bufLen = 0;
+        while (bufLen < sizeof(buf) && uart_is_readable(rx.uart))
+        {
+            buf[bufLen] = (uint8_t)uart_getc(rx.uart);
+            ++bufLen;
+        }
 
         // is there someone who wants it and a place to put it?
-        if (distIn.GetCallbackCount() == 0)
+        if (rx.dist.GetCallbackCount() == 0)
         {
-            pipeIn.Flush();
+            rx.bytesDropped += bufLen;
         }
         else
         {
-            pipeIn.Put(ch, 0);
+            uint32_t len = rx.ring.Write(buf, bufLen);
 
-            dataReady = true;
+            rx.bytesReceived += len;
+            rx.bytesDropped  += bufLen - len;
+
+            dataReady = dataReady || len;
         }
     }
 
     if (dataReady)
     {
-        Evm::QueueLowPriorityWork(workLabel, [&]{
-            if (pipeIn.Count())
-            {
-                vector<uint8_t> byteList;
-
-                char ch;
-                bool ok = pipeIn.Get(ch, 0);
-                while (ok)
-                {
-                    byteList.push_back(ch);
+        Evm::QueueLowPriorityWork(workLabel, [&rx]{
+            UartRxDistribute(rx);
+        });
+    }
+}
 
-                    ok = pipeIn.Get(ch, 0);
-                }
+// https://stackoverflow.com/questions/76367736/uart-tx-produce-endless-interrupts-how-to-acknowlage-the-interrupt
+// https://forums.raspberrypi.com/viewtopic.php?t=343110
+static void UartInterruptHandlerUartX(const char *workLabel, UartTx &tx, UartRx &rx)
+{
+    // do some writing
+    if (tx.mode == UartTxMode::IRQ)
+    {
+        UartTxFillFifo(tx);
+    }
 
-                if (byteList.size())
-                {
-                    distIn.Distribute(byteList);
-                }
-            }
-        });
+    // do some reading
+    if (rx.mode == UartRxMode::IRQ)
+    {
+        UartRxDrainFifo(workLabel, rx);
     }
 }
 
 static void UartInterruptHandlerUart0()
 {
-    UartInterruptHandlerUartX("UART::uart0",
-                              uart0,
-                              UART_0_OUTPUT_PIPE,
-                              UART_0_INPUT_PIPE,
-                              UART_0_INPUT_DATA_STREAM_DISTRIBUTOR);
+    UartInterruptHandlerUartX("UART::uart0", UART_0_TX, UART_0_RX);
 }
 
 static void UartInterruptHandlerUart1()
 {
-    UartInterruptHandlerUartX("UART::uart1",
-                              uart1,
-                              UART_1_OUTPUT_PIPE,
-                              UART_1_INPUT_PIPE,
-                              UART_1_INPUT_DATA_STREAM_DISTRIBUTOR);
+    UartInterruptHandlerUartX("UART::uart1", UART_1_TX, UART_1_RX);
 }
 
 
@@ -241,28 +465,7 @@ void UartSend(const uint8_t *buf, uint16_t bufLen)
 
         if (uart == UART::UART_0 || uart == UART::UART_1)
         {
-            if (bufLen <= UART_OUTPUT_PIPE_SIZE)
-            {
-                // Make sure the output isn't disabled before sending
-                bool sendOk = true;
-
-                auto *pipe = &UartGetPipe();
-                // if (pipe == &UART_1_OUTPUT_PIPE)
-                // {
-                //     sendOk = UartIsEnabled(UART::UART_1);
-                // }
-
-                if (sendOk)
-                {
-                    // Should be ok without an IRQ lock given guarantees around the pipe
-                    pipe->Put((char *)buf, bufLen);
-                    irq_set_pending(UartCurrent() == UART::UART_0 ? UART0_IRQ : UART1_IRQ);
-                }
-            }
-            else
-            {
-                // I guess it's not going then
-            }
+            UartTxWrite(UartGetTx(uart), buf, bufLen);
         }
         else if (uart == UART::UART_USB)
         {
@@ -281,7 +484,7 @@ void UartSend(const vector<uint8_t> &byteList)
 // UART DataStream Interface
 ////////////////////////////////////////////////////////////////////////////////
 
-pair<bool, uint8_t> UartAddDataStreamCallback(UART uart, function<void(const vector<uint8_t> &data)> cbFn)
+pair<bool, uint8_t> UartAddDataStreamCallback(UART uart, function<void(span<const uint8_t> data)> cbFn)
 {
     bool retValOk = false;
     uint8_t retValId = 0;
@@ -311,7 +514,7 @@ pair<bool, uint8_t> UartAddDataStreamCallback(UART uart, function<void(const vec
     return { retValOk, retValId };
 }
 
-bool UartSetDataStreamCallback(UART uart, function<void(const vector<uint8_t> &data)> cbFn, uint8_t id)
+bool UartSetDataStreamCallback(UART uart, function<void(span<const uint8_t> data)> cbFn, uint8_t id)
 {
     bool retVal = false;
 
@@ -368,12 +571,10 @@ bool UartRemoveDataStreamCallback(UART uart, uint8_t id)
 // UART LineStream Interface
 ////////////////////////////////////////////////////////////////////////////////
 
-pair<bool, uint8_t> UartAddLineStreamCallback(UART uart, function<void(const string &line)> cbFn, bool hideBlankLines)
+static LineStreamDistributor *UartGetLineStreamDistributor(UART uart)
 {
-    bool retValOk = false;
-    uint8_t retValId = 0;
-
     LineStreamDistributor *dist = nullptr;
+
     if (uart == UART::UART_0)
     {
         dist = &UART_0_INPUT_LINE_STREAM_DISTRIBUTOR;
@@ -387,7 +588,15 @@ pair<bool, uint8_t> UartAddLineStreamCallback(UART uart, function<void(const str
         dist = &UART_USB_INPUT_LINE_STREAM_DISTRIBUTOR;
     }
 
-    if (dist)
+    return dist;
+}
+
+pair<bool, uint8_t> UartAddLineStreamCallback(UART uart, function<void(const string &line)> cbFn, bool hideBlankLines)
+{
+    bool retValOk = false;
+    uint8_t retValId = 0;
+
+    if (LineStreamDistributor *dist = UartGetLineStreamDistributor(uart))
     {
         auto [ok, id] = dist->AddLineStreamCallback(cbFn, hideBlankLines);
 
@@ -398,25 +607,27 @@ pair<bool, uint8_t> UartAddLineStreamCallback(UART uart, function<void(const str
     return { retValOk, retValId };
 }
 
-bool UartSetLineStreamCallback(UART uart, function<void(const string &line)> cbFn, uint8_t id, bool hideBlankLines)
+pair<bool, uint8_t> UartAddLineStreamViewCallback(UART uart, function<void(string_view line)> cbFn, bool hideBlankLines)
 {
-    bool retVal = false;
+    bool retValOk = false;
+    uint8_t retValId = 0;
 
-    LineStreamDistributor *dist = nullptr;
-    if (uart == UART::UART_0)
+    if (LineStreamDistributor *dist = UartGetLineStreamDistributor(uart))
     {
-        dist = &UART_0_INPUT_LINE_STREAM_DISTRIBUTOR;
-    }
-    else if (uart == UART::UART_1)
-    {
-        dist = &UART_1_INPUT_LINE_STREAM_DISTRIBUTOR;
-    }
-    else if (uart == UART::UART_USB)
-    {
-        dist = &UART_USB_INPUT_LINE_STREAM_DISTRIBUTOR;
+        auto [ok, id] = dist->AddLineStreamViewCallback(cbFn, hideBlankLines);
+
+        retValOk = ok;
+        retValId = id;
     }
 
-    if (dist)
+    return { retValOk, retValId };
+}
+
+bool UartSetLineStreamCallback(UART uart, function<void(const string &line)> cbFn, uint8_t id, bool hideBlankLines)
+{
+    bool retVal = false;
+
+    if (LineStreamDistributor *dist = UartGetLineStreamDistributor(uart))
     {
         retVal = dist->SetLineStreamCallback(id, cbFn, hideBlankLines);
     }
@@ -424,25 +635,23 @@ bool UartSetLineStreamCallback(UART uart, function<void(const string &line)> cbF
     return retVal;
 }
 
-bool UartRemoveLineStreamCallback(UART uart, uint8_t id)
+bool UartSetLineStreamViewCallback(UART uart, function<void(string_view line)> cbFn, uint8_t id, bool hideBlankLines)
 {
     bool retVal = false;
 
-    LineStreamDistributor *dist = nullptr;
-    if (uart == UART::UART_0)
+    if (LineStreamDistributor *dist = UartGetLineStreamDistributor(uart))
     {
-        dist = &UART_0_INPUT_LINE_STREAM_DISTRIBUTOR;
-    }
-    else if (uart == UART::UART_1)
-    {
-        dist = &UART_1_INPUT_LINE_STREAM_DISTRIBUTOR;
-    }
-    else if (uart == UART::UART_USB)
-    {
-        dist = &UART_USB_INPUT_LINE_STREAM_DISTRIBUTOR;
+        retVal = dist->SetLineStreamViewCallback(id, cbFn, hideBlankLines);
     }
 
-    if (dist)
+    return retVal;
+}
+
+bool UartRemoveLineStreamCallback(UART uart, uint8_t id)
+{
+    bool retVal = false;
+
+    if (LineStreamDistributor *dist = UartGetLineStreamDistributor(uart))
     {
         retVal = dist->RemoveLineStreamCallback(id);
     }
@@ -483,6 +692,15 @@ static void UartDeInitDevice(uart_inst_t *uart, uint8_t pinRx, uint8_t pinTx)
     gpio_set_function(pinTx, GPIO_FUNC_NULL);
 }
 
+// interrupts are only wanted for the directions not fed by DMA
+static void UartUpdateIrqEnables(UART uart)
+{
+    UartTx &tx = UartGetTx(uart);
+    UartRx &rx = UartGetRx(uart);
+
+    uart_set_irq_enables(tx.uart, rx.mode == UartRxMode::IRQ, tx.mode == UartTxMode::IRQ);
+}
+
 static void UartInitDeviceInterrupts(uart_inst_t *uart, irq_handler_t handler)
 {
     // Set up a RX interrupt
@@ -498,7 +716,7 @@ static void UartInitDeviceInterrupts(uart_inst_t *uart, irq_handler_t handler)
     irq_set_enabled(UART_IRQ, true);
 
     // Now enable the UART to send interrupts - RX and TX
-    uart_set_irq_enables(uart, true, true);
+    UartUpdateIrqEnables(uart == uart0 ? UART::UART_0 : UART::UART_1);
 }
 
 static void UartDeInitDeviceInterrupts(uart_inst_t *uart)
@@ -509,6 +727,246 @@ static void UartDeInitDeviceInterrupts(uart_inst_t *uart)
 }
 
 
+static void UartTxDmaInit(UartTx &tx)
+{
+    if (tx.dmaChannel == -1)
+    {
+        tx.dmaChannel = dma_claim_unused_channel(false);
+    }
+
+    if (tx.dmaChannel == -1)
+    {
+        return;
+    }
+
+    static bool irqInit = false;
+    if (!irqInit)
+    {
+        irq_add_shared_handler(DMA_IRQ_0, UartTxDmaInterruptHandler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+
+        irqInit = true;
+    }
+
+    // byte at a time from the ring, wrapping at the ring size, into the
+    // fixed TX data register, paced by the UART
+    dma_channel_config cfg = dma_channel_get_default_config((uint)tx.dmaChannel);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_ring(&cfg, false, __builtin_ctz(UART_OUTPUT_RING_SIZE));
+    channel_config_set_dreq(&cfg, uart_get_dreq(tx.uart, true));
+
+    dma_channel_configure((uint)tx.dmaChannel,
+                          &cfg,
+                          &uart_get_hw(tx.uart)->dr,
+                          tx.ring.GetBuf(),
+                          0,
+                          false);
+
+    dma_channel_set_irq0_enabled((uint)tx.dmaChannel, true);
+}
+
+static void UartTxDmaDeInit(UartTx &tx)
+{
+    if (tx.dmaChannel == -1)
+    {
+        return;
+    }
+
+    dma_channel_set_irq0_enabled((uint)tx.dmaChannel, false);
+    dma_channel_abort((uint)tx.dmaChannel);
+    dma_channel_acknowledge_irq0((uint)tx.dmaChannel);
+
+    // whatever was in flight is dropped
+    tx.ring.Flush();
+    tx.dmaInFlight = 0;
+
+    dma_channel_unclaim((uint)tx.dmaChannel);
+    tx.dmaChannel = -1;
+}
+
+bool UartSetTxMode(UART uart, UartTxMode mode)
+{
+    if (uart != UART::UART_0 && uart != UART::UART_1)
+    {
+        return false;
+    }
+
+    UartTx &tx = UartGetTx(uart);
+
+    if (tx.mode == mode)
+    {
+        return true;
+    }
+
+    // let what is queued go out under the current mode first
+    while (tx.ring.Count() && UartIsEnabled(uart))
+    {
+        PAL.Delay(1);
+    }
+
+    IrqLock lock;
+
+    bool retVal = true;
+
+    if (mode == UartTxMode::DMA)
+    {
+        UartTxDmaInit(tx);
+
+        if (tx.dmaChannel != -1)
+        {
+            tx.mode = UartTxMode::DMA;
+            UartUpdateIrqEnables(uart);
+            UartTxDmaStart(tx);
+        }
+        else
+        {
+            retVal = false;
+        }
+    }
+    else
+    {
+        UartTxDmaDeInit(tx);
+
+        tx.mode = UartTxMode::IRQ;
+        UartUpdateIrqEnables(uart);
+        irq_set_pending(tx.uart == uart0 ? UART0_IRQ : UART1_IRQ);
+    }
+
+    return retVal;
+}
+
+UartTxMode UartGetTxMode(UART uart)
+{
+    return UartGetTx(uart).mode;
+}
+
+static const uint32_t UART_RX_DMA_POLL_MS = 5;
+static Timer timerRxDmaPoll_("TIMER_UART_RX_DMA_POLL");
+
+// (re)start the RX channel writing at the ring's write position, for as
+// many bytes as the channel can count
+static void UartRxDmaStart(UartRx &rx)
+{
+    dma_channel_set_write_addr((uint)rx.dmaChannel, &rx.ring.GetBuf()[rx.ring.GetWriteIdx()], false);
+    dma_channel_set_trans_count((uint)rx.dmaChannel, UINT32_MAX, true);
+}
+
+static void UartRxDmaPoll()
+{
+    // re-arm well before the count runs out, any bytes arriving in the
+    // meantime wait in the UART FIFO
+    static const uint32_t REARM_BELOW = 0x1000'0000;
+
+    for (UartRx *rx : { &UART_0_RX, &UART_1_RX })
+    {
+        if (rx->mode == UartRxMode::DMA)
+        {
+            if (dma_channel_hw_addr((uint)rx->dmaChannel)->transfer_count < REARM_BELOW)
+            {
+                IrqLock lock;
+
+                dma_channel_abort((uint)rx->dmaChannel);
+                UartRxDmaSync(*rx);
+                UartRxDmaStart(*rx);
+            }
+
+            UartRxDistribute(*rx);
+        }
+    }
+}
+
+bool UartSetRxMode(UART uart, UartRxMode mode)
+{
+    if (uart != UART::UART_0 && uart != UART::UART_1)
+    {
+        return false;
+    }
+
+    UartRx &rx = UartGetRx(uart);
+
+    if (rx.mode == mode)
+    {
+        return true;
+    }
+
+    bool retVal = true;
+
+    {
+        IrqLock lock;
+
+        if (mode == UartRxMode::DMA)
+        {
+            if (rx.dmaChannel == -1)
+            {
+                rx.dmaChannel = dma_claim_unused_channel(false);
+            }
+
+            if (rx.dmaChannel != -1)
+            {
+                // byte at a time from the fixed RX data register into the
+                // ring, wrapping at the ring size, paced by the UART
+                dma_channel_config cfg = dma_channel_get_default_config((uint)rx.dmaChannel);
+                channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+                channel_config_set_read_increment(&cfg, false);
+                channel_config_set_write_increment(&cfg, true);
+                channel_config_set_ring(&cfg, true, __builtin_ctz(UART_INPUT_RING_SIZE));
+                channel_config_set_dreq(&cfg, uart_get_dreq(rx.uart, false));
+
+                dma_channel_configure((uint)rx.dmaChannel,
+                                      &cfg,
+                                      &rx.ring.GetBuf()[rx.ring.GetWriteIdx()],
+                                      &uart_get_hw(rx.uart)->dr,
+                                      0,
+                                      false);
+
+                rx.mode = UartRxMode::DMA;
+                UartUpdateIrqEnables(uart);
+                UartRxDmaStart(rx);
+            }
+            else
+            {
+                retVal = false;
+            }
+        }
+        else
+        {
+            // keep what has already arrived
+            dma_channel_abort((uint)rx.dmaChannel);
+            UartRxDmaSync(rx);
+
+            dma_channel_unclaim((uint)rx.dmaChannel);
+            rx.dmaChannel = -1;
+
+            rx.mode = UartRxMode::IRQ;
+            UartUpdateIrqEnables(uart);
+        }
+    }
+
+    // poll while any UART is receiving by DMA
+    if (UART_0_RX.mode == UartRxMode::DMA || UART_1_RX.mode == UartRxMode::DMA)
+    {
+        if (timerRxDmaPoll_.IsPending() == false)
+        {
+            timerRxDmaPoll_.SetCallback(UartRxDmaPoll);
+            timerRxDmaPoll_.TimeoutIntervalMs(UART_RX_DMA_POLL_MS);
+        }
+    }
+    else
+    {
+        timerRxDmaPoll_.Cancel();
+    }
+
+    return retVal;
+}
+
+UartRxMode UartGetRxMode(UART uart)
+{
+    return UartGetRx(uart).mode;
+}
+
+
 static bool uart1Enabled_ = false;
 
 void UartEnable(UART uart)
@@ -522,13 +980,13 @@ void UartEnable(UART uart)
     {
         UartInitDevice(uart0, 1, 0, 76800);
         UartInitDeviceInterrupts(uart0, UartInterruptHandlerUart0);
-        irq_set_pending(UART0_IRQ);
+        UartTxKick(UART_0_TX);
     }
     else if (uart == UART::UART_1)
     {
         UartInitDevice(uart1, 9, 8, 9600);
         UartInitDeviceInterrupts(uart1, UartInterruptHandlerUart1);
-        irq_set_pending(UART1_IRQ);
+        UartTxKick(UART_1_TX);
 
         uart1Enabled_ = true;
     }
@@ -572,7 +1030,20 @@ void UartClearRxBuffer(UART uart)
     // clear the queues seen below
     if (uart == UART::UART_1)
     {
-        UART_1_INPUT_PIPE.Flush();
+        UartRx &rx = UART_1_RX;
+
+        {
+            IrqLock lock;
+
+            if (rx.mode == UartRxMode::DMA)
+            {
+                UartRxDmaSync(rx);
+            }
+
+            rx.ring.Flush();
+            ++rx.flushSeqNo;
+        }
+
         UART_1_INPUT_LINE_STREAM_DISTRIBUTOR.Clear();
         UART_1_INPUT_LINE_STREAM_DISTRIBUTOR.ClearInFlight();
     }
@@ -582,7 +1053,19 @@ void UartClearTxBuffer(UART uart)
 {
     if (uart == UART::UART_1)
     {
-        UART_1_OUTPUT_PIPE.Flush();
+        IrqLock lock;
+
+        UartTx &tx = UART_1_TX;
+
+        // stop any transfer, the ring is emptied below anyway
+        if (tx.dmaInFlight)
+        {
+            dma_channel_abort((uint)tx.dmaChannel);
+            dma_channel_acknowledge_irq0((uint)tx.dmaChannel);
+            tx.dmaInFlight = 0;
+        }
+
+        tx.ring.Flush();
     }
 }
 
@@ -599,13 +1082,13 @@ void UartInit()
     stdio_init_all();
 
     // register the line distributors with the binary distributors -- daisy chain
-    UART_0_INPUT_DATA_STREAM_DISTRIBUTOR.AddDataStreamCallback([](const vector<uint8_t> &data){
+    UART_0_INPUT_DATA_STREAM_DISTRIBUTOR.AddDataStreamCallback([](span<const uint8_t> data){
         UART_0_INPUT_LINE_STREAM_DISTRIBUTOR.AddData(data);
     });
-    UART_1_INPUT_DATA_STREAM_DISTRIBUTOR.AddDataStreamCallback([](const vector<uint8_t> &data){
+    UART_1_INPUT_DATA_STREAM_DISTRIBUTOR.AddDataStreamCallback([](span<const uint8_t> data){
         UART_1_INPUT_LINE_STREAM_DISTRIBUTOR.AddData(data);
     });
-    UART_USB_INPUT_DATA_STREAM_DISTRIBUTOR.AddDataStreamCallback([](const vector<uint8_t> &data){
+    UART_USB_INPUT_DATA_STREAM_DISTRIBUTOR.AddDataStreamCallback([](span<const uint8_t> data){
         UART_USB_INPUT_LINE_STREAM_DISTRIBUTOR.AddData(data);
     });
 
@@ -637,14 +1120,31 @@ void UartSetupShell()
     }, { .argCount = 2, .help = "UART log <uart=1> <msg>"});
 
     Shell::AddCommand("uart.stats", [](vector<string> argList){
+        auto fnTxStats = [](UartTx &tx){
+            Log("- tx mode       : ", tx.mode == UartTxMode::DMA ? "DMA" : "IRQ");
+            Log("- tx queued     : ", Commas(tx.ring.Count()), " (max ", Commas(tx.ring.GetHighWaterMark()), " of ", Commas(tx.ring.Capacity()), ")");
+            Log("- tx sent       : ", Commas(tx.bytesSent));
+            Log("- tx waits      : ", Commas(tx.producerWaits));
+            Log("- tx dma xfers  : ", Commas(tx.dmaTransfers));
+        };
+
+        auto fnRxStats = [](UartRx &rx){
+            Log("- rx mode       : ", rx.mode == UartRxMode::DMA ? "DMA" : "IRQ");
+            Log("- irq queued    : ", Commas(rx.ring.Count()), " (max ", Commas(rx.ring.GetHighWaterMark()), " of ", Commas(rx.ring.Capacity()), ")");
+            Log("- rx received   : ", Commas(rx.bytesReceived));
+            Log("- rx dropped    : ", Commas(rx.bytesDropped));
+        };
+
         Log("UART_0");
-        Log("- irq queued    : ", UART_0_INPUT_PIPE.Count());
+        fnTxStats(UART_0_TX);
+        fnRxStats(UART_0_RX);
         Log("- raw listeners : ", UART_0_INPUT_DATA_STREAM_DISTRIBUTOR.GetCallbackCount() - 1);
         Log("- line listeners: ", UART_0_INPUT_LINE_STREAM_DISTRIBUTOR.GetCallbackCount());
         Log("  - queued      : ", UART_0_INPUT_LINE_STREAM_DISTRIBUTOR.Size());
         LogNL();
         Log("UART_1");
-        Log("- irq queued    : ", UART_1_INPUT_PIPE.Count());
+        fnTxStats(UART_1_TX);
+        fnRxStats(UART_1_RX);
         Log("- raw listeners : ", UART_1_INPUT_DATA_STREAM_DISTRIBUTOR.GetCallbackCount() - 1);
         Log("- line listeners: ", UART_1_INPUT_LINE_STREAM_DISTRIBUTOR.GetCallbackCount());
         Log("  - queued      : ", UART_1_INPUT_LINE_STREAM_DISTRIBUTOR.Size());
@@ -656,6 +1156,108 @@ void UartSetupShell()
         Log("  - queued      : ", UART_USB_INPUT_LINE_STREAM_DISTRIBUTOR.Size());
     }, { .argCount = 0, .help = "UART stats"});
 
+    Shell::AddCommand("uart.tx.mode", [](vector<string> argList){
+        UART uart = argList[0] == "1" ? UART::UART_1 : UART::UART_0;
+        UartTxMode mode = argList[1] == "dma" ? UartTxMode::DMA : UartTxMode::IRQ;
+
+        bool ok = UartSetTxMode(uart, mode);
+        Log("TX mode ", argList[1], ok ? " set" : " not available");
+    }, { .argCount = 2, .help = "UART <uart=0/1> TX mode <irq/dma>"});
+
+    // Input drained from the FIFO by the IRQ, or written straight into the
+    // ring by DMA.
+    Shell::AddCommand("uart.rx.mode", [](vector<string> argList){
+        UART uart = argList[0] == "1" ? UART::UART_1 : UART::UART_0;
+        UartRxMode mode = argList[1] == "dma" ? UartRxMode::DMA : UartRxMode::IRQ;
+
+        bool ok = UartSetRxMode(uart, mode);
+        Log("RX mode ", argList[1], ok ? " set" : " not available");
+    }, { .argCount = 2, .help = "UART <uart=0/1> RX mode <irq/dma>"});
+
+    // Measure throughput and CPU cost of async output in a given mode.
+    //
+    // CPU cost is measured by the busy-loop method.  A counter is spun with
+    // nothing else going on to get a baseline rate, then spun again while
+    // the output is being written and drained.  The shortfall in count is
+    // the share of CPU taken by UartSend plus the IRQ / DMA handling.
+    //
+    // Output is written in log-line sized chunks and only when it fits, so
+    // the producer never blocks inside the measurement.
+    Shell::AddCommand("uart.bench", [](vector<string> argList){
+        UART uart = argList[0] == "1" ? UART::UART_1 : UART::UART_0;
+        UartTxMode mode = argList[1] == "dma" ? UartTxMode::DMA : UartTxMode::IRQ;
+        uint32_t bytes = (uint32_t)atol(argList[2].c_str());
+
+        UartTx &tx = UartGetTx(uart);
+        UartTxMode modeWas = tx.mode;
+
+        if (UartSetTxMode(uart, mode) == false)
+        {
+            Log("TX mode ", argList[1], " not available");
+            return;
+        }
+
+        static const uint32_t CHUNK_SIZE = 64;
+        uint8_t chunk[CHUNK_SIZE];
+        for (uint32_t i = 0; i < CHUNK_SIZE; ++i)
+        {
+            chunk[i] = (uint8_t)('0' + (i % 10));
+        }
+        chunk[CHUNK_SIZE - 1] = '\n';
+
+        if (UartIsEnabled(uart) == false)
+        {
+            Log("UART ", argList[0], " not enabled");
+            return;
+        }
+
+        // let the console go quiet before measuring
+        while (tx.ring.Count() || UART_0_TX.ring.Count())
+        {
+            PAL.Delay(1);
+        }
+
+        // the same loop is used for both the baseline and under load, only
+        // the amount of data differs
+        auto fnSpin = [&](uint32_t bytesToSend, uint64_t durationMinUs) -> pair<uint32_t, uint64_t> {
+            volatile uint32_t spin = 0;
+
+            uint32_t remaining = bytesToSend;
+            uint64_t timeStart = PAL.Micros();
+            uint64_t timeEnd   = timeStart + durationMinUs;
+            while (PAL.Micros() < timeEnd || remaining || tx.ring.Count() || tx.dmaInFlight)
+            {
+                uint32_t len = remaining < CHUNK_SIZE ? remaining : CHUNK_SIZE;
+                if (len && tx.ring.Space() >= len)
+                {
+                    UartTxWrite(tx, chunk, len);
+                    remaining -= len;
+                }
+
+                spin = spin + 1;
+            }
+
+            return { spin, PAL.Micros() - timeStart };
+        };
+
+        auto [spinBaseline, durationBaseline] = fnSpin(0, 100'000);
+        auto [spin,         duration]         = fnSpin(bytes, 0);
+
+        double spinPerUs = (double)spinBaseline / (double)durationBaseline;
+
+        double spinExpected = spinPerUs * (double)duration;
+        uint32_t pctCpu = spinExpected > spin ? (uint32_t)(100 * (spinExpected - spin) / spinExpected) : 0;
+        uint32_t bytesPerSec = duration ? (uint32_t)((uint64_t)bytes * 1'000'000 / duration) : 0;
+
+        UartSetTxMode(uart, modeWas);
+
+        Log("UART ", argList[0], " TX ", argList[1]);
+        Log("- bytes     : ", Commas(bytes));
+        Log("- duration  : ", Commas(duration), " us");
+        Log("- bytes/sec : ", Commas(bytesPerSec));
+        Log("- cpu       : ", pctCpu, " %");
+    }, { .argCount = 3, .help = "UART <uart=0/1> TX bench <irq/dma> <bytes>"});
+
     Shell::AddCommand("uart.uart1", [](vector<string> argList){
         if (argList[0] == "on") { UartEnable(UART::UART_1);  }
         else                    { UartDisable(UART::UART_1); }
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 
 extern void UartInit();
@@ -42,16 +46,49 @@ extern void UartOut(const char *str);
 extern void UartSend(const uint8_t *buf, uint16_t bufLen);
 extern void UartSend(const std::vector<uint8_t> &byteList);
 
+// How async output on UART_0 / UART_1 reaches the hardware
+// - IRQ - the UART TX interrupt refills the FIFO (default)
+// - DMA - a DMA channel paced by the UART feeds it, no per-byte CPU work
+enum class UartTxMode : uint8_t
+{
+    IRQ,
+    DMA,
+};
+
+// Waits for queued output to drain before switching.
+// Returns false if DMA was requested but no channel was available.
+extern bool       UartSetTxMode(UART uart, UartTxMode mode);
+extern UartTxMode UartGetTxMode(UART uart);
+
 // Input handling for raw data streams
 // Low frills (no auto-uart re-direct of output), cb executes in smaller thread stack
-extern std::pair<bool, uint8_t> UartAddDataStreamCallback(UART uart, std::function<void(const std::vector<uint8_t> &data)> cbFn);
-extern bool                     UartSetDataStreamCallback(UART uart, std::function<void(const std::vector<uint8_t> &data)> cbFn, uint8_t id = 0);
+// data is a view onto the receive buffer, only valid for the duration of the callback
+extern std::pair<bool, uint8_t> UartAddDataStreamCallback(UART uart, std::function<void(std::span<const uint8_t> data)> cbFn);
+extern bool                     UartSetDataStreamCallback(UART uart, std::function<void(std::span<const uint8_t> data)> cbFn, uint8_t id = 0);
 extern bool                     UartRemoveDataStreamCallback(UART uart, uint8_t id = 0);
 
+// How input on UART_0 / UART_1 is received
+// - IRQ - the UART RX interrupt empties the FIFO into a ring (default)
+// - DMA - a DMA channel paced by the UART writes into the ring, which is
+//         polled every few ms, no per-byte CPU work
+enum class UartRxMode : uint8_t
+{
+    IRQ,
+    DMA,
+};
+
+// Returns false if DMA was requested but no channel was available.
+extern bool       UartSetRxMode(UART uart, UartRxMode mode);
+extern UartRxMode UartGetRxMode(UART uart);
+
 // Input handling for ASCII-only lines
 // high frills (auto-redirect output), cb executes in main evm thread
+// line refers to the line buffer, only valid for the duration of the callback
+// (the View variants avoid std::string entirely, removal is common to both)
 extern std::pair<bool, uint8_t> UartAddLineStreamCallback(UART uart, std::function<void(const std::string &line)> cbFn, bool hideBlankLines = true);
 extern bool                     UartSetLineStreamCallback(UART uart, std::function<void(const std::string &line)> cbFn, uint8_t id = 0, bool hideBlankLines = true);
+extern std::pair<bool, uint8_t> UartAddLineStreamViewCallback(UART uart, std::function<void(std::string_view line)> cbFn, bool hideBlankLines = true);
+extern bool                     UartSetLineStreamViewCallback(UART uart, std::function<void(std::string_view line)> cbFn, uint8_t id = 0, bool hideBlankLines = true);
 extern bool                     UartRemoveLineStreamCallback(UART uart, uint8_t id = 0);
 
 
@@ -1,12 +1,16 @@
 #include "USB.h"
+#include "JSONMsgRouter.h"
 #include "Log.h"
 #include "KTask.h"
+#include "PAL.h"
 #include "Shell.h"
 #include "Timeline.h"
 #include "Utl.h"
 
 #include "tusb.h"
 
+#include <algorithm>
+#include <string_view>
 using namespace std;
 
 #include "StrictMode.h"
@@ -283,6 +287,42 @@ void USB::SetupShell()
 
         cdc0->ReportStats();
     }, { .argCount = 0, .help = "cdc0 stats"});
+
+    Shell::AddCommand("usb.cdc0.json.bench", [](vector<string> argList){
+        USB_CDC *cdc0 = USB::GetCdcInstance(0);
+
+        if (cdc0->GetDtr())
+        {
+            // replies go out over cdc0, one per line, waiting for room as
+            // needed, so the rate is end to end
+            static JSONMsgRouter::Iface iface;
+            iface.SetOnReceiveViewCallback([cdc0](string_view jsonStr){
+                auto fnSend = [&](const char *buf, size_t bufLen){
+                    while (bufLen && cdc0->GetDtr())
+                    {
+                        uint16_t bytesSent = cdc0->Send((const uint8_t *)buf, (uint16_t)min(bufLen, (size_t)UINT16_MAX));
+
+                        buf    += bytesSent;
+                        bufLen -= bytesSent;
+
+                        if (bufLen)
+                        {
+                            PAL.Delay(1);
+                        }
+                    }
+                };
+
+                fnSend(jsonStr.data(), jsonStr.size());
+                fnSend("\n", 1);
+            });
+
+            JSONMsgRouter::Bench(iface, argList.size() ? (uint32_t)atoi(argList[0].c_str()) : 1'000);
+        }
+        else
+        {
+            Log("ERR: cdc0 not connected (DTR)");
+        }
+    }, { .argCount = -1, .help = "route <count=1000> REQ_PING messages, replies over cdc0"});
 }
 
 
@@ -0,0 +1,349 @@
+#include "ADCSampler.h"
+#include "Clock.h"
+#include "ClockGovernor.h"
+#include "Evm.h"
+#include "I2CEngine.h"
+#include "Log.h"
+#include "PAL.h"
+#include "PWMAudio.h"
+#include "Shell.h"
+#include "Timeline.h"
+#include "Utl.h"
+
+#include <algorithm>
+using namespace std;
+
+#include "StrictMode.h"
+
+
+/////////////////////////////////////////////////////////////////
+// Configuration
+/////////////////////////////////////////////////////////////////
+
+// 1500 MHz VCO divided by 12, 15, 20 and 30
+ClockGovernor::Config ClockGovernor::GetDefaultConfig()
+{
+    Config config;
+
+    config.levelList = {
+        {  50'000, 1'000 },
+        {  75'000, 1'050 },
+        { 100'000, 1'100 },
+        { 125'000, 1'100 },
+    };
+
+    return config;
+}
+
+void ClockGovernor::SetConfig(const Config &config)
+{
+    if (config.levelList.empty())
+    {
+        Log("ClockGovernor ERR: no levels");
+    }
+    else
+    {
+        policy_.SetConfig(config);
+        configSet_ = true;
+
+        if (running_)
+        {
+            Start();
+        }
+    }
+}
+
+const ClockGovernor::Config &ClockGovernor::GetConfig()
+{
+    if (configSet_ == false)
+    {
+        SetConfig(GetDefaultConfig());
+    }
+
+    return policy_.GetConfig();
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Control
+/////////////////////////////////////////////////////////////////
+
+void ClockGovernor::Start()
+{
+    Timeline::Global().Event("ClockGovernor::Start");
+
+    GetConfig();
+
+    uint8_t levelTop = policy_.GetLevelTop();
+    ApplyLevel(levelTop);
+
+    const Evm::Load &load = Evm::GetLoad();
+    policy_.Reset(PAL.Micros(), load.timeBusyUs, levelTop);
+
+    stats_        = {};
+    timeStartUs_  = PAL.Micros();
+    handledStart_ = load.handled;
+    running_      = true;
+
+    Evm::SetLoadHooks([]{ OnPass(); }, [](uint64_t sleepUs){ OnSleep(sleepUs); });
+}
+
+void ClockGovernor::Stop()
+{
+    Timeline::Global().Event("ClockGovernor::Stop");
+
+    if (running_)
+    {
+        Evm::SetLoadHooks(nullptr, nullptr);
+
+        policy_.Account(PAL.Micros(), Evm::GetLoad().timeBusyUs);
+
+        ApplyLevel(policy_.GetLevelTop());
+
+        running_ = false;
+    }
+}
+
+bool ClockGovernor::IsRunning()
+{
+    return running_;
+}
+
+void ClockGovernor::RegisterTimer(Timer *timer, uint32_t latencyUs)
+{
+    DeRegisterTimer(timer);
+
+    timerGuardList_.push_back({ timer, latencyUs });
+}
+
+void ClockGovernor::DeRegisterTimer(Timer *timer)
+{
+    erase_if(timerGuardList_, [&](const TimerGuard &tg){
+        return tg.timer == timer;
+    });
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Switching
+/////////////////////////////////////////////////////////////////
+
+void ClockGovernor::OnPass()
+{
+    ClockGovernorPolicy::Want want = policy_.OnPass(PAL.Micros(), Evm::GetLoad().timeBusyUs, Evm::GetWorkDepth());
+
+    if (want.reason != ClockGovernorPolicy::Reason::NONE)
+    {
+        Change(want);
+    }
+}
+
+void ClockGovernor::OnSleep(uint64_t sleepUs)
+{
+    ClockGovernorPolicy::Want want = policy_.OnSleep(PAL.Micros(), sleepUs);
+
+    if (want.reason != ClockGovernorPolicy::Reason::NONE)
+    {
+        Change(want);
+    }
+}
+
+void ClockGovernor::Change(const ClockGovernorPolicy::Want &want)
+{
+    const Level &level = policy_.GetConfig().levelList[want.level];
+
+    uint64_t timeStartUs = PAL.Micros();
+    uint32_t costUs      = max(Clock::GetStats().fastUsMax, SWITCH_US_GUESS);
+    if (level.mv > mvNow_)
+    {
+        costUs += VREG_SETTLE_US;
+    }
+
+    ClockGovernorPolicy::Peripherals peripherals = {
+        .i2cBusy    = I2CEngine::Get(0).IsIdle() == false || I2CEngine::Get(1).IsIdle() == false,
+        .pwmAudio   = PWMAudio::IsAnyRunning(),
+        .adcSampler = ADCSampler::IsRunning(),
+    };
+    ClockGovernorPolicy::Hold hold = ClockGovernorPolicy::GetHold(peripherals);
+
+    if (IsSafeToSwitch(timeStartUs, costUs) == false)
+    {
+        ++stats_.deferredTimer;
+    }
+    else if (hold == ClockGovernorPolicy::Hold::I2C)
+    {
+        ++stats_.deferredI2C;
+    }
+    else if (hold == ClockGovernorPolicy::Hold::PERIPHERAL)
+    {
+        ++stats_.deferredPeripheral;
+    }
+    else
+    {
+        Timeline::Global().Event("CLOCK_GOVERNOR_CHANGE");
+
+        ApplyLevel(want.level);
+
+        if (Clock::GetClockKHz() / 1'000 != level.khz / 1'000)
+        {
+            ++stats_.failed;
+        }
+
+        uint64_t timeNowUs = PAL.Micros();
+        policy_.Apply(timeNowUs, Evm::GetLoad().timeBusyUs, want.level);
+
+        stats_.switchUsMax = max(stats_.switchUsMax, (uint32_t)(timeNowUs - timeStartUs));
+
+        switch (want.reason)
+        {
+        case ClockGovernorPolicy::Reason::BURST: ++stats_.upBurst;   break;
+        case ClockGovernorPolicy::Reason::LOAD:  ++stats_.upLoad;    break;
+        case ClockGovernorPolicy::Reason::IDLE:  ++stats_.downIdle;  break;
+        case ClockGovernorPolicy::Reason::SLEEP: ++stats_.downSleep; break;
+        default: break;
+        }
+    }
+}
+
+// Safe if the main loop, held up for costUs, is back before each pending
+// registered timer is late by more than its latency.
+bool ClockGovernor::IsSafeToSwitch(uint64_t timeNowUs, uint32_t costUs)
+{
+    bool retVal = true;
+
+    for (const auto &tg : timerGuardList_)
+    {
+        if (tg.timer->IsPending() && timeNowUs + costUs > tg.timer->GetTimeoutAtUs() + tg.latencyUs)
+        {
+            retVal = false;
+
+            break;
+        }
+    }
+
+    return retVal;
+}
+
+// Voltage up before the clock, down after
+void ClockGovernor::ApplyLevel(uint8_t level)
+{
+    const Level &l = policy_.GetConfig().levelList[level];
+
+    if (l.mv && l.mv > mvNow_)
+    {
+        Clock::SetVoltageMv(l.mv);
+        mvNow_ = l.mv;
+
+        PAL.DelayBusyUs(VREG_SETTLE_US);
+    }
+
+    Clock::SetClockKHz(l.khz);
+
+    if (l.mv && l.mv < mvNow_)
+    {
+        Clock::SetVoltageMv(l.mv);
+        mvNow_ = l.mv;
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Reporting
+/////////////////////////////////////////////////////////////////
+
+const ClockGovernor::Stats &ClockGovernor::GetStats()
+{
+    return stats_;
+}
+
+// Time at each level and the clock cycles spent (MHz * seconds), against
+// the work got through and what running flat out at the top would have
+// cost.
+void ClockGovernor::Report()
+{
+    uint64_t timeNowUs = PAL.Micros();
+
+    if (running_)
+    {
+        policy_.Account(timeNowUs, Evm::GetLoad().timeBusyUs);
+    }
+
+    const Config &config    = GetConfig();
+    uint64_t      elapsedUs = max(timeNowUs - timeStartUs_, (uint64_t)1);
+    uint64_t      handled   = Evm::GetLoad().handled - handledStart_;
+
+    Log("ClockGovernor ", running_ ? "running" : "stopped", ", ", Commas(elapsedUs / 1'000), " ms");
+    Log("   kHz      mV     time ms     %  busy %");
+    for (uint8_t i = 0; i < config.levelList.size(); ++i)
+    {
+        uint64_t timeUs = policy_.GetTimeAtLevelUs(i);
+        uint64_t busyUs = policy_.GetBusyAtLevelUs(i);
+
+        Log(StrUtl::PadLeft(Commas(config.levelList[i].khz), ' ', 7),
+            StrUtl::PadLeft(Commas(config.levelList[i].mv), ' ', 8),
+            StrUtl::PadLeft(Commas(timeUs / 1'000), ' ', 12),
+            StrUtl::PadLeft(to_string(timeUs * 100 / elapsedUs), ' ', 6),
+            StrUtl::PadLeft(to_string(timeUs ? busyUs * 100 / timeUs : 0), ' ', 8),
+            i == policy_.GetLevel() ? "  <" : "");
+    }
+    LogNL();
+
+    double mhzS      = policy_.GetMhzSeconds();
+    double mhzSBusy  = policy_.GetMhzSecondsBusy();
+    double mhzSFixed = (double)config.levelList.back().khz * (double)elapsedUs / 1'000'000'000.0;
+    double seconds   = (double)elapsedUs / 1'000'000.0;
+
+    Log("MHz*s          : ", mhzS, " (", mhzSBusy, " busy)");
+    Log("MHz*s at top   : ", mhzSFixed, " (", (uint32_t)(mhzSFixed ? 100 - mhzS * 100 / mhzSFixed : 0), " % saved)");
+    Log("Handled        : ", Commas(handled), " (", Commas((uint64_t)((double)handled / seconds)), " / sec, ", (uint32_t)(mhzS ? (double)handled / mhzS : 0), " / MHz*s)");
+    LogNL();
+
+    Log("Up             : ", Commas(stats_.upBurst), " burst, ", Commas(stats_.upLoad), " load");
+    Log("Down           : ", Commas(stats_.downIdle), " idle, ", Commas(stats_.downSleep), " sleep");
+    Log("Deferred       : ", Commas(stats_.deferredTimer), " timer, ", Commas(stats_.deferredI2C), " I2C, ", Commas(stats_.deferredPeripheral), " PWMAudio");
+    Log("Failed         : ", Commas(stats_.failed));
+    Log("Switch us max  : ", Commas(stats_.switchUsMax));
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Shell
+/////////////////////////////////////////////////////////////////
+
+void ClockGovernor::SetupShell()
+{
+    Timeline::Global().Event("ClockGovernor::SetupShell");
+
+    Shell::AddCommand("clk.gov.start", [](vector<string> argList){
+        Start();
+    }, { .argCount = 0, .help = "start scaling the clock with load" });
+
+    Shell::AddCommand("clk.gov.stop", [](vector<string> argList){
+        Stop();
+    }, { .argCount = 0, .help = "stop, leaving the clock at the top level" });
+
+    Shell::AddCommand("clk.gov.report", [](vector<string> argList){
+        Report();
+    }, { .argCount = 0, .help = "time per level, MHz*s and throughput" });
+
+    Shell::AddCommand("clk.gov.set", [](vector<string> argList){
+        Config config = GetConfig();
+
+        string   name  = argList[0];
+        uint32_t value = (uint32_t)atoi(argList[1].c_str());
+
+        if      (name == "windowUs")    { config.windowUs    = value;            }
+        else if (name == "upPct")       { config.upPct       = (uint8_t)value;   }
+        else if (name == "downPct")     { config.downPct     = (uint8_t)value;   }
+        else if (name == "downWindows") { config.downWindows = (uint8_t)value;   }
+        else if (name == "burstDepth")  { config.burstDepth  = (uint16_t)value;  }
+        else if (name == "idleSleepUs") { config.idleSleepUs = value;            }
+        else if (name == "holdUs")      { config.holdUs      = value;            }
+        else
+        {
+            Log("Unknown setting ", name);
+        }
+
+        SetConfig(config);
+    }, { .argCount = 2, .help = "set <windowUs|upPct|downPct|downWindows|burstDepth|idleSleepUs|holdUs> <value>" });
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "ClockGovernorPolicy.h"
+#include "Timer.h"
+
+#include <cstdint>
+#include <vector>
+
+
+// Scales the system clock, and core voltage, with how busy Evm is.
+//
+// Hooks the Evm main loop, which asks ClockGovernorPolicy at the start of
+// each pass and before each sleep what level to run at.  Switching is by
+// Clock::SetClockKHz, which between PLL frequencies only touches registers.
+// The default levels all come from a 1500 MHz VCO, so the PLL stays locked
+// and only its post dividers change.
+//
+// Voltage goes up before the clock, waiting for the regulator to settle,
+// and down after it.  The default voltages are conservative, but below
+// nominal, so check them on the board.
+//
+// A switch stalls the main loop briefly, so timers registered here with a
+// latency are protected.  A switch which could hold up the main loop past
+// one's timeout by more than its latency is put off, and asked for again
+// on a later pass.
+//
+// A switch moves clk_sys, clk_peri and clk_adc together, all being on
+// pll_sys, so also changes anything timed off them:
+// - I2C is set up again once the bus is idle, switches are put off while
+//   it isn't
+// - PWMAudio works out its divider once, on Start, so switches are put
+//   off while it's playing, else pitch would follow the clock
+// - ADCSampler works its divider out again, so its sample rate holds
+// - the UARTs are set up again, so a byte on the wire at the time may be
+//   lost
+// - anything else dividing one of these clocks (PWM, PIO, SPI) has to work
+//   its divider out again on KTime::RegisterCallbackScalingFactorChange
+//
+// Not started by default.
+class ClockGovernor
+{
+public:
+
+    using Level  = ClockGovernorPolicy::Level;
+    using Config = ClockGovernorPolicy::Config;
+
+    struct Stats
+    {
+        uint32_t upBurst;
+        uint32_t upLoad;
+        uint32_t downIdle;
+        uint32_t downSleep;
+
+        uint32_t deferredTimer;
+        uint32_t deferredI2C;
+        uint32_t deferredPeripheral;    // PWMAudio playing
+        uint32_t failed;
+
+        uint32_t switchUsMax;
+    };
+
+    // Levels slowest first
+    static void SetConfig(const Config &config);
+    static const Config &GetConfig();
+
+    static void Start();
+    static void Stop();     // leaves the clock at the top level
+    static bool IsRunning();
+
+    static void RegisterTimer(Timer *timer, uint32_t latencyUs);
+    static void DeRegisterTimer(Timer *timer);
+
+    static const Stats &GetStats();
+    static void Report();
+
+    static void SetupShell();
+
+
+private:
+
+    // the regulator's settling time on the way up, as pico-sdk allows
+    static const uint32_t VREG_SETTLE_US = 1'000;
+
+    // until a switch has been measured
+    static const uint32_t SWITCH_US_GUESS = 250;
+
+    struct TimerGuard
+    {
+        Timer    *timer;
+        uint32_t  latencyUs;
+    };
+
+    static void OnPass();
+    static void OnSleep(uint64_t sleepUs);
+    static void Change(const ClockGovernorPolicy::Want &want);
+    static bool IsSafeToSwitch(uint64_t timeNowUs, uint32_t costUs);
+    static void ApplyLevel(uint8_t level);
+
+    static Config GetDefaultConfig();
+
+
+private:
+
+    inline static ClockGovernorPolicy policy_;
+    inline static bool                configSet_ = false;
+    inline static bool                running_   = false;
+    inline static uint16_t            mvNow_     = 0;
+
+    inline static std::vector<TimerGuard> timerGuardList_;
+
+    inline static Stats stats_ = {};
+
+    inline static uint64_t timeStartUs_ = 0;
+    inline static uint64_t handledStart_ = 0;
+};
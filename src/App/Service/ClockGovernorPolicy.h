@@ -0,0 +1,282 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+// How ClockGovernor picks a clock level from how busy the Evm main loop is.
+// Only the arithmetic, so it can run off-target.
+//
+// Levels are ordered slowest first.  Going up is immediate, going down is
+// held off, so bursts get the clock right away and it can't thrash:
+// - work queued burstDepth or deeper at the start of a pass goes straight
+//   to the top
+// - busy upPct or more of a window goes straight to the top
+// - busy under downPct for downWindows windows in a row steps down one
+// - about to sleep for idleSleepUs or longer goes straight to the bottom
+// - nothing goes down within holdUs of the last change
+//
+// The time spent at each level, and busy at each level, is kept for the
+// energy proxy, MHz times seconds (cycles, in effect).
+class ClockGovernorPolicy
+{
+public:
+
+    struct Level
+    {
+        uint32_t khz;
+        uint16_t mv;    // core voltage, 0 leaves it alone
+    };
+
+    struct Config
+    {
+        std::vector<Level> levelList;
+
+        uint32_t windowUs    = 50'000;
+        uint8_t  upPct       = 80;
+        uint8_t  downPct     = 30;
+        uint8_t  downWindows = 4;
+        uint16_t burstDepth  = 8;
+        uint32_t idleSleepUs = 20'000;
+        uint32_t holdUs      = 10'000;
+    };
+
+    enum class Reason : uint8_t
+    {
+        NONE,
+        BURST,
+        LOAD,
+        IDLE,
+        SLEEP,
+    };
+
+    struct Want
+    {
+        uint8_t level;
+        Reason  reason;
+    };
+
+    // What's running off the clocks being switched, as found before a
+    // switch
+    struct Peripherals
+    {
+        bool i2cBusy    = false;
+        bool pwmAudio   = false;
+        bool adcSampler = false;
+    };
+
+    enum class Hold : uint8_t
+    {
+        NONE,
+        I2C,
+        PERIPHERAL,
+    };
+
+
+public:
+
+    void SetConfig(const Config &config)
+    {
+        config_ = config;
+
+        timeAtLevelUs_.assign(config_.levelList.size(), 0);
+        busyAtLevelUs_.assign(config_.levelList.size(), 0);
+    }
+
+    const Config &GetConfig() const
+    {
+        return config_;
+    }
+
+    // Starts over, at the given level
+    void Reset(uint64_t timeNowUs, uint64_t timeBusyUs, uint8_t level)
+    {
+        level_ = level;
+
+        windowStartUs_     = timeNowUs;
+        windowBusyStartUs_ = timeBusyUs;
+        idleWindows_       = 0;
+
+        timeChangedUs_    = timeNowUs;
+        timeAccountedUs_  = timeNowUs;
+        busyAccountedUs_  = timeBusyUs;
+
+        timeAtLevelUs_.assign(config_.levelList.size(), 0);
+        busyAtLevelUs_.assign(config_.levelList.size(), 0);
+    }
+
+    // At the start of a main loop pass
+    Want OnPass(uint64_t timeNowUs, uint64_t timeBusyUs, uint16_t depth)
+    {
+        Want retVal = { level_, Reason::NONE };
+
+        uint8_t levelTop = GetLevelTop();
+
+        if (timeNowUs - windowStartUs_ >= config_.windowUs)
+        {
+            uint64_t durationUs = timeNowUs - windowStartUs_;
+            uint64_t busyUs     = timeBusyUs - windowBusyStartUs_;
+            uint32_t pct        = (uint32_t)(busyUs * 100 / durationUs);
+
+            windowStartUs_     = timeNowUs;
+            windowBusyStartUs_ = timeBusyUs;
+
+            if (pct >= config_.upPct)
+            {
+                idleWindows_ = 0;
+
+                if (level_ < levelTop)
+                {
+                    retVal = { levelTop, Reason::LOAD };
+                }
+            }
+            else if (pct < config_.downPct)
+            {
+                if (idleWindows_ < config_.downWindows)
+                {
+                    ++idleWindows_;
+                }
+            }
+            else
+            {
+                idleWindows_ = 0;
+            }
+        }
+
+        if (depth >= config_.burstDepth && level_ < levelTop)
+        {
+            retVal = { levelTop, Reason::BURST };
+        }
+        else if (retVal.reason == Reason::NONE && idleWindows_ >= config_.downWindows && level_ > 0 && CanGoDown(timeNowUs))
+        {
+            retVal = { (uint8_t)(level_ - 1), Reason::IDLE };
+        }
+
+        return retVal;
+    }
+
+    // Just before the main loop sleeps
+    Want OnSleep(uint64_t timeNowUs, uint64_t sleepUs)
+    {
+        Want retVal = { level_, Reason::NONE };
+
+        if (sleepUs >= config_.idleSleepUs && level_ > 0 && CanGoDown(timeNowUs))
+        {
+            retVal = { 0, Reason::SLEEP };
+        }
+
+        return retVal;
+    }
+
+    // Once the wanted level is in effect
+    void Apply(uint64_t timeNowUs, uint64_t timeBusyUs, uint8_t level)
+    {
+        Account(timeNowUs, timeBusyUs);
+
+        level_         = level;
+        timeChangedUs_ = timeNowUs;
+        idleWindows_   = 0;
+    }
+
+    // What a switch has to wait for, if anything.  I2C is set up again
+    // once its bus is idle, and PWMAudio works its divider out only on
+    // Start.  ADCSampler works its divider out again on the change, so
+    // doesn't hold a switch.
+    static Hold GetHold(const Peripherals &peripherals)
+    {
+        Hold retVal = Hold::NONE;
+
+        if (peripherals.i2cBusy)
+        {
+            retVal = Hold::I2C;
+        }
+        else if (peripherals.pwmAudio)
+        {
+            retVal = Hold::PERIPHERAL;
+        }
+
+        return retVal;
+    }
+
+    // Brings the time at each level up to now
+    void Account(uint64_t timeNowUs, uint64_t timeBusyUs)
+    {
+        if (level_ < timeAtLevelUs_.size())
+        {
+            timeAtLevelUs_[level_] += timeNowUs  - timeAccountedUs_;
+            busyAtLevelUs_[level_] += timeBusyUs - busyAccountedUs_;
+        }
+
+        timeAccountedUs_ = timeNowUs;
+        busyAccountedUs_ = timeBusyUs;
+    }
+
+    uint8_t GetLevel() const
+    {
+        return level_;
+    }
+
+    uint8_t GetLevelTop() const
+    {
+        return config_.levelList.empty() ? 0 : (uint8_t)(config_.levelList.size() - 1);
+    }
+
+    uint64_t GetTimeAtLevelUs(uint8_t level) const
+    {
+        return timeAtLevelUs_[level];
+    }
+
+    uint64_t GetBusyAtLevelUs(uint8_t level) const
+    {
+        return busyAtLevelUs_[level];
+    }
+
+    // Clock cycles, in MHz * seconds, in all and while busy
+    double GetMhzSeconds() const
+    {
+        return GetMhzSeconds(timeAtLevelUs_);
+    }
+
+    double GetMhzSecondsBusy() const
+    {
+        return GetMhzSeconds(busyAtLevelUs_);
+    }
+
+
+private:
+
+    bool CanGoDown(uint64_t timeNowUs) const
+    {
+        return timeNowUs - timeChangedUs_ >= config_.holdUs;
+    }
+
+    double GetMhzSeconds(const std::vector<uint64_t> &usList) const
+    {
+        uint64_t khzUs = 0;
+        for (uint8_t i = 0; i < usList.size(); ++i)
+        {
+            khzUs += usList[i] * config_.levelList[i].khz;
+        }
+
+        return (double)khzUs / 1'000'000'000.0;
+    }
+
+
+private:
+
+    Config config_;
+
+    uint8_t level_ = 0;
+
+    uint64_t windowStartUs_     = 0;
+    uint64_t windowBusyStartUs_ = 0;
+    uint8_t  idleWindows_       = 0;
+
+    uint64_t timeChangedUs_ = 0;
+
+    uint64_t timeAccountedUs_ = 0;
+    uint64_t busyAccountedUs_ = 0;
+
+    std::vector<uint64_t> timeAtLevelUs_;
+    std::vector<uint64_t> busyAtLevelUs_;
+};
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+
+// Lock-free single-producer, single-consumer byte ring.
+//
+// One side (eg a task) only ever writes, the other side (eg an ISR or a
+// DMA completion handler) only ever reads, and neither needs to lock the
+// other out.  If there is more than one producer (or consumer) they must
+// exclude each other by some other means.
+//
+// Storage is supplied by the caller, and SIZE must be a power of 2.  If the
+// storage is also aligned to SIZE, it can be handed directly to a DMA
+// channel configured to wrap its read (or write) address at SIZE, see
+// GetReadIdx() and Produce().
+//
+// Head and tail are free-running counters, masked on use, so full and empty
+// are distinguishable without sacrificing a byte.
+template <uint32_t SIZE>
+class ByteRing
+{
+    static_assert(SIZE && (SIZE & (SIZE - 1)) == 0, "ByteRing: SIZE must be a power of 2");
+
+    static const uint32_t MASK = SIZE - 1;
+
+public:
+
+    explicit ByteRing(uint8_t *buf)
+    : buf_(buf)
+    {
+        // nothing to do
+    }
+
+    ByteRing(const ByteRing &)            = delete;
+    ByteRing &operator=(const ByteRing &) = delete;
+
+
+    /////////////////////////////////////////////////////////////////
+    // Producer
+    /////////////////////////////////////////////////////////////////
+
+    // writes as much of buf as fits, returns the count written
+    uint32_t Write(const uint8_t *buf, uint32_t bufLen)
+    {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        uint32_t tail = tail_.load(std::memory_order_acquire);
+
+        uint32_t space = SIZE - (head - tail);
+        uint32_t len   = bufLen < space ? bufLen : space;
+
+        // up to two copies, before and after the wrap
+        uint32_t idx      = head & MASK;
+        uint32_t lenFirst = SIZE - idx < len ? SIZE - idx : len;
+
+        memcpy(&buf_[idx], buf, lenFirst);
+        memcpy(&buf_[0],   buf + lenFirst, len - lenFirst);
+
+        head_.store(head + len, std::memory_order_release);
+
+        UpdateHighWaterMark(head + len - tail);
+
+        return len;
+    }
+
+    uint32_t Space() const
+    {
+        return SIZE - Count();
+    }
+
+    // for producers (eg DMA) which write into the storage themselves,
+    // starting at GetWriteIdx(), make len more bytes readable
+    void Produce(uint32_t len)
+    {
+        uint32_t head = head_.load(std::memory_order_relaxed) + len;
+
+        head_.store(head, std::memory_order_release);
+
+        UpdateHighWaterMark(head - tail_.load(std::memory_order_acquire));
+    }
+
+    uint32_t GetWriteIdx() const
+    {
+        return head_.load(std::memory_order_relaxed) & MASK;
+    }
+
+
+    /////////////////////////////////////////////////////////////////
+    // Consumer
+    /////////////////////////////////////////////////////////////////
+
+    // reads up to bufLen bytes, returns the count read
+    uint32_t Read(uint8_t *buf, uint32_t bufLen)
+    {
+        uint32_t len = 0;
+
+        while (len < bufLen)
+        {
+            auto [ptr, ptrLen] = Peek();
+            if (ptrLen == 0)
+            {
+                break;
+            }
+
+            uint32_t lenCopy = bufLen - len < ptrLen ? bufLen - len : ptrLen;
+            memcpy(&buf[len], ptr, lenCopy);
+            Consume(lenCopy);
+
+            len += lenCopy;
+        }
+
+        return len;
+    }
+
+    // contiguous readable region, up to the wrap.  the bytes stay in the
+    // ring until Consume()d.
+    std::pair<const uint8_t *, uint32_t> Peek() const
+    {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        uint32_t head = head_.load(std::memory_order_acquire);
+
+        uint32_t idx   = tail & MASK;
+        uint32_t count = head - tail;
+        uint32_t len   = SIZE - idx < count ? SIZE - idx : count;
+
+        return { &buf_[idx], len };
+    }
+
+    void Consume(uint32_t len)
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    }
+
+    // index into the storage of the next byte to read, for consumers (eg
+    // DMA) which handle the wrap themselves and read Count() bytes from here
+    uint32_t GetReadIdx() const
+    {
+        return tail_.load(std::memory_order_relaxed) & MASK;
+    }
+
+    // discard everything currently readable
+    void Flush()
+    {
+        tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+
+    /////////////////////////////////////////////////////////////////
+    // Either side
+    /////////////////////////////////////////////////////////////////
+
+    uint32_t Count() const
+    {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    static constexpr uint32_t Capacity()
+    {
+        return SIZE;
+    }
+
+    uint8_t *GetBuf()
+    {
+        return buf_;
+    }
+
+    const uint8_t *GetBuf() const
+    {
+        return buf_;
+    }
+
+    uint32_t GetHighWaterMark() const
+    {
+        return countMax_;
+    }
+
+    void ResetHighWaterMark()
+    {
+        countMax_ = Count();
+    }
+
+
+private:
+
+    void UpdateHighWaterMark(uint32_t count)
+    {
+        if (count > countMax_)
+        {
+            countMax_ = count;
+        }
+    }
+
+
+private:
+
+    uint8_t *buf_;
+
+    std::atomic<uint32_t> head_ = 0;
+    std::atomic<uint32_t> tail_ = 0;
+
+    // producer-side statistic only, not synchronized
+    uint32_t countMax_ = 0;
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "IDMaker.h"
+
+#include <cstdint>
+#include <utility>
+
+
+// Callbacks kept in a flat array indexed by id, for distributors which call
+// each in turn (eg DataStreamDistributor, LineStreamDistributor).
+//
+// Id 0 is reserved for special purposes, Add never returns it, but it can
+// be Set.
+//
+// Callbacks may add, set, or remove callbacks (including themselves) while
+// being called by ForEach.  Removals take effect immediately (a removed
+// callback is not called again), but are tombstoned, and sets are staged,
+// so the callback objects are only replaced or destroyed once the
+// outermost ForEach is complete.  A callback set during a ForEach is first
+// called by the next one.
+//
+// eg gps getting a lock, bubbling the lock event, which then says ok no
+// need to listen anymore, which finds its way back to deregistering, all
+// while the initial callback is still executing.
+template <typename T, uint8_t CAPACITY = 32>
+class CallbackSlots
+{
+public:
+
+    CallbackSlots()
+    {
+        idMaker_.GetNextId();   // 0
+    }
+
+    std::pair<bool, uint8_t> Add(T &&cb)
+    {
+        auto [ok, id] = idMaker_.GetNextId();
+
+        if (ok)
+        {
+            Set(id, std::move(cb));
+        }
+
+        return { ok, id };
+    }
+
+    // only ids handed out by Add, or 0
+    bool Set(uint8_t id, T &&cb)
+    {
+        bool retVal = false;
+
+        if (idMaker_.IsUsed(id))
+        {
+            Slot &slot = slotList_[id];
+
+            if (slot.active == false)
+            {
+                slot.active = true;
+                ++count_;
+            }
+
+            if (depth_)
+            {
+                // the current function may be the one executing
+                slot.cbPending     = std::move(cb);
+                slot.setPending    = true;
+                slot.removePending = false;
+
+                pending_ = true;
+            }
+            else
+            {
+                slot.cb = std::move(cb);
+            }
+
+            retVal = true;
+        }
+
+        return retVal;
+    }
+
+    bool Remove(uint8_t id)
+    {
+        bool retVal = false;
+
+        // id 0 is reserved, and never returned
+        if (id != 0)
+        {
+            idMaker_.ReturnId(id);
+        }
+
+        if (id < CAPACITY && slotList_[id].active)
+        {
+            Slot &slot = slotList_[id];
+
+            slot.active = false;
+            --count_;
+
+            if (depth_)
+            {
+                // tombstone, the callback may be the one executing
+                slot.setPending    = false;
+                slot.removePending = true;
+
+                pending_ = true;
+            }
+            else
+            {
+                slot.cb = T{};
+            }
+
+            retVal = true;
+        }
+
+        return retVal;
+    }
+
+    bool IsActive(uint8_t id) const
+    {
+        return id < CAPACITY && slotList_[id].active;
+    }
+
+    uint8_t GetCount() const
+    {
+        return count_;
+    }
+
+    // Calls fn(cb) for each callback, in id order
+    template <typename Fn>
+    void ForEach(Fn &&fn)
+    {
+        ++depth_;
+
+        for (auto &slot : slotList_)
+        {
+            if (slot.active && slot.setPending == false)
+            {
+                fn(slot.cb);
+            }
+        }
+
+        --depth_;
+
+        if (depth_ == 0 && pending_)
+        {
+            ApplyPending();
+        }
+    }
+
+
+private:
+
+    void ApplyPending()
+    {
+        for (auto &slot : slotList_)
+        {
+            if (slot.setPending)
+            {
+                slot.cb        = std::move(slot.cbPending);
+                slot.cbPending = T{};
+            }
+            else if (slot.removePending)
+            {
+                slot.cb = T{};
+            }
+
+            slot.setPending    = false;
+            slot.removePending = false;
+        }
+
+        pending_ = false;
+    }
+
+
+private:
+
+    struct Slot
+    {
+        T    cb;
+        bool active = false;
+
+        // changes made during ForEach
+        T    cbPending;
+        bool setPending    = false;
+        bool removePending = false;
+    };
+
+    IDMaker<CAPACITY> idMaker_;
+    Slot              slotList_[CAPACITY];
+    uint8_t           count_ = 0;
+
+    uint8_t depth_   = 0;
+    bool    pending_ = false;
+};
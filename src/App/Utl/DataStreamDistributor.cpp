@@ -8,57 +8,38 @@ using namespace std;
 DataStreamDistributor::DataStreamDistributor(UART uart)
 : uart_(uart)
 {
-    // Reserve id of 0 for special purposes
-    idMaker_.GetNextId();   // 0
+    // Nothing to do
 }
 
-pair<bool, uint8_t> DataStreamDistributor::AddDataStreamCallback(function<void(const vector<uint8_t> &data)> cbFn)
+pair<bool, uint8_t> DataStreamDistributor::AddDataStreamCallback(CbFn cbFn)
 {
-    auto [ok, id] = idMaker_.GetNextId();
-
-    if (ok)
-    {
-        id__cbFn_[id] = cbFn;
-    }
-
-    return { ok, id };
+    return cbList_.Add(move(cbFn));
 }
 
-bool DataStreamDistributor::SetDataStreamCallback(uint8_t id, function<void(const vector<uint8_t> &data)> cbFn)
+bool DataStreamDistributor::SetDataStreamCallback(uint8_t id, CbFn cbFn)
 {
-    bool retVal = false;
-
-    if (id__cbFn_.contains(id) || id == 0)
-    {
-        id__cbFn_[id] = cbFn;
-
-        retVal = true;
-    }
-
-    return retVal;
+    return cbList_.Set(id, move(cbFn));
 }
 
 bool DataStreamDistributor::RemoveDataStreamCallback(uint8_t id)
 {
-    idMaker_.ReturnId(id);
-
-    return id__cbFn_.erase(id);
+    return cbList_.Remove(id);
 }
 
-void DataStreamDistributor::Distribute(const vector<uint8_t> &data)
+void DataStreamDistributor::Distribute(span<const uint8_t> data)
 {
-    // distribute
-    for (auto &[id, cbFn] : id__cbFn_)
-    {
-        // default to writing back to the uart that sent the data
-        // UartTarget target(uart_);    // ehh, let's keep this functionality very simple
-
-        // fire callback
-        cbFn(data);
-    }
+    // default to writing back to the uart that sent the data
+    // UartTarget target(uart_);    // ehh, let's keep this functionality very simple
+
+    cbList_.ForEach([&](CbFn &cbFn){
+        if (cbFn)
+        {
+            cbFn(data);
+        }
+    });
 }
 
 uint8_t DataStreamDistributor::GetCallbackCount()
 {
-    return (uint8_t)id__cbFn_.size();
+    return cbList_.GetCount();
 }
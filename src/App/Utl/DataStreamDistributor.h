@@ -1,29 +1,35 @@
 #pragma once
 
-#include "IDMaker.h"
+#include "CallbackSlots.h"
 #include "UART.h"
 
 #include <cstdint>
 #include <functional>
-#include <unordered_map>
+#include <span>
 #include <utility>
 
 
+// Hands each burst of received bytes to every registered callback, as a
+// view onto the caller's buffer.  Nothing is copied or allocated per burst.
+//
+// Callbacks may add, set, or remove callbacks (including themselves) while
+// being called, see CallbackSlots.
 class DataStreamDistributor
 {
 public:
+    using CbFn = std::function<void(std::span<const uint8_t> data)>;
+
     DataStreamDistributor(UART uart);
 
-    std::pair<bool, uint8_t> AddDataStreamCallback(std::function<void(const std::vector<uint8_t> &data)> cbFn);
-    bool SetDataStreamCallback(uint8_t id, std::function<void(const std::vector<uint8_t> &data)> cbFn);
+    std::pair<bool, uint8_t> AddDataStreamCallback(CbFn cbFn);
+    bool SetDataStreamCallback(uint8_t id, CbFn cbFn);
     bool RemoveDataStreamCallback(uint8_t id);
-    void Distribute(const std::vector<uint8_t> &data);
+    void Distribute(std::span<const uint8_t> data);
     uint8_t GetCallbackCount();
 
 
 private:
 
     UART uart_;
-    IDMaker<32> idMaker_;
-    std::unordered_map<uint8_t, std::function<void(const std::vector<uint8_t> &data)>> id__cbFn_;
+    CallbackSlots<CbFn> cbList_;
 };
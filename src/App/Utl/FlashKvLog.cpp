@@ -0,0 +1,616 @@
+#include "FlashKvLog.h"
+#include "Log.h"
+#include "PAL.h"
+#include "Shell.h"
+#include "Utl.h"
+
+#include <algorithm>
+#include <cstring>
+using namespace std;
+
+#include "StrictMode.h"
+
+
+/////////////////////////////////////////////////////////////////
+// Utility
+/////////////////////////////////////////////////////////////////
+
+// CRC-16/CCITT-FALSE
+static uint16_t Crc16(uint16_t crc, const void *buf, uint32_t len)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        crc ^= (uint16_t)(p[i] << 8);
+
+        for (uint8_t bit = 0; bit < 8; ++bit)
+        {
+            crc = (uint16_t)((crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1));
+        }
+    }
+
+    return crc;
+}
+
+static uint16_t RecordCrc(uint16_t key, uint16_t len, uint16_t type, const void *buf)
+{
+    uint16_t fieldList[3] = { key, len, type };
+
+    uint16_t crc = Crc16(0xFFFF, fieldList, sizeof(fieldList));
+
+    return Crc16(crc, buf, len);
+}
+
+static bool IsErased(const void *buf, uint32_t len)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+
+    return all_of(p, p + len, [](uint8_t b){ return b == 0xFF; });
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Init
+/////////////////////////////////////////////////////////////////
+
+bool FlashKvLog::Init(const FilesystemBlockDevice &blockDevice)
+{
+    dev_   = blockDevice;
+    ready_ = false;
+
+    index_.clear();
+    liveBytes_ = 0;
+
+    bool ok = dev_.blockCount >= 2                                                   &&
+              dev_.readSize == 1                                                     &&
+              dev_.progSize && dev_.blockSize % dev_.progSize == 0                   &&
+              dev_.blockSize >= sizeof(BlockHeader) + GetRecordSize(MAX_VALUE_SIZE)  &&
+              dev_.fnRead && dev_.fnProg && dev_.fnErase;
+
+    if (ok == false)
+    {
+        Log("FlashKvLog ERR: unsupported block device");
+
+        return false;
+    }
+
+    // staging for an append, which can straddle a page boundary
+    uint32_t recordSizeMax = GetRecordSize(MAX_VALUE_SIZE);
+    progBuf_.reserve((recordSizeMax + dev_.progSize - 1) / dev_.progSize * dev_.progSize + dev_.progSize);
+
+    uint32_t generation0 = 0;
+    uint32_t generation1 = 0;
+    bool valid0 = ReadBlockHeader(0, generation0);
+    bool valid1 = ReadBlockHeader(1, generation1);
+
+    if (valid0 && valid1)
+    {
+        // the newer, allowing for the generation wrapping
+        activeBlock_ = (int32_t)(generation1 - generation0) > 0 ? 1 : 0;
+        generation_  = activeBlock_ ? generation1 : generation0;
+    }
+    else if (valid0 || valid1)
+    {
+        activeBlock_ = valid0 ? 0 : 1;
+        generation_  = valid0 ? generation0 : generation1;
+    }
+    else
+    {
+        return Format();
+    }
+
+    ready_ = true;
+
+    Scan();
+
+    return true;
+}
+
+bool FlashKvLog::Format()
+{
+    index_.clear();
+    liveBytes_ = 0;
+
+    // both, so an old log can't come back
+    bool retVal = Erase(0) && Erase(1) && WriteBlockHeader(0, 1);
+
+    activeBlock_ = 0;
+    generation_  = 1;
+    writeOff_    = sizeof(BlockHeader);
+
+    ready_ = retVal;
+
+    return retVal;
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Access
+/////////////////////////////////////////////////////////////////
+
+bool FlashKvLog::Put(uint16_t key, const void *buf, uint16_t len)
+{
+    if (ready_ == false || key == KEY_NONE || len > MAX_VALUE_SIZE)
+    {
+        return false;
+    }
+
+    uint64_t timeStartUs = PAL.Micros();
+
+    ++stats_.puts;
+
+    // skip rewriting what's already there
+    auto it = index_.find(key);
+    if (it != index_.end() && it->second.len == len)
+    {
+        vector<uint8_t> stored(len);
+
+        if (dev_.fnRead(activeBlock_, it->second.off + sizeof(RecordHeader), stored.data(), len) &&
+            memcmp(stored.data(), buf, len) == 0)
+        {
+            ++stats_.putsUnchanged;
+
+            return true;
+        }
+    }
+
+    vector<uint8_t> record = MakeRecord(key, TYPE_VALUE, buf, len);
+
+    bool retVal = Fits(record) ? Append(record) : CompactWith(key, record);
+
+    OpDone(timeStartUs);
+
+    return retVal;
+}
+
+bool FlashKvLog::Get(uint16_t key, void *buf, uint16_t len)
+{
+    bool retVal = false;
+
+    auto it = index_.find(key);
+    if (ready_ && it != index_.end() && it->second.len == len)
+    {
+        retVal = dev_.fnRead(activeBlock_, it->second.off + sizeof(RecordHeader), buf, len);
+    }
+
+    return retVal;
+}
+
+int32_t FlashKvLog::GetSize(uint16_t key) const
+{
+    auto it = index_.find(key);
+
+    return it == index_.end() ? -1 : it->second.len;
+}
+
+bool FlashKvLog::Delete(uint16_t key)
+{
+    if (ready_ == false)
+    {
+        return false;
+    }
+
+    // nothing to do
+    if (index_.contains(key) == false)
+    {
+        return true;
+    }
+
+    uint64_t timeStartUs = PAL.Micros();
+
+    ++stats_.deletes;
+
+    vector<uint8_t> record = MakeRecord(key, TYPE_DELETE, nullptr, 0);
+
+    bool retVal = Fits(record) ? Append(record) : CompactWith(key, record);
+
+    OpDone(timeStartUs);
+
+    return retVal;
+}
+
+bool FlashKvLog::Compact()
+{
+    return ready_ && CompactWith(KEY_NONE, {});
+}
+
+vector<uint16_t> FlashKvLog::GetKeyList() const
+{
+    vector<uint16_t> retVal;
+
+    for (const auto &[key, loc] : index_)
+    {
+        retVal.push_back(key);
+    }
+
+    return retVal;
+}
+
+uint32_t FlashKvLog::GetFreeBytes() const
+{
+    return dev_.blockSize - writeOff_;
+}
+
+uint32_t FlashKvLog::GetLiveBytes() const
+{
+    return liveBytes_;
+}
+
+FlashKvLog &FlashKvLog::Global()
+{
+    static FlashKvLog kv;
+
+    return kv;
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Stats
+/////////////////////////////////////////////////////////////////
+
+const FlashKvLog::Stats &FlashKvLog::GetStats() const
+{
+    return stats_;
+}
+
+void FlashKvLog::ResetStats()
+{
+    stats_ = Stats{};
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Log Format
+/////////////////////////////////////////////////////////////////
+
+uint32_t FlashKvLog::GetRecordSize(uint16_t len)
+{
+    // keep records 4 byte aligned
+    return sizeof(RecordHeader) + ((len + 3u) & ~3u);
+}
+
+vector<uint8_t> FlashKvLog::MakeRecord(uint16_t key, uint16_t type, const void *buf, uint16_t len)
+{
+    vector<uint8_t> retVal(GetRecordSize(len), 0xFF);
+
+    RecordHeader hdr = {
+        .key  = key,
+        .len  = len,
+        .crc  = RecordCrc(key, len, type, buf),
+        .type = type,
+    };
+
+    memcpy(retVal.data(), &hdr, sizeof(hdr));
+    if (len)
+    {
+        memcpy(&retVal[sizeof(hdr)], buf, len);
+    }
+
+    return retVal;
+}
+
+bool FlashKvLog::ReadBlockHeader(uint32_t block, uint32_t &generation)
+{
+    BlockHeader hdr;
+
+    bool retVal = dev_.fnRead(block, 0, &hdr, sizeof(hdr)) &&
+                  hdr.magic == MAGIC                       &&
+                  hdr.generation == ~hdr.generationInv;
+
+    if (retVal)
+    {
+        generation = hdr.generation;
+    }
+
+    return retVal;
+}
+
+bool FlashKvLog::WriteBlockHeader(uint32_t block, uint32_t generation)
+{
+    BlockHeader hdr = {
+        .magic         = MAGIC,
+        .generation    = generation,
+        .generationInv = ~generation,
+        .reserved      = 0xFFFFFFFF,
+    };
+
+    // the rest of the page is left as it is
+    bool retVal = true;
+    for (uint32_t off = 0; retVal && off < sizeof(hdr); off += dev_.progSize)
+    {
+        progBuf_.assign(dev_.progSize, 0xFF);
+        memcpy(progBuf_.data(), (const uint8_t *)&hdr + off, min((uint32_t)sizeof(hdr) - off, dev_.progSize));
+
+        retVal = Prog(block, off, progBuf_.data(), dev_.progSize);
+    }
+
+    return retVal;
+}
+
+// Rebuilds the index from the active block, and finds where the log ends
+void FlashKvLog::Scan()
+{
+    index_.clear();
+    liveBytes_ = 0;
+
+    vector<uint8_t> data(MAX_VALUE_SIZE);
+
+    uint32_t off = sizeof(BlockHeader);
+    bool     end = false;
+    bool     bad = false;
+
+    while (end == false && bad == false && off + sizeof(RecordHeader) <= dev_.blockSize)
+    {
+        RecordHeader hdr;
+        if (dev_.fnRead(activeBlock_, off, &hdr, sizeof(hdr)) == false)
+        {
+            bad = true;
+        }
+        else if (IsErased(&hdr, sizeof(hdr)))
+        {
+            end = true;
+        }
+        else if ((hdr.type != TYPE_VALUE && hdr.type != TYPE_DELETE) ||
+                 hdr.key == KEY_NONE                                  ||
+                 hdr.len > MAX_VALUE_SIZE                             ||
+                 off + GetRecordSize(hdr.len) > dev_.blockSize)
+        {
+            bad = true;
+        }
+        else if (dev_.fnRead(activeBlock_, off + sizeof(hdr), data.data(), hdr.len) == false ||
+                 RecordCrc(hdr.key, hdr.len, hdr.type, data.data()) != hdr.crc)
+        {
+            bad = true;
+        }
+        else
+        {
+            auto it = index_.find(hdr.key);
+            if (it != index_.end())
+            {
+                liveBytes_ -= GetRecordSize(it->second.len);
+                index_.erase(it);
+            }
+
+            if (hdr.type == TYPE_VALUE)
+            {
+                index_[hdr.key] = { off, hdr.len };
+                liveBytes_ += GetRecordSize(hdr.len);
+            }
+
+            off += GetRecordSize(hdr.len);
+        }
+    }
+
+    writeOff_ = off;
+
+    // power lost part way through an append can leave a torn record, or
+    // bits programmed past the end.  either way the rest of the block
+    // can't be trusted to program, so it's treated as full, and the next
+    // write compacts.
+    if (end && off < dev_.blockSize)
+    {
+        vector<uint8_t> rest(dev_.blockSize - off);
+
+        bad = dev_.fnRead(activeBlock_, off, rest.data(), (uint32_t)rest.size()) == false ||
+              IsErased(rest.data(), (uint32_t)rest.size()) == false;
+    }
+
+    if (bad)
+    {
+        ++stats_.corrupt;
+
+        writeOff_ = dev_.blockSize;
+    }
+}
+
+bool FlashKvLog::Fits(const vector<uint8_t> &record) const
+{
+    return writeOff_ + record.size() <= dev_.blockSize;
+}
+
+bool FlashKvLog::Append(const vector<uint8_t> &record)
+{
+    uint32_t size = (uint32_t)record.size();
+
+    // whole pages, with 0xFF around the record, which leaves what's
+    // already programmed in the first page as it is
+    uint32_t pageStart = writeOff_ / dev_.progSize * dev_.progSize;
+    uint32_t pageEnd   = (writeOff_ + size + dev_.progSize - 1) / dev_.progSize * dev_.progSize;
+
+    progBuf_.assign(pageEnd - pageStart, 0xFF);
+    memcpy(&progBuf_[writeOff_ - pageStart], record.data(), size);
+
+    bool retVal = Prog(activeBlock_, pageStart, progBuf_.data(), pageEnd - pageStart);
+
+    if (retVal)
+    {
+        ++stats_.appends;
+
+        RecordHeader hdr;
+        memcpy(&hdr, record.data(), sizeof(hdr));
+
+        auto it = index_.find(hdr.key);
+        if (it != index_.end())
+        {
+            liveBytes_ -= GetRecordSize(it->second.len);
+            index_.erase(it);
+        }
+
+        if (hdr.type == TYPE_VALUE)
+        {
+            index_[hdr.key] = { writeOff_, hdr.len };
+            liveBytes_ += size;
+        }
+    }
+
+    // a failed program leaves the page unknown, so don't append after it
+    writeOff_ = retVal ? writeOff_ + size : dev_.blockSize;
+
+    return retVal;
+}
+
+// Writes the live records, with the given record in place of any for its
+// key, to the other block, which then becomes active.
+bool FlashKvLog::CompactWith(uint16_t key, const vector<uint8_t> &record)
+{
+    ++stats_.compactions;
+
+    uint32_t blockTarget = activeBlock_ ^ 1;
+
+    vector<uint8_t> image(dev_.blockSize, 0xFF);
+    map<uint16_t, Loc> index;
+    uint32_t off = sizeof(BlockHeader);
+
+    bool ok = true;
+
+    for (const auto &[keyLive, loc] : index_)
+    {
+        uint32_t size = GetRecordSize(loc.len);
+
+        if (ok && keyLive != key)
+        {
+            ok = off + size <= dev_.blockSize && dev_.fnRead(activeBlock_, loc.off, &image[off], size);
+
+            index[keyLive] = { off, loc.len };
+            off += size;
+        }
+    }
+
+    if (ok && record.size())
+    {
+        RecordHeader hdr;
+        memcpy(&hdr, record.data(), sizeof(hdr));
+
+        // a delete just leaves the key out
+        if (hdr.type == TYPE_VALUE)
+        {
+            ok = off + record.size() <= dev_.blockSize;
+
+            if (ok)
+            {
+                memcpy(&image[off], record.data(), record.size());
+
+                index[key] = { off, hdr.len };
+                off += (uint32_t)record.size();
+            }
+        }
+    }
+
+    if (ok == false)
+    {
+        Log("FlashKvLog ERR: no room to compact");
+        ++stats_.errors;
+
+        return false;
+    }
+
+    // records first, with the header left erased, then the header, as
+    // that's what makes the block live
+    uint32_t progEnd = (off + dev_.progSize - 1) / dev_.progSize * dev_.progSize;
+
+    ok = Erase(blockTarget);
+    if (ok && off > sizeof(BlockHeader))
+    {
+        ok = Prog(blockTarget, 0, image.data(), progEnd);
+    }
+    ok = ok && WriteBlockHeader(blockTarget, generation_ + 1);
+
+    if (ok)
+    {
+        activeBlock_ = blockTarget;
+        ++generation_;
+        writeOff_    = off;
+
+        index_     = index;
+        liveBytes_ = off - (uint32_t)sizeof(BlockHeader);
+    }
+
+    return ok;
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Block Device
+/////////////////////////////////////////////////////////////////
+
+bool FlashKvLog::Prog(uint32_t block, uint32_t off, const void *buf, uint32_t size)
+{
+    bool retVal = dev_.fnProg(block, off, buf, size) && (dev_.fnSync == nullptr || dev_.fnSync());
+
+    if (retVal)
+    {
+        stats_.progBytes += size;
+    }
+    else
+    {
+        ++stats_.errors;
+    }
+
+    return retVal;
+}
+
+bool FlashKvLog::Erase(uint32_t block)
+{
+    bool retVal = dev_.fnErase(block);
+
+    if (retVal)
+    {
+        ++stats_.erases;
+    }
+    else
+    {
+        ++stats_.errors;
+    }
+
+    return retVal;
+}
+
+void FlashKvLog::OpDone(uint64_t timeStartUs)
+{
+    stats_.opUsMax = max(stats_.opUsMax, (uint32_t)(PAL.Micros() - timeStartUs));
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Shell
+/////////////////////////////////////////////////////////////////
+
+void FlashKvLog::SetupShell()
+{
+    Shell::AddCommand("kv.stats", [](vector<string> argList){
+        FlashKvLog &kv = Global();
+        const Stats &stats = kv.GetStats();
+
+        Log("Block      : ", kv.activeBlock_, " (generation ", kv.generation_, ")");
+        Log("Keys       : ", kv.index_.size());
+        Log("Live bytes : ", Commas(kv.GetLiveBytes()));
+        Log("Free bytes : ", Commas(kv.GetFreeBytes()));
+        Log("Puts       : ", Commas(stats.puts), " (", Commas(stats.putsUnchanged), " unchanged)");
+        Log("Deletes    : ", Commas(stats.deletes));
+        Log("Appends    : ", Commas(stats.appends));
+        Log("Compacts   : ", Commas(stats.compactions));
+        Log("Erases     : ", Commas(stats.erases));
+        Log("Prog bytes : ", Commas(stats.progBytes));
+        Log("Corrupt    : ", Commas(stats.corrupt));
+        Log("Errors     : ", Commas(stats.errors));
+        Log("Op us      : max ", Commas(stats.opUsMax));
+    }, { .argCount = 0, .help = "key/value log stats" });
+
+    Shell::AddCommand("kv.ls", [](vector<string> argList){
+        FlashKvLog &kv = Global();
+
+        for (auto key : kv.GetKeyList())
+        {
+            Log(FormatStr("%5u", key), " : ", kv.GetSize(key), " bytes");
+        }
+    }, { .argCount = 0, .help = "list keys" });
+
+    Shell::AddCommand("kv.compact", [](vector<string> argList){
+        Log(Global().Compact() ? "OK" : "ERR");
+    }, { .argCount = 0, .help = "compact the log into the other block" });
+
+    Shell::AddCommand("kv.format", [](vector<string> argList){
+        Log(Global().Format() ? "OK" : "ERR");
+    }, { .argCount = 0, .help = "erase the key/value log" });
+}
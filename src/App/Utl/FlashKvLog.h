@@ -0,0 +1,145 @@
+#pragma once
+
+#include "FilesystemBlockDevice.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+
+// Key/value store for small objects (eg config), kept as an append-only log
+// on a block device, for when a filesystem is more than is needed.
+//
+// Each Put or Delete appends one record, so flash is only programmed, a
+// page or two at a time, and is only erased when the log's block fills.
+// Then the live records are compacted into the other block, and the log
+// carries on from there.  Rewriting a file in littlefs costs an erase or
+// more every time, here it's an erase per block's worth of updates.
+//
+// Uses the first two blocks of the device, alternately.  A block is only
+// used once its header is written, which compaction does last, so power
+// lost part way leaves the old block in use.  A record only counts if its
+// CRC is good, so a torn append loses that one update.
+//
+// An index of where each key's latest record is is kept in RAM.
+class FlashKvLog
+{
+public:
+
+    static const uint16_t MAX_VALUE_SIZE = 240;
+
+    // Mounts the log on the device, formatting it if there isn't one.
+    // The device must have at least 2 blocks, and a read size of 1.
+    bool Init(const FilesystemBlockDevice &blockDevice);
+
+    // Erases the log, leaving it empty
+    bool Format();
+
+    // Storing a value the same as what's stored is skipped
+    bool Put(uint16_t key, const void *buf, uint16_t len);
+
+    // false if not found, or stored at a different size
+    bool Get(uint16_t key, void *buf, uint16_t len);
+
+    // -1 if not found
+    int32_t GetSize(uint16_t key) const;
+
+    bool Delete(uint16_t key);
+
+    // Makes room by writing just the live records to the other block
+    bool Compact();
+
+    std::vector<uint16_t> GetKeyList() const;
+
+    // room left in the block before a compaction is needed
+    uint32_t GetFreeBytes() const;
+    uint32_t GetLiveBytes() const;
+
+    // the instance on flash, set up by App
+    static FlashKvLog &Global();
+
+    static void SetupShell();
+
+
+public:
+
+    struct Stats
+    {
+        uint32_t puts          = 0;
+        uint32_t putsUnchanged = 0;
+        uint32_t deletes       = 0;
+        uint32_t appends       = 0;
+        uint32_t compactions   = 0;
+        uint32_t erases        = 0;
+        uint64_t progBytes     = 0;
+        uint32_t corrupt       = 0;
+        uint32_t errors        = 0;
+
+        // the longest a Put or Delete took, including any compaction
+        uint32_t opUsMax       = 0;
+    };
+
+    const Stats &GetStats() const;
+    void ResetStats();
+
+
+private:
+
+    struct BlockHeader
+    {
+        uint32_t magic;
+        uint32_t generation;
+        uint32_t generationInv;
+        uint32_t reserved;
+    };
+
+    struct RecordHeader
+    {
+        uint16_t key;
+        uint16_t len;
+        uint16_t crc;
+        uint16_t type;
+    };
+
+    struct Loc
+    {
+        uint32_t off;
+        uint16_t len;
+    };
+
+    static const uint32_t MAGIC       = 0x4B564C31;   // KVL1
+    static const uint16_t TYPE_VALUE  = 0xA55A;
+    static const uint16_t TYPE_DELETE = 0x5AA5;
+    static const uint16_t KEY_NONE    = 0xFFFF;
+
+    static uint32_t GetRecordSize(uint16_t len);
+    static std::vector<uint8_t> MakeRecord(uint16_t key, uint16_t type, const void *buf, uint16_t len);
+
+    bool ReadBlockHeader(uint32_t block, uint32_t &generation);
+    bool WriteBlockHeader(uint32_t block, uint32_t generation);
+    void Scan();
+    bool Fits(const std::vector<uint8_t> &record) const;
+    bool Append(const std::vector<uint8_t> &record);
+    bool CompactWith(uint16_t key, const std::vector<uint8_t> &record);
+
+    bool Prog(uint32_t block, uint32_t off, const void *buf, uint32_t size);
+    bool Erase(uint32_t block);
+    void OpDone(uint64_t timeStartUs);
+
+
+private:
+
+    FilesystemBlockDevice dev_;
+    bool ready_ = false;
+
+    uint32_t activeBlock_ = 0;
+    uint32_t generation_  = 0;
+    uint32_t writeOff_    = 0;
+
+    std::map<uint16_t, Loc> index_;
+    uint32_t liveBytes_ = 0;
+
+    std::vector<uint8_t> progBuf_;
+
+    Stats stats_;
+};
@@ -0,0 +1,219 @@
+#include "FlashWriteBehind.h"
+#include "Log.h"
+#include "PAL.h"
+#include "Shell.h"
+#include "Timer.h"
+#include "Utl.h"
+
+#include <algorithm>
+#include <cstring>
+using namespace std;
+
+#include "StrictMode.h"
+
+
+static Timer timer_("TIMER_FLASH_WRITE_BEHIND");
+static FlashWriteBehind::Stats stats_;
+
+
+/////////////////////////////////////////////////////////////////
+// Queueing
+/////////////////////////////////////////////////////////////////
+
+void FlashWriteBehind::Queue(const string &key, const void *buf, uint32_t len, FnWrite fnWrite)
+{
+    ++stats_.queued;
+
+    const uint8_t *p = (const uint8_t *)buf;
+
+    auto it = find_if(entryList_.begin(), entryList_.end(), [&](const Entry &entry){
+        return entry.key == key;
+    });
+
+    if (it != entryList_.end())
+    {
+        // keep the time first queued, so continuous updates still get written
+        it->data.assign(p, p + len);
+        it->fnWrite = fnWrite;
+
+        ++stats_.coalesced;
+    }
+    else
+    {
+        entryList_.push_back({ key, vector<uint8_t>(p, p + len), fnWrite, PAL.Micros() });
+
+        stats_.pendingMax = max(stats_.pendingMax, (uint32_t)entryList_.size());
+
+        Schedule();
+    }
+}
+
+bool FlashWriteBehind::GetPending(const string &key, void *buf, uint32_t len)
+{
+    bool retVal = false;
+
+    for (const auto &entry : entryList_)
+    {
+        if (entry.key == key)
+        {
+            if (entry.data.size() == len)
+            {
+                memcpy(buf, entry.data.data(), len);
+
+                retVal = true;
+            }
+
+            break;
+        }
+    }
+
+    return retVal;
+}
+
+void FlashWriteBehind::Cancel(const string &key)
+{
+    erase_if(entryList_, [&](const Entry &entry){
+        return entry.key == key;
+    });
+
+    Schedule();
+}
+
+void FlashWriteBehind::Flush()
+{
+    // taken out first, as writing may queue more
+    vector<Entry> entryList;
+    entryList.swap(entryList_);
+
+    for (auto &entry : entryList)
+    {
+        WriteOne(entry);
+    }
+
+    Schedule();
+}
+
+uint32_t FlashWriteBehind::GetPendingCount()
+{
+    return (uint32_t)entryList_.size();
+}
+
+void FlashWriteBehind::SetDelayMs(uint32_t delayMs)
+{
+    delayMs_ = delayMs;
+
+    Schedule();
+}
+
+void FlashWriteBehind::SetGapMs(uint32_t gapMs)
+{
+    gapMs_ = gapMs;
+
+    Schedule();
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Stats
+/////////////////////////////////////////////////////////////////
+
+const FlashWriteBehind::Stats &FlashWriteBehind::GetStats()
+{
+    return stats_;
+}
+
+void FlashWriteBehind::ResetStats()
+{
+    stats_ = Stats{};
+    stats_.pendingMax = (uint32_t)entryList_.size();
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Background Writing
+/////////////////////////////////////////////////////////////////
+
+void FlashWriteBehind::Schedule()
+{
+    if (entryList_.empty())
+    {
+        timer_.Cancel();
+    }
+    else
+    {
+        uint64_t timeDueUs = entryList_.front().timeQueuedUs + (uint64_t)delayMs_ * 1'000;
+        uint64_t timeGapUs = timeLastWriteUs_ + (uint64_t)gapMs_ * 1'000;
+
+        timer_.SetCallback([]{ OnTimeout(); });
+        timer_.TimeoutAtUs(max(timeDueUs, timeGapUs));
+    }
+}
+
+void FlashWriteBehind::WriteOne(Entry &entry)
+{
+    uint64_t timeStartUs = PAL.Micros();
+
+    bool ok = entry.fnWrite(entry.data);
+
+    timeLastWriteUs_ = PAL.Micros();
+    stats_.writeUsMax = max(stats_.writeUsMax, (uint32_t)(timeLastWriteUs_ - timeStartUs));
+
+    if (ok)
+    {
+        ++stats_.written;
+    }
+    else
+    {
+        ++stats_.failed;
+
+        Log("ERR: FlashWriteBehind write of ", entry.key, " failed");
+    }
+}
+
+void FlashWriteBehind::OnTimeout()
+{
+    if (entryList_.size())
+    {
+        Entry entry = move(entryList_.front());
+        entryList_.erase(entryList_.begin());
+
+        WriteOne(entry);
+    }
+
+    Schedule();
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Shell
+/////////////////////////////////////////////////////////////////
+
+void FlashWriteBehind::SetupShell()
+{
+    Shell::AddCommand("flash.wb.stats", [](vector<string> argList){
+        Log("Pending    : ", entryList_.size(), " (max ", stats_.pendingMax, ")");
+        Log("Queued     : ", Commas(stats_.queued));
+        Log("Coalesced  : ", Commas(stats_.coalesced));
+        Log("Written    : ", Commas(stats_.written));
+        Log("Failed     : ", Commas(stats_.failed));
+        Log("Write us   : max ", Commas(stats_.writeUsMax));
+        Log("Delay ms   : ", delayMs_, ", gap ms: ", gapMs_);
+
+        for (const auto &entry : entryList_)
+        {
+            Log("  ", entry.key, " (", entry.data.size(), " bytes)");
+        }
+    }, { .argCount = 0, .help = "write-behind queue stats" });
+
+    Shell::AddCommand("flash.wb.stats.reset", [](vector<string> argList){
+        ResetStats();
+    }, { .argCount = 0, .help = "reset write-behind queue stats" });
+
+    Shell::AddCommand("flash.wb.flush", [](vector<string> argList){
+        Flush();
+    }, { .argCount = 0, .help = "write everything pending now" });
+
+    Shell::AddCommand("flash.wb.delay", [](vector<string> argList){
+        SetDelayMs((uint32_t)atoi(argList[0].c_str()));
+    }, { .argCount = 1, .help = "set the ms a write waits to be coalesced" });
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+// Queue of writes to flash, held in RAM and carried out later from the Evm.
+//
+// Flash programs and erases run with interrupts off, so a burst of writes
+// (eg a setting changed over and over from a UI) stalls UART receive and
+// timers for as long as they all take.  Here, each write is queued under a
+// key, and a write queued for a key already waiting replaces it, so only
+// the latest data gets written.
+//
+// A queued write is carried out once it has waited the delay, measured
+// from when the key was first queued, so a key updated continuously is
+// still written at least that often.  One write is done per Evm timer
+// callback, with at least the gap between, so other work gets to run in
+// between.
+//
+// Anything pending is lost on reset, Flush() first if that matters.
+class FlashWriteBehind
+{
+public:
+
+    using FnWrite = std::function<bool(const std::vector<uint8_t> &data)>;
+
+    static const uint32_t DEFAULT_DELAY_MS = 2'000;
+    static const uint32_t DEFAULT_GAP_MS   =    20;
+
+    // Copies the data.  Replaces whatever is pending for the key.
+    static void Queue(const std::string &key, const void *buf, uint32_t len, FnWrite fnWrite);
+
+    // true if data of exactly len is pending for the key, copied into buf
+    static bool GetPending(const std::string &key, void *buf, uint32_t len);
+
+    // Drops the pending write for the key, if any
+    static void Cancel(const std::string &key);
+
+    // Carries out every pending write now
+    static void Flush();
+
+    static uint32_t GetPendingCount();
+
+    static void SetDelayMs(uint32_t delayMs);
+    static void SetGapMs(uint32_t gapMs);
+
+    static void SetupShell();
+
+
+public:
+
+    struct Stats
+    {
+        uint32_t queued     = 0;
+        uint32_t coalesced  = 0;
+        uint32_t written    = 0;
+        uint32_t failed     = 0;
+        uint32_t pendingMax = 0;
+
+        uint32_t writeUsMax = 0;
+    };
+
+    static const Stats &GetStats();
+    static void ResetStats();
+
+
+private:
+
+    struct Entry
+    {
+        std::string          key;
+        std::vector<uint8_t> data;
+        FnWrite              fnWrite;
+        uint64_t             timeQueuedUs = 0;
+    };
+
+    static void Schedule();
+    static void WriteOne(Entry &entry);
+    static void OnTimeout();
+
+
+private:
+
+    // in the order first queued, so the front is due soonest
+    inline static std::vector<Entry> entryList_;
+
+    inline static uint32_t delayMs_ = DEFAULT_DELAY_MS;
+    inline static uint32_t gapMs_   = DEFAULT_GAP_MS;
+
+    inline static uint64_t timeLastWriteUs_ = 0;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "FilesystemLittleFS.h"
+#include "FlashWriteBehind.h"
 #include "Log.h"
 
 #include <string>
@@ -48,7 +49,17 @@ public:
         bool retVal = false;
 
         DirEnt dirEnt;
-        if (FilesystemLittleFS::Stat(id_, dirEnt))
+        T tmp;
+        if (FlashWriteBehind::GetPending(GetWriteBehindKey(), (uint8_t *)&tmp, sizeof(T)))
+        {
+            // a write not made yet is newer than what's in storage
+            T &ref = *(T *)this;
+
+            ref = tmp;
+
+            retVal = true;
+        }
+        else if (FilesystemLittleFS::Stat(id_, dirEnt))
         {
             if (dirEnt.type != DirEnt::Type::FILE)
             {
@@ -64,8 +75,6 @@ public:
 
                 if (f.Open())
                 {
-                    T tmp;
-
                     retVal = f.Read((uint8_t *)&tmp, sizeof(T));
 
                     // only modify the wrapped type if the lookup worked
@@ -97,37 +106,71 @@ public:
     }
 
     bool Put()
+    {
+        // supersedes anything waiting to be written
+        FlashWriteBehind::Cancel(GetWriteBehindKey());
+
+        // get reference to the wrapped type
+        T &ref = *(T *)this;
+
+        return Write(id_, (uint8_t *)&ref);
+    }
+
+    // Queued to be written in the background, see FlashWriteBehind.
+    // Get() sees it straight away.
+    void PutAsync()
+    {
+        // get reference to the wrapped type
+        T &ref = *(T *)this;
+
+        FlashWriteBehind::Queue(GetWriteBehindKey(), (uint8_t *)&ref, sizeof(T), [id = id_](const std::vector<uint8_t> &data){
+            return Write(id, data.data());
+        });
+    }
+
+    bool Delete()
+    {
+        FlashWriteBehind::Cancel(GetWriteBehindKey());
+
+        return FilesystemLittleFS::Remove(id_);
+    }
+
+private:
+
+    std::string GetWriteBehindKey() const
+    {
+        return "lfs/" + id_;
+    }
+
+    static bool Write(const std::string &id, const uint8_t *buf)
     {
         bool retVal = false;
 
         bool okToTry = true;
 
         DirEnt dirEnt;
-        if (FilesystemLittleFS::Stat(id_, dirEnt))
+        if (FilesystemLittleFS::Stat(id, dirEnt))
         {
             if (dirEnt.type != DirEnt::Type::FILE)
             {
                 okToTry = false;
 
-                Log("Put ERR: Flashable object ", id_, " not a file in storage");
+                Log("Put ERR: Flashable object ", id, " not a file in storage");
             }
             else if (dirEnt.size != sizeof(T))
             {
                 okToTry = false;
 
-                Log("Put ERR: Flashable object ", id_, " is the wrong size in storage, should be ", sizeof(T), ", but is ", dirEnt.size);
+                Log("Put ERR: Flashable object ", id, " is the wrong size in storage, should be ", sizeof(T), ", but is ", dirEnt.size);
             }
         }
 
         if (okToTry)
         {
-            auto f = FilesystemLittleFS::GetFile(id_);
+            auto f = FilesystemLittleFS::GetFile(id);
             if (f.Open())
             {
-                // get reference to the wrapped type
-                T &ref = *(T *)this;
-
-                retVal = f.Write((uint8_t *)&ref, sizeof(T));
+                retVal = f.Write((uint8_t *)buf, sizeof(T));
 
                 f.Close();
             }
@@ -136,11 +179,6 @@ public:
         return retVal;
     }
 
-    bool Delete()
-    {
-        return FilesystemLittleFS::Remove(id_);
-    }
-
 private:
 
     std::string id_;
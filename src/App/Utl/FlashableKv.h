@@ -0,0 +1,117 @@
+#pragma once
+
+#include "FlashKvLog.h"
+#include "FlashWriteBehind.h"
+#include "Log.h"
+
+#include <string>
+
+
+// As Flashable, but kept in the FlashKvLog store rather than a file, for
+// small objects (up to FlashKvLog::MAX_VALUE_SIZE) updated often.
+//
+// Ids are a separate space from Flashable's.
+//
+// The store is only set up when built with PICO_INF_ENABLE_KV=1.
+template <typename T>
+class FlashableKv
+: public T
+{
+    static_assert(sizeof(T) <= FlashKvLog::MAX_VALUE_SIZE, "FlashableKv type too large for FlashKvLog");
+
+public:
+    FlashableKv(uint16_t id)
+    : id_(id)
+    {
+        // Nothing to do
+    }
+
+    bool Get(bool hideWarningIfNotFound = false)
+    {
+        bool retVal = false;
+
+        T tmp;
+        if (FlashWriteBehind::GetPending(GetWriteBehindKey(), (uint8_t *)&tmp, sizeof(T)))
+        {
+            // a write not made yet is newer than what's in storage
+            retVal = true;
+        }
+        else
+        {
+            int32_t size = FlashKvLog::Global().GetSize(id_);
+
+            if (size == -1)
+            {
+                if (hideWarningIfNotFound == false)
+                {
+                    Log("ERR: FlashableKv object ", id_, " does not exist");
+                }
+            }
+            else if (size != sizeof(T))
+            {
+                Log("Get ERR: FlashableKv object ", id_, " is the wrong size in storage, should be ", sizeof(T), ", but is ", size);
+            }
+            else
+            {
+                retVal = FlashKvLog::Global().Get(id_, (uint8_t *)&tmp, sizeof(T));
+
+                if (retVal == false)
+                {
+                    Log("Get ERR: FlashableKv object ", id_, " could not be read");
+                }
+            }
+        }
+
+        // only modify the wrapped type if the lookup worked
+        if (retVal)
+        {
+            // get reference to the wrapped type
+            T &ref = *(T *)this;
+
+            ref = tmp;
+        }
+
+        return retVal;
+    }
+
+    bool Put()
+    {
+        // supersedes anything waiting to be written
+        FlashWriteBehind::Cancel(GetWriteBehindKey());
+
+        // get reference to the wrapped type
+        T &ref = *(T *)this;
+
+        return FlashKvLog::Global().Put(id_, (uint8_t *)&ref, sizeof(T));
+    }
+
+    // Queued to be written in the background, see FlashWriteBehind.
+    // Get() sees it straight away.
+    void PutAsync()
+    {
+        // get reference to the wrapped type
+        T &ref = *(T *)this;
+
+        FlashWriteBehind::Queue(GetWriteBehindKey(), (uint8_t *)&ref, sizeof(T), [id = id_](const std::vector<uint8_t> &data){
+            return FlashKvLog::Global().Put(id, data.data(), (uint16_t)data.size());
+        });
+    }
+
+    bool Delete()
+    {
+        FlashWriteBehind::Cancel(GetWriteBehindKey());
+
+        return FlashKvLog::Global().Delete(id_);
+    }
+
+private:
+
+    std::string GetWriteBehindKey() const
+    {
+        return "kv/" + std::to_string(id_);
+    }
+
+private:
+
+    uint16_t id_;
+};
@@ -39,6 +39,11 @@ public:
         }
     }
 
+    bool IsUsed(uint8_t id)
+    {
+        return id < CAPACITY && bits_[id];
+    }
+
     uint8_t GetSize()
     {
         uint8_t size = 0;
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+// A std::function-like callable wrapper which stores the callable inline,
+// in a fixed-size buffer, and never allocates.
+//
+// Callables (lambda captures) larger than CAPACITY are rejected at compile
+// time rather than spilling to the heap.
+//
+// Move-only.  Moving transfers the callable with its own move constructor
+// (so it is safe to capture types which own memory, eg std::vector or
+// std::function), and the callable is destroyed properly when replaced or
+// when the wrapper goes out of scope.
+//
+// Calling an empty InplaceFunction does nothing and returns R{}.
+
+template <typename Sig, size_t CAPACITY>
+class InplaceFunction;
+
+template <typename R, typename ...Args, size_t CAPACITY>
+class InplaceFunction<R(Args...), CAPACITY>
+{
+    static const size_t ALIGNMENT = alignof(std::max_align_t);
+
+public:
+
+    InplaceFunction() = default;
+
+    template <typename F,
+              typename T = std::decay_t<F>,
+              typename   = std::enable_if_t<!std::is_same_v<T, InplaceFunction>>,
+              typename   = std::enable_if_t<std::is_invocable_r_v<R, T &, Args...>>>
+    InplaceFunction(F &&fn)
+    {
+        static_assert(sizeof(T) <= CAPACITY,
+                      "InplaceFunction: callable too large for inline storage, capture less (or by reference)");
+        static_assert(alignof(T) <= ALIGNMENT,
+                      "InplaceFunction: callable alignment not supported");
+        static_assert(std::is_nothrow_move_constructible_v<T>,
+                      "InplaceFunction: callable must be nothrow move constructible");
+
+        new (buf_) T(std::forward<F>(fn));
+        ops_ = &OPS<T>;
+    }
+
+    InplaceFunction(InplaceFunction &&other) noexcept
+    {
+        MoveFrom(other);
+    }
+
+    InplaceFunction &operator=(InplaceFunction &&other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            MoveFrom(other);
+        }
+
+        return *this;
+    }
+
+    InplaceFunction(const InplaceFunction &)            = delete;
+    InplaceFunction &operator=(const InplaceFunction &) = delete;
+
+    ~InplaceFunction()
+    {
+        Reset();
+    }
+
+    void Reset()
+    {
+        if (ops_)
+        {
+            ops_->destroy(buf_);
+            ops_ = nullptr;
+        }
+    }
+
+    explicit operator bool() const
+    {
+        return ops_ != nullptr;
+    }
+
+    R operator()(Args ...args)
+    {
+        if (ops_)
+        {
+            return ops_->invoke(buf_, std::forward<Args>(args)...);
+        }
+        else
+        {
+            return R();
+        }
+    }
+
+
+private:
+
+    struct Ops
+    {
+        R    (*invoke)(void *buf, Args &&...args);
+        void (*move)(void *bufDst, void *bufSrc);
+        void (*destroy)(void *buf);
+    };
+
+    template <typename T>
+    static constexpr Ops OPS = {
+        .invoke = [](void *buf, Args &&...args) -> R {
+            return (*(T *)buf)(std::forward<Args>(args)...);
+        },
+        .move = [](void *bufDst, void *bufSrc) {
+            new (bufDst) T(std::move(*(T *)bufSrc));
+            ((T *)bufSrc)->~T();
+        },
+        .destroy = [](void *buf) {
+            ((T *)buf)->~T();
+        },
+    };
+
+    void MoveFrom(InplaceFunction &other)
+    {
+        if (other.ops_)
+        {
+            other.ops_->move(buf_, other.buf_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+
+private:
+
+    alignas(ALIGNMENT) uint8_t buf_[CAPACITY];
+    const Ops *ops_ = nullptr;
+};
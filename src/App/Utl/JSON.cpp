@@ -1,5 +1,6 @@
 #include "JSON.h"
 #include "Log.h"
+#include "PAL.h"
 #include "UART.h"
 
 using namespace std;
@@ -28,6 +29,25 @@ pair<bool, JSON::JSONObj> JSON::DeSerialize(const string &jsonStr)
     return { ok, docParse };
 }
 
+bool JSON::DeSerialize(string_view jsonStr, JsonDocument &doc)
+{
+    bool ok = false;
+
+    DeserializationError ret = deserializeJson(doc, jsonStr.data(), jsonStr.size());
+
+    if (ret == DeserializationError::Ok)
+    {
+        ok = true;
+    }
+    else
+    {
+        UartTarget target(UART::UART_0);
+        Log("ERR: JSON DeSerialize: \"", jsonStr, "\": ", ret.c_str());
+    }
+
+    return ok;
+}
+
 void JSON::UseJSON(const string &jsonStr, function<void(JsonObject &json)> fn)
 {
     auto [ok, jsonDoc] = DeSerialize(jsonStr);
@@ -44,7 +64,7 @@ JSON::JSONObj JSON::GetObj()
     return DynamicJsonDocument{ JSON_DOC_BYTE_ALLOC };
 }
 
-string JSON::Serialize(JSONObj &json)
+string JSON::Serialize(const JsonDocument &json)
 {
     class WriterToString
     {
@@ -81,3 +101,71 @@ string JSON::Serialize(JSONObj &json)
     return writer.GetString();
 }
 
+
+////////////////////////////////////////////////////////////////////////////////
+// Document Pool
+////////////////////////////////////////////////////////////////////////////////
+
+// allocated on first use, then kept
+static JSON::JSONObj *docPool_[JSON::JSON_DOC_POOL_COUNT] = {};
+static bool docPoolInUse_[JSON::JSON_DOC_POOL_COUNT] = {};
+static uint32_t docPoolHeapFallbackCount_ = 0;
+
+JSON::PooledDoc::PooledDoc()
+{
+    {
+        IrqLock lock;
+
+        for (uint8_t i = 0; i < JSON_DOC_POOL_COUNT; ++i)
+        {
+            if (docPoolInUse_[i] == false)
+            {
+                docPoolInUse_[i] = true;
+                idx_ = (int8_t)i;
+
+                break;
+            }
+        }
+
+        if (idx_ == -1)
+        {
+            ++docPoolHeapFallbackCount_;
+        }
+    }
+
+    if (idx_ != -1)
+    {
+        // the slot is this one's while in use, so no lock needed
+        if (docPool_[idx_] == nullptr)
+        {
+            docPool_[idx_] = new JSONObj(JSON_DOC_BYTE_ALLOC);
+        }
+
+        doc_ = docPool_[idx_];
+        doc_->clear();
+    }
+    else
+    {
+        heapDoc_ = new JSONObj(JSON_DOC_BYTE_ALLOC);
+        doc_ = heapDoc_;
+    }
+}
+
+JSON::PooledDoc::~PooledDoc()
+{
+    if (idx_ != -1)
+    {
+        IrqLock lock;
+
+        docPoolInUse_[idx_] = false;
+    }
+    else
+    {
+        delete heapDoc_;
+    }
+}
+
+uint32_t JSON::GetPoolHeapFallbackCount()
+{
+    return docPoolHeapFallbackCount_;
+}
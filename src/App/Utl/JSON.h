@@ -5,19 +5,48 @@
 #include <cstdint>
 #include <functional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 
 class JSON
 {
+public:
     static const uint32_t JSON_DOC_BYTE_ALLOC = 5000;
+    static const uint8_t  JSON_DOC_POOL_COUNT = 2;  // an inbound message and its reply
 
 public:
     using JSONObj = DynamicJsonDocument;
 
+    // A document taken from a small pool for as long as this is in scope,
+    // so frequent users (eg message routing) don't allocate each time.
+    // Pool documents are allocated the first time each is needed and kept,
+    // so nothing is taken by an app which doesn't use JSON.
+    // When the pool is all in use (eg nested use) it comes from the heap.
+    class PooledDoc
+    {
+    public:
+        PooledDoc();
+        ~PooledDoc();
+
+        PooledDoc(const PooledDoc &) = delete;
+        PooledDoc &operator=(const PooledDoc &) = delete;
+
+        JsonDocument &Get()
+        {
+            return *doc_;
+        }
+
+    private:
+        JsonDocument *doc_ = nullptr;
+        JSONObj *heapDoc_ = nullptr;
+        int8_t idx_ = -1;
+    };
+
 public:
     static std::pair<bool, JSONObj> DeSerialize(const std::string &jsonStr);
+    static bool DeSerialize(std::string_view jsonStr, JsonDocument &doc);
     static void UseJSON(const std::string &jsonStr, std::function<void(JsonObject &json)> fn);
 
     template <typename T>
@@ -40,6 +69,7 @@ public:
     }
 
     static JSONObj GetObj();
-    static std::string Serialize(JSONObj &json);
+    static std::string Serialize(const JsonDocument &json);
+    static uint32_t GetPoolHeapFallbackCount();
 };
 
@@ -3,19 +3,112 @@
 #include "Shell.h"
 #include "Timeline.h"
 #include "UART.h"
+#include "Utl.h"
 
+#include <algorithm>
 using namespace std;
 
 #include "StrictMode.h"
 
 
-void JSONMsgRouter::OnLine(const Iface &iface, const string &jsonStr)
+////////////////////////////////////////////////////////////////////////////////
+// Dispatch Table
+////////////////////////////////////////////////////////////////////////////////
+
+// FNV-1a
+uint32_t JSONMsgRouter::Hash(string_view type)
+{
+    uint32_t hash = 2166136261u;
+
+    for (char c : type)
+    {
+        hash ^= (uint8_t)c;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+void JSONMsgRouter::RegisterHandler(string type, Handler cbHandle)
+{
+    // only one handler per message type, the first registered
+    if (FindHandler(type) == nullptr)
+    {
+        uint32_t hash = Hash(type);
+        handlerDataList_.push_back({type, hash, cbHandle});
+
+        // grow to keep the table no more than half full, re-inserting all
+        if (slotList_.size() < handlerDataList_.size() * 2)
+        {
+            size_t size = slotList_.size() ? slotList_.size() : 16;
+            while (size < handlerDataList_.size() * 2)
+            {
+                size *= 2;
+            }
+            slotList_.assign(size, 0);
+
+            for (size_t idx = 0; idx + 1 < handlerDataList_.size(); ++idx)
+            {
+                size_t slot = handlerDataList_[idx].hash & (slotList_.size() - 1);
+                while (slotList_[slot])
+                {
+                    slot = (slot + 1) & (slotList_.size() - 1);
+                }
+                slotList_[slot] = (uint16_t)(idx + 1);
+            }
+        }
+
+        size_t slot = hash & (slotList_.size() - 1);
+        while (slotList_[slot])
+        {
+            slot = (slot + 1) & (slotList_.size() - 1);
+        }
+        slotList_[slot] = (uint16_t)handlerDataList_.size();
+    }
+}
+
+JSONMsgRouter::HandlerData *JSONMsgRouter::FindHandler(string_view type)
+{
+    HandlerData *retVal = nullptr;
+
+    if (slotList_.size())
+    {
+        uint32_t hash = Hash(type);
+
+        size_t slot = hash & (slotList_.size() - 1);
+        while (slotList_[slot])
+        {
+            HandlerData &hd = handlerDataList_[slotList_[slot] - 1];
+
+            if (hd.hash == hash && hd.type == type)
+            {
+                retVal = &hd;
+
+                break;
+            }
+
+            slot = (slot + 1) & (slotList_.size() - 1);
+        }
+    }
+
+    return retVal;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Routing
+////////////////////////////////////////////////////////////////////////////////
+
+void JSONMsgRouter::OnLine(const Iface &iface, string_view jsonStr)
 {
     // default to outputting to regular serial so
     // all code following this can log normally
     UartTarget target(UART::UART_0);
 
-    auto [ok, inJsonDoc] = JSON::DeSerialize(jsonStr);
+    JSON::PooledDoc inDoc;
+    JsonDocument &inJsonDoc = inDoc.Get();
+
+    bool ok = JSON::DeSerialize(jsonStr, inJsonDoc);
 
     // 'as' the document to a json object ('to' would reset it before doing so)
     auto inJson = inJsonDoc.as<JsonObject>();
@@ -24,55 +117,37 @@ void JSONMsgRouter::OnLine(const Iface &iface, const string &jsonStr)
     {
         if (inJson.containsKey("type"))
         {
-            bool handled = false;
-
             const char *typeStr = inJson["type"];
 
-            // get root document.
-            // convert to an object.
-            // can't 'as' to an object, it's null at the moment
-            auto outJsonDoc = JSON::GetObj();
-            auto outJson = outJsonDoc.to<JsonObject>();
-
-            // keep track of whether a reply is sent
-            bool replySent = false;
-
             // find handler
-            for (auto &[type, cbHandle] : handlerDataList_)
+            HandlerData *hd = FindHandler(typeStr ? typeStr : "");
+
+            if (hd)
             {
-                if (type == typeStr)
+                // get root document.
+                // convert to an object.
+                // can't 'as' to an object, it's null at the moment
+                JSON::PooledDoc outDoc;
+                JsonDocument &outJsonDoc = outDoc.Get();
+                auto outJson = outJsonDoc.to<JsonObject>();
+
+                // actually call handler
+                hd->cbHandle(inJson, outJson);
+
+                // ensure every received message is replied to, either by the
+                // handling code, or automatically
+                if (outJson.size() == 0)
                 {
-                    // actually call handler
-                    cbHandle(inJson, outJson);
-
-                    // look at return size to decide if a reply is to be sent
-                    size_t size = measureJson(outJsonDoc);
-                    if (size > OBSERVED_EMPTY_MESSAGE_SIZE)
-                    {
-                        iface.OnReceive(JSON::Serialize(outJsonDoc));
-
-                        replySent = true;
-                    }
-
-                    // only one handler per message type
-                    handled = true;
-                    break;
+                    // auto ack
+                    outJson["type"] = "ACK";
+                    outJson["inType"] = inJson["type"];
                 }
-            }
 
-            if (handled == false)
-            {
-                Log("ERR: message was not handled: \"", JSON::Serialize(inJsonDoc), "\"");
+                Reply(iface, outJsonDoc);
             }
-
-            // ensure every received message is replied to, either by the
-            // handling code, or automatically
-            if (handled && replySent == false)
+            else
             {
-                // auto ack
-                outJson["type"] = "ACK";
-                outJson["inType"] = inJson["type"];
-                iface.OnReceive(JSON::Serialize(outJsonDoc));
+                Log("ERR: message was not handled: \"", JSON::Serialize(inJsonDoc), "\"");
             }
         }
         else
@@ -85,18 +160,17 @@ void JSONMsgRouter::OnLine(const Iface &iface, const string &jsonStr)
 void JSONMsgRouter::Send(const Iface &iface, function<void(JsonObject &out)> handler)
 {
     // create json object to send
-    auto jsonDoc = JSON::GetObj();
-    auto out     = jsonDoc.to<JsonObject>();
+    JSON::PooledDoc doc;
+    JsonDocument &jsonDoc = doc.Get();
+    auto out = jsonDoc.to<JsonObject>();
 
     // let the handler fill out the outbound message
     handler(out);
 
-    // look at return size to decide if it should be sent
-    size_t size = measureJson(jsonDoc);
-
-    if (size > OBSERVED_EMPTY_MESSAGE_SIZE)
+    // look at the content to decide if it should be sent
+    if (out.size())
     {
-        iface.OnReceive(JSON::Serialize(jsonDoc));
+        Reply(iface, jsonDoc);
     }
     else
     {
@@ -104,22 +178,55 @@ void JSONMsgRouter::Send(const Iface &iface, function<void(JsonObject &out)> han
     }
 }
 
+// Serialize straight into a fixed buffer and hand the iface a view of it.
+// The buffer is not reentrant (a receiver may itself send), and a message
+// may not fit, in which case a string is built instead.
+void JSONMsgRouter::Reply(const Iface &iface, const JsonDocument &jsonDoc)
+{
+    static char buf[SERIALIZE_BUF_SIZE];
+    static bool bufInUse = false;
 
+    bool sent = false;
 
+    if (bufInUse == false)
+    {
+        // anything short of the full buffer is complete
+        size_t len = serializeJson(jsonDoc, buf, SERIALIZE_BUF_SIZE);
 
+        if (len < SERIALIZE_BUF_SIZE)
+        {
+            bufInUse = true;
+            iface.OnReceive(string_view{buf, len});
+            bufInUse = false;
 
+            sent = true;
+        }
+    }
 
+    if (sent == false)
+    {
+        iface.OnReceive(JSON::Serialize(jsonDoc));
+    }
+}
 
+void JSONMsgRouter::Bench(const Iface &iface, uint32_t count)
+{
+    static const char MSG[] = "{\"type\":\"REQ_PING\"}";
 
+    uint32_t heapFallbackBefore = JSON::GetPoolHeapFallbackCount();
 
+    uint64_t timeStart = PAL.Micros();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        iface.Route(string_view{MSG, sizeof(MSG) - 1});
+    }
+    uint64_t timeDiff = PAL.Micros() - timeStart;
 
-
-
-
-
-
-
-
+    Log("Routed ", Commas(count), " messages in ", Commas(timeDiff), " us");
+    Log("- us / msg  : ", count ? (double)timeDiff / count : 0.0);
+    Log("- msgs / sec: ", Commas(timeDiff ? (uint64_t)count * 1'000'000 / timeDiff : 0));
+    Log("- heap docs : ", Commas(JSON::GetPoolHeapFallbackCount() - heapFallbackBefore));
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 // Initilization
@@ -135,7 +242,7 @@ void JSONMsgRouter::SetupShell()
     Timeline::Global().Event("JSONRouter::SetupShell");
 
     static JSONMsgRouter::Iface router_;
-    router_.SetOnReceiveCallback([](const string &jsonStr){
+    router_.SetOnReceiveViewCallback([](string_view jsonStr){
         Log(jsonStr);
     });
 
@@ -153,6 +260,23 @@ void JSONMsgRouter::SetupShell()
         }
     }, { .argCount = -1, .help = "send <type> [<tag> <value> ...]"});
 
+    Shell::AddCommand("json.route", [](vector<string> argList){
+        router_.Route(argList[0]);
+    }, { .argCount = 1, .help = "route <json> as if received"});
+
+    Shell::AddCommand("json.bench", [](vector<string> argList){
+        static JSONMsgRouter::Iface iface;
+
+        static uint32_t bytes;
+        bytes = 0;
+        iface.SetOnReceiveViewCallback([](string_view jsonStr){
+            bytes += (uint32_t)jsonStr.size();
+        });
+
+        JSONMsgRouter::Bench(iface, argList.size() ? (uint32_t)atoi(argList[0].c_str()) : 1'000);
+        Log("- reply bytes: ", Commas(bytes));
+    }, { .argCount = -1, .help = "route <count=1000> REQ_PING messages, replies discarded"});
+
     Shell::AddCommand("json.list", [](vector<string> argList){
         vector<string> typeList;
         for (auto &hd : JSONMsgRouter::handlerDataList_)
@@ -4,11 +4,22 @@
 
 #include <functional>
 #include <string>
-
-
+#include <string_view>
+#include <vector>
+
+
+// Routes inbound JSON messages to the handler registered for their "type".
+//
+// Handlers are found through a hash table over the registered types, built
+// as they are registered, rather than by comparing against each in turn.
+//
+// Inbound and outbound documents come from the JSON document pool, and
+// replies are serialized straight into a fixed buffer which is handed to
+// the Iface as a view.  Only an Iface with the older std::string callback
+// (or a reply too large for the buffer) costs an allocation.
 class JSONMsgRouter
 {
-    static const uint8_t OBSERVED_EMPTY_MESSAGE_SIZE = 4;
+    static const uint16_t SERIALIZE_BUF_SIZE = 1024;
 
     // handlers receive the inbound object, which has at least the type they want
     // handlers recieve a json object they can fill out to reply
@@ -18,6 +29,7 @@ class JSONMsgRouter
     struct HandlerData
     {
         std::string type;
+        uint32_t    hash;
         Handler     cbHandle;
     };
 
@@ -29,7 +41,7 @@ public:
     {
     public:
 
-        void Route(const std::string &jsonStr) const
+        void Route(std::string_view jsonStr) const
         {
             JSONMsgRouter::OnLine(*this, jsonStr);
         }
@@ -39,32 +51,52 @@ public:
             JSONMsgRouter::Send(*this, handler);
         }
 
-        void OnReceive(const std::string &jsonStr) const
+        void OnReceive(std::string_view jsonStr) const
         {
-            cbFnOnReceive_(jsonStr);
+            if (cbFnOnReceiveView_)
+            {
+                cbFnOnReceiveView_(jsonStr);
+            }
+            else
+            {
+                cbFnOnReceive_(std::string{jsonStr});
+            }
         }
 
         void SetOnReceiveCallback(std::function<void(const std::string &jsonStr)> cbFn)
         {
             cbFnOnReceive_ = cbFn;
+            cbFnOnReceiveView_ = nullptr;
+        }
+
+        // the view is only valid for the duration of the call, it is
+        // typically written straight out (eg UART, USB CDC)
+        void SetOnReceiveViewCallback(std::function<void(std::string_view jsonStr)> cbFn)
+        {
+            cbFnOnReceiveView_ = cbFn;
         }
 
     private:
         std::function<void(const std::string &jsonStr)> cbFnOnReceive_ = [](const std::string &jsonStr){};
+        std::function<void(std::string_view jsonStr)>   cbFnOnReceiveView_;
     };
 
 public:
 
-    static void RegisterHandler(std::string type, Handler cbHandle)
-    {
-        handlerDataList_.push_back({type, cbHandle});
-    }
+    static void RegisterHandler(std::string type, Handler cbHandle);
+
+    // route count REQ_PING messages through the iface, and report the rate
+    static void Bench(const Iface &iface, uint32_t count);
 
 
 private:
 
-    static void OnLine(const Iface &iface, const std::string &jsonStr);
+    static void OnLine(const Iface &iface, std::string_view jsonStr);
     static void Send(const Iface &iface, std::function<void(JsonObject &out)> handler);
+    static void Reply(const Iface &iface, const JsonDocument &jsonDoc);
+
+    static uint32_t Hash(std::string_view type);
+    static HandlerData *FindHandler(std::string_view type);
 
 public:
 
@@ -76,4 +108,8 @@ public:
 private:
 
     inline static std::vector<HandlerData> handlerDataList_;
+
+    // open addressed, power of 2 sized, at most half full.
+    // each slot is 1 + an index into handlerDataList_, 0 when empty.
+    inline static std::vector<uint16_t> slotList_;
 };
@@ -11,81 +11,53 @@ LineStreamDistributor::LineStreamDistributor(UART uart, uint16_t maxLineLen, con
 , maxLineLen_(maxLineLen)
 , name_(name)
 {
-    // Reserve id of 0 for special purposes
-    idMaker_.GetNextId();   // 0
+    // the only allocation the line buffer ever makes
+    line_.reserve(maxLineLen_);
 }
 
-pair<bool, uint8_t> LineStreamDistributor::AddLineStreamCallback(function<void(const string &line)> cbFn, bool hideBlankLines)
+pair<bool, uint8_t> LineStreamDistributor::AddLineStreamCallback(CbFn cbFn, bool hideBlankLines)
 {
-    auto [ok, id] = idMaker_.GetNextId();
-
-    if (ok)
-    {
-        id__data_[id] = Data{cbFn, hideBlankLines};
-    }
-
-    return { ok, id };
+    return cbList_.Add(Callback{ .cbFn = move(cbFn), .hideBlankLines = hideBlankLines });
 }
 
-bool LineStreamDistributor::SetLineStreamCallback(uint8_t id, function<void(const string &line)> cbFn, bool hideBlankLines)
+pair<bool, uint8_t> LineStreamDistributor::AddLineStreamViewCallback(CbFnView cbFn, bool hideBlankLines)
 {
-    bool retVal = false;
-
-    if (id__data_.contains(id) || id == 0)
-    {
-        id__data_[id] = Data{cbFn, hideBlankLines};
+    return cbList_.Add(Callback{ .cbFnView = move(cbFn), .hideBlankLines = hideBlankLines });
+}
 
-        retVal = true;
-    }
+bool LineStreamDistributor::SetLineStreamCallback(uint8_t id, CbFn cbFn, bool hideBlankLines)
+{
+    return cbList_.Set(id, Callback{ .cbFn = move(cbFn), .hideBlankLines = hideBlankLines });
+}
 
-    return retVal;
+bool LineStreamDistributor::SetLineStreamViewCallback(uint8_t id, CbFnView cbFn, bool hideBlankLines)
+{
+    return cbList_.Set(id, Callback{ .cbFnView = move(cbFn), .hideBlankLines = hideBlankLines });
 }
 
 bool LineStreamDistributor::RemoveLineStreamCallback(uint8_t id)
 {
-    idMaker_.ReturnId(id);
-    
-    return id__data_.erase(id);
+    return cbList_.Remove(id);
 }
 
-void LineStreamDistributor::AddData(const vector<uint8_t> &data)
+void LineStreamDistributor::AddData(span<const uint8_t> data)
 {
-    if (id__data_.empty()) { return; }
+    if (cbList_.GetCount() == 0) { return; }
 
     for (size_t i = 0; i < data.size(); ++i)
     {
-        char c = data[i];
+        char c = (char)data[i];
 
-        if (c == '\n' || c == '\r' || inputStream_.size() == maxLineLen_)
+        if (c == '\n' || c == '\r' || line_.size() == maxLineLen_)
         {
             // remember if max line len hit
-            bool wasMaxLine = inputStream_.size() == maxLineLen_;
+            bool wasMaxLine = line_.size() == maxLineLen_;
 
             // distribute
-
-            // handle case where the callback leads to the caller
-            // de-registering itself and invalidating the id and callback fn
-            // itself.
-            //
-            // this was happening with gps getting a lock, bubbling the lock
-            // event, which then says ok no need to listen anymore, which
-            // found its way back to deregistering, all while the initial
-            // callback was still executing
-            auto tmp = id__data_;
-            for (auto &[id, data] : tmp)
-            {
-                if (inputStream_.size() || data.hideBlankLines == false)
-                {
-                    // default to writing back to the uart that sent the data
-                    UartTarget target(uart_);
-
-                    // fire callback
-                    data.cbFn(inputStream_);
-                }
-            }
+            DistributeLine();
 
             // clear line cache
-            inputStream_.clear();
+            line_.clear();
 
             // wind forward to next newline if needed
             if (wasMaxLine)
@@ -101,26 +73,47 @@ void LineStreamDistributor::AddData(const vector<uint8_t> &data)
         }
         else if ((isprint(c) || c == ' ' || c == '\t'))
         {
-            inputStream_.push_back(c);
+            // never beyond the reserved capacity, see above
+            line_.push_back(c);
         }
     }
 }
 
+void LineStreamDistributor::DistributeLine()
+{
+    cbList_.ForEach([&](Callback &cb){
+        if (line_.size() || cb.hideBlankLines == false)
+        {
+            // default to writing back to the uart that sent the data
+            UartTarget target(uart_);
+
+            if (cb.cbFnView)
+            {
+                cb.cbFnView(line_);
+            }
+            else if (cb.cbFn)
+            {
+                cb.cbFn(line_);
+            }
+        }
+    });
+}
+
 uint8_t LineStreamDistributor::GetCallbackCount()
 {
-    return (uint8_t)id__data_.size();
+    return cbList_.GetCount();
 }
 
 uint32_t LineStreamDistributor::Size() const
 {
-    return inputStream_.size();
+    return (uint32_t)line_.size();
 }
 
 uint32_t LineStreamDistributor::Clear()
 {
-    uint32_t size = inputStream_.size();
+    uint32_t size = (uint32_t)line_.size();
 
-    inputStream_.clear();
+    line_.clear();
 
     return size;
 }
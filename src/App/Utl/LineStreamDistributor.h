@@ -1,38 +1,62 @@
 #pragma once
 
-#include "IDMaker.h"
+#include "CallbackSlots.h"
 #include "UART.h"
 
 #include <cstdint>
 #include <functional>
-#include <unordered_map>
+#include <span>
+#include <string>
+#include <string_view>
 #include <utility>
-#include <vector>
 
 
+// Assembles printable input into lines and hands each completed line to
+// every registered callback.
+//
+// The line is built in a buffer reserved once, at maxLineLen, so it never
+// grows.  Callbacks either see it as a std::string_view, or (for code which
+// wants one) as a const std::string & onto that same buffer, so nothing is
+// allocated or copied per line.  Either way the line is only valid for the
+// duration of the callback.
+//
+// A callback may add, set, or remove callbacks (including itself) while
+// being called, see CallbackSlots.
 class LineStreamDistributor
 {
 public:
+    using CbFn     = std::function<void(const std::string &line)>;
+    using CbFnView = std::function<void(std::string_view line)>;
+
     LineStreamDistributor(UART uart, uint16_t maxLineLen, const char *name);
-    std::pair<bool, uint8_t> AddLineStreamCallback(std::function<void(const std::string &line)> cbFn, bool hideBlankLines = true);
-    bool SetLineStreamCallback(uint8_t id, std::function<void(const std::string &line)> cbFn, bool hideBlankLines = true);
+    std::pair<bool, uint8_t> AddLineStreamCallback(CbFn cbFn, bool hideBlankLines = true);
+    std::pair<bool, uint8_t> AddLineStreamViewCallback(CbFnView cbFn, bool hideBlankLines = true);
+    bool SetLineStreamCallback(uint8_t id, CbFn cbFn, bool hideBlankLines = true);
+    bool SetLineStreamViewCallback(uint8_t id, CbFnView cbFn, bool hideBlankLines = true);
     bool RemoveLineStreamCallback(uint8_t id);
-    void AddData(const std::vector<uint8_t> &data);
+    void AddData(std::span<const uint8_t> data);
     uint8_t GetCallbackCount();
     uint32_t Size() const;
     uint32_t Clear();
     uint32_t ClearInFlight();
 
+private:
+
+    struct Callback
+    {
+        CbFn     cbFn;
+        CbFnView cbFnView;
+        bool     hideBlankLines = true;
+    };
+
+    void DistributeLine();
+
 private:
     UART uart_;
     uint16_t maxLineLen_;
     const char *name_;
-    IDMaker<32> idMaker_;
-    struct Data
-    {
-        std::function<void(const std::string &)> cbFn = [](const std::string &){};
-        bool hideBlankLines = true;
-    };
-    std::unordered_map<uint8_t, Data> id__data_;
-    std::string inputStream_;
-};
\ No newline at end of file
+    CallbackSlots<Callback> cbList_;
+
+    // reserved at maxLineLen_, never reallocated
+    std::string line_;
+};
@@ -5,12 +5,104 @@
 #include "Utl.h"
 #include "Work.h"
 
+#include "hardware/sync.h"
+
+#include <algorithm>
 #include <cstring>
 using namespace std;
 
 #include "StrictMode.h"
 
 
+////////////////////////////////////////////////////////////////////////////////
+// Name interning
+//
+// Names are interned by address into a fixed open-addressed table, and an
+// event carries the slot index as its id.  Lookups of names already seen
+// (the usual case) take no lock.  Adding a name is serialized across cores
+// by a hardware spinlock, claimed in Init(), before which only one core is
+// running and masking interrupts is enough.
+////////////////////////////////////////////////////////////////////////////////
+
+static const uint16_t NAME_TABLE_SIZE = 256;    // power of 2
+static const uint16_t NAME_ID_NONE    = 0xFFFF;
+
+static const char * volatile nameTable_[NAME_TABLE_SIZE];
+static spin_lock_t *nameTableLock_ = nullptr;
+
+static uint16_t NameHash(const char *name)
+{
+    return (uint16_t)((((uint32_t)(uintptr_t)name >> 2) * 2654435761u) >> 24);
+}
+
+static uint16_t NameToId(const char *name)
+{
+    uint16_t idx = NameHash(name);
+
+    // already interned
+    for (uint16_t i = 0; i < NAME_TABLE_SIZE; ++i)
+    {
+        const char *nameAt = nameTable_[idx];
+
+        if (nameAt == name)
+        {
+            return idx;
+        }
+        else if (nameAt == nullptr)
+        {
+            break;
+        }
+
+        idx = (uint16_t)((idx + 1) & (NAME_TABLE_SIZE - 1));
+    }
+
+    // add it, probing again, another core may have just done so
+    uint16_t retVal = NAME_ID_NONE;
+
+    uint32_t key = nameTableLock_ ? spin_lock_blocking(nameTableLock_) : PAL.IrqLock();
+
+    idx = NameHash(name);
+    for (uint16_t i = 0; i < NAME_TABLE_SIZE; ++i)
+    {
+        if (nameTable_[idx] == name)
+        {
+            retVal = idx;
+            break;
+        }
+        else if (nameTable_[idx] == nullptr)
+        {
+            nameTable_[idx] = name;
+            retVal = idx;
+            break;
+        }
+
+        idx = (uint16_t)((idx + 1) & (NAME_TABLE_SIZE - 1));
+    }
+
+    if (nameTableLock_)
+    {
+        spin_unlock(nameTableLock_, key);
+    }
+    else
+    {
+        PAL.IrqUnlock(key);
+    }
+
+    return retVal;
+}
+
+static const char *IdToName(uint16_t id)
+{
+    const char *name = id < NAME_TABLE_SIZE ? nameTable_[id] : nullptr;
+
+    return name ? name : "(TIMELINE_NAMES_FULL)";
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Timeline
+////////////////////////////////////////////////////////////////////////////////
+
 Timeline::Timeline(const char *str)
 {
     IrqLock lock;
@@ -26,13 +118,16 @@ Timeline::Timeline(const char *str)
 void Timeline::SetMaxEvents(uint32_t maxEvents)
 {
     IrqLock lock;
-    
-    eventList_.SetCapacity(maxEvents);
+
+    for (auto &eventList : eventList_)
+    {
+        eventList.SetCapacity(maxEvents);
+    }
 }
 
 uint32_t Timeline::GetMaxEvents()
 {
-    return eventList_.GetCapacity();
+    return eventList_[0].GetCapacity();
 }
 
 void Timeline::KeepOldest()
@@ -49,22 +144,36 @@ uint64_t Timeline::Event(const char *name)
 {
     name = name ? name : "NULLPTR";
 
-    uint64_t timeUs = PAL.Micros();
-    
     if (ccGlobal_ && !iAmTheGlobal_)
     {
         Global().Event(name);
     }
 
+    uint8_t core = (uint8_t)(get_core_num() % CORE_COUNT);
+
+    uint64_t timeUs;
+
     if (!currentlyReporting_)
     {
+        EventData ed = {
+            .id   = NameToId(name),
+            .core = core,
+            .isr  = PAL.InIsrReal(),
+        };
+
+        CircularBuffer<EventData> &eventList = eventList_[core];
+
         IrqLock lock;
-        
+
+        // timestamped inside the lock, so each core's events are in order
+        timeUs = PAL.Micros();
+        ed.timeUs = (uint32_t)(timeUs - baseUs_);
+
         // We want to add another element.
         // That will either be possible or not.
         // If we're keeping the oldest, and we're at our limit, we don't add.
 
-        bool weAreAtOurLimit = eventList_.Size() == eventList_.GetCapacity();
+        bool weAreAtOurLimit = eventList.Size() == eventList.GetCapacity();
         bool addItem = true;
 
         if (weAreAtOurLimit)
@@ -77,36 +186,89 @@ uint64_t Timeline::Event(const char *name)
 
         if (addItem)
         {
-            eventList_.PushBack((EventData){
-                .name = name,
-                .timeUs = timeUs,
-            });
+            eventList.PushBack(ed);
         }
         else
         {
-            ++eventsLost_;
+            ++eventsLost_[core];
         }
     }
     else
     {
-        ++eventsLost_;
+        timeUs = PAL.Micros();
+
+        ++eventsLost_[core];
     }
 
     return timeUs;
 }
 
+// All cores' events, with absolute times, oldest first.
+// Relative times are unwrapped on the way, each core's ring is in order.
+void Timeline::GetEventList(vector<EventAt> &eventAtList)
+{
+    eventAtList.clear();
+
+    for (auto &eventList : eventList_)
+    {
+        uint64_t wrapUs = 0;
+        uint32_t timeUsLast = 0;
+
+        for (uint32_t i = 0; i < eventList.Size(); ++i)
+        {
+            EventData &ed = eventList[i];
+
+            if (ed.timeUs < timeUsLast)
+            {
+                wrapUs += 0x1'0000'0000ull;
+            }
+            timeUsLast = ed.timeUs;
+
+            eventAtList.push_back({ baseUs_ + wrapUs + ed.timeUs, ed });
+        }
+    }
+
+    stable_sort(eventAtList.begin(), eventAtList.end(), [](const EventAt &a, const EventAt &b){
+        return a.timeUs < b.timeUs;
+    });
+}
+
+// name, with where it happened if not on core 0 outside of an ISR
+string Timeline::GetEventName(const EventData &ed)
+{
+    string retVal = IdToName(ed.id);
+
+    if (ed.core != 0 || ed.isr)
+    {
+        retVal += " [";
+        if (ed.core != 0)
+        {
+            retVal += "core";
+            retVal += to_string(ed.core);
+            retVal += ed.isr ? " " : "";
+        }
+        retVal += ed.isr ? "isr" : "";
+        retVal += "]";
+    }
+
+    return retVal;
+}
+
 // Returns the time at the most recent matching event label, 0 if not found
 uint64_t Timeline::GetTimeAtEvent(const char *name)
 {
     uint64_t retVal = 0;
 
-    for (int i = (int)eventList_.Size() - 1; i >= 0; --i)
+    vector<EventAt> eventAtList;
+    GetEventList(eventAtList);
+
+    for (int i = (int)eventAtList.size() - 1; i >= 0; --i)
     {
-        EventData &ed = eventList_[(uint32_t)i];
+        EventAt &ea = eventAtList[(uint32_t)i];
 
-        if (strcmp(name, ed.name) == 0)
+        if (strcmp(name, IdToName(ea.ed.id)) == 0)
         {
-            retVal = ed.timeUs;
+            retVal = ea.timeUs;
 
             break;
         }
@@ -149,18 +311,31 @@ void Timeline::ReportNow(const char *title)
             LogNNL("[Timeline: ");
         }
     }
-    Log(eventList_.Size(), " Events (", CommasStatic(eventsLost_), " lost)]");
-    if (eventList_.Size())
+    vector<EventAt> eventAtList;
+    GetEventList(eventAtList);
+
+    uint32_t eventsLost = 0;
+    for (auto lost : eventsLost_)
     {
+        eventsLost += lost;
+    }
+
+    Log(eventAtList.size(), " Events (", CommasStatic(eventsLost), " lost)]");
+    if (eventAtList.size())
+    {
+        vector<string> nameList;
+        for (auto &ea : eventAtList)
+        {
+            nameList.push_back(GetEventName(ea.ed));
+        }
+
         // find lengths
         size_t len = 0;
-        for (uint32_t i = 0; i < eventList_.Size(); ++i)
+        for (auto &name : nameList)
         {
-            auto &evt = eventList_[i];
-
-            if (strlen(evt.name) > len)
+            if (name.size() > len)
             {
-                len = strlen(evt.name);
+                len = name.size();
             }
         }
 
@@ -170,10 +345,10 @@ void Timeline::ReportNow(const char *title)
             // walk the list
             uint32_t idxLast = 0;
             uint32_t idxThis = 1;
-            while (idxThis != eventList_.Size())
+            while (idxThis < eventAtList.size())
             {
-                auto &evtLast = eventList_[idxLast];
-                auto &evtThis = eventList_[idxThis];
+                auto &evtLast = eventAtList[idxLast];
+                auto &evtThis = eventAtList[idxThis];
 
                 uint64_t diffUs = evtThis.timeUs - evtLast.timeUs;
                 uint64_t diffMs = diffUs / 1000;
@@ -198,10 +373,10 @@ void Timeline::ReportNow(const char *title)
         // walk the list
         uint32_t idxLast = 0;
         uint32_t idxThis = 1;
-        while (idxThis < eventList_.Size())
+        while (idxThis < eventAtList.size())
         {
-            auto &evtLast = eventList_[idxLast];
-            auto &evtThis = eventList_[idxThis];
+            auto &evtLast = eventAtList[idxLast];
+            auto &evtThis = eventAtList[idxThis];
 
             uint64_t diffUs = evtThis.timeUs - evtLast.timeUs;
             uint64_t diffMs = diffUs / 1000;
@@ -217,8 +392,8 @@ void Timeline::ReportNow(const char *title)
                 LogNNL(completedStr);
             };
 
-            fnPrint("%%%us - ",    len,   evtLast.name);
-            fnPrint("%%%us: ",     len,   evtThis.name);
+            fnPrint("%%%us - ",    len,   nameList[idxLast].c_str());
+            fnPrint("%%%us: ",     len,   nameList[idxThis].c_str());
             fnPrint("%%%us ms, ",  lenMs, CommasStatic(diffMs).c_str());
             fnPrint("%%%us us - ", lenUs, CommasStatic(diffUs).c_str());
             fnPrint("%%12s\n",     12,    Time::GetNotionalTimeAtSystemUs(evtThis.timeUs));
@@ -227,9 +402,9 @@ void Timeline::ReportNow(const char *title)
             ++idxThis;
         }
 
-        if (eventList_.Size() >= 2)
+        if (eventAtList.size() >= 2)
         {
-            uint64_t totalUs = eventList_[eventList_.Size() - 1].timeUs - eventList_[0].timeUs;
+            uint64_t totalUs = eventAtList[eventAtList.size() - 1].timeUs - eventAtList[0].timeUs;
 
             Log("[Total Duration: ", Time::MakeDurationFromUs(totalUs), "]");
         }
@@ -239,12 +414,116 @@ void Timeline::ReportNow(const char *title)
     currentlyReporting_ = false;
 }
 
+// Binary export, little-endian:
+//   "TLN1"
+//   uint64_t baseUs      (system time of the Reset)
+//   uint32_t eventsLost
+//   uint16_t nameCount, then per name
+//     uint16_t id
+//     uint8_t  len
+//     char     name[len]
+//   uint32_t eventCount, then per event, oldest first
+//     uint32_t timeUs    (since baseUs, wrapping)
+//     uint16_t id
+//     uint8_t  core
+//     uint8_t  isr
+//
+// written to the console as "TIMELINE:<hex>" lines, for
+// utl/TimelineToTrace.py to pick out of a capture.
+void Timeline::Dump()
+{
+    currentlyReporting_ = true;
+
+    vector<EventAt> eventAtList;
+    GetEventList(eventAtList);
+
+    vector<uint8_t> byteList;
+    auto fnAdd = [&](uint64_t val, uint8_t len) {
+        for (uint8_t i = 0; i < len; ++i)
+        {
+            byteList.push_back((uint8_t)(val >> (8 * i)));
+        }
+    };
+
+    byteList.insert(byteList.end(), { 'T', 'L', 'N', '1' });
+    fnAdd(baseUs_, 8);
+
+    uint32_t eventsLost = 0;
+    for (auto lost : eventsLost_)
+    {
+        eventsLost += lost;
+    }
+    fnAdd(eventsLost, 4);
+
+    // only the names in use
+    vector<bool> idUsed(NAME_TABLE_SIZE + 1, false);
+    vector<uint16_t> idList;
+    for (auto &ea : eventAtList)
+    {
+        uint16_t id = ea.ed.id < NAME_TABLE_SIZE ? ea.ed.id : NAME_TABLE_SIZE;
+        if (!idUsed[id])
+        {
+            idUsed[id] = true;
+            idList.push_back(ea.ed.id);
+        }
+    }
+
+    fnAdd(idList.size(), 2);
+    for (auto id : idList)
+    {
+        const char *name = IdToName(id);
+        uint8_t len = (uint8_t)min(strlen(name), (size_t)255);
+
+        fnAdd(id, 2);
+        fnAdd(len, 1);
+        byteList.insert(byteList.end(), name, name + len);
+    }
+
+    fnAdd(eventAtList.size(), 4);
+    for (auto &ea : eventAtList)
+    {
+        fnAdd(ea.ed.timeUs, 4);
+        fnAdd(ea.ed.id,     2);
+        fnAdd(ea.ed.core,   1);
+        fnAdd(ea.ed.isr,    1);
+    }
+
+    // one line per chunk
+    static const char *HEX = "0123456789ABCDEF";
+    static const uint32_t CHUNK_SIZE = 32;
+
+    for (uint32_t idx = 0; idx < byteList.size(); idx += CHUNK_SIZE)
+    {
+        char line[9 + 2 * CHUNK_SIZE + 1] = "TIMELINE:";
+        uint32_t lineIdx = 9;
+
+        for (uint32_t i = idx; i < byteList.size() && i < idx + CHUNK_SIZE; ++i)
+        {
+            line[lineIdx++] = HEX[byteList[i] >> 4];
+            line[lineIdx++] = HEX[byteList[i] & 0x0F];
+        }
+        line[lineIdx] = '\0';
+
+        Log(line);
+    }
+
+    currentlyReporting_ = false;
+}
+
 void Timeline::Reset()
 {
     IrqLock lock;
-    
-    eventList_.Clear();
-    eventsLost_ = 0;
+
+    for (auto &eventList : eventList_)
+    {
+        eventList.Clear();
+    }
+    for (auto &lost : eventsLost_)
+    {
+        lost = 0;
+    }
+
+    baseUs_ = PAL.Micros();
 
     // record a reset event, but don't CC to the global.
     // accomplish this by pretending to be the global for
@@ -292,6 +571,9 @@ Timeline &Timeline::Global()
 
 void Timeline::Init()
 {
+    // from here on names may be added from either core
+    nameTableLock_ = spin_lock_instance((uint)spin_lock_claim_unused(true));
+
     Timeline::EnableCcGlobal();
     Timeline::Global().SetMaxEvents(80);
     Timeline::Global().Reset();
@@ -333,5 +615,9 @@ void Timeline::SetupShell()
     Shell::AddCommand("t.reportnow", [&](vector<string> argList){
         Timeline::Global().ReportNow();
     }, { .argCount = 0, .help = "Global Timeline Report, Now" });
+
+    Shell::AddCommand("t.dump", [&](vector<string> argList){
+        Timeline::Global().Dump();
+    }, { .argCount = 0, .help = "Global Timeline binary dump, see utl/TimelineToTrace.py" });
 }
 
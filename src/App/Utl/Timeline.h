@@ -5,8 +5,25 @@
 
 #include <cstdint>
 #include <functional>
-
-
+#include <string>
+#include <vector>
+
+
+// Records named, timestamped events, for later reporting or export.
+//
+// Events are kept in one ring per RP2040 core, so the cores never contend.
+// An event is only 8 bytes: a 32-bit time relative to the last Reset()
+// (good for ~71 minutes), a 16-bit id for the name, which is interned by
+// address (so names must outlive the Timeline, eg string literals), and
+// the core and ISR context it was recorded from.
+//
+// Recording takes no lock shared between cores.  On its own core it
+// masks interrupts for the few instructions needed to claim a slot, which
+// on the Cortex-M0+ (no atomic read-modify-write) is what keeps ISRs and
+// task switches from interleaving with it.
+//
+// Dump() exports in a compact binary form, as hex text on the console,
+// which utl/TimelineToTrace.py turns into Chrome trace / Perfetto JSON.
 class Timeline
 : private NonCopyable
 , private NonMovable
@@ -21,6 +38,7 @@ public:
     uint64_t GetTimeAtEvent(const char *name);
     void Report(const char *title = nullptr);
     void ReportNow(const char *title = nullptr);
+    void Dump();
     void Reset();
 
     static uint64_t Measure(std::function<void(Timeline &t)> fn, const char *title = nullptr);
@@ -34,19 +52,33 @@ public:
 
 
 private:
+    static const uint8_t CORE_COUNT = 2;
+
     struct EventData
     {
-        const char *name;
-        uint64_t timeUs = 0;
+        uint32_t timeUs = 0;    // since baseUs_
+        uint16_t id     = 0;
+        uint8_t  core   = 0;
+        uint8_t  isr    = 0;
     };
 
-    CircularBuffer<EventData> eventList_;
+    // an event with its absolute time, for reporting
+    struct EventAt
+    {
+        uint64_t timeUs;
+        EventData ed;
+    };
+
+    void GetEventList(std::vector<EventAt> &eventAtList);
+    static std::string GetEventName(const EventData &ed);
+
+    CircularBuffer<EventData> eventList_[CORE_COUNT];
 
     bool keepOldest_ = false;
-    uint32_t eventsLost_ = 0;
+    uint32_t eventsLost_[CORE_COUNT] = {};
     bool currentlyReporting_ = false;
 
-    uint32_t firstTimeUs_ = 0;
+    uint64_t baseUs_ = 0;
 
     bool iAmTheGlobal_ = false;
 
@@ -4,13 +4,15 @@
 #include "Log.h"
 #include "NMEAStringMaker.h"
 #include "NMEAStringParser.h"
+#include "NMEATokenizer.h"
 #include "TimeClass.h"
 #include "UbxMessage.h"
 #include "Utl.h"
 
+#include <algorithm>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_set>
 using namespace std;
 
 
@@ -213,6 +215,22 @@ private:
         string speedKnotsStr;
         string courseDegreesStr;
 
+        // Binary (UBX) source, held as numbers, and used in place of the
+        // strings above when set
+        bool fromUbx = false;
+
+        uint16_t year          = 0;
+        uint8_t  month         = 0;
+        uint8_t  day           = 0;
+        uint8_t  hour          = 0;
+        uint8_t  minute        = 0;
+        uint8_t  second        = 0;
+        uint16_t millisecond   = 0;
+        int32_t  latDegE7      = 0;
+        int32_t  lngDegE7      = 0;
+        int32_t  altitudeMm    = 0;
+        int32_t  speedMmPerSec = 0;
+        int32_t  courseDegE5   = 0;
     };
     AccumulatedData data_;
 
@@ -227,13 +245,23 @@ private:
     bool cbOnFix3DSet_ = false;
     bool cbOnFix3DPlusSet_ = false;
 
-    // UBX message monitoring state
+    // NMEA message monitoring state
     uint8_t idNmea_ = 0;
 
+    // NMEA sentence currently being processed
+    NMEATokenizer nmea_;
+
+    // UBX message monitoring state
+    uint8_t idUbx_ = 0;
+
+    // UBX message currently being processed
+    UbxMessageParser ubx_;
+
     // Stats
     struct Stats
     {
         uint32_t countNmeaMessagesSeen = 0;
+        uint32_t countUbxMessagesSeen  = 0;
     };
 
     Stats stats_;
@@ -245,6 +273,18 @@ private:
 
 public:
 
+    // What the fix data is acquired from.
+    //
+    // NMEA is the module default.  UBX needs the module configured to
+    // emit NAV-PVT, NAV-SAT and NAV-DOP (see GPSWriter::
+    // SendModuleMessageRateConfigurationUbx), and skips the text handling
+    // entirely, the binary fields being read in place.
+    enum class Source : uint8_t
+    {
+        NMEA,
+        UBX,
+    };
+
     void DisableVerboseLogging()
     {
         verboseLogging_ = false;
@@ -255,10 +295,10 @@ public:
     /////////////////////////////////////////////////////////////////
 
     // Assumes one line at a time, ascii only, no newlines
-    uint64_t ReadLine(const string &line)
+    uint64_t ReadLine(string_view line)
     {
         // We know about these, so don't warn if seen
-        static const unordered_set<string> msgIgnoreSet = {
+        static const string_view msgIgnoreList[] = {
             "GSA",
             "GGA",
             "GLL",
@@ -271,9 +311,8 @@ public:
 
         uint64_t timeStartUs = PAL.Micros();
 
-        if (NMEAStringParser::IsValid(line))
+        if (nmea_.Tokenize(line))
         {
-            vector<string> linePartList = NMEAStringParser::GetLineDataPartList(line);
 
             // "The default output is GGA, GSA, GSV and RMC in 1 second period"
             //
@@ -292,27 +331,22 @@ public:
             // GA for GALILEO-only  - EU
             // GN is for GNSS, combination of different global position satellite systems
 
-            string type   = linePartList[0];
-            string talker = type.substr(0, 2);
-
-            // Get last 3 chars representing the message
-            if (type.size() >= 3)
-            {
-                type = type.substr(type.size() - 3);
-            }
+            // Last 3 chars represent the message
+            string_view type   = nmea_.GetMessageType();
+            string_view talker = nmea_.GetTalker();
 
             bool ok = true;
             if (type == "RMC") // RMC - Recommended Minimum data for GPS
             {
-                ok = OnRMC(linePartList, line);
+                ok = OnRMC(nmea_, line);
             }
             else if (type == "GGA") // GGA - Fix information
             {
-                ok = OnGGA(linePartList, line);
+                ok = OnGGA(nmea_, line);
             }
             else if (type == "GSV") // GSV - Detailed satellite data (multi-row)
             {
-                ok = OnGSV(talker, linePartList);
+                ok = OnGSV(talker, nmea_);
             }
             // VTG - Vector track and speed over ground
             // GSA - Overall satellite data (multi-row)
@@ -323,10 +357,10 @@ public:
             // TXT - Antenna status message
             else
             {
-                if (!msgIgnoreSet.contains(type))
+                if (find(begin(msgIgnoreList), end(msgIgnoreList), type) == end(msgIgnoreList))
                 {
                     ok = false;
-                    Log("Unknown message: ", linePartList[0]);
+                    Log("Unknown message: ", nmea_.GetField(0));
                 }
             }
 
@@ -335,10 +369,9 @@ public:
                 LogNL();
                 Log("Line not processed correctly");
                 Log("\"", line, "\"");
-                for (int i = 0; const string &linePart : linePartList)
+                for (uint8_t i = 0; i < nmea_.GetFieldCount(); ++i)
                 {
-                    Log(i, ": \"", linePart, "\"");
-                    ++i;
+                    Log(i, ": \"", nmea_.GetField(i), "\"");
                 }
                 LogNL();
             }
@@ -356,6 +389,30 @@ public:
         return diffUs;
     }
 
+    // Assumes a whole message, as found by a UbxMessageParser.
+    // Messages other than the ones handled are ignored.
+    uint64_t ReadUbx(const UbxMessageParser &p)
+    {
+        uint64_t timeStartUs = PAL.Micros();
+
+        if (UbxView<UbxNavPvt> pvt(p); pvt.Ok())
+        {
+            OnNavPvt(pvt, p.GetData().size());
+        }
+        else if (UbxView<UbxNavSat> sat(p); sat.Ok())
+        {
+            OnNavSat(sat);
+        }
+        else if (UbxView<UbxNavDop> dop(p); dop.Ok())
+        {
+            OnNavDop(dop);
+        }
+
+        uint64_t diffUs = PAL.Micros() - timeStartUs;
+
+        return diffUs;
+    }
+
     // cause all current data to be considered out of date
     // new data needs to be processed before being used
     void Reset()
@@ -382,11 +439,13 @@ public:
         // Stats
         Log("Stats:");
         Log("- NMEA Messages Seen: ", stats_.countNmeaMessagesSeen);
+        Log("- UBX Messages Seen : ", stats_.countUbxMessagesSeen);
 
         // Monitoring status
         LogNL();
         Log("Monitoring:");
         Log("- NMEA Messages: ", idNmea_ != 0);
+        Log("- UBX Messages : ", idUbx_ != 0);
 
         LogNL();
     }
@@ -396,28 +455,67 @@ public:
     // Actions - Async
     /////////////////////////////////////////////////////////////////
 
-    void StartMonitoring()
+    void StartMonitoring(Source source = Source::NMEA)
     {
         StopMonitoring();
 
-        if (verboseLogging_)
+        if (source == Source::NMEA)
         {
-            Log("Reader starting monitoring for NMEA");
-        }
+            if (verboseLogging_)
+            {
+                Log("Reader starting monitoring for NMEA");
+            }
 
-        auto [ok, id] = UartAddLineStreamCallback(uart_, [this](const string &line){
-            UartTarget target(UART::UART_0);
+            auto [ok, id] = UartAddLineStreamViewCallback(uart_, [this](string_view line){
+                UartTarget target(UART::UART_0);
 
-            if (processData_)
-            {
-                ++stats_.countNmeaMessagesSeen;
+                if (processData_)
+                {
+                    ++stats_.countNmeaMessagesSeen;
 
-                // Send to sync line processor
-                ReadLine(line);
+                    // Send to sync line processor
+                    ReadLine(line);
+                }
+            });
+
+            idNmea_ = ok ? id : 0;
+        }
+        else
+        {
+            if (verboseLogging_)
+            {
+                Log("Reader starting monitoring for UBX");
             }
-        });
 
-        idNmea_ = ok ? id : 0;
+            ubx_.Reset();
+            auto [ok, id] = UartAddDataStreamCallback(uart_, [this](span<const uint8_t> byteList){
+                UartTarget target(UART::UART_0);
+
+                while (byteList.size())
+                {
+                    byteList = byteList.subspan(ubx_.AddBytes(byteList));
+
+                    if (ubx_.MessageFound())
+                    {
+                        if (processData_)
+                        {
+                            ++stats_.countUbxMessagesSeen;
+
+                            // Send to sync message processor
+                            ReadUbx(ubx_);
+                        }
+
+                        ubx_.Reset();
+                    }
+                    else if (ubx_.ErrorEncountered())
+                    {
+                        ubx_.Reset();
+                    }
+                }
+            });
+
+            idUbx_ = ok ? id : 0;
+        }
     }
 
     void StopMonitoring()
@@ -430,6 +528,15 @@ public:
 
             idNmea_ = 0;
         }
+
+        if (idUbx_ != 0)
+        {
+            Log("Reader stopping monitoring for UBX");
+
+            UartRemoveDataStreamCallback(uart_, idUbx_);
+
+            idUbx_ = 0;
+        }
     }
 
 
@@ -542,7 +649,13 @@ public:
         uint16_t year  = 0;
         uint8_t  month = 0;
         uint8_t  day   = 0;
-        if (data_.dateStr.size() == 6)
+        if (data_.fromUbx)
+        {
+            year  = data_.year;
+            month = data_.month;
+            day   = data_.day;
+        }
+        else if (data_.dateStr.size() == 6)
         {
             year  = 2000 + TwoCharToInt(&data_.dateStr.c_str()[4]);
             month = TwoCharToInt(&data_.dateStr.c_str()[2]);
@@ -553,7 +666,14 @@ public:
         uint8_t  minute      = 0;
         uint8_t  second      = 0;
         uint16_t millisecond = 0;
-        if (data_.timeStr.size() >= 6)
+        if (data_.fromUbx)
+        {
+            hour        = data_.hour;
+            minute      = data_.minute;
+            second      = data_.second;
+            millisecond = data_.millisecond;
+        }
+        else if (data_.timeStr.size() >= 6)
         {
             double timeFloat = fabs(atof(data_.timeStr.c_str()));
 
@@ -593,8 +713,19 @@ public:
 
     Fix2D GetFix2D()
     {
-        auto dmsLat = ToDegMinSec(data_.latStr, data_.latNorthSouth);
-        auto dmsLng = ToDegMinSec(data_.lngStr, data_.lngEastWest);
+        DegMinSec dmsLat;
+        DegMinSec dmsLng;
+        if (data_.fromUbx)
+        {
+            // 1e-7 degrees to millionths
+            dmsLat = ToDegMinSec(data_.latDegE7 / 10);
+            dmsLng = ToDegMinSec(data_.lngDegE7 / 10);
+        }
+        else
+        {
+            dmsLat = ToDegMinSec(data_.latStr, data_.latNorthSouth);
+            dmsLng = ToDegMinSec(data_.lngStr, data_.lngEastWest);
+        }
 
         string maidenheadGrid = ToMaidenheadGrid(dmsLat.degMillionths, dmsLng.degMillionths);
 
@@ -630,7 +761,9 @@ public:
 
         static const double METERS_TO_FEET = 3.28084;
 
-        double altitudeM = atof(data_.altitudeStr.c_str());
+        double altitudeM = data_.fromUbx ?
+                           data_.altitudeMm / 1'000.0 :
+                           atof(data_.altitudeStr.c_str());
 
         retVal.altitudeM  = round(altitudeM);
         retVal.altitudeFt = round(altitudeM * METERS_TO_FEET);
@@ -651,10 +784,16 @@ public:
 
         static const double KNOTS_TO_MPH = 1.15078;
         static const double KNOTS_TO_KPH = 1.852;
+        static const double MM_PER_SEC_PER_KNOT = 514.444;
 
-        retVal.courseDegrees = round(atof(data_.courseDegreesStr.c_str()));
+        double courseDegrees = data_.fromUbx ?
+                               data_.courseDegE5 / 100'000.0 :
+                               atof(data_.courseDegreesStr.c_str());
+        retVal.courseDegrees = round(courseDegrees);
 
-        double speedKnots = atof(data_.speedKnotsStr.c_str());
+        double speedKnots = data_.fromUbx ?
+                            data_.speedMmPerSec / MM_PER_SEC_PER_KNOT :
+                            atof(data_.speedKnotsStr.c_str());
         retVal.speedKnots = round(speedKnots);
         retVal.speedMph   = round(speedKnots * KNOTS_TO_MPH);
         retVal.speedKph   = round(speedKnots * KNOTS_TO_KPH);
@@ -805,12 +944,15 @@ private:
     // PPS
     /////////////////////////////////////////////////////////////////
 
-    void CalculateTimeAtPPS(uint64_t timeNowUs, const string &line)
+    // byteCount is the size on the wire of the message which has just
+    // arrived, and is the first of its period (GGA or NAV-PVT)
+    void CalculateTimeAtPPS(uint64_t timeNowUs, size_t byteCount)
     {
         // Calculate the PPS time (in place of a better actual PPS signal input).
         //
         // This class processes GGA and RMC messages.
         // In practice, the GGA message is coming first of the two, and first period.
+        // In UBX mode it is NAV-PVT.
         // The inherent latency of this moment in time from the actual PPS moment is
         // composed of:
         // - The delay on the GPS module itself in constructing the data to send
@@ -826,7 +968,7 @@ private:
         // the number of characters in the sentence (plus \r\n).
         const uint64_t DURATION_BAUD_9600_US_PER_CHAR_US = 1'042;
         const uint64_t DURATION_NMEA_SENTENCE_TRANSMISSION_US =
-            (line.length() + 2) * DURATION_BAUD_9600_US_PER_CHAR_US;
+            byteCount * DURATION_BAUD_9600_US_PER_CHAR_US;
 
         // The processing time is difficult to know and depends on a lot of factors. Instead of
         // calculating, we will have a placeholder estimate.
@@ -1012,12 +1154,28 @@ private:
         return { deg, min, sec, degMillionths };
     }
 
+    // input in millionths of a degree, as from UBX (after scaling)
+    static DegMinSec ToDegMinSec(int32_t degMillionths)
+    {
+        // get degrees (whole), carrying the sign
+        int16_t deg = (int16_t)(degMillionths / 1'000'000);
+
+        // get minutes, and sub-minutes in millionths of a minute
+        uint64_t minMillionths = (uint64_t)abs(degMillionths % 1'000'000) * 60;
+        uint8_t  min           = (uint8_t)(minMillionths / 1'000'000);
+
+        // get seconds whole from remaining, rounded
+        uint8_t sec = (uint8_t)(((minMillionths % 1'000'000) * 60 + 500'000) / 1'000'000);
+
+        return { deg, min, sec, degMillionths };
+    }
+
 
     /////////////////////////////////////////////////////////////////
     // Message Handlers
     /////////////////////////////////////////////////////////////////
 
-    static bool TimeIsRoundSecond(const string &time)
+    static bool TimeIsRoundSecond(string_view time)
     {
         bool retVal = true;
 
@@ -1032,7 +1190,7 @@ private:
 
         // if no decimal point, the second is round
         // if there is, confirm
-        if (pos != string::npos)
+        if (pos != string_view::npos)
         {
             ++pos;
 
@@ -1053,7 +1211,7 @@ private:
     // - time has to be round seconds (no fractional ms component)
     // - it has to have been that way for 2 consecutive times
     //   - as in, different times seen
-    bool TimeStateIsValid(const string &time)
+    bool TimeStateIsValid(string_view time)
     {
         static const uint8_t COUNT_THRESHOLD = 2;
 
@@ -1097,81 +1255,95 @@ private:
         return retVal;
     }
 
+    // keep the most recent 2 source lines, reusing their storage
+    static void AddSourceLine(vector<string> &sourceList, string_view line)
+    {
+        if (sourceList.size() == 2)
+        {
+            rotate(sourceList.begin(), sourceList.begin() + 1, sourceList.end());
+            sourceList.back() = line;
+        }
+        else
+        {
+            sourceList.emplace_back(line);
+        }
+    }
+
     // from neo-6
     // $GPRMC,133735.00,A,4044.56345,N,07401.96989,W,0.329,,160323,,,A*6F
     //
     // from atgm336h-5n31
     // $GNRMC,160755.000,A,4044.51805,N,07401.96538,W,0.21,165.84,200323,,,E*65
-    bool OnRMC(const vector<string> &linePartList, const string &line)
+    bool OnRMC(const NMEATokenizer &nmea, string_view line)
     {
         bool retVal = true;
 
         // Note the current time
         uint64_t timeNowUs = PAL.Micros();
 
-        if (linePartList.size() >= 13)
+        if (nmea.GetFieldCount() >= 13)
         {
-            int i = 1;
+            uint8_t i = 1;
 
             // 1 - Time
             // GP - hhmmss.ss
             // GN - hhmmss.fff
-            const string &time = linePartList[i];
+            string_view time = nmea.GetField(i);
             ++i;
 
             // 2 - Status
             // A = Valid, V = Invalid
             char status = 'V';
-            if (linePartList[i].size() >= 1)
+            if (nmea.GetField(i).size() >= 1)
             {
-                status = linePartList[i][0];
+                status = nmea.GetField(i)[0];
             }
             ++i;
 
             // 3 - Latitude
             // GP - ddmm.mmmmm
             // GN - llll.lllllll
-            const string &latStr = linePartList[i];
+            string_view latStr = nmea.GetField(i);
             ++i;
 
             // 4 - North/South indicator
             // N or S
             char northSouth = 'N';
-            if (linePartList[i].size() >= 1)
+            if (nmea.GetField(i).size() >= 1)
             {
-                northSouth = linePartList[i][0];
+                northSouth = nmea.GetField(i)[0];
             }
             ++i;
 
             // 5 - Longitude
             // GP - dddmm.mmmmm
             // GN - yyyyy.yyyyyyy
-            const string &lngStr = linePartList[i];
+            string_view lngStr = nmea.GetField(i);
             ++i;
 
             // 6 - East/West indicator
             // E or W
             char eastWest = 'W';
-            if (linePartList[i].size() >= 1)
+            if (nmea.GetField(i).size() >= 1)
             {
-                eastWest = linePartList[i][0];
+                eastWest = nmea.GetField(i)[0];
             }
             ++i;
 
             // 7 - Speed over ground (knots)
             // GP - numeric (eg 0.004)
             // GN - x.x
-            const string &speedKnotsStr = linePartList[i];
+            string_view speedKnotsStr = nmea.GetField(i);
             ++i;
 
             // 8 - Course over ground (degrees)
             // GP - numeric (eg 77.52)
             // GN - x.x
-            const string &courseDegrees = linePartList[i];
+            string_view courseDegrees = nmea.GetField(i);
             ++i;
 
             // 9 - Date (UTC DDMMYY)
-            const string &date = linePartList[i];
+            string_view date = nmea.GetField(i);
             ++i;
 
             // 10 - Magnetic variation
@@ -1197,8 +1369,10 @@ private:
             // date may not be set yet
             if (timeStateIsValid)
             {
-                data_.timeStr = move(time);
-                data_.dateStr = move(date);
+                data_.fromUbx = false;
+
+                data_.timeStr = time;
+                data_.dateStr = date;
 
                 data_.timeAtTimeLockUs = timeNowUs;
 
@@ -1213,31 +1387,23 @@ private:
             if (status == 'A' && timeStateIsValid)
             {
                 // add to 2D/3D
-                data_.latStr = move(latStr);
+                data_.latStr = latStr;
                 data_.latNorthSouth = northSouth;
-                data_.lngStr = move(lngStr);
+                data_.lngStr = lngStr;
                 data_.lngEastWest = eastWest;
 
                 data_.timeAtFix2dUs = timeNowUs;
 
                 // add to the 3D plus
-                data_.speedKnotsStr = move(speedKnotsStr);
-                data_.courseDegreesStr = move(courseDegrees);
+                data_.speedKnotsStr = speedKnotsStr;
+                data_.courseDegreesStr = courseDegrees;
 
                 data_.timeAtSpeedCourseUs = timeNowUs;
 
                 // capture source of lock
                 data_.fix2dSource = line;
-                if (data_.fix3dSourceList.size() == 2)
-                {
-                    data_.fix3dSourceList.erase(data_.fix3dSourceList.begin());
-                }
-                data_.fix3dSourceList.push_back(line);
-                if (data_.fix3dPlusSourceList.size() == 2)
-                {
-                    data_.fix3dPlusSourceList.erase(data_.fix3dPlusSourceList.begin());
-                }
-                data_.fix3dPlusSourceList.push_back(line);
+                AddSourceLine(data_.fix3dSourceList, line);
+                AddSourceLine(data_.fix3dPlusSourceList, line);
 
                 // notify change in data
                 OnFix2D();
@@ -1259,48 +1425,48 @@ private:
     //
     // from atgm336h-5n31
     // $GNGGA,160755.000,4044.51805,N,07401.96538,W,6,04,7.3,115.8,M,0.0,M,,*64
-    bool OnGGA(const vector<string> &linePartList, const string &line)
+    bool OnGGA(const NMEATokenizer &nmea, string_view line)
     {
         bool retVal = true;
 
         // Note the current time
         uint64_t timeNowUs = PAL.Micros();
 
-        if (linePartList.size() >= 15)
+        if (nmea.GetFieldCount() >= 15)
         {
-            int i = 1;
+            uint8_t i = 1;
 
             // 1 - Time
             // GP - hhmmss.ss
             // GN - hhmmss.fff
-            const string &time = linePartList[i];
+            string_view time = nmea.GetField(i);
             ++i;
 
             // 2 - Latitude
             // GP - ddmm.mmmm
             // GN - llll.lllllll
-            const string &latStr = linePartList[i];
+            string_view latStr = nmea.GetField(i);
             ++i;
 
             // 3 - North/South indicator
             char northSouth = 'N';
-            if (linePartList[i].size() >= 1)
+            if (nmea.GetField(i).size() >= 1)
             {
-                northSouth = linePartList[i][0];
+                northSouth = nmea.GetField(i)[0];
             }
             ++i;
 
             // 4 - Longitude
             // GP - dddmm.mmmmm
             // GN - yyyyy.yyyyyyy
-            const string &lngStr = linePartList[i];
+            string_view lngStr = nmea.GetField(i);
             ++i;
 
             // 5 - East/West indicator
             char eastWest = 'W';
-            if (linePartList[i].size() >= 1)
+            if (nmea.GetField(i).size() >= 1)
             {
-                eastWest = linePartList[i][0];
+                eastWest = nmea.GetField(i)[0];
             }
             ++i;
 
@@ -1309,27 +1475,29 @@ private:
             // GN - 0 = No Fix, 1 = GNSS Fix, 2 = Differential GNSS Fix, 3 = PPS Fix, 4 = Real Time Kinematic, 5 = Float RTK, 6 = Estimated, 7 = Manual input mode, 8 = Simulation mode
             //   (values above 2 are 2.3 features)
             char quality = '0';
-            if (linePartList[i].size() >= 1)
+            if (nmea.GetField(i).size() >= 1)
             {
-                quality = linePartList[i][0];
+                quality = nmea.GetField(i)[0];
             }
             ++i;
 
             // 7 - Number of satellites used (range 0-12)
             // GP - numeric (eg 08)
             // GN - (range 00-40)
-            // const string &numSatStr = linePartList[i];
-            uint8_t satsUsedCount = atoi(linePartList[i].c_str());
+            uint32_t satsUsedCount = 0;
+            NMEATokenizer::ToUInt(nmea.GetField(i), satsUsedCount);
             ++i;
 
             // 8 - HDOP Horizontal Dilution of Precision
-            double hdop = atof(linePartList[i].c_str());
+            int32_t hdopHundredths = 0;
+            NMEATokenizer::ToFixed(nmea.GetField(i), 2, hdopHundredths);
+            double hdop = hdopHundredths / 100.0;
             ++i;
 
             // 9 - Altitude above mean sea level (meters)
             // GN - numeric (eg 499.6)
             // GP - x.x
-            const string &altitudeStr = linePartList[i];
+            string_view altitudeStr = nmea.GetField(i);
             ++i;
 
             // 10 - Altitude units (meters - fixed constant field)
@@ -1353,13 +1521,15 @@ private:
             // date may not be set yet
             if (timeStateIsValid)
             {
-                data_.satsUsedCount = satsUsedCount;
+                data_.fromUbx = false;
+
+                data_.satsUsedCount = (uint8_t)satsUsedCount;
                 data_.hdop          = hdop;
 
-                data_.timeStr = move(time);
+                data_.timeStr = time;
 
                 data_.timeAtTimeLockUs = timeNowUs;
-                CalculateTimeAtPPS(timeNowUs, line);
+                CalculateTimeAtPPS(timeNowUs, line.length() + 2);
 
                 // capture source of lock
                 data_.fixTimeSource = line;
@@ -1372,28 +1542,20 @@ private:
             if (quality > '0' && quality < '6' && timeStateIsValid)
             {
                 // add to the 2D/3D
-                data_.latStr = move(latStr);
+                data_.latStr = latStr;
                 data_.latNorthSouth = northSouth;
                 data_.lngStr = lngStr;
-                data_.lngEastWest = move(eastWest);
+                data_.lngEastWest = eastWest;
                 data_.timeAtFix2dUs = timeNowUs;
 
                 // add to the 3D
-                data_.altitudeStr = move(altitudeStr);
+                data_.altitudeStr = altitudeStr;
                 data_.timeAtFix3dUs = timeNowUs;
 
                 // capture source of lock
                 data_.fix2dSource = line;
-                if (data_.fix3dSourceList.size() == 2)
-                {
-                    data_.fix3dSourceList.erase(data_.fix3dSourceList.begin());
-                }
-                data_.fix3dSourceList.push_back(line);
-                if (data_.fix3dPlusSourceList.size() == 2)
-                {
-                    data_.fix3dPlusSourceList.erase(data_.fix3dPlusSourceList.begin());
-                }
-                data_.fix3dPlusSourceList.push_back(line);
+                AddSourceLine(data_.fix3dSourceList, line);
+                AddSourceLine(data_.fix3dPlusSourceList, line);
 
                 // notify on data change
                 OnFix2D();
@@ -1418,7 +1580,7 @@ private:
     //
     // from atgm336h-5n31
     // $BDGSV,1,1,03,11,52,179,30,34,68,148,29,43,28,200,29*5B
-    bool OnGSV(const string &talker, const vector<string> &linePartList)
+    bool OnGSV(string_view talker, const NMEATokenizer &nmea)
     {
         bool retVal = true;
 
@@ -1432,24 +1594,29 @@ private:
 
         static SatelliteDataParseCache satCache_;
 
+        // keeps the list storage for the next batch
         auto ResetCache = []{
-            satCache_ = SatelliteDataParseCache{};
+            satCache_.seqNoNextExpected = 1;
+            satCache_.endSeqNo = 0;
+            satCache_.satDataList.clear();
         };
 
         // Processing message
-        if (linePartList.size() >= 4)
+        if (nmea.GetFieldCount() >= 4)
         {
-            int i = 1;
+            uint8_t i = 1;
 
             // examine "header" of this message type
 
             // 0 - Number of GSV messages to expect in this batch (repeated each msg in batch)
-            uint8_t endSeqNo = stoi(linePartList[i]);
+            uint32_t endSeqNo = 0;
+            NMEATokenizer::ToUInt(nmea.GetField(i), endSeqNo);
             // Log("endSeqNo: ", endSeqNo);
             ++i;
             
             // 1 - The sequence number of this message (eg 3 of 4) (diff each batch)
-            uint8_t seqNo = stoi(linePartList[i]);
+            uint32_t seqNo = 0;
+            NMEATokenizer::ToUInt(nmea.GetField(i), seqNo);
             // Log("seqNo: ", seqNo);
             ++i;
 
@@ -1465,7 +1632,7 @@ private:
                 ResetCache();
 
                 // we only set this once
-                satCache_.endSeqNo = endSeqNo;
+                satCache_.endSeqNo = (uint8_t)endSeqNo;
             }
 
             // Batch processing logic:
@@ -1486,7 +1653,7 @@ private:
                 bool ok = true;
 
                 // how many cells left?
-                int cellsRemaining = linePartList.size() - 4;
+                int cellsRemaining = nmea.GetFieldCount() - 4;
                 // Log("cellsRemaining: ", cellsRemaining);
 
                 // how many groupings?
@@ -1509,15 +1676,19 @@ private:
                         satData.talker = talker;
 
                         // 4 + (4N) - Satellite ID (can be in 16-bit range eg 901)
-                        const string &strId = linePartList[i];
-                        satData.id = atoi(strId.c_str());
+                        string_view strId = nmea.GetField(i);
+                        uint32_t id = 0;
+                        NMEATokenizer::ToUInt(strId, id);
+                        satData.id = (uint16_t)id;
                         // Log("id: ", satData.id);
                         ++i;
 
                         // 4 + (5N) - Elevation (degrees, range 0-90)
-                        const string &strElevation = linePartList[i];
-                        satData.elevation = atoi(strElevation.c_str());
-                        if (satData.elevation > 90)
+                        string_view strElevation = nmea.GetField(i);
+                        uint32_t elevation = 0;
+                        NMEATokenizer::ToUInt(strElevation, elevation);
+                        satData.elevation = (uint8_t)min(elevation, (uint32_t)UINT8_MAX);
+                        if (elevation > 90)
                         {
                             // Log("Bad Elevation");
                             ok = false;
@@ -1526,9 +1697,11 @@ private:
                         ++i;
 
                         // 4 + (6N) - Azimuth (degrees, range 0-359)
-                        const string &strAzimuth = linePartList[i];
-                        satData.azimuth = atoi(strAzimuth.c_str());
-                        if (satData.azimuth > 360)
+                        string_view strAzimuth = nmea.GetField(i);
+                        uint32_t azimuth = 0;
+                        NMEATokenizer::ToUInt(strAzimuth, azimuth);
+                        satData.azimuth = (uint16_t)min(azimuth, (uint32_t)UINT16_MAX);
+                        if (azimuth > 360)
                         {
                             // Log("Bad Azimuth");
                             ok = false;
@@ -1602,6 +1775,143 @@ private:
     }
 
 
+    /////////////////////////////////////////////////////////////////
+    // UBX Message Handlers
+    /////////////////////////////////////////////////////////////////
+
+    // NAV-PVT carries time, position, altitude, speed and course for an
+    // epoch in one message.  The module says whether the time is valid
+    // and whether it has a fix, so there is no waiting on consecutive
+    // round seconds as with NMEA.
+    void OnNavPvt(const UbxView<UbxNavPvt> &pvt, size_t byteCount)
+    {
+        static const string_view SOURCE = "UBX NAV-PVT";
+
+        // Note the current time
+        uint64_t timeNowUs = PAL.Micros();
+
+        uint8_t valid   = pvt->valid;
+        uint8_t fixType = pvt->fixType;
+        bool    fixOk   = pvt->flags & UbxNavPvt::FLAG_GNSS_FIX_OK;
+
+        bool timeIsValid = (valid & UbxNavPvt::VALID_TIME) && (valid & UbxNavPvt::FULLY_RESOLVED);
+
+        if (timeIsValid)
+        {
+            data_.fromUbx = true;
+
+            data_.satsUsedCount = pvt->numSV;
+
+            // date may not be set yet
+            bool dateIsValid = valid & UbxNavPvt::VALID_DATE;
+            data_.year  = dateIsValid ? (uint16_t)pvt->year : (uint16_t)0;
+            data_.month = dateIsValid ? pvt->month : (uint8_t)0;
+            data_.day   = dateIsValid ? pvt->day   : (uint8_t)0;
+
+            // beware leap seconds
+            // nano can be negative, the time then being just short of the
+            // second given, which is close enough
+            int32_t nano = pvt->nano;
+            data_.hour        = pvt->hour;
+            data_.minute      = pvt->min;
+            data_.second      = min(pvt->sec, (uint8_t)59);
+            data_.millisecond = (uint16_t)(nano > 0 ? nano / 1'000'000 : 0);
+
+            data_.timeAtTimeLockUs = timeNowUs;
+            CalculateTimeAtPPS(timeNowUs, byteCount);
+
+            // capture source of lock
+            data_.fixTimeSource = SOURCE;
+
+            // notify change in data
+            OnFixTime();
+        }
+
+        // check if 2D location is good
+        if (timeIsValid && fixOk && fixType >= UbxNavPvt::FIX_2D && fixType <= UbxNavPvt::FIX_GNSS_DR)
+        {
+            // add to 2D/3D
+            data_.latDegE7 = pvt->lat;
+            data_.lngDegE7 = pvt->lon;
+            data_.timeAtFix2dUs = timeNowUs;
+
+            // add to the 3D, when there is altitude
+            if (fixType != UbxNavPvt::FIX_2D)
+            {
+                data_.altitudeMm = pvt->hMSL;
+                data_.timeAtFix3dUs = timeNowUs;
+            }
+
+            // add to the 3D plus
+            data_.speedMmPerSec = pvt->gSpeed;
+            data_.courseDegE5   = pvt->headMot;
+            data_.timeAtSpeedCourseUs = timeNowUs;
+
+            // capture source of lock
+            data_.fix2dSource = SOURCE;
+            AddSourceLine(data_.fix3dSourceList, SOURCE);
+            AddSourceLine(data_.fix3dPlusSourceList, SOURCE);
+
+            // notify change in data
+            OnFix2D();
+            OnFix3DMaybe();
+            OnFix3DPlusMaybe();
+        }
+    }
+
+    // NAV-SAT lists every satellite in view, in one message.
+    //
+    // As with GSV, GPS (plus SBAS and QZSS, which NMEA also reports as GP)
+    // go to the GP list and BeiDou to the BD list.  Other constellations
+    // are not kept.  The lists are refilled in place, keeping storage.
+    void OnNavSat(const UbxView<UbxNavSat> &sat)
+    {
+        using Block = UbxNavSat::Block;
+
+        data_.satDataGPList.clear();
+        data_.satDataBDList.clear();
+
+        for (uint16_t i = 0; i < sat.GetBlockCount(); ++i)
+        {
+            const Block &block = sat.GetBlock(i);
+
+            uint8_t gnssId = block.gnssId;
+
+            vector<FixSatelliteData> *satDataList = nullptr;
+            const char               *talker      = nullptr;
+            if (gnssId == Block::GNSS_GPS || gnssId == Block::GNSS_SBAS || gnssId == Block::GNSS_QZSS)
+            {
+                satDataList = &data_.satDataGPList;
+                talker      = "GP";
+            }
+            else if (gnssId == Block::GNSS_BEIDOU)
+            {
+                satDataList = &data_.satDataBDList;
+                talker      = "BD";
+            }
+
+            if (satDataList)
+            {
+                FixSatelliteData &satData = satDataList->emplace_back();
+
+                // elevation is -90..90, below the horizon is kept as 0
+                int8_t  elevation = block.elev;
+                int16_t azimuth   = block.azim;
+
+                satData.talker    = talker;
+                satData.id        = block.svId;
+                satData.elevation = (uint8_t)max(elevation, (int8_t)0);
+                satData.azimuth   = (uint16_t)max(azimuth, (int16_t)0);
+            }
+        }
+    }
+
+    void OnNavDop(const UbxView<UbxNavDop> &dop)
+    {
+        data_.hdop = (uint16_t)dop->hDOP / 100.0;
+    }
+
+
     /////////////////////////////////////////////////////////////////
     // Misc
     /////////////////////////////////////////////////////////////////
@@ -2108,6 +2418,27 @@ public:
         SendModuleMessageRateConfiguration(msgCfgList);
     }
 
+    // NMEA off, and the UBX messages GPSReader uses in Source::UBX mode on,
+    // once per navigation solution
+    void SendModuleMessageRateConfigurationUbx()
+    {
+        vector<MsgCfg> msgCfgList = {
+            { 0xF0, 0x02, 0, "GSA (satellite id list)"            },
+            { 0xF0, 0x00, 0, "GGA (time, lat/lng, altitude)"      },
+            { 0xF0, 0x01, 0, "GLL (time, lat/lng)"                },
+            { 0xF0, 0x03, 0, "GSV (satellite locations)"          },
+            { 0xF0, 0x04, 0, "RMC (time, lat/lng, speed, course)" },
+            { 0xF0, 0x05, 0, "VTG (speed, course)"                },
+            { 0xF0, 0x08, 0, "ZDA (time, timezone)"               },
+            { 0xF0, 0x41, 0, "TXT (text transmission)"            },
+            { UbxNavPvt::CLASS, UbxNavPvt::ID, 1, "NAV-PVT (time, lat/lng, altitude, speed, course)" },
+            { UbxNavSat::CLASS, UbxNavSat::ID, 1, "NAV-SAT (satellite locations)"                    },
+            { UbxNavDop::CLASS, UbxNavDop::ID, 1, "NAV-DOP (dilution of precision)"                  },
+        };
+
+        SendModuleMessageRateConfiguration(msgCfgList);
+    }
+
     void SendModuleMessageRateConfiguration(const vector<MsgCfg> &msgCfgList)
     {
         if (verboseLogging_)
@@ -2163,17 +2494,15 @@ private:
         
         // Set up handling to watch for UBX messages
         pUbx_.Reset();
-        auto [ok, id] = UartAddDataStreamCallback(uart_, [this](const vector<uint8_t> &byteList){
+        auto [ok, id] = UartAddDataStreamCallback(uart_, [this](span<const uint8_t> byteList){
             UartTarget target(UART::UART_0);
 
-            for (auto b : byteList)
+            while (byteList.size())
             {
-                pUbx_.AddByte(b);
+                byteList = byteList.subspan(pUbx_.AddBytes(byteList));
 
                 if (pUbx_.MessageFound())
                 {
-                    const vector<uint8_t> &dat = pUbx_.GetData();
-
                     ++stats_.countUbxMessagesSeen;
 
                     if (verboseLogging_)
@@ -2181,18 +2510,32 @@ private:
                         LogNL();
                         Log("UBX Msg found -- ", ToHex(pUbx_.GetClassId()));
 
-                        if (UbxMsgAckAck::MessageValid(pUbx_))
+                        // decoded in place in the parser's buffer
+                        if (UbxView<UbxAckAck> ack(pUbx_); ack.Ok())
+                        {
+                            Log("ACK from ", ToHex(ack->GetClassId()));
+                        }
+                        else if (UbxView<UbxAckNak> nak(pUbx_); nak.Ok())
+                        {
+                            Log("NAK from ", ToHex(nak->GetClassId()));
+                        }
+                        else if (UbxView<UbxNavPvt> pvt(pUbx_); pvt.Ok())
+                        {
+                            Log("NAV-PVT fixType ", pvt->fixType, ", numSV ", pvt->numSV,
+                                ", lat ", (int32_t)pvt->lat, ", lon ", (int32_t)pvt->lon);
+                        }
+                        else if (UbxView<UbxNavSat> sat(pUbx_); sat.Ok())
                         {
-                            UbxMsgAckAck msg(pUbx_);
-                            Log("ACK from ", ToHex(msg.GetAckClassId()));
+                            Log("NAV-SAT numSvs ", sat->numSvs, ", blocks ", sat.GetBlockCount());
                         }
-                        else if (UbxMsgAckNak::MessageValid(pUbx_))
+                        else if (UbxView<UbxTimTp> tp(pUbx_); tp.Ok())
                         {
-                            UbxMsgAckNak msg(pUbx_);
-                            Log("NAK from ", ToHex(msg.GetNakClassId()));
+                            Log("TIM-TP week ", (uint16_t)tp->week, ", towMS ", (uint32_t)tp->towMS);
                         }
                         else
                         {
+                            span<const uint8_t> dat = pUbx_.GetData();
+
                             Log("Unknown message: ", ToHex(pUbx_.GetClassId()));
                             LogBlob(dat.data(), dat.size());
                         }
@@ -2229,6 +2572,7 @@ public:
         Log("Stats:");
         Log("- UBX Messages Sent : ", stats_.countUbxMessagesSent);
         Log("- UBX Messages Seen : ", stats_.countUbxMessagesSeen);
+        Log("- UBX Oversize Drops: ", pUbx_.GetOversizeCount());
         Log("- NMEA Messages Seen: ", stats_.countNmeaMessagesSeen);
 
         // Monitoring status
@@ -2303,6 +2647,10 @@ public:
             SendModuleMessageRateConfigurationMinimal();
         }, { .argCount = 0, .help = "GPS send message rate configuration"});
 
+        Shell::AddCommand(prefix + ".send.rate.ubx", [this](vector<string> argList){
+            SendModuleMessageRateConfigurationUbx();
+        }, { .argCount = 0, .help = "GPS send message rate configuration, UBX only"});
+
 
         Shell::AddCommand(prefix + ".send.cas00", [this](vector<string> argList){
             string line = NMEAStringMaker::Make({
@@ -0,0 +1,303 @@
+#include "NMEATokenizer.h"
+
+using namespace std;
+
+#include "StrictMode.h"
+
+
+
+static int8_t HexVal(char c)
+{
+    int8_t retVal = -1;
+
+    if (c >= '0' && c <= '9')
+    {
+        retVal = (int8_t)(c - '0');
+    }
+    else if (c >= 'A' && c <= 'F')
+    {
+        retVal = (int8_t)(c - 'A' + 10);
+    }
+    else if (c >= 'a' && c <= 'f')
+    {
+        retVal = (int8_t)(c - 'a' + 10);
+    }
+
+    return retVal;
+}
+
+bool NMEATokenizer::Feed(char c)
+{
+    complete_ = false;
+
+    if (c == '$')
+    {
+        // start (or restart) a sentence
+        state_ = State::DATA;
+
+        len_ = 0;
+        buf_[len_++] = c;
+
+        fieldCount_    = 0;
+        fieldStart_[0] = len_;
+
+        checksumCalcd_ = 0;
+    }
+    else if (state_ != State::WAIT_START)
+    {
+        if (c == '\r' || c == '\n')
+        {
+            // ended before the checksum
+            state_ = State::WAIT_START;
+        }
+        else if (len_ == MAX_LINE_LEN)
+        {
+            ++stats_.overflow;
+
+            state_ = State::WAIT_START;
+        }
+        else if (state_ == State::DATA)
+        {
+            buf_[len_++] = c;
+
+            if (c == '*')
+            {
+                // the end of the last field
+                ++fieldCount_;
+                fieldStart_[fieldCount_] = len_;
+
+                state_ = State::CHECKSUM_HI;
+            }
+            else
+            {
+                checksumCalcd_ ^= (uint8_t)c;
+
+                if (c == ',')
+                {
+                    // leave room to close the last field at the '*'
+                    if (fieldCount_ + 1 < MAX_FIELDS)
+                    {
+                        ++fieldCount_;
+                        fieldStart_[fieldCount_] = len_;
+                    }
+                    else
+                    {
+                        ++stats_.overflow;
+
+                        state_ = State::WAIT_START;
+                    }
+                }
+            }
+        }
+        else
+        {
+            int8_t val = HexVal(c);
+
+            if (val == -1)
+            {
+                ++stats_.badChecksum;
+
+                state_ = State::WAIT_START;
+            }
+            else if (state_ == State::CHECKSUM_HI)
+            {
+                buf_[len_++] = c;
+
+                checksumRecvd_ = (uint8_t)(val << 4);
+
+                state_ = State::CHECKSUM_LO;
+            }
+            else
+            {
+                buf_[len_++] = c;
+
+                checksumRecvd_ |= (uint8_t)val;
+
+                if (checksumRecvd_ == checksumCalcd_)
+                {
+                    ++stats_.sentences;
+
+                    complete_ = true;
+                }
+                else
+                {
+                    ++stats_.badChecksum;
+                }
+
+                state_ = State::WAIT_START;
+            }
+        }
+    }
+
+    return complete_;
+}
+
+bool NMEATokenizer::Tokenize(string_view line)
+{
+    bool retVal = false;
+
+    if (line.size() && line[0] == '$')
+    {
+        for (char c : line)
+        {
+            retVal = Feed(c);
+        }
+    }
+    else
+    {
+        complete_ = false;
+    }
+
+    // not left part way through a sentence for the next
+    state_ = State::WAIT_START;
+
+    return retVal;
+}
+
+uint8_t NMEATokenizer::GetFieldCount() const
+{
+    return complete_ ? fieldCount_ : 0;
+}
+
+string_view NMEATokenizer::GetField(uint8_t idx) const
+{
+    string_view retVal;
+
+    if (idx < GetFieldCount())
+    {
+        // each field is followed by its ',' or the '*'
+        retVal = string_view{ &buf_[fieldStart_[idx]], (size_t)(fieldStart_[idx + 1] - fieldStart_[idx] - 1) };
+    }
+
+    return retVal;
+}
+
+string_view NMEATokenizer::GetLine() const
+{
+    return complete_ ? string_view{ buf_, len_ } : string_view{};
+}
+
+string_view NMEATokenizer::GetTalker() const
+{
+    string_view field = GetField(0);
+
+    return field.substr(0, 2);
+}
+
+string_view NMEATokenizer::GetMessageType() const
+{
+    string_view field = GetField(0);
+
+    return field.size() >= 3 ? field.substr(field.size() - 3) : field;
+}
+
+const NMEATokenizer::Stats &NMEATokenizer::GetStats() const
+{
+    return stats_;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Numeric Conversion
+////////////////////////////////////////////////////////////////////////////////
+
+bool NMEATokenizer::ToUInt(string_view str, uint32_t &val)
+{
+    bool retVal = str.size() != 0;
+
+    uint32_t valTmp = 0;
+    for (char c : str)
+    {
+        if (c >= '0' && c <= '9')
+        {
+            valTmp = (valTmp * 10) + (uint32_t)(c - '0');
+        }
+        else
+        {
+            retVal = false;
+
+            break;
+        }
+    }
+
+    if (retVal)
+    {
+        val = valTmp;
+    }
+
+    return retVal;
+}
+
+bool NMEATokenizer::ToFixed(string_view str, uint8_t decimals, int32_t &val)
+{
+    bool retVal = true;
+
+    bool isNegative = false;
+    if (str.size() && (str[0] == '-' || str[0] == '+'))
+    {
+        isNegative = str[0] == '-';
+
+        str.remove_prefix(1);
+    }
+
+    int64_t valTmp     = 0;
+    uint8_t digitCount = 0;
+    bool    seenDot    = false;
+    uint8_t places     = 0;
+
+    for (char c : str)
+    {
+        if (c >= '0' && c <= '9')
+        {
+            ++digitCount;
+
+            if (seenDot == false)
+            {
+                valTmp = (valTmp * 10) + (c - '0');
+            }
+            else if (places < decimals)
+            {
+                valTmp = (valTmp * 10) + (c - '0');
+                ++places;
+            }
+
+            // stop before it can overflow, the field is no good anyway
+            if (valTmp > INT32_MAX)
+            {
+                retVal = false;
+
+                break;
+            }
+        }
+        else if (c == '.' && seenDot == false)
+        {
+            seenDot = true;
+        }
+        else
+        {
+            retVal = false;
+
+            break;
+        }
+    }
+
+    if (retVal && digitCount)
+    {
+        // pad out to the requested places
+        for (; places < decimals && valTmp <= INT32_MAX; ++places)
+        {
+            valTmp *= 10;
+        }
+    }
+
+    if (retVal && digitCount && valTmp <= INT32_MAX)
+    {
+        val = (int32_t)(isNegative ? -valTmp : valTmp);
+    }
+    else
+    {
+        retVal = false;
+    }
+
+    return retVal;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+
+// Single-pass NMEA sentence tokenizer, fed a byte at a time (or a line).
+//
+// Format of a sentence:
+// $<data>*<CC>
+// CC is the 2-digit hex checksum of <data>, and <data> is comma separated
+// fields, the first being the talker and message type (eg GNRMC).
+//
+// The checksum is accumulated as bytes arrive, and field boundaries are
+// recorded as offsets into a fixed buffer, so nothing is allocated.
+// Fields are views into that buffer, valid until the next byte is fed.
+//
+// A '$' always starts a new sentence, anything before one is discarded, as
+// is a sentence which is too long, has too many fields, or has a bad
+// checksum.
+class NMEATokenizer
+{
+public:
+
+    static const uint8_t MAX_LINE_LEN   = 120;  // NMEA says 82, some talkers exceed it
+    static const uint8_t MAX_FIELDS     = 32;
+
+    // feed a byte, true when it completed a valid sentence, which stays
+    // available until the next byte is fed
+    bool Feed(char c);
+
+    // tokenize one whole sentence, no newlines, true if valid
+    bool Tokenize(std::string_view line);
+
+    // of the last valid sentence
+    uint8_t          GetFieldCount() const;
+    std::string_view GetField(uint8_t idx) const;   // empty if out of range
+    std::string_view GetLine() const;               // $ through checksum
+
+    std::string_view GetTalker() const;             // eg GN
+    std::string_view GetMessageType() const;        // eg RMC
+
+    struct Stats
+    {
+        uint32_t sentences   = 0;
+        uint32_t badChecksum = 0;
+        uint32_t overflow    = 0;
+    };
+
+    const Stats &GetStats() const;
+
+
+    // Numeric conversion of fields.
+    // Empty or malformed fields return false and leave val alone.
+
+    // unsigned whole number, eg "08"
+    static bool ToUInt(std::string_view str, uint32_t &val);
+
+    // signed decimal as fixed point with the given number of decimal
+    // places, eg "-18.15" with 2 -> -1815.  extra places are truncated.
+    // false if the result would not fit in an int32_t.
+    static bool ToFixed(std::string_view str, uint8_t decimals, int32_t &val);
+
+
+private:
+
+    enum class State : uint8_t
+    {
+        WAIT_START,
+        DATA,
+        CHECKSUM_HI,
+        CHECKSUM_LO,
+    };
+
+    State state_ = State::WAIT_START;
+
+    char    buf_[MAX_LINE_LEN];
+    uint8_t len_ = 0;
+
+    // buf_ offset of each field's first char, and one past the last field
+    uint8_t fieldStart_[MAX_FIELDS + 1];
+    uint8_t fieldCount_ = 0;
+
+    uint8_t checksumCalcd_ = 0;
+    uint8_t checksumRecvd_ = 0;
+
+    bool complete_ = false;
+
+    Stats stats_;
+};
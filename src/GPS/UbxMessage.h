@@ -2,21 +2,46 @@
 
 #include "UART.h"
 #include "Utl.h"
+#include "UtlEndian.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <span>
 
 
 /////////////////////////////////////////////////////////////////////
 // UbxMessageParser
 /////////////////////////////////////////////////////////////////////
 
+// Fed a byte at a time, finds a UBX frame:
+//
+// [0xB5 0x62] [class] [id] [len, 2 bytes LE] [payload] [ckA ckB]
+//
+// into a fixed buffer, so nothing is allocated however fast messages
+// arrive.  The buffer holds the largest message expected (NAV-SAT with a
+// full sky), larger ones are counted and dropped as an error.
+//
+// Once found, the message stays in place until Reset(), and can be read
+// without copying through a UbxView.
 class UbxMessageParser
 {
-    static const uint8_t DEFAULT_MAX_PAYLOAD_LIMIT = 100;
+public:
+    static const uint16_t NON_PAYLOAD_BYTES = 8;
+    static const uint16_t MAX_PAYLOAD_BYTES = 512;
+    static const uint16_t MAX_MSG_BYTES     = NON_PAYLOAD_BYTES + MAX_PAYLOAD_BYTES;
+
+    static const uint8_t IDX_CLASS   = 2;
+    static const uint8_t IDX_ID      = 3;
+    static const uint8_t IDX_SIZE    = 4;
+    static const uint8_t IDX_PAYLOAD = 6;
 
-    vector<uint8_t> buf_;
+private:
+
+    uint8_t  buf_[MAX_MSG_BYTES];
+    uint16_t len_        = 0;
     uint16_t stopAtSize_ = 0;
-    
+
     enum class State : uint8_t
     {
         LOOKING_FOR_HEADER = 0,
@@ -30,11 +55,13 @@ class UbxMessageParser
 
     State state_ = State::LOOKING_FOR_HEADER;
 
+    uint32_t countOversize_ = 0;
+
 
 public:
     void Reset()
     {
-        buf_.clear();
+        len_        = 0;
         stopAtSize_ = 0;
 
         state_ = State::LOOKING_FOR_HEADER;
@@ -55,6 +82,37 @@ public:
         }
     }
 
+    // Add as many of the bytes as are needed, stopping early when a
+    // message is found or an error hit, for the caller to handle and
+    // Reset() before adding the rest.  Returns the count used.
+    //
+    // Payload bytes are copied in a run, rather than a byte at a time
+    // through the state machine.
+    size_t AddBytes(std::span<const uint8_t> byteList)
+    {
+        size_t idx = 0;
+
+        while (idx < byteList.size() && state_ != State::FOUND && state_ != State::ERR)
+        {
+            if (state_ == State::LOOKING_FOR_CHECKSUM && len_ < stopAtSize_ - 2)
+            {
+                size_t count = std::min((size_t)(stopAtSize_ - 2 - len_), byteList.size() - idx);
+
+                memcpy(&buf_[len_], &byteList[idx], count);
+
+                len_ = (uint16_t)(len_ + count);
+                idx += count;
+            }
+            else
+            {
+                AddByteInternal(byteList[idx]);
+                ++idx;
+            }
+        }
+
+        return idx;
+    }
+
     bool ErrorEncountered() const
     {
         return state_ == State::ERR;
@@ -65,21 +123,38 @@ public:
         return state_ == State::FOUND;
     }
 
-    uint16_t GetClassId()
+    uint8_t GetClass() const
     {
-        uint16_t retVal = 0;
+        return MessageFound() ? buf_[IDX_CLASS] : 0;
+    }
 
-        if (MessageFound())
-        {
-            retVal = buf_[2] << 8 | buf_[3];
-        }
+    uint8_t GetId() const
+    {
+        return MessageFound() ? buf_[IDX_ID] : 0;
+    }
 
-        return retVal;
+    uint16_t GetClassId() const
+    {
+        return (uint16_t)(GetClass() << 8 | GetId());
+    }
+
+    // the whole message, sync bytes through checksum, once found
+    std::span<const uint8_t> GetData() const
+    {
+        return { buf_, MessageFound() ? len_ : (uint16_t)0 };
+    }
+
+    std::span<const uint8_t> GetPayload() const
+    {
+        return MessageFound() ?
+            std::span<const uint8_t>{ &buf_[IDX_PAYLOAD], (size_t)(len_ - NON_PAYLOAD_BYTES) } :
+            std::span<const uint8_t>{};
     }
 
-    const vector<uint8_t> &GetData() const
+    // messages dropped for having a payload beyond MAX_PAYLOAD_BYTES
+    uint32_t GetOversizeCount() const
     {
-        return buf_;
+        return countOversize_;
     }
         
 
@@ -89,83 +164,68 @@ private:
     {
         if (state_ == State::LOOKING_FOR_HEADER)
         {
-            // Log("LOOKING_FOR_HEADER");
-            
-            // store this byte
-            buf_.push_back(b);
-
-            // check if we received a byte previously
-            // need 2 to match header
-            if (buf_.size() == 1)
+            if (len_ == 0)
+            {
+                // wait for the first sync byte
+                if (b == 0xB5)
+                {
+                    buf_[len_++] = b;
+                }
+            }
+            else if (b == 0x62)
             {
-                // nope, leave that byte stored and carry on
+                buf_[len_++] = b;
+
+                state_ = State::LOOKING_FOR_CLASS;
             }
             else
             {
-                // yup, check if this is a valid header now
-                if (buf_[0] == 0xB5 && buf_[1] == 0x62)
-                {
-                    // yup, move to next state
-                    state_ = State::LOOKING_FOR_CLASS;
-                }
-                else
+                // nope, maybe the last byte that came in is the start
+                len_ = 0;
+                if (b == 0xB5)
                 {
-                    // Log("    discarding ", ToHex(buf_[0]));
-                    
-                    // nope, maybe the last byte that came in is the start,
-                    // shift it to the start and carry on
-                    buf_.erase(buf_.begin());
+                    buf_[len_++] = b;
                 }
             }
         }
         else if (state_ == State::LOOKING_FOR_CLASS)
         {
-            // Log("LOOKING_FOR_CLASS");
-
-            buf_.push_back(b);
-            
-            // Log("    class: ", ToHex(b));
+            buf_[len_++] = b;
 
             state_ = State::LOOKING_FOR_ID;
         }
         else if (state_ == State::LOOKING_FOR_ID)
         {
-            // Log("LOOKING_FOR_ID");
-
-            buf_.push_back(b);
-
-            // Log("       id: ", ToHex(b));
+            buf_[len_++] = b;
 
             state_ = State::LOOKING_FOR_LEN;
         }
         else if (state_ == State::LOOKING_FOR_LEN)
         {
-            // Log("LOOKING_FOR_LEN");
-            
-            buf_.push_back(b);
+            buf_[len_++] = b;
 
-            if (buf_.size() == 6)
+            if (len_ == IDX_PAYLOAD)
             {
-                // we have the full size
-                // we want to go from little endian wire format to host endian
-                // start by making a network-byte-order 16-bit int, aka big endian
-                uint16_t lenBigEndian;
-                char *p = (char *)&lenBigEndian;
-                p[0] = buf_[5];
-                p[1] = buf_[4];
-
-                uint16_t len = ntohs(lenBigEndian);
-
-                // Log("    lenBigEndian: ", lenBigEndian);
-                // Log("    len         : ", len);
-
+                // we have the full size, little endian on the wire.
                 // length refers to the payload only
                 // total message size is:
-                //   [2 sync bytes + 1 class byte + 1 id byte] + payload + [2 crc bytes]
-                // the current buffer has the 2 sync bytes and class and id bytes
-                stopAtSize_ = buf_.size() + len + 2;
+                //   [2 sync bytes + 1 class byte + 1 id byte + 2 len bytes] + payload + [2 crc bytes]
+                uint16_t lenLe;
+                memcpy(&lenLe, &buf_[IDX_SIZE], sizeof(lenLe));
+                uint16_t len = ltohs(lenLe);
+
+                if (len <= MAX_PAYLOAD_BYTES)
+                {
+                    stopAtSize_ = (uint16_t)(NON_PAYLOAD_BYTES + len);
+
+                    state_ = State::LOOKING_FOR_CHECKSUM;
+                }
+                else
+                {
+                    ++countOversize_;
 
-                state_ = State::LOOKING_FOR_CHECKSUM;
+                    state_ = State::ERR;
+                }
             }
             else
             {
@@ -174,56 +234,323 @@ private:
         }
         else if (state_ == State::LOOKING_FOR_CHECKSUM)
         {
-            // Log("LOOKING_FOR_CHECKSUM");
-            
-            buf_.push_back(b);
+            buf_[len_++] = b;
 
-            if (buf_.size() == stopAtSize_)
+            if (len_ == stopAtSize_)
             {
-                // Time to calculate and compare the checksum
-                uint8_t ckA = 0;
-                uint8_t ckB = 0;
+                CheckChecksum();
+            }
+        }
+        else
+        {
+            // nothing to do, done or error state
+        }
+    }
 
-                // checksum class, id, length, payload
-                uint8_t idxChecksumStart = buf_.size() - 2;
-                for (uint8_t i = 2; i < idxChecksumStart; ++i)
-                {
-                    uint8_t b = buf_[i];
-                    
-                    ckA += b;
-                    ckB += ckA;
-                }
+    void CheckChecksum()
+    {
+        // checksum class, id, length, payload
+        uint8_t ckA = 0;
+        uint8_t ckB = 0;
 
-                // extract the message checksum
-                uint8_t msgCkA = buf_[idxChecksumStart + 0];
-                uint8_t msgCkB = buf_[idxChecksumStart + 1];
+        uint16_t idxChecksumStart = (uint16_t)(len_ - 2);
+        for (uint16_t i = IDX_CLASS; i < idxChecksumStart; ++i)
+        {
+            ckA = (uint8_t)(ckA + buf_[i]);
+            ckB = (uint8_t)(ckB + ckA);
+        }
 
-                // Log("ckA, ckB: ", ckA, " ", ckB);
-                // Log("msgCkA, msgCkB: ", msgCkA, " ", msgCkB);
+        if (ckA == buf_[idxChecksumStart + 0] && ckB == buf_[idxChecksumStart + 1])
+        {
+            // success
+            state_ = State::FOUND;
+        }
+        else
+        {
+            state_ = State::ERR;
+        }
+    }
+};
 
-                // LogBlob(buf_.data(), buf_.size());
 
-                if (ckA == msgCkA && ckB == msgCkB)
-                {
-                    // success
-                    state_ = State::FOUND;
-                }
-                else
-                {
-                    // Log("Checksum failed");
-                    state_ = State::ERR;
-                }
-            }
-            else
-            {
-                // Nothing to do, just pile on bytes until reaching the checksum
-            }
+/////////////////////////////////////////////////////////////////////
+// UbxView - zero-copy typed access to a parsed message
+/////////////////////////////////////////////////////////////////////
+
+// A little endian field of a UBX payload.
+//
+// Stored as bytes, so a struct made of these has no padding and an
+// alignment of 1, and can be laid directly over the parser's buffer,
+// wherever in it the payload lands.  Reads go through memcpy (so no
+// unaligned word loads, which fault on the M0+) and the UtlEndian
+// conversions.
+template <typename T>
+struct UbxLE
+{
+    static_assert(sizeof(T) == 2 || sizeof(T) == 4);
+
+    uint8_t byteList[sizeof(T)];
+
+    T Get() const
+    {
+        T retVal;
+
+        if constexpr (sizeof(T) == 2)
+        {
+            uint16_t val;
+            memcpy(&val, byteList, sizeof(val));
+            val = ltohs(val);
+            memcpy(&retVal, &val, sizeof(retVal));
         }
         else
         {
-            // nothing to do, done or error state
+            uint32_t val;
+            memcpy(&val, byteList, sizeof(val));
+            val = ltohl(val);
+            memcpy(&retVal, &val, sizeof(retVal));
         }
+
+        return retVal;
+    }
+
+    operator T() const
+    {
+        return Get();
+    }
+};
+
+using UbxU1 = uint8_t;
+using UbxI1 = int8_t;
+using UbxU2 = UbxLE<uint16_t>;
+using UbxI2 = UbxLE<int16_t>;
+using UbxU4 = UbxLE<uint32_t>;
+using UbxI4 = UbxLE<int32_t>;
+
+
+// Typed view of the message in a parser, when it is of type T.
+//
+// T is a payload overlay, giving its CLASS, ID, and fixed PAYLOAD_BYTES,
+// and for messages with a repeated section, a Block overlay for it.
+// The view is only valid until the parser is Reset() or fed more.
+//
+//   UbxView<UbxNavPvt> pvt(parser);
+//   if (pvt.Ok()) { int32_t lat = pvt->lat; }
+template <typename T>
+class UbxView
+{
+    static_assert(alignof(T) == 1, "payload overlays must be made of UbxLE / byte fields");
+    static_assert(sizeof(T) == T::PAYLOAD_BYTES, "payload overlay does not match its size");
+
+public:
+
+    UbxView(const UbxMessageParser &p)
+    {
+        if (p.GetClass() == T::CLASS && p.GetId() == T::ID)
+        {
+            std::span<const uint8_t> payload = p.GetPayload();
+
+            if (payload.size() == T::PAYLOAD_BYTES)
+            {
+                p_ = payload.data();
+            }
+            else if constexpr (HasBlock<T>)
+            {
+                size_t blockBytes = payload.size() - T::PAYLOAD_BYTES;
+
+                if (payload.size() > T::PAYLOAD_BYTES && blockBytes % sizeof(typename T::Block) == 0)
+                {
+                    p_ = payload.data();
+                    blockCount_ = (uint16_t)(blockBytes / sizeof(typename T::Block));
+                }
+            }
+        }
+    }
+
+    bool Ok() const
+    {
+        return p_ != nullptr;
+    }
+
+    const T *operator->() const
+    {
+        return (const T *)p_;
+    }
+
+    const T &Get() const
+    {
+        return *(const T *)p_;
+    }
+
+    uint16_t GetBlockCount() const
+    {
+        return blockCount_;
+    }
+
+    template <typename U = T>
+    const typename U::Block &GetBlock(uint16_t idx) const
+    {
+        return ((const typename U::Block *)&p_[T::PAYLOAD_BYTES])[idx];
     }
+
+private:
+
+    template <typename U>
+    static constexpr bool HasBlock = requires { typename U::Block; };
+
+    const uint8_t *p_ = nullptr;
+    uint16_t blockCount_ = 0;
+};
+
+
+/////////////////////////////////////////////////////////////////////
+// Payload overlays, for UbxView
+/////////////////////////////////////////////////////////////////////
+
+// ACK-ACK - 0x05 0x01
+struct UbxAckAck
+{
+    static const uint8_t  CLASS = 0x05;
+    static const uint8_t  ID    = 0x01;
+    static const uint16_t PAYLOAD_BYTES = 2;
+
+    UbxU1 clsId;
+    UbxU1 msgId;
+
+    uint16_t GetClassId() const { return (uint16_t)(clsId << 8 | msgId); }
+};
+
+// ACK-NAK - 0x05 0x00
+struct UbxAckNak
+: public UbxAckAck
+{
+    static const uint8_t ID = 0x00;
+};
+
+// NAV-PVT - 0x01 0x07 (navigation solution, time, position, velocity)
+struct UbxNavPvt
+{
+    static const uint8_t  CLASS = 0x01;
+    static const uint8_t  ID    = 0x07;
+    static const uint16_t PAYLOAD_BYTES = 92;
+
+    // valid bits
+    static const uint8_t VALID_DATE      = 0b0000'0001;
+    static const uint8_t VALID_TIME      = 0b0000'0010;
+    static const uint8_t FULLY_RESOLVED  = 0b0000'0100;
+
+    // flags bits
+    static const uint8_t FLAG_GNSS_FIX_OK = 0b0000'0001;
+
+    // fixType values
+    static const uint8_t FIX_NONE     = 0;
+    static const uint8_t FIX_DR       = 1;
+    static const uint8_t FIX_2D       = 2;
+    static const uint8_t FIX_3D       = 3;
+    static const uint8_t FIX_GNSS_DR  = 4;
+    static const uint8_t FIX_TIME     = 5;
+
+    UbxU4 iTOW;         // ms, GPS time of week of the navigation epoch
+    UbxU2 year;         // UTC
+    UbxU1 month;
+    UbxU1 day;
+    UbxU1 hour;
+    UbxU1 min;
+    UbxU1 sec;
+    UbxU1 valid;
+    UbxU4 tAcc;         // ns
+    UbxI4 nano;         // ns, fraction of second, -1e9..1e9
+    UbxU1 fixType;
+    UbxU1 flags;
+    UbxU1 flags2;
+    UbxU1 numSV;
+    UbxI4 lon;          // deg * 1e-7
+    UbxI4 lat;          // deg * 1e-7
+    UbxI4 height;       // mm above ellipsoid
+    UbxI4 hMSL;         // mm above mean sea level
+    UbxU4 hAcc;         // mm
+    UbxU4 vAcc;         // mm
+    UbxI4 velN;         // mm/s
+    UbxI4 velE;         // mm/s
+    UbxI4 velD;         // mm/s
+    UbxI4 gSpeed;       // mm/s, 2D ground speed
+    UbxI4 headMot;      // deg * 1e-5, 2D heading of motion
+    UbxU4 sAcc;         // mm/s
+    UbxU4 headAcc;      // deg * 1e-5
+    UbxU2 pDOP;         // * 0.01
+    UbxU1 reserved1[6];
+    UbxI4 headVeh;      // deg * 1e-5
+    UbxI2 magDec;       // deg * 1e-2
+    UbxU2 magAcc;       // deg * 1e-2
+};
+
+// NAV-DOP - 0x01 0x04 (dilution of precision)
+struct UbxNavDop
+{
+    static const uint8_t  CLASS = 0x01;
+    static const uint8_t  ID    = 0x04;
+    static const uint16_t PAYLOAD_BYTES = 18;
+
+    UbxU4 iTOW;         // ms
+    UbxU2 gDOP;         // * 0.01, geometric
+    UbxU2 pDOP;         // * 0.01, position
+    UbxU2 tDOP;         // * 0.01, time
+    UbxU2 vDOP;         // * 0.01, vertical
+    UbxU2 hDOP;         // * 0.01, horizontal
+    UbxU2 nDOP;         // * 0.01, northing
+    UbxU2 eDOP;         // * 0.01, easting
+};
+
+// NAV-SAT - 0x01 0x35 (satellite information), a Block per satellite
+struct UbxNavSat
+{
+    static const uint8_t  CLASS = 0x01;
+    static const uint8_t  ID    = 0x35;
+    static const uint16_t PAYLOAD_BYTES = 8;
+
+    UbxU4 iTOW;         // ms
+    UbxU1 version;
+    UbxU1 numSvs;
+    UbxU1 reserved1[2];
+
+    struct Block
+    {
+        // gnssId values
+        static const uint8_t GNSS_GPS     = 0;
+        static const uint8_t GNSS_SBAS    = 1;
+        static const uint8_t GNSS_GALILEO = 2;
+        static const uint8_t GNSS_BEIDOU  = 3;
+        static const uint8_t GNSS_IMES    = 4;
+        static const uint8_t GNSS_QZSS    = 5;
+        static const uint8_t GNSS_GLONASS = 6;
+
+        // flags bits
+        static const uint32_t FLAG_QUALITY_MASK = 0b0000'0111;
+        static const uint32_t FLAG_SV_USED      = 0b0000'1000;
+
+        UbxU1 gnssId;
+        UbxU1 svId;
+        UbxU1 cno;      // dBHz
+        UbxI1 elev;     // deg, -90..90
+        UbxI2 azim;     // deg, 0..360
+        UbxI2 prRes;    // m * 0.1
+        UbxU4 flags;
+    };
+    static_assert(sizeof(Block) == 12);
+};
+
+// TIM-TP - 0x0D 0x01 (time pulse time data, for the next pulse)
+struct UbxTimTp
+{
+    static const uint8_t  CLASS = 0x0D;
+    static const uint8_t  ID    = 0x01;
+    static const uint16_t PAYLOAD_BYTES = 16;
+
+    UbxU4 towMS;        // ms, time of week of the next pulse
+    UbxU4 towSubMS;     // ms * 2^-32
+    UbxI4 qErr;         // ps, quantization error of the pulse
+    UbxU2 week;         // weeks
+    UbxU1 flags;
+    UbxU1 refInfo;
 };
 
 
@@ -274,23 +601,16 @@ public:
 
     bool SetMsgData(const uint8_t *buf, uint8_t bufSize)
     {
-        vector<uint8_t> val;
-
-        for (int i = 0; i < (int)bufSize; ++i)
-        {
-            val.push_back(buf[i]);
-        }
-
-        return SetMsgData(val);
+        return SetMsgData(std::span<const uint8_t>{ buf, bufSize });
     }
 
-    bool SetMsgData(const vector<uint8_t> &byteList)
+    bool SetMsgData(std::span<const uint8_t> byteList)
     {
         Reset();
 
         if (MessageValid(byteList))
         {
-            byteList_ = byteList;
+            std::copy(byteList.begin(), byteList.end(), byteList_.begin());
             beenSet_ = true;
         }
 
@@ -320,7 +640,8 @@ public:
         byteList_[IDX_ID]    = T::ID;
 
         // Set up size
-        *(uint16_t *)&byteList_.data()[IDX_SIZE] = htols(T::PAYLOAD_BYTES);
+        uint16_t size = htols(T::PAYLOAD_BYTES);
+        memcpy(&byteList_.data()[IDX_SIZE], &size, sizeof(size));
 
         // calculate and compare the checksum
         uint8_t ckA = 0;
@@ -365,15 +686,14 @@ public:
     // Fast ID of a valid message being this particular type
     static bool MessageValid(const UbxMessageParser &p)
     {
-        const vector<uint8_t> &byteList = p.GetData();
-
         return p.MessageFound() &&
-               byteList[IDX_CLASS] == T::CLASS && 
-               byteList[IDX_ID]    == T::ID;
+               p.GetClass() == T::CLASS && 
+               p.GetId()    == T::ID &&
+               p.GetData().size() == TOTAL_BYTES;
     }
 
     // Slow validation
-    static bool MessageValid(const vector<uint8_t> &byteList)
+    static bool MessageValid(std::span<const uint8_t> byteList)
     {
         bool retVal = false;
 
@@ -383,12 +703,7 @@ public:
             {
                 UbxMessageParser p;
 
-                for (int i = 0; i < (int)byteList.size(); ++i)
-                {
-                    p.AddByte(byteList[i]);
-                }
-
-                retVal = p.MessageFound();
+                retVal = p.AddBytes(byteList) == byteList.size() && p.MessageFound();
             }
         }
 
@@ -438,12 +753,16 @@ protected:
     //
     uint16_t GetU2AtIdx(uint8_t idx)
     {
-        return ltohs(*(uint16_t *)&GetPayloadData()[idx]);
+        uint16_t val;
+        memcpy(&val, &GetPayloadData()[idx], sizeof(val));
+
+        return ltohs(val);
     }
 
     void SetU2AtIdx(uint8_t idx, uint16_t val)
     {
-        *(uint16_t *)&GetPayloadData()[idx] = htols(val);
+        val = htols(val);
+        memcpy(&GetPayloadData()[idx], &val, sizeof(val));
     }
 
     int16_t GetI2AtIdx(uint8_t idx)
@@ -462,12 +781,16 @@ protected:
     //
     uint32_t GetU4AtIdx(uint8_t idx)
     {
-        return ltohl(*(uint32_t *)&GetPayloadData()[idx]);
+        uint32_t val;
+        memcpy(&val, &GetPayloadData()[idx], sizeof(val));
+
+        return ltohl(val);
     }
 
     void SetU4AtIdx(uint8_t idx, uint32_t val)
     {
-        *(uint32_t *)&GetPayloadData()[idx] = htoll(val);
+        val = htoll(val);
+        memcpy(&GetPayloadData()[idx], &val, sizeof(val));
     }
 
     int32_t GetI4AtIdx(uint8_t idx)
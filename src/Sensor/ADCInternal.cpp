@@ -1,4 +1,5 @@
 #include "ADCInternal.h"
+#include "ADCSampler.h"
 #include "Log.h"
 #include "PAL.h"
 #include "Shell.h"
@@ -10,6 +11,7 @@
 #include "pico/cyw43_arch.h"
 #endif
 
+#include <algorithm>
 #include <string>
 #include <vector>
 using namespace std;
@@ -45,21 +47,20 @@ uint16_t ADC::GetMilliVolts()
 // raw 12-bit value
 uint16_t ADC::Read(uint8_t pin)
 {
-    adc_gpio_init(pin);
+    uint8_t input = GetInputFromPin(pin);
 
-    return InputRead(GetInputFromPin(pin));
+    if (ADCSampler::IsReady(input) == false)
+    {
+        adc_gpio_init(pin);
+    }
+
+    return SamplerRead(input);
 }
 
 // raw converted to mv, assuming 3.3v reference
 uint16_t ADC::GetMilliVolts(uint8_t pin)
 {
-    uint16_t rawVal = Read(pin);
-
-    // 12-bit, so out of 4096
-    // referencing a 3.3v internal voltage
-    uint16_t retVal = (uint16_t)(((uint32_t)rawVal * 3300) / 4096);
-
-    return retVal;
+    return RawToMilliVolts(Read(pin));
 }
 
 
@@ -78,14 +79,30 @@ uint16_t ADC::GetMilliVoltsVCC()
         // Make sure cyw43 is awake
         cyw43_arch_gpio_get(CYW43_WL_GPIO_VBUS_PIN);
     }
-#endif
 
-    retVal = GetMilliVolts(PICO_VSYS_PIN) * 3;
-    
-#ifdef PICO_W
+    // the VSYS pin is shared with the wireless chip, so can only be read
+    // while holding it, which rules out sampling it in the background.
+    // pause the sampler around a foreground read.
+    uint8_t  inputMask    = ADCSampler::GetInputMask();
+    bool     wasRunning   = ADCSampler::IsRunning();
+    uint32_t sampleRate   = ADCSampler::GetSampleRate();
+    uint16_t averageCount = ADCSampler::GetAverageCount();
+
+    ADCSampler::Stop();
+
+    adc_gpio_init(PICO_VSYS_PIN);
+    retVal = RawToMilliVolts(InputRead(GetInputFromPin(PICO_VSYS_PIN))) * 3;
+
+    if (wasRunning)
+    {
+        ADCSampler::Start(inputMask, sampleRate, averageCount);
+    }
+
     {
         cyw43_thread_exit();
     }
+#else
+    retVal = GetMilliVolts(PICO_VSYS_PIN) * 3;
 #endif
 
     return retVal;
@@ -93,7 +110,7 @@ uint16_t ADC::GetMilliVoltsVCC()
 
 uint16_t ADC::ReadTemperature()
 {
-    return InputRead(4);
+    return SamplerRead(ADCSampler::INPUT_TEMP);
 }
 
 
@@ -150,6 +167,9 @@ void ADC::Init()
 
     adc_init();
     adc_set_temp_sensor_enabled(true);
+
+    // the sampler is started by the first read, so costs nothing (DMA
+    // channels, interrupts) in applications which don't read
 }
 
 void ADC::SetupShell()
@@ -191,6 +211,60 @@ uint8_t ADC::GetInputFromPin(uint8_t pin)
     return retVal;
 }
 
+uint16_t ADC::RawToMilliVolts(uint16_t raw)
+{
+    // 12-bit, so out of 4096
+    // referencing a 3.3v internal voltage
+    uint16_t retVal = (uint16_t)(((uint32_t)raw * 3300) / 4096);
+
+    return retVal;
+}
+
+uint16_t ADC::SamplerRead(uint8_t input)
+{
+    if (ADCSampler::IsReady(input) == false)
+    {
+        // keeping to any rate set from the shell
+        bool     running      = ADCSampler::IsRunning();
+        uint8_t  inputMask    = ADCSampler::GetInputMask() | (uint8_t)(1 << input);
+        uint32_t sampleRate   = running ? ADCSampler::GetSampleRate()   : SAMPLE_RATE;
+        uint16_t averageCount = running ? ADCSampler::GetAverageCount() : AVERAGE_COUNT;
+
+        // fewer averaged if another input doesn't fit the buffer, rather
+        // than the sampler being left stopped
+        uint8_t inputCount = 0;
+        for (uint8_t i = 0; i < ADCSampler::INPUT_COUNT; ++i)
+        {
+            inputCount += (inputMask >> i) & 1;
+        }
+        averageCount = min(averageCount, (uint16_t)(ADCSampler::BUF_SAMPLES / inputCount));
+
+        if (ADCSampler::Start(inputMask, sampleRate, averageCount))
+        {
+            // first average is a couple of blocks away
+            uint64_t timeTimeoutUs = PAL.Micros() + FIRST_READ_TIMEOUT_MS * 1'000;
+            while (ADCSampler::IsReady(input) == false && PAL.Micros() < timeTimeoutUs)
+            {
+                // wait
+            }
+        }
+    }
+
+    uint16_t retVal = 0;
+
+    if (ADCSampler::IsReady(input))
+    {
+        retVal = ADCSampler::GetLatest(input);
+    }
+    else if (ADCSampler::IsRunning() == false)
+    {
+        // sampler couldn't start, eg no DMA channels
+        retVal = InputRead(input);
+    }
+
+    return retVal;
+}
+
 // adapted from power_status.c in pico-examples read_vsys.
 // discarding samples was originally only part of reading 
 // vcc, but I'm applying it to all channels because why not.
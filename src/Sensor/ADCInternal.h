@@ -3,12 +3,24 @@
 #include <cstdint>
 
 
+// Reads come from ADCSampler, which samples in the background, so they
+// return the latest average straight away.  Reading a pin (or the
+// temperature) for the first time sets it up for analog use and adds it to
+// what's sampled, starting the sampler if need be, which waits for the
+// first average.  If the sampler can't be started, each read samples in
+// the foreground, blocking.
 class ADC
 {
 private:
     static const uint8_t PICO_FIRST_ADC_PIN = 26;
     static const uint8_t PICO_POWER_SAMPLE_COUNT = 100;
 
+    // samples/sec across all sampled inputs, and samples of each averaged
+    static const uint32_t SAMPLE_RATE   = 4'000;
+    static const uint16_t AVERAGE_COUNT = 32;
+
+    static const uint32_t FIRST_READ_TIMEOUT_MS = 250;
+
 
 public:
 
@@ -70,6 +82,11 @@ private:
 
     static uint8_t GetInputFromPin(uint8_t pin);
 
+    static uint16_t RawToMilliVolts(uint16_t raw);
+
+    // from the sampler, adding the input to it if not already there
+    static uint16_t SamplerRead(uint8_t input);
+
     // adapted from power_status.c in pico-examples read_vsys.
     // discarding samples was originally only part of reading 
     // vcc, but I'm applying it to all channels because why not.
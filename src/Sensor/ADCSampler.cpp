@@ -0,0 +1,373 @@
+#include "ADCSampler.h"
+#include "Evm.h"
+#include "KTime.h"
+#include "Log.h"
+#include "PAL.h"
+#include "Shell.h"
+#include "Timeline.h"
+#include "Utl.h"
+
+#include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "StrictMode.h"
+
+
+static ADCSampler::Stats stats_;
+
+
+/////////////////////////////////////////////////////////////////
+// Control
+/////////////////////////////////////////////////////////////////
+
+bool ADCSampler::Start(uint8_t inputMask, uint32_t sampleRate, uint16_t averageCount)
+{
+    bool wasRunning = running_;
+
+    Stop();
+
+    // the inputs, in the order round-robin visits them
+    uint8_t inputCount = 0;
+    for (uint8_t input = 0; input < INPUT_COUNT; ++input)
+    {
+        if (inputMask & (1 << input))
+        {
+            inputList_[inputCount] = input;
+            ++inputCount;
+        }
+    }
+
+    if (inputCount == 0 || (inputMask >> INPUT_COUNT) || averageCount == 0 ||
+        (uint32_t)inputCount * averageCount > BUF_SAMPLES)
+    {
+        return false;
+    }
+
+    // a conversion every (1 + div) cycles of clk_adc, but no sooner than
+    // every 96.  clk_adc is usually 48 MHz from pll_usb, but can be on
+    // pll_sys, so is asked for.
+    uint32_t adcClockHz = clock_get_hz(clk_adc);
+    if (sampleRate == 0)
+    {
+        return false;
+    }
+    uint32_t div = (adcClockHz + sampleRate / 2) / sampleRate;
+    if (div < 96 || div > 0x10000)
+    {
+        return false;
+    }
+
+    for (auto &dmaChannel : dmaChannelList_)
+    {
+        dmaChannel = (int8_t)dma_claim_unused_channel(false);
+    }
+    if (dmaChannelList_[0] == -1 || dmaChannelList_[1] == -1)
+    {
+        Stop();
+
+        return false;
+    }
+
+    static bool irqInit = false;
+    if (!irqInit)
+    {
+        irq_add_shared_handler(DMA_IRQ_0, DmaInterruptHandler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+
+        // clk_adc follows the system clock when on pll_sys
+        KTime::RegisterCallbackScalingFactorChange([]{
+            OnClockChange();
+        });
+
+        irqInit = true;
+    }
+
+    inputMask_       = inputMask;
+    inputCount_      = inputCount;
+    averageCount_    = averageCount;
+    blockSamples_    = (uint16_t)(inputCount * averageCount);
+    sampleRateAsked_ = sampleRate;
+    sampleRate_      = adcClockHz / div;
+
+    {
+        IrqLock lock;
+
+        // what was being sampled until now stays readable
+        readyMask_    = wasRunning ? readyMask_ & inputMask : 0;
+        discardCount_ = 1;
+    }
+
+    if (inputMask & (1 << INPUT_TEMP))
+    {
+        adc_set_temp_sensor_enabled(true);
+    }
+
+    // start from the lowest input, so each buffer starts with it
+    adc_select_input(inputList_[0]);
+    adc_set_round_robin(inputMask);
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_set_clkdiv((float)(div - 1));
+    adc_fifo_drain();
+
+    // each a buffer of samples from the FIFO, paced by it, then on to the
+    // other buffer
+    for (uint8_t i = 0; i < 2; ++i)
+    {
+        uint dmaChannel      = (uint)dmaChannelList_[i];
+        uint dmaChannelOther = (uint)dmaChannelList_[i ^ 1];
+
+        dma_channel_config cfg = dma_channel_get_default_config(dmaChannel);
+        channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+        channel_config_set_read_increment(&cfg, false);
+        channel_config_set_write_increment(&cfg, true);
+        channel_config_set_dreq(&cfg, DREQ_ADC);
+        channel_config_set_chain_to(&cfg, dmaChannelOther);
+
+        dma_channel_configure(dmaChannel,
+                              &cfg,
+                              bufList_[i],
+                              &adc_hw->fifo,
+                              blockSamples_,
+                              false);
+
+        dma_channel_set_irq0_enabled(dmaChannel, true);
+    }
+
+    running_ = true;
+
+    dma_channel_start((uint)dmaChannelList_[0]);
+    adc_run(true);
+
+    return true;
+}
+
+void ADCSampler::Stop()
+{
+    if (running_)
+    {
+        adc_run(false);
+        adc_set_round_robin(0);
+        adc_fifo_setup(false, false, 0, false, false);
+    }
+
+    running_ = false;
+
+    // unchain before aborting, else an abort can set off the other channel
+    for (auto &dmaChannel : dmaChannelList_)
+    {
+        if (dmaChannel != -1)
+        {
+            dma_channel_set_irq0_enabled((uint)dmaChannel, false);
+
+            dma_channel_config cfg = dma_get_channel_config((uint)dmaChannel);
+            channel_config_set_chain_to(&cfg, (uint)dmaChannel);
+            dma_channel_set_config((uint)dmaChannel, &cfg, false);
+        }
+    }
+    for (auto &dmaChannel : dmaChannelList_)
+    {
+        if (dmaChannel != -1)
+        {
+            dma_channel_abort((uint)dmaChannel);
+            dma_channel_acknowledge_irq0((uint)dmaChannel);
+            dma_channel_unclaim((uint)dmaChannel);
+
+            dmaChannel = -1;
+        }
+    }
+
+    adc_fifo_drain();
+}
+
+bool ADCSampler::IsRunning()
+{
+    return running_;
+}
+
+uint8_t ADCSampler::GetInputMask()
+{
+    return inputMask_;
+}
+
+uint16_t ADCSampler::GetAverageCount()
+{
+    return averageCount_;
+}
+
+uint32_t ADCSampler::GetSampleRate()
+{
+    return sampleRate_;
+}
+
+// The divider worked out again for the rate asked for, as near as the new
+// clock allows.
+void ADCSampler::OnClockChange()
+{
+    if (running_)
+    {
+        uint32_t adcClockHz = clock_get_hz(clk_adc);
+        uint32_t div        = (adcClockHz + sampleRateAsked_ / 2) / sampleRateAsked_;
+        div = clamp(div, (uint32_t)96, (uint32_t)0x10000);
+
+        adc_set_clkdiv((float)(div - 1));
+
+        sampleRate_ = adcClockHz / div;
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Reading
+/////////////////////////////////////////////////////////////////
+
+bool ADCSampler::IsReady(uint8_t input)
+{
+    return running_ && input < INPUT_COUNT && (readyMask_ & (1 << input));
+}
+
+uint16_t ADCSampler::GetLatest(uint8_t input)
+{
+    return IsReady(input) ? latestList_[input] : 0;
+}
+
+void ADCSampler::SetCallbackOnBlock(FnBlock fnBlock)
+{
+    fnBlock_ = fnBlock;
+}
+
+const ADCSampler::Stats &ADCSampler::GetStats()
+{
+    return stats_;
+}
+
+
+/////////////////////////////////////////////////////////////////
+// DMA IRQ
+/////////////////////////////////////////////////////////////////
+
+// The other buffer is already filling, by chaining.  Point this one's
+// channel back at the start of its buffer, ready for when it's chained to
+// next, and average what's in it.
+void ADCSampler::OnDmaComplete(uint8_t bufIdx)
+{
+    uint64_t timeStartUs = PAL.Micros();
+
+    dma_channel_set_write_addr((uint)dmaChannelList_[bufIdx], bufList_[bufIdx], false);
+
+    if (discardCount_)
+    {
+        discardCount_ = discardCount_ - 1;
+
+        return;
+    }
+
+    uint32_t sumList[INPUT_COUNT] = {};
+
+    const uint16_t *p = bufList_[bufIdx];
+    for (uint16_t i = 0; i < averageCount_; ++i)
+    {
+        for (uint8_t j = 0; j < inputCount_; ++j)
+        {
+            sumList[j] += *p;
+            ++p;
+        }
+    }
+
+    for (uint8_t j = 0; j < inputCount_; ++j)
+    {
+        latestList_[inputList_[j]] = (uint16_t)((sumList[j] + averageCount_ / 2) / averageCount_);
+    }
+    readyMask_ = readyMask_ | inputMask_;
+
+    ++stats_.blocks;
+    blockSeq_ = blockSeq_ + 1;
+
+    if (fnBlock_)
+    {
+        uint32_t seq = blockSeq_;
+
+        Evm::QueueWork("ADCSampler::OnBlock", [bufIdx, seq]{
+            // refilled since, or stopped
+            if (blockSeq_ != seq || running_ == false)
+            {
+                ++stats_.blocksLate;
+            }
+            else if (fnBlock_)
+            {
+                fnBlock_(bufList_[bufIdx], blockSamples_);
+            }
+        });
+    }
+
+    stats_.isrUsMax = max(stats_.isrUsMax, (uint32_t)(PAL.Micros() - timeStartUs));
+}
+
+void ADCSampler::DmaInterruptHandler()
+{
+    if (running_)
+    {
+        for (uint8_t i = 0; i < 2; ++i)
+        {
+            uint dmaChannel = (uint)dmaChannelList_[i];
+
+            if (dma_channel_get_irq0_status(dmaChannel))
+            {
+                dma_channel_acknowledge_irq0(dmaChannel);
+
+                OnDmaComplete(i);
+            }
+        }
+    }
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Shell
+/////////////////////////////////////////////////////////////////
+
+void ADCSampler::SetupShell()
+{
+    Timeline::Global().Event("ADCSampler::SetupShell");
+
+    Shell::AddCommand("adc.sampler.start", [](vector<string> argList){
+        uint8_t  inputMask    = (uint8_t)strtoul(argList[0].c_str(), nullptr, 0);
+        uint32_t sampleRate   = (uint32_t)atoi(argList[1].c_str());
+        uint16_t averageCount = (uint16_t)atoi(argList[2].c_str());
+
+        if (Start(inputMask, sampleRate, averageCount))
+        {
+            Log("Sampling at ", Commas(GetSampleRate()), " samples/sec");
+        }
+        else
+        {
+            Log("Could not start");
+        }
+    }, { .argCount = 3, .help = "sample <inputMask> at <rate>/sec total, averaging <n> each" });
+
+    Shell::AddCommand("adc.sampler.stop", [](vector<string> argList){
+        Stop();
+    }, { .argCount = 0, .help = "stop background sampling" });
+
+    Shell::AddCommand("adc.sampler.stats", [](vector<string> argList){
+        Log("Running    : ", running_ ? "yes" : "no");
+        Log("Input mask : ", ToHex(inputMask_));
+        Log("Rate       : ", Commas(sampleRate_), " samples/sec, averaging ", averageCount_);
+        Log("Blocks     : ", Commas(stats_.blocks), " (", Commas(stats_.blocksLate), " late to callback)");
+        Log("ISR us     : max ", stats_.isrUsMax);
+
+        for (uint8_t input = 0; input < INPUT_COUNT; ++input)
+        {
+            if (IsReady(input))
+            {
+                Log("  Input ", input, ": ", GetLatest(input));
+            }
+        }
+    }, { .argCount = 0, .help = "background sampling stats and latest values" });
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+
+// Continuous sampling of the ADC inputs in the background, by DMA.
+//
+// The ADC runs free in round-robin mode, converting each input in the mask
+// in turn (lowest first), at the sample rate in total.  Two DMA channels,
+// chained to each other, take the samples from the FIFO into two buffers
+// alternately, so none are missed.
+//
+// As each buffer fills, the DMA IRQ averages each input's samples in it
+// into that input's latest value, which can then be read in O(1) at any
+// time.  The first buffer after starting is thrown away, as the first
+// conversions read low.
+//
+// Optionally, each buffer of raw samples is also handed to a callback from
+// Evm.  The samples are interleaved, in the order the inputs are sampled.
+// The buffer is being filled again one buffer's duration after it was
+// queued, so the callback has to be done by then, blocks arriving after
+// that are skipped and counted as late.
+//
+// Inputs 0-3 are pins 26-29, 4 is the temperature sensor.  Pins aren't set
+// up for analog use here, see ADC.
+class ADCSampler
+{
+public:
+
+    static const uint8_t  INPUT_COUNT = 5;
+    static const uint8_t  INPUT_TEMP  = 4;
+    static const uint16_t BUF_SAMPLES = 320;
+
+    using FnBlock = std::function<void(const uint16_t *sampleList, uint16_t count)>;
+
+    struct Stats
+    {
+        uint32_t blocks     = 0;
+        uint32_t blocksLate = 0;
+        uint32_t isrUsMax   = 0;
+    };
+
+
+public:
+
+    // Samples the inputs in the mask (bit n for input n) at sampleRate
+    // conversions/sec in total, averaging averageCount samples of each.
+    //
+    // false if the rate can't be made (clk_adc / 65,536 to clk_adc / 96),
+    // the inputs times the average count don't fit a buffer, or DMA
+    // channels aren't available.
+    //
+    // If already running, latest values of inputs sampled before are kept
+    // while the first block is taken.
+    //
+    // The clock divider is worked out again when the system clock changes
+    // (clk_adc is on pll_sys), so the rate holds as near as it can.
+    static bool Start(uint8_t inputMask, uint32_t sampleRate, uint16_t averageCount);
+    static void Stop();
+    static bool IsRunning();
+
+    static uint8_t  GetInputMask();
+    static uint16_t GetAverageCount();
+
+    // as made by the clock divider
+    static uint32_t GetSampleRate();
+
+    // true once an average has been taken of the input, and while it's
+    // still being sampled
+    static bool IsReady(uint8_t input);
+
+    // 12-bit average, 0 if not ready
+    static uint16_t GetLatest(uint8_t input);
+
+    static void SetCallbackOnBlock(FnBlock fnBlock);
+
+    static const Stats &GetStats();
+
+    static void SetupShell();
+
+
+private:
+
+    static void OnClockChange();
+    static void OnDmaComplete(uint8_t bufIdx);
+    static void DmaInterruptHandler();
+
+
+private:
+
+    inline static bool     running_         = false;
+    inline static uint8_t  inputMask_       = 0;
+    inline static uint16_t averageCount_    = 0;
+    inline static uint32_t sampleRate_      = 0;
+    inline static uint32_t sampleRateAsked_ = 0;
+
+    // inputs in the order sampled
+    inline static uint8_t inputList_[INPUT_COUNT] = {};
+    inline static uint8_t inputCount_             = 0;
+    inline static uint16_t blockSamples_          = 0;
+
+    inline static int8_t   dmaChannelList_[2] = { -1, -1 };
+    inline static uint16_t bufList_[2][BUF_SAMPLES];
+
+    // written by the DMA IRQ
+    inline static volatile uint16_t latestList_[INPUT_COUNT] = {};
+    inline static volatile uint8_t  readyMask_               = 0;
+    inline static volatile uint8_t  discardCount_            = 0;
+    inline static volatile uint32_t blockSeq_                = 0;
+
+    inline static FnBlock fnBlock_;
+};
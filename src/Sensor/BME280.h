@@ -1,20 +1,23 @@
 #pragma once
 
-#include "ArduinoSensorCore.h"
+#include "BoschBaro.h"
 #include "I2C.h"
 
+#include <cmath>
+
 
 class BME280
 {
 public:
 
     // Address is either 0x76 or 0x77
-    // 120ms
+    // 120ms, waits for the first measurement
     BME280(uint8_t addr, I2C::Instance instance)
-    : tw_(addr, instance)
+    : baro_(addr, instance, BoschBaro::Model::BME280)
     {
-        // this calls a default setSampling()
-        bme280_.begin(addr, &tw_);
+        // oversampling x16 for each, filter off, standby 0.5ms, normal mode
+        baro_.Init(0b101, 0b101'101'11, 0b000'000'00);
+        baro_.StartSampling("BME280");
     }
 
     static bool IsValidAddr(uint8_t addr)
@@ -24,53 +27,57 @@ public:
 
     bool IsAlive()
     {
-        return tw_.GetI2C().IsAlive();
+        return baro_.IsAlive();
+    }
+
+    // Values below are from the latest reading, polled in the background,
+    // and cost no bus traffic
+    const BoschBaro::Reading &GetReading()
+    {
+        return baro_.GetReading();
+    }
+
+    void SetIntervalMs(uint32_t intervalMs)
+    {
+        baro_.SetIntervalMs(intervalMs);
     }
 
-    // 1ms
     double GetTemperatureCelsius()
     {
-        // sensor returns celsius
-        return bme280_.readTemperature();
+        return GetReading().temperatureCentiC / 100.0;
     }
 
-    // 1ms
     double GetTemperatureFahrenheit()
     {
         return (GetTemperatureCelsius() * (9.0 / 5.0)) + 32;
     }
 
-    // 1ms
     double GetPressureHectoPascals()
     {
-        // sensor returns Pa
-        return bme280_.readPressure() / 100;
+        // Pa in Q24.8
+        return GetReading().pressurePaQ8 / 25'600.0;
     }
 
-    // 1ms
     double GetPressureMilliBars()
     {
         return GetPressureHectoPascals();
     }
 
-    // 1ms
     double GetAltitudeMeters()
     {
-        // sensor returns meters
         // calibrated to nominal pressure at sea level (hPa)
-        return bme280_.readAltitude(1013.25);
+        return 44'330.0 * (1.0 - pow(GetPressureHectoPascals() / 1013.25, 0.1903));
     }
 
-    // 1ms
     double GetAltitudeFeet()
     {
         return GetAltitudeMeters() * 3.28084;
     }
 
-    // 1ms
     double GetHumidityPct()
     {
-        return bme280_.readHumidity();
+        // %RH in Q22.10
+        return GetReading().humidityPctQ10 / 1'024.0;
     }
 
 
@@ -80,6 +87,5 @@ public:
 
 private:
 
-    TwoWire tw_;
-    Adafruit_BME280 bme280_;
+    BoschBaro baro_;
 };
\ No newline at end of file
@@ -1,27 +1,25 @@
 #pragma once
 
-#include "ArduinoSensorCore.h"
+#include "BoschBaro.h"
 #include "I2C.h"
 
+#include <cmath>
+
 
 class BMP280
 {
 public:
 
     // Address is either 0x76 or 0x77
-    // 105ms
+    // 105ms, waits for the first measurement
     BMP280(uint8_t addr, I2C::Instance instance)
-    : tw_(addr, instance)
-    , bmp280_(&tw_)
+    : baro_(addr, instance, BoschBaro::Model::BMP280)
     {
-        // startup sequence taken from example ino.
         // "Default settings from datasheet."
-        bmp280_.begin(addr);
-        bmp280_.setSampling(Adafruit_BMP280::MODE_NORMAL,     /* Operating Mode. */
-                            Adafruit_BMP280::SAMPLING_X2,     /* Temp. oversampling */
-                            Adafruit_BMP280::SAMPLING_X16,    /* Pressure oversampling */
-                            Adafruit_BMP280::FILTER_X16,      /* Filtering. */
-                            Adafruit_BMP280::STANDBY_MS_500); /* Standby time. */
+        // temperature oversampling x2, pressure x16, filter x16,
+        // standby 500ms, normal mode
+        baro_.Init(0, 0b010'101'11, 0b100'100'00);
+        baro_.StartSampling("BMP280");
     }
 
     static bool IsValidAddr(uint8_t addr)
@@ -31,44 +29,48 @@ public:
 
     bool IsAlive()
     {
-        return tw_.GetI2C().IsAlive();
+        return baro_.IsAlive();
+    }
+
+    // Values below are from the latest reading, polled in the background,
+    // and cost no bus traffic
+    const BoschBaro::Reading &GetReading()
+    {
+        return baro_.GetReading();
+    }
+
+    void SetIntervalMs(uint32_t intervalMs)
+    {
+        baro_.SetIntervalMs(intervalMs);
     }
 
-    // 1ms
     double GetTemperatureCelsius()
     {
-        // sensor returns celsius
-        return bmp280_.readTemperature();
+        return GetReading().temperatureCentiC / 100.0;
     }
 
-    // 1ms
     double GetTemperatureFahrenheit()
     {
         return (GetTemperatureCelsius() * (9.0 / 5.0)) + 32;
     }
 
-    // 1ms
     double GetPressureHectoPascals()
     {
-        // sensor returns Pa
-        return bmp280_.readPressure() / 100;
+        // Pa in Q24.8
+        return GetReading().pressurePaQ8 / 25'600.0;
     }
 
-    // 1ms
     double GetPressureMilliBars()
     {
         return GetPressureHectoPascals();
     }
 
-    // 1ms
     double GetAltitudeMeters()
     {
-        // sensor returns meters
         // calibrated to nominal pressure at sea level (hPa)
-        return bmp280_.readAltitude(1013.25);
+        return 44'330.0 * (1.0 - pow(GetPressureHectoPascals() / 1013.25, 0.1903));
     }
 
-    // 1ms
     double GetAltitudeFeet()
     {
         return GetAltitudeMeters() * 3.28084;
@@ -81,6 +83,5 @@ public:
 
 private:
 
-    TwoWire tw_;
-    Adafruit_BMP280 bmp280_;
+    BoschBaro baro_;
 };
\ No newline at end of file
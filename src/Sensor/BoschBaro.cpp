@@ -0,0 +1,217 @@
+#include "BoschBaro.h"
+#include "PAL.h"
+
+using namespace std;
+
+#include "StrictMode.h"
+
+
+// a reading register before any measurement has been made
+static const int32_t ADC_SKIPPED_TP = 0x80000;
+static const int32_t ADC_SKIPPED_H  = 0x8000;
+
+
+/////////////////////////////////////////////////////////////////
+// Setup
+/////////////////////////////////////////////////////////////////
+
+BoschBaro::BoschBaro(uint8_t addr, I2C::Instance instance, Model model)
+: i2c_(addr, instance)
+, model_(model)
+, state_(make_shared<State>())
+{
+    // nothing to do
+}
+
+BoschBaro::~BoschBaro()
+{
+    if (samplerId_)
+    {
+        SensorSampler::Unregister(samplerId_);
+    }
+}
+
+bool BoschBaro::Init(uint8_t ctrlHum, uint8_t ctrlMeas, uint8_t config)
+{
+    bool retVal = false;
+
+    uint8_t chipId = i2c_.ReadReg8(REG_CHIP_ID);
+    bool    idOk   = model_ == Model::BME280 ? chipId == 0x60 : (chipId >= 0x56 && chipId <= 0x58);
+
+    if (idOk)
+    {
+        // the calibration is copied out of NVM after reset
+        i2c_.WriteReg8(REG_RESET, 0xB6);
+        PAL.Delay(2);
+        for (uint8_t i = 0; i < 10 && (i2c_.ReadReg8(REG_STATUS) & 0x01); ++i)
+        {
+            PAL.Delay(1);
+        }
+
+        uint8_t buf[BoschCompensation::CALIB_TP_LEN];
+        bool    ok = i2c_.ReadReg(BoschCompensation::REG_CALIB_TP, buf, sizeof(buf)) == sizeof(buf);
+
+        if (ok)
+        {
+            BoschCompensation::ParseCalibrationTP(buf, state_->cal);
+        }
+
+        if (ok && model_ == Model::BME280)
+        {
+            ok = i2c_.ReadReg(BoschCompensation::REG_CALIB_H, buf, BoschCompensation::CALIB_H_LEN) == BoschCompensation::CALIB_H_LEN;
+
+            if (ok)
+            {
+                BoschCompensation::ParseCalibrationH(buf, state_->cal);
+
+                // only takes effect once ctrl_meas is written
+                i2c_.WriteReg8(REG_CTRL_HUM, ctrlHum);
+            }
+        }
+
+        if (ok)
+        {
+            // config is written while still asleep from the reset
+            i2c_.WriteReg8(REG_CONFIG, config);
+            i2c_.WriteReg8(REG_CTRL_MEAS, ctrlMeas);
+
+            for (uint8_t i = 0; i < 20 && Sample() == false; ++i)
+            {
+                PAL.Delay(10);
+            }
+
+            retVal = state_->reading.valid;
+        }
+    }
+
+    return retVal;
+}
+
+bool BoschBaro::IsAlive()
+{
+    return i2c_.IsAlive();
+}
+
+void BoschBaro::StartSampling(const char *name, uint32_t intervalMs)
+{
+    if (samplerId_ == 0)
+    {
+        samplerId_ = SensorSampler::Register(name, intervalMs, [this]{
+            SampleAsync();
+        });
+    }
+    else
+    {
+        SetIntervalMs(intervalMs);
+    }
+}
+
+void BoschBaro::SetIntervalMs(uint32_t intervalMs)
+{
+    SensorSampler::SetIntervalMs(samplerId_, intervalMs);
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Reading
+/////////////////////////////////////////////////////////////////
+
+const BoschBaro::Reading &BoschBaro::GetReading()
+{
+    if (state_->reading.valid == false)
+    {
+        Sample();
+    }
+
+    return state_->reading;
+}
+
+bool BoschBaro::Sample()
+{
+    bool retVal = false;
+
+    uint8_t len = GetDataLen();
+    uint8_t buf[BoschCompensation::DATA_LEN_BME280];
+
+    if (i2c_.ReadReg(BoschCompensation::REG_DATA, buf, len) == len)
+    {
+        retVal = Apply(*state_, buf, len);
+    }
+    else
+    {
+        ++state_->stats.failures;
+    }
+
+    return retVal;
+}
+
+bool BoschBaro::SampleAsync()
+{
+    bool retVal = false;
+
+    if (state_->pending)
+    {
+        ++state_->stats.skipsPending;
+    }
+    else
+    {
+        shared_ptr<State> state = state_;
+
+        retVal = i2c_.ReadRegAsync(BoschCompensation::REG_DATA, GetDataLen(), [state](bool ok, const uint8_t *buf, uint8_t len){
+            state->pending = false;
+
+            if (ok)
+            {
+                Apply(*state, buf, len);
+            }
+            else
+            {
+                ++state->stats.failures;
+            }
+        });
+
+        if (retVal)
+        {
+            state_->pending = true;
+        }
+        else
+        {
+            ++state_->stats.failures;
+        }
+    }
+
+    return retVal;
+}
+
+const BoschBaro::Stats &BoschBaro::GetStats()
+{
+    return state_->stats;
+}
+
+bool BoschBaro::Apply(State &state, const uint8_t *buf, uint8_t len)
+{
+    BoschCompensation::Raw raw = BoschCompensation::ParseRaw(buf, len);
+
+    if (raw.adcT == ADC_SKIPPED_TP)
+    {
+        return false;
+    }
+
+    Reading &reading = state.reading;
+
+    int32_t tFine = 0;
+    reading.temperatureCentiC = BoschCompensation::Temperature(state.cal, raw.adcT, tFine);
+    reading.pressurePaQ8      = raw.adcP == ADC_SKIPPED_TP ? 0 : BoschCompensation::Pressure(state.cal, raw.adcP, tFine);
+    reading.humidityPctQ10    = len < BoschCompensation::DATA_LEN_BME280 || raw.adcH == ADC_SKIPPED_H ? 0 : BoschCompensation::Humidity(state.cal, raw.adcH, tFine);
+    reading.timeUs            = PAL.Micros();
+    reading.valid             = true;
+
+    ++state.stats.samples;
+
+    return true;
+}
+
+uint8_t BoschBaro::GetDataLen()
+{
+    return model_ == Model::BME280 ? BoschCompensation::DATA_LEN_BME280 : BoschCompensation::DATA_LEN_BMP280;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "BoschCompensation.h"
+#include "I2C.h"
+#include "SensorSampler.h"
+
+#include <cstdint>
+#include <memory>
+
+
+// BMP280 / BME280 over I2C, without a vendor library.
+//
+// The sensor runs in normal mode, measuring continuously on its own.  Once
+// sampling is started, SensorSampler polls it at the interval with one
+// queued burst read of all the data registers, and the reading is
+// compensated with integer math and kept, timestamped.  Getting the
+// reading is then just a copy.
+class BoschBaro
+{
+public:
+
+    enum class Model : uint8_t
+    {
+        BMP280,
+        BME280,
+    };
+
+    struct Reading
+    {
+        bool     valid;
+        uint64_t timeUs;
+
+        int32_t  temperatureCentiC;     // 0.01 C
+        uint32_t pressurePaQ8;          // Pa, Q24.8
+        uint32_t humidityPctQ10;        // %RH, Q22.10, 0 on the BMP280
+    };
+
+    struct Stats
+    {
+        uint32_t samples;
+        uint32_t failures;
+        uint32_t skipsPending;
+    };
+
+
+public:
+
+    BoschBaro(uint8_t addr, I2C::Instance instance, Model model);
+    ~BoschBaro();
+
+    // Checks the chip id, resets, reads the calibration, sets the control
+    // registers and normal mode, then waits (up to about 200ms) for the
+    // first measurement.
+    bool Init(uint8_t ctrlHum, uint8_t ctrlMeas, uint8_t config);
+    bool IsAlive();
+
+    void StartSampling(const char *name, uint32_t intervalMs = SensorSampler::DEFAULT_INTERVAL_MS);
+    void SetIntervalMs(uint32_t intervalMs);
+
+    // The latest reading, taken by blocking if there isn't one yet
+    const Reading &GetReading();
+
+    // Blocking burst read
+    bool Sample();
+
+    // Queued burst read, kept once done.  Skipped if the last is still
+    // pending.
+    bool SampleAsync();
+
+    const Stats &GetStats();
+
+
+private:
+
+    static const uint8_t REG_CHIP_ID   = 0xD0;
+    static const uint8_t REG_RESET     = 0xE0;
+    static const uint8_t REG_CTRL_HUM  = 0xF2;
+    static const uint8_t REG_STATUS    = 0xF3;
+    static const uint8_t REG_CTRL_MEAS = 0xF4;
+    static const uint8_t REG_CONFIG    = 0xF5;
+
+    // shared with queued reads, which may complete after this is gone
+    struct State
+    {
+        BoschCompensation::Calibration cal;
+        Reading                        reading;
+        Stats                          stats;
+        bool                           pending;
+    };
+
+    static bool Apply(State &state, const uint8_t *buf, uint8_t len);
+
+    uint8_t GetDataLen();
+
+
+private:
+
+    I2C   i2c_;
+    Model model_;
+
+    std::shared_ptr<State> state_;
+
+    uint32_t samplerId_ = 0;
+};
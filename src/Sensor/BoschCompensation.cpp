@@ -0,0 +1,117 @@
+#include "BoschCompensation.h"
+
+using namespace std;
+
+#include "StrictMode.h"
+
+
+/////////////////////////////////////////////////////////////////
+// Parsing
+/////////////////////////////////////////////////////////////////
+
+static uint16_t U16LE(const uint8_t *buf)
+{
+    return (uint16_t)(buf[0] | (buf[1] << 8));
+}
+
+static int16_t S16LE(const uint8_t *buf)
+{
+    return (int16_t)U16LE(buf);
+}
+
+void BoschCompensation::ParseCalibrationTP(const uint8_t *buf, Calibration &cal)
+{
+    cal.T1 = U16LE(&buf[0]);
+    cal.T2 = S16LE(&buf[2]);
+    cal.T3 = S16LE(&buf[4]);
+
+    cal.P1 = U16LE(&buf[6]);
+    cal.P2 = S16LE(&buf[8]);
+    cal.P3 = S16LE(&buf[10]);
+    cal.P4 = S16LE(&buf[12]);
+    cal.P5 = S16LE(&buf[14]);
+    cal.P6 = S16LE(&buf[16]);
+    cal.P7 = S16LE(&buf[18]);
+    cal.P8 = S16LE(&buf[20]);
+    cal.P9 = S16LE(&buf[22]);
+
+    // 0xA0 is reserved, 0xA1 is H1 on the BME280
+    cal.H1 = buf[25];
+}
+
+// H4 and H5 are 12 bits each, sharing the nibbles of 0xE5
+void BoschCompensation::ParseCalibrationH(const uint8_t *buf, Calibration &cal)
+{
+    cal.H2 = S16LE(&buf[0]);
+    cal.H3 = buf[2];
+    cal.H4 = (int16_t)(((int8_t)buf[3] * 16) | (buf[4] & 0x0F));
+    cal.H5 = (int16_t)(((int8_t)buf[5] * 16) | (buf[4] >> 4));
+    cal.H6 = (int8_t)buf[6];
+}
+
+// 20-bit pressure and temperature, msb first, 16-bit humidity
+BoschCompensation::Raw BoschCompensation::ParseRaw(const uint8_t *buf, uint8_t len)
+{
+    Raw retVal;
+
+    retVal.adcP = (int32_t)(((uint32_t)buf[0] << 12) | ((uint32_t)buf[1] << 4) | (buf[2] >> 4));
+    retVal.adcT = (int32_t)(((uint32_t)buf[3] << 12) | ((uint32_t)buf[4] << 4) | (buf[5] >> 4));
+    retVal.adcH = len >= DATA_LEN_BME280 ? (int32_t)((buf[6] << 8) | buf[7]) : 0;
+
+    return retVal;
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Compensation, from the datasheets
+/////////////////////////////////////////////////////////////////
+
+int32_t BoschCompensation::Temperature(const Calibration &cal, int32_t adcT, int32_t &tFine)
+{
+    int32_t var1 = ((((adcT >> 3) - ((int32_t)cal.T1 << 1))) * ((int32_t)cal.T2)) >> 11;
+    int32_t var2 = (((((adcT >> 4) - ((int32_t)cal.T1)) * ((adcT >> 4) - ((int32_t)cal.T1))) >> 12) * ((int32_t)cal.T3)) >> 14;
+
+    tFine = var1 + var2;
+
+    return (tFine * 5 + 128) >> 8;
+}
+
+// the 64-bit form, to the resolution the oversampling gives, rather than
+// the 32-bit form's 1 Pa
+uint32_t BoschCompensation::Pressure(const Calibration &cal, int32_t adcP, int32_t tFine)
+{
+    int64_t var1 = ((int64_t)tFine) - 128000;
+    int64_t var2 = var1 * var1 * (int64_t)cal.P6;
+    var2 = var2 + ((var1 * (int64_t)cal.P5) * ((int64_t)1 << 17));
+    var2 = var2 + (((int64_t)cal.P4) * ((int64_t)1 << 35));
+    var1 = ((var1 * var1 * (int64_t)cal.P3) >> 8) + ((var1 * (int64_t)cal.P2) * ((int64_t)1 << 12));
+    var1 = ((((int64_t)1) << 47) + var1) * ((int64_t)cal.P1) >> 33;
+
+    // avoid divide by zero, eg no calibration
+    if (var1 == 0)
+    {
+        return 0;
+    }
+
+    int64_t p = 1048576 - adcP;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (((int64_t)cal.P9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t)cal.P8) * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (((int64_t)cal.P7) << 4);
+
+    return (uint32_t)p;
+}
+
+uint32_t BoschCompensation::Humidity(const Calibration &cal, int32_t adcH, int32_t tFine)
+{
+    int32_t v = tFine - ((int32_t)76800);
+
+    v = (((((adcH << 14) - (((int32_t)cal.H4) << 20) - (((int32_t)cal.H5) * v)) + ((int32_t)16384)) >> 15) *
+         (((((((v * ((int32_t)cal.H6)) >> 10) * (((v * ((int32_t)cal.H3)) >> 11) + ((int32_t)32768))) >> 10) +
+            ((int32_t)2097152)) * ((int32_t)cal.H2) + 8192) >> 14));
+    v = (v - (((((v >> 15) * (v >> 15)) >> 7) * ((int32_t)cal.H1)) >> 4));
+    v = (v < 0 ? 0 : v);
+    v = (v > 419430400 ? 419430400 : v);
+
+    return (uint32_t)(v >> 12);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+
+// Integer compensation of BMP280 / BME280 raw readings, as given in the
+// datasheets (BME280 4.2.3, BMP280 3.11.3), so no floating point is needed
+// to turn a reading into units.
+//
+// Temperature has to be worked out first, it gives the tFine the others
+// are compensated with.
+class BoschCompensation
+{
+public:
+
+    // calibration burst read from 0x88, 0x88-0xA1
+    static const uint8_t REG_CALIB_TP     = 0x88;
+    static const uint8_t CALIB_TP_LEN     = 26;
+
+    // BME280 only, 0xE1-0xE7
+    static const uint8_t REG_CALIB_H      = 0xE1;
+    static const uint8_t CALIB_H_LEN      = 7;
+
+    // data burst read from 0xF7, pressure, temperature, then (BME280) humidity
+    static const uint8_t REG_DATA         = 0xF7;
+    static const uint8_t DATA_LEN_BMP280  = 6;
+    static const uint8_t DATA_LEN_BME280  = 8;
+
+    struct Calibration
+    {
+        uint16_t T1;
+        int16_t  T2;
+        int16_t  T3;
+
+        uint16_t P1;
+        int16_t  P2;
+        int16_t  P3;
+        int16_t  P4;
+        int16_t  P5;
+        int16_t  P6;
+        int16_t  P7;
+        int16_t  P8;
+        int16_t  P9;
+
+        uint8_t  H1;
+        int16_t  H2;
+        uint8_t  H3;
+        int16_t  H4;
+        int16_t  H5;
+        int8_t   H6;
+    };
+
+    struct Raw
+    {
+        int32_t adcT;
+        int32_t adcP;
+        int32_t adcH;
+    };
+
+    static void ParseCalibrationTP(const uint8_t *buf, Calibration &cal);
+    static void ParseCalibrationH(const uint8_t *buf, Calibration &cal);
+
+    // len is DATA_LEN_BMP280 or DATA_LEN_BME280
+    static Raw ParseRaw(const uint8_t *buf, uint8_t len);
+
+    // 0.01 C, eg 5123 is 51.23 C
+    static int32_t Temperature(const Calibration &cal, int32_t adcT, int32_t &tFine);
+
+    // Pa, Q24.8, eg 24674867 is 24674867 / 256 = 96386.2 Pa
+    static uint32_t Pressure(const Calibration &cal, int32_t adcP, int32_t tFine);
+
+    // %RH, Q22.10, eg 47445 is 47445 / 1024 = 46.333 %RH
+    static uint32_t Humidity(const Calibration &cal, int32_t adcH, int32_t tFine);
+};
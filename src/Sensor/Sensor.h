@@ -4,6 +4,7 @@
 #include "BME280.h"
 #include "BMP280.h"
 #include "MMC56x3.h"
+#include "SensorSampler.h"
 #include "SI7021.h"
 #include "Timeline.h"
 
@@ -21,5 +22,6 @@ public:
         BMP280::SetupShell();
         MMC56x3::SetupShell();
         SI7021::SetupShell();
+        SensorSampler::SetupShell();
     }
 };
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include "Log.h"
+#include "PAL.h"
+#include "SensorSampler.h"
+#include "Shell.h"
+#include "Timeline.h"
+#include "Timer.h"
+#include "Utl.h"
+
+#include <algorithm>
+using namespace std;
+
+#include "StrictMode.h"
+
+
+static Timer timer_("TIMER_SENSOR_SAMPLER");
+
+
+/////////////////////////////////////////////////////////////////
+// Registration
+/////////////////////////////////////////////////////////////////
+
+uint32_t SensorSampler::Register(const string &name, uint32_t intervalMs, FnSample fnSample)
+{
+    uint32_t id = idNext_;
+    ++idNext_;
+
+    entryList_.push_back({
+        .id         = id,
+        .name       = name,
+        .intervalMs = max(intervalMs, (uint32_t)1),
+        .fnSample   = fnSample,
+        .timeNextUs = PAL.Micros(),
+        .polls      = 0,
+        .pollsLate  = 0,
+        .pollUsMax  = 0,
+    });
+
+    Schedule();
+
+    return id;
+}
+
+void SensorSampler::Unregister(uint32_t id)
+{
+    erase_if(entryList_, [&](const Entry &entry){
+        return entry.id == id;
+    });
+
+    Schedule();
+}
+
+void SensorSampler::SetIntervalMs(uint32_t id, uint32_t intervalMs)
+{
+    if (Entry *entry = GetEntry(id))
+    {
+        entry->intervalMs = max(intervalMs, (uint32_t)1);
+        entry->timeNextUs = PAL.Micros() + (uint64_t)entry->intervalMs * 1'000;
+
+        Schedule();
+    }
+}
+
+SensorSampler::Entry *SensorSampler::GetEntry(uint32_t id)
+{
+    Entry *retVal = nullptr;
+
+    for (auto &entry : entryList_)
+    {
+        if (entry.id == id)
+        {
+            retVal = &entry;
+
+            break;
+        }
+    }
+
+    return retVal;
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Polling
+/////////////////////////////////////////////////////////////////
+
+void SensorSampler::Schedule()
+{
+    if (entryList_.empty())
+    {
+        timer_.Cancel();
+    }
+    else
+    {
+        uint64_t timeNextUs = entryList_[0].timeNextUs;
+        for (const auto &entry : entryList_)
+        {
+            timeNextUs = min(timeNextUs, entry.timeNextUs);
+        }
+
+        timer_.SetCallback([]{ OnTimeout(); });
+        timer_.TimeoutAtUs(timeNextUs);
+    }
+}
+
+void SensorSampler::OnTimeout()
+{
+    uint64_t timeNowUs = PAL.Micros();
+
+    // by id, as polling may register or unregister
+    vector<uint32_t> idDueList;
+    for (const auto &entry : entryList_)
+    {
+        if (entry.timeNextUs <= timeNowUs)
+        {
+            idDueList.push_back(entry.id);
+        }
+    }
+
+    for (uint32_t id : idDueList)
+    {
+        Entry *entry = GetEntry(id);
+        if (entry == nullptr)
+        {
+            continue;
+        }
+
+        // keep to the schedule, unless a whole interval has been missed
+        entry->timeNextUs += (uint64_t)entry->intervalMs * 1'000;
+        if (entry->timeNextUs <= timeNowUs)
+        {
+            entry->timeNextUs = timeNowUs + (uint64_t)entry->intervalMs * 1'000;
+
+            ++entry->pollsLate;
+        }
+        ++entry->polls;
+
+        FnSample fnSample = entry->fnSample;
+
+        uint64_t timeStartUs = PAL.Micros();
+        fnSample();
+        uint32_t durationUs = (uint32_t)(PAL.Micros() - timeStartUs);
+
+        if ((entry = GetEntry(id)))
+        {
+            entry->pollUsMax = max(entry->pollUsMax, durationUs);
+        }
+    }
+
+    Schedule();
+}
+
+
+/////////////////////////////////////////////////////////////////
+// Shell
+/////////////////////////////////////////////////////////////////
+
+void SensorSampler::SetupShell()
+{
+    Timeline::Global().Event("SensorSampler::SetupShell");
+
+    Shell::AddCommand("sensor.sampler.stats", [](vector<string> argList){
+        Log("Sensors: ", entryList_.size());
+
+        for (const auto &entry : entryList_)
+        {
+            Log("  ", entry.id, " ", entry.name,
+                ": every ", Commas(entry.intervalMs), " ms",
+                ", polls ", Commas(entry.polls),
+                " (", Commas(entry.pollsLate), " late)",
+                ", poll us max ", Commas(entry.pollUsMax));
+        }
+    }, { .argCount = 0, .help = "registered sensors and polling stats" });
+
+    Shell::AddCommand("sensor.sampler.interval", [](vector<string> argList){
+        uint32_t id         = (uint32_t)atoi(argList[0].c_str());
+        uint32_t intervalMs = (uint32_t)atoi(argList[1].c_str());
+
+        SetIntervalMs(id, intervalMs);
+    }, { .argCount = 2, .help = "set <id> polling <intervalMs>" });
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+// Polls registered sensors on a schedule, from Evm.
+//
+// Each sensor registers a function which starts a reading, each at its own
+// interval.  Sensors due at the same time are polled together, so their
+// bus transfers queue back to back.  The sensor keeps its own latest
+// reading, so anything wanting a value reads it from there at no cost,
+// rather than going to the bus.
+class SensorSampler
+{
+public:
+
+    using FnSample = std::function<void()>;
+
+    static const uint32_t DEFAULT_INTERVAL_MS = 1'000;
+
+    // Returns an id for later calls.  The first poll is right away.
+    static uint32_t Register(const std::string &name, uint32_t intervalMs, FnSample fnSample);
+    static void Unregister(uint32_t id);
+    static void SetIntervalMs(uint32_t id, uint32_t intervalMs);
+
+    static void SetupShell();
+
+
+private:
+
+    struct Entry
+    {
+        uint32_t    id;
+        std::string name;
+        uint32_t    intervalMs;
+        FnSample    fnSample;
+        uint64_t    timeNextUs;
+
+        uint32_t    polls;
+        uint32_t    pollsLate;
+        uint32_t    pollUsMax;
+    };
+
+    static Entry *GetEntry(uint32_t id);
+    static void Schedule();
+    static void OnTimeout();
+
+
+private:
+
+    inline static std::vector<Entry> entryList_;
+    inline static uint32_t idNext_ = 1;
+};
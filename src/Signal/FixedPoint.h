@@ -50,20 +50,21 @@ public:
 
     // Moving member instantiation to explicit constructor since more ctors are
     // being added and better to be explicit, especially for debugging.
-    inline FixedPoint()
+    inline constexpr FixedPoint()
     : val_(0)
     {
         // Nothing to do
     }
     
     // For copy elision, not actually part of a particular use case
-    inline FixedPoint(const FixedPointClass &val)
+    inline constexpr FixedPoint(const FixedPointClass &val)
+    : val_(0)
     {
         operator=(val);
     }
 
     // For inspecting internal state
-    inline auto GetValueState() const
+    inline constexpr auto GetValueState() const
     {
         return val_;
     }
@@ -75,7 +76,7 @@ public:
     }
 
     // Useful for assignment after subtraction in limit mode stepping
-    inline void operator=(const FixedPointClass &rhs)
+    inline constexpr void operator=(const FixedPointClass &rhs)
     {
         val_ = rhs.val_;
     }
@@ -135,21 +136,25 @@ public:
     //
     ////////////////////////////////////////////////////////////////////
 
-    inline FixedPoint(const double val)
+    // constexpr so that eg filter coefficients can be written as doubles
+    // and still be converted at compile time
+    inline constexpr FixedPoint(const double val)
+    : val_(0)
     {
         operator=(val);
     }
     
-    inline void operator=(const double &rhs)
+    inline constexpr void operator=(const double &rhs)
     {
-        STORAGE_TYPE_HALF_SIZE whole = (STORAGE_TYPE_HALF_SIZE)rhs;
-        double                 frac  = rhs - whole;
-        
-        STORAGE_TYPE_HALF_SIZE fracAsInt =
-            (STORAGE_TYPE_HALF_SIZE)round(frac * ((STORAGE_TYPE)1 << BITS_FRAC));
-        
-        // val = whole + round(frac * 2^BITS_FRAC)
-        val_ = (((STORAGE_TYPE)whole << BITS_WHOLE) | fracAsInt);
+        // val = round(rhs * 2^BITS_FRAC), away from zero at the half
+        double scaled = rhs * (double)((uint64_t)1 << BITS_FRAC);
+
+        val_ = (STORAGE_TYPE)(int64_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+    }
+
+    explicit inline constexpr operator double() const
+    {
+        return (double)val_ / (double)((uint64_t)1 << BITS_FRAC);
     }
     
     
@@ -161,29 +166,29 @@ public:
 
     inline void operator=(const uint16_t rhs)
     {
-        val_ = ((STORAGE_TYPE)rhs << BITS_WHOLE);
+        val_ = ((STORAGE_TYPE)rhs << BITS_FRAC);
     }
     
     inline void operator-=(const uint16_t rhs)
     {
-        STORAGE_TYPE tmp = ((STORAGE_TYPE)rhs << BITS_WHOLE);
+        STORAGE_TYPE tmp = ((STORAGE_TYPE)rhs << BITS_FRAC);
         
         val_ -= tmp;
     }
     
     inline bool operator>(const uint16_t rhs) const
     {
-        return val_ > ((STORAGE_TYPE)rhs << BITS_WHOLE);
+        return val_ > ((STORAGE_TYPE)rhs << BITS_FRAC);
     }
     
     inline bool operator<(const uint16_t rhs) const
     {
-        return val_ < ((STORAGE_TYPE)rhs << BITS_WHOLE);
+        return val_ < ((STORAGE_TYPE)rhs << BITS_FRAC);
     }
     
     explicit inline operator uint16_t() const
     {
-        return (uint16_t)(val_ >> BITS_WHOLE);
+        return (uint16_t)(val_ >> BITS_FRAC);
     }
 
     
@@ -196,22 +201,22 @@ public:
     
     inline FixedPoint(const uint8_t val)
     {
-        val_ = ((STORAGE_TYPE)val << BITS_WHOLE);
+        val_ = ((STORAGE_TYPE)val << BITS_FRAC);
     }
     
     inline bool operator>(const uint8_t rhs) const
     {
-        return val_ > ((STORAGE_TYPE)rhs << BITS_WHOLE);
+        return val_ > ((STORAGE_TYPE)rhs << BITS_FRAC);
     }
 
     inline bool operator<(const uint8_t rhs) const
     {
-        return val_ < ((STORAGE_TYPE)rhs << BITS_WHOLE);
+        return val_ < ((STORAGE_TYPE)rhs << BITS_FRAC);
     }
 
     explicit inline operator uint8_t() const
     {
-        return (uint8_t)(val_ >> BITS_WHOLE);
+        return (uint8_t)(val_ >> BITS_FRAC);
     }
         
 private:
@@ -224,6 +229,18 @@ private:
 using Q1616 = FixedPoint<16, 16, uint32_t, uint16_t>;
 using Q88   = FixedPoint<8, 8, uint16_t, uint8_t>;
 
+// Signed, for signal processing.  The whole part includes the sign bit.
+using Q115  = FixedPoint<1, 15, int16_t, int8_t>;    // -1.0 to just under 1.0
+using Q214  = FixedPoint<2, 14, int16_t, int8_t>;    // -2.0 to just under 2.0
+using Q230  = FixedPoint<2, 30, int32_t, int16_t>;   // -2.0 to just under 2.0
+
+
+// Clamp a wider intermediate result back into a 16-bit sample.
+inline int16_t SaturateToInt16(int32_t val)
+{
+    return (int16_t)(val > INT16_MAX ? INT16_MAX : (val < INT16_MIN ? INT16_MIN : val));
+}
+
 
 /*
  * Note that this class specifically avoids casting multiplication operation
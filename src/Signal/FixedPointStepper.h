@@ -42,6 +42,11 @@ public:
     {
         stepSize_ = stepSize;
     }
+
+    inline auto GetStepSizeState() const
+    {
+        return stepSize_.GetValueState();
+    }
     
     template <typename T>
     inline void SetLimitLower(const T &limitLower)
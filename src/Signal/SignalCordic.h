@@ -0,0 +1,262 @@
+#pragma once
+
+#include <bit>
+#include <stdint.h>
+
+
+/*
+ * Trigonometry and square roots in integer arithmetic, for use where double
+ * would mean software floating point (the RP2040 has no FPU).
+ *
+ * sin/cos and atan2/magnitude are CORDIC, which needs only shifts, adds and
+ * a small table.  Each iteration gains a bit, so results are good to about
+ * 1 part in 2^28.
+ *
+ * Angles are binary radians across the full 32 bits, a uint32_t where a
+ * full circle is 2^32, so wrap-around is free.  This is the 32-bit version
+ * of the 8-bit brads of SignalOscillator.
+ *
+ * sin and cos come back as Q230 state, so 1.0 is 2^30.
+ *
+ * All functions are constexpr, so also usable to work out eg filter
+ * coefficients at compile time (see SignalFilterBiquad).
+ *
+ *
+ * Example use:
+ * ------------
+ * auto sc = SignalCordic::SinCos(SignalCordic::AngleFromDegrees(30));
+ * // sc.sin is 0.5 in Q230, within a few of 2^29
+ *
+ * uint32_t angle = SignalCordic::Atan2(accelY, accelX);
+ * int32_t  tenthsDeg = SignalCordic::AngleToTenthsDegreesSigned(angle);
+ *
+ */
+
+class SignalCordic
+{
+public:
+
+    static const uint8_t ITERATIONS = 30;
+
+    static const int32_t ONE_Q230 = (int32_t)1 << 30;
+
+    struct SinCosResult
+    {
+        int32_t sin = 0;    // Q230
+        int32_t cos = 0;    // Q230
+    };
+
+    struct PolarResult
+    {
+        uint32_t magnitude = 0;
+        uint32_t angle     = 0;
+    };
+
+
+public:
+
+    static constexpr uint32_t AngleFromDegrees(double degrees)
+    {
+        double turns = degrees / 360.0;
+
+        turns -= (double)(int64_t)turns;
+        if (turns < 0)
+        {
+            turns += 1.0;
+        }
+
+        return (uint32_t)(uint64_t)(turns * 4294967296.0 + 0.5);
+    }
+
+    static constexpr uint32_t AngleFromFraction(double fractionOfCircle)
+    {
+        return AngleFromDegrees(fractionOfCircle * 360.0);
+    }
+
+    // -1800 to 1799
+    static constexpr int32_t AngleToTenthsDegreesSigned(uint32_t angle)
+    {
+        return (int32_t)(((int64_t)(int32_t)angle * 3600) >> 32);
+    }
+
+    static constexpr SinCosResult SinCos(uint32_t angle)
+    {
+        // Rotation only converges within about +/- 99 degrees, so angles
+        // in the left half plane are turned half a circle first, and the
+        // result negated after.
+        bool flip = (uint32_t)(angle + 0x4000'0000) >= 0x8000'0000;
+        if (flip)
+        {
+            angle += 0x8000'0000;
+        }
+
+        // start pre-scaled by the gain the iterations will add
+        int32_t x = GAIN_INV_Q230;
+        int32_t y = 0;
+        int32_t z = (int32_t)angle;
+
+        // turn toward z reaching 0, the direction applied without a branch,
+        // (v ^ sign) - sign being v or -v
+        for (uint8_t i = 0; i < ITERATIONS; ++i)
+        {
+            int32_t sign = z >> 31;
+
+            int32_t dx = ((y >> i) ^ sign) - sign;
+            int32_t dy = ((x >> i) ^ sign) - sign;
+
+            x -= dx;
+            y += dy;
+            z -= (ATAN_TABLE[i] ^ sign) - sign;
+        }
+
+        SinCosResult retVal;
+
+        retVal.sin = flip ? -y : y;
+        retVal.cos = flip ? -x : x;
+
+        return retVal;
+    }
+
+    static constexpr int32_t Sin(uint32_t angle)
+    {
+        return SinCos(angle).sin;
+    }
+
+    static constexpr int32_t Cos(uint32_t angle)
+    {
+        return SinCos(angle).cos;
+    }
+
+    // Length and angle of the vector (x, y), any values other than INT32_MIN.
+    static constexpr PolarResult ToPolar(int32_t y, int32_t x)
+    {
+        PolarResult retVal;
+
+        if (x == 0 && y == 0)
+        {
+            return retVal;
+        }
+
+        // Vectoring needs x positive, so vectors on the left are turned
+        // half a circle first
+        uint32_t angle = 0;
+        if (x < 0)
+        {
+            x = -x;
+            y = -y;
+            angle = 0x8000'0000;
+        }
+
+        // Scale to use the most bits without overflow.  The iterations grow
+        // the vector by 1.65, so the larger part is put between 2^28 and
+        // 2^29.  The scale doesn't change the angle, and is undone on the
+        // magnitude.
+        uint32_t ax = (uint32_t)x;
+        uint32_t ay = (uint32_t)(y < 0 ? -y : y);
+        int8_t shift = (int8_t)(std::countl_zero(ax | ay) - 3);
+
+        if (shift >= 0)
+        {
+            x = (int32_t)((uint32_t)x << shift);
+            y = (int32_t)((uint32_t)y << shift);
+        }
+        else
+        {
+            x >>= -shift;
+            y >>= -shift;
+        }
+
+        int32_t z = 0;
+        // turn toward y reaching 0, as above
+        for (uint8_t i = 0; i < ITERATIONS; ++i)
+        {
+            int32_t sign = y >> 31;
+
+            int32_t dx = ((y >> i) ^ sign) - sign;
+            int32_t dy = ((x >> i) ^ sign) - sign;
+
+            x += dx;
+            y -= dy;
+            z += (ATAN_TABLE[i] ^ sign) - sign;
+        }
+
+        // take out the gain
+        uint64_t magnitude = ((uint64_t)(uint32_t)x * (uint32_t)GAIN_INV_Q230) >> 30;
+        if (shift >= 0)
+        {
+            magnitude >>= shift;
+        }
+        else
+        {
+            magnitude <<= -shift;
+        }
+
+        retVal.magnitude = (uint32_t)magnitude;
+        retVal.angle     = angle + (uint32_t)z;
+
+        return retVal;
+    }
+
+    static constexpr uint32_t Atan2(int32_t y, int32_t x)
+    {
+        return ToPolar(y, x).angle;
+    }
+
+    static constexpr uint32_t Magnitude(int32_t y, int32_t x)
+    {
+        return ToPolar(y, x).magnitude;
+    }
+
+    // floor(sqrt(val)).
+    //
+    // Not CORDIC, which would need its hyperbolic form, but the digit by
+    // digit method, which is also only shifts and adds, and exact.
+    //
+    // Works on fixed point too, the root of a value with 2n fractional
+    // bits has n, eg the root of Q1616 state is Q248.
+    static constexpr uint16_t Sqrt(uint32_t val)
+    {
+        uint32_t root = 0;
+        uint32_t bit  = (uint32_t)1 << 30;
+
+        while (bit > val)
+        {
+            bit >>= 2;
+        }
+
+        while (bit)
+        {
+            if (val >= root + bit)
+            {
+                val  -= root + bit;
+                root  = (root >> 1) + bit;
+            }
+            else
+            {
+                root >>= 1;
+            }
+
+            bit >>= 2;
+        }
+
+        return (uint16_t)root;
+    }
+
+
+private:
+
+    // product of cos(atan(2^-i)) over the iterations, 0.607252935
+    static const int32_t GAIN_INV_Q230 = 0x26DD'3B6A;
+
+    // atan(2^-i) in 32-bit binary radians
+    static constexpr int32_t ATAN_TABLE[ITERATIONS] = {
+        0x20000000, 0x12E4051E, 0x09FB385B, 0x051111D4,
+        0x028B0D43, 0x0145D7E1, 0x00A2F61E, 0x00517C55,
+        0x0028BE53, 0x00145F2F, 0x000A2F98, 0x000517CC,
+        0x00028BE6, 0x000145F3, 0x0000A2FA, 0x0000517D,
+        0x000028BE, 0x0000145F, 0x00000A30, 0x00000518,
+        0x0000028C, 0x00000146, 0x000000A3, 0x00000051,
+        0x00000029, 0x00000014, 0x0000000A, 0x00000005,
+        0x00000003, 0x00000001,
+    };
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "SignalFilterFIR.h"
+
+
+/*
+ * Reduce the sample rate by an integer factor, with a low-pass FIR first
+ * so that what's above the new Nyquist frequency doesn't alias down.
+ *
+ * Only every FACTOR-th output of the filter is kept, so only those are
+ * worked out.  The others are only pushed into the filter's history, which
+ * makes the cost per input sample about TAP_COUNT / FACTOR multiplies.
+ *
+ * The coefficients are as for SignalFilterFIR, and should cut off below
+ * half the output rate.
+ *
+ *
+ * Example use:
+ * ------------
+ * // 4x, eg 4 kHz ADC samples down to 1 kHz
+ * inline constexpr Q115 LPF[] = { ... };
+ *
+ * SignalDecimator<4, LPF> dec;
+ * uint32_t outCount = dec.Process(inList, inCount, outList);
+ *
+ */
+
+template <uint8_t FACTOR, const auto &COEFF_LIST>
+class SignalDecimator
+{
+    static_assert(FACTOR >= 1, "Decimation factor must be at least 1");
+
+public:
+
+    void Reset()
+    {
+        fir_.Reset();
+        phase_ = 0;
+    }
+
+    // true when sample completed an output, given in out
+    inline bool Process(int16_t sample, int16_t &out)
+    {
+        bool retVal = false;
+
+        fir_.Push(sample);
+
+        if (++phase_ == FACTOR)
+        {
+            phase_ = 0;
+
+            out = fir_.Calculate();
+
+            retVal = true;
+        }
+
+        return retVal;
+    }
+
+    // outList must have room for inCount / FACTOR + 1, returns the count
+    // written.  Blocks needn't be a multiple of FACTOR, the phase carries
+    // over to the next.
+    uint32_t Process(const int16_t *inList, uint32_t inCount, int16_t *outList)
+    {
+        uint32_t retVal = 0;
+
+        for (uint32_t i = 0; i < inCount; ++i)
+        {
+            retVal += Process(inList[i], outList[retVal]);
+        }
+
+        return retVal;
+    }
+
+
+private:
+
+    SignalFilterFIR<COEFF_LIST> fir_;
+
+    uint8_t phase_ = 0;
+};
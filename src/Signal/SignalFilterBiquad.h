@@ -0,0 +1,218 @@
+#pragma once
+
+#include <initializer_list>
+#include <stdint.h>
+#include <type_traits>
+
+#include "FixedPoint.h"
+#include "SignalCordic.h"
+
+
+/*
+ * Coefficients of a biquad (second order IIR) section, normalized so a0 is
+ * 1.0, as Q214 (-2.0 to just under 2.0), which covers a stable section's
+ * a1 and a2.
+ *
+ * The designers are the usual ones from the Audio EQ Cookbook.  They are
+ * constexpr, with the trigonometry done by SignalCordic, so coefficients
+ * defined as constexpr cost nothing at runtime.
+ *
+ * 14 fractional bits limit how low a cutoff can be relative to the sample
+ * rate, as the poles crowd towards 1.0.  Down to about fs/200 works well,
+ * below that decimate first (see SignalDecimator).
+ */
+struct SignalFilterBiquadCoeff
+{
+    Q214 b0;
+    Q214 b1;
+    Q214 b2;
+    Q214 a1;
+    Q214 a2;
+
+    static constexpr SignalFilterBiquadCoeff FromDouble(double b0, double b1, double b2, double a0, double a1, double a2)
+    {
+        SignalFilterBiquadCoeff retVal;
+
+        retVal.b0 = b0 / a0;
+        retVal.b1 = b1 / a0;
+        retVal.b2 = b2 / a0;
+        retVal.a1 = a1 / a0;
+        retVal.a2 = a2 / a0;
+
+        return retVal;
+    }
+
+    static constexpr SignalFilterBiquadCoeff LowPass(double sampleRate, double cutoff, double q = 0.7071)
+    {
+        Trig t(sampleRate, cutoff, q);
+
+        return FromDouble((1 - t.cos) / 2, 1 - t.cos, (1 - t.cos) / 2,
+                          1 + t.alpha, -2 * t.cos, 1 - t.alpha);
+    }
+
+    static constexpr SignalFilterBiquadCoeff HighPass(double sampleRate, double cutoff, double q = 0.7071)
+    {
+        Trig t(sampleRate, cutoff, q);
+
+        return FromDouble((1 + t.cos) / 2, -(1 + t.cos), (1 + t.cos) / 2,
+                          1 + t.alpha, -2 * t.cos, 1 - t.alpha);
+    }
+
+    // 0 dB at the center
+    static constexpr SignalFilterBiquadCoeff BandPass(double sampleRate, double center, double q)
+    {
+        Trig t(sampleRate, center, q);
+
+        return FromDouble(t.alpha, 0, -t.alpha,
+                          1 + t.alpha, -2 * t.cos, 1 - t.alpha);
+    }
+
+private:
+
+    struct Trig
+    {
+        constexpr Trig(double sampleRate, double frequency, double q)
+        {
+            auto sc = SignalCordic::SinCos(SignalCordic::AngleFromFraction(frequency / sampleRate));
+
+            sin   = (double)sc.sin / SignalCordic::ONE_Q230;
+            cos   = (double)sc.cos / SignalCordic::ONE_Q230;
+            alpha = sin / (2 * q);
+        }
+
+        double sin   = 0;
+        double cos   = 0;
+        double alpha = 0;
+    };
+};
+
+
+/*
+ * Biquad filter section on 16-bit samples, with coefficients fixed at
+ * compile time.
+ *
+ * Direct Form I, so the state is the last two inputs and outputs, all
+ * 16-bit.  The products are summed in 32 bits where the coefficients allow
+ * (absolute values summing under 4.0, eg lowpass), otherwise in 64 bits
+ * (eg highpass, whose b1 and a1 are both near 2.0), chosen at compile time.
+ *
+ * The bits dropped scaling the sum back to 16 bits are carried into the
+ * next sample (error feedback), rather than lost, which keeps low cutoff
+ * filters from sticking a little off their settled value.
+ *
+ *
+ * Example use:
+ * ------------
+ * inline constexpr auto LPF_50 = SignalFilterBiquadCoeff::LowPass(1000, 50);
+ *
+ * SignalFilterBiquad<LPF_50> lpf;
+ * int16_t out = lpf.Process(in);
+ *
+ * For steeper filters, cascade sections.
+ *
+ */
+
+template <const SignalFilterBiquadCoeff &COEFF>
+class SignalFilterBiquad
+{
+    static const uint8_t BITS_FRAC = 14;
+
+    static constexpr uint32_t CoeffAbsSum()
+    {
+        uint32_t retVal = 0;
+
+        for (int32_t val : { COEFF.b0.GetValueState(), COEFF.b1.GetValueState(), COEFF.b2.GetValueState(),
+                             COEFF.a1.GetValueState(), COEFF.a2.GetValueState() })
+        {
+            retVal += (uint32_t)(val < 0 ? -val : val);
+        }
+
+        return retVal;
+    }
+
+public:
+
+    // full scale input, plus the carried error, fits 32 bits
+    static constexpr bool ACC_32 = (uint64_t)CoeffAbsSum() * 32'768 + (1 << BITS_FRAC) <= INT32_MAX;
+
+private:
+
+    using Acc = std::conditional_t<ACC_32, int32_t, int64_t>;
+
+public:
+
+    void Reset()
+    {
+        x1_  = 0;
+        x2_  = 0;
+        y1_  = 0;
+        y2_  = 0;
+        err_ = 0;
+    }
+
+    inline int16_t Process(int16_t x0)
+    {
+        int16_t retVal = Step(x0, x1_, x2_, y1_, y2_, err_);
+
+        return retVal;
+    }
+
+    // in and out can be the same buffer
+    void Process(const int16_t *inList, int16_t *outList, uint32_t count)
+    {
+        // state in locals for the block, as they'd otherwise be reloaded
+        // after each store through outList
+        int16_t x1  = x1_;
+        int16_t x2  = x2_;
+        int16_t y1  = y1_;
+        int16_t y2  = y2_;
+        int32_t err = err_;
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            outList[i] = Step(inList[i], x1, x2, y1, y2, err);
+        }
+
+        x1_  = x1;
+        x2_  = x2;
+        y1_  = y1;
+        y2_  = y2;
+        err_ = err;
+    }
+
+
+private:
+
+    static inline int16_t Step(int16_t x0, int16_t &x1, int16_t &x2, int16_t &y1, int16_t &y2, int32_t &err)
+    {
+        Acc acc = err;
+
+        // each product fits 32 bits, only the sum may not
+        acc += (int32_t)COEFF.b0.GetValueState() * x0;
+        acc += (int32_t)COEFF.b1.GetValueState() * x1;
+        acc += (int32_t)COEFF.b2.GetValueState() * x2;
+        acc -= (int32_t)COEFF.a1.GetValueState() * y1;
+        acc -= (int32_t)COEFF.a2.GetValueState() * y2;
+
+        // at most 5 * 2.0 times full scale once scaled back, so fits 32 bits
+        int16_t y0 = SaturateToInt16((int32_t)(acc >> BITS_FRAC));
+
+        err = (int32_t)(acc & ((1 << BITS_FRAC) - 1));
+
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = y0;
+
+        return y0;
+    }
+
+
+private:
+
+    int16_t x1_  = 0;
+    int16_t x2_  = 0;
+    int16_t y1_  = 0;
+    int16_t y2_  = 0;
+    int32_t err_ = 0;
+};
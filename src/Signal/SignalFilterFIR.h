@@ -0,0 +1,131 @@
+#pragma once
+
+#include <iterator>
+#include <stdint.h>
+#include <type_traits>
+
+#include "FixedPoint.h"
+
+
+/*
+ * FIR filter on 16-bit samples, with coefficients fixed at compile time.
+ *
+ * The coefficients are a constexpr array of Q115 (-1.0 to just under 1.0),
+ * written as doubles and converted by the compiler, and passed as the
+ * template parameter.  The tap count is then known, and each coefficient
+ * is a constant in the generated code.
+ *
+ * Products are summed in 32 bits, which can't overflow while the absolute
+ * sum of the coefficients is below 2.0, which is checked at compile time.
+ * The result is rounded and saturated back to 16 bits.
+ *
+ * Each sample is kept in the history twice, TAP_COUNT apart, so the most
+ * recent TAP_COUNT samples are always contiguous, without wrapping or
+ * a modulo per tap.
+ *
+ *
+ * Example use:
+ * ------------
+ * // 5-tap smoothing
+ * inline constexpr Q115 SMOOTH[] = { 0.1, 0.2, 0.4, 0.2, 0.1 };
+ *
+ * SignalFilterFIR<SMOOTH> fir;
+ * int16_t out = fir.Process(in);
+ * fir.Process(inList, outList, count);
+ *
+ */
+
+template <const auto &COEFF_LIST>
+class SignalFilterFIR
+{
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(COEFF_LIST[0])>, Q115>,
+                  "FIR coefficients must be Q115");
+
+public:
+
+    static const uint16_t TAP_COUNT = (uint16_t)std::size(COEFF_LIST);
+
+    static_assert(TAP_COUNT > 0, "FIR needs at least one tap");
+
+private:
+
+    static constexpr uint32_t CoeffAbsSum()
+    {
+        uint32_t retVal = 0;
+
+        for (const auto &coeff : COEFF_LIST)
+        {
+            int32_t val = coeff.GetValueState();
+
+            retVal += (uint32_t)(val < 0 ? -val : val);
+        }
+
+        return retVal;
+    }
+
+    static_assert(CoeffAbsSum() < 0x1'0000, "FIR coefficients would overflow the accumulator");
+
+public:
+
+    SignalFilterFIR()
+    {
+        Reset();
+    }
+
+    void Reset()
+    {
+        for (auto &sample : histList_)
+        {
+            sample = 0;
+        }
+
+        idx_ = 0;
+    }
+
+    // Add a sample without working out the output, eg the samples being
+    // dropped when decimating
+    inline void Push(int16_t sample)
+    {
+        idx_ = idx_ == 0 ? TAP_COUNT - 1 : idx_ - 1;
+
+        histList_[idx_]             = sample;
+        histList_[idx_ + TAP_COUNT] = sample;
+    }
+
+    // Output for the samples pushed so far
+    inline int16_t Calculate() const
+    {
+        // newest first, so the sample from k ago lines up with coeff k
+        const int16_t *hist = &histList_[idx_];
+
+        int32_t acc = (int32_t)1 << 14;
+        for (uint16_t i = 0; i < TAP_COUNT; ++i)
+        {
+            acc += (int32_t)COEFF_LIST[i].GetValueState() * hist[i];
+        }
+
+        return SaturateToInt16(acc >> 15);
+    }
+
+    inline int16_t Process(int16_t sample)
+    {
+        Push(sample);
+
+        return Calculate();
+    }
+
+    // in and out can be the same buffer
+    void Process(const int16_t *inList, int16_t *outList, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            outList[i] = Process(inList[i]);
+        }
+    }
+
+
+private:
+
+    int16_t  histList_[TAP_COUNT * 2];
+    uint16_t idx_ = 0;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+
+/*
+ * Helpers for combining the output of several SignalOscillators.
+ *
+ * Oscillators are mixed by each adding their samples into a shared int16_t
+ * buffer (SignalOscillator::MixIntoBuffer), which can't overflow for up to
+ * 256 oscillators.  The sum is then scaled back down to the 8-bit signal
+ * range for output.
+ *
+ * Example use:
+ * ------------
+ * int16_t  mix[256];
+ * uint16_t levelList[256];
+ * 
+ * SignalMixer::Clear(mix, 256);
+ * o1.MixIntoBuffer<SignalSourceSineWave::GetSample>(mix, 256);
+ * o2.MixIntoBuffer<SignalSourceSineWave::GetSample>(mix, 256);
+ * SignalMixer::ToLevels(mix, levelList, 256, 2);
+ * 
+ */
+
+class SignalMixer
+{
+public:
+
+    static void Clear(int16_t *mix, uint32_t count)
+    {
+        memset(mix, 0, count * sizeof(int16_t));
+    }
+
+    // Scales the sum of oscillatorCount oscillators back to the -128 to 127
+    // range, offset to 0 to 255, as levels for eg PWMAudio.
+    //
+    // The scaling is a multiply by a Q8 gain rather than a divide per
+    // sample, rounding down, so the result never clips.
+    static void ToLevels(const int16_t *mix, uint16_t *levelList, uint32_t count, uint8_t oscillatorCount)
+    {
+        int32_t gain = 256 / (oscillatorCount ? oscillatorCount : 1);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            levelList[i] = (uint16_t)(128 + ((mix[i] * gain) >> 8));
+        }
+    }
+
+    // As above, for a single oscillator's samples
+    static void ToLevels(const int8_t *sampleList, uint16_t *levelList, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            levelList[i] = (uint16_t)(128 + sampleList[i]);
+        }
+    }
+};
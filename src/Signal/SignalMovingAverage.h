@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdint.h>
+
+
+/*
+ * Moving average of the last WINDOW 16-bit samples.
+ *
+ * A running sum is kept, so each sample costs an add and a subtract
+ * whatever the window, and WINDOW is a power of two so the divide is a
+ * shift.
+ *
+ * The window starts full of zeros, so the average ramps up over the first
+ * WINDOW samples.  Use Fill() to start from a known level instead.
+ *
+ *
+ * Example use:
+ * ------------
+ * SignalMovingAverage<16> avg;
+ * int16_t smoothed = avg.Process(adcVal);
+ *
+ */
+
+template <uint16_t WINDOW>
+class SignalMovingAverage
+{
+    static_assert(WINDOW != 0 && (WINDOW & (WINDOW - 1)) == 0, "Window must be a power of two");
+    static_assert(WINDOW <= 0x8000, "Window too large for the 32-bit sum");
+
+    static constexpr uint8_t Log2(uint16_t val)
+    {
+        uint8_t retVal = 0;
+
+        while (val > 1)
+        {
+            val >>= 1;
+            ++retVal;
+        }
+
+        return retVal;
+    }
+
+    static const uint8_t WINDOW_BITS = Log2(WINDOW);
+
+public:
+
+    void Reset()
+    {
+        Fill(0);
+    }
+
+    void Fill(int16_t sample)
+    {
+        for (auto &val : sampleList_)
+        {
+            val = sample;
+        }
+
+        sum_ = (int32_t)sample * WINDOW;
+        idx_ = 0;
+    }
+
+    inline int16_t Process(int16_t sample)
+    {
+        sum_ += sample - sampleList_[idx_];
+
+        sampleList_[idx_] = sample;
+        idx_ = (idx_ + 1) & (WINDOW - 1);
+
+        return GetAverage();
+    }
+
+    // in and out can be the same buffer
+    void Process(const int16_t *inList, int16_t *outList, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            outList[i] = Process(inList[i]);
+        }
+    }
+
+    // rounds toward negative infinity
+    inline int16_t GetAverage() const
+    {
+        return (int16_t)(sum_ >> WINDOW_BITS);
+    }
+
+
+private:
+
+    int16_t  sampleList_[WINDOW] = {};
+    int32_t  sum_ = 0;
+    uint16_t idx_ = 0;
+};
@@ -63,6 +63,25 @@ struct SignalOscillatorFrequencyConfig
  * }
  * 
  * 
+ * Block use:
+ * ----------
+ * At audio rates, samples are better made a block at a time, eg to fill a
+ * buffer being played out by DMA (see PWMAudio).  The block functions give
+ * exactly the samples the same number of GetNextSample() calls would, but
+ * keep the oscillator state in registers for the whole block, and take
+ * the signal source as a template parameter so it is inlined.
+ * 
+ * int8_t buf[256];
+ * o.FillBuffer<SignalSourceSineWave::GetSample>(buf, 256);
+ * 
+ * Several oscillators are mixed by adding each into an int16_t buffer, then
+ * scaling the sum back down (see SignalMixer).
+ * 
+ * int16_t mix[256] = {};
+ * o1.MixIntoBuffer<SignalSourceSineWave::GetSample>(mix, 256);
+ * o2.MixIntoBuffer<SignalSourceSineWave::GetSample>(mix, 256);
+ * 
+ * 
  * Other Notes
  * - Class original design was for audio synthesis.
  *   - So expected hundreds-to-thousands of Hz for signals
@@ -174,6 +193,39 @@ public:
         return 128 + GetNextSample();
     }
 
+    // count samples, with the signal source inlined
+    template <SignalSourceFn SS_FN>
+    void FillBuffer(int8_t *buf, uint32_t count)
+    {
+        Generate(count, SS_FN, [buf](uint32_t i, int8_t sample){
+            buf[i] = sample;
+        });
+    }
+
+    // count samples, from the signal source set at runtime
+    void FillBuffer(int8_t *buf, uint32_t count)
+    {
+        Generate(count, ssFn_, [buf](uint32_t i, int8_t sample){
+            buf[i] = sample;
+        });
+    }
+
+    // count samples added to what is in buf, for mixing oscillators
+    template <SignalSourceFn SS_FN>
+    void MixIntoBuffer(int16_t *buf, uint32_t count)
+    {
+        Generate(count, SS_FN, [buf](uint32_t i, int8_t sample){
+            buf[i] = (int16_t)(buf[i] + sample);
+        });
+    }
+
+    void MixIntoBuffer(int16_t *buf, uint32_t count)
+    {
+        Generate(count, ssFn_, [buf](uint32_t i, int8_t sample){
+            buf[i] = (int16_t)(buf[i] + sample);
+        });
+    }
+
     Q88::INTERNAL_STORAGE_TYPE GetRotationState() const
     {
         return rotation_.GetValueState();
@@ -189,6 +241,30 @@ public:
         rotation_.SetValue((Q88)(uint8_t)0);
     }
 
+private:
+
+    // The stepper's state worked on directly, as a plain Q8.8 integer whose
+    // whole part is the brad, and written back once at the end.
+    template <typename FnSource, typename FnOut>
+    inline void Generate(uint32_t count, FnSource fnSource, FnOut fnOut)
+    {
+        Q88::INTERNAL_STORAGE_TYPE rotation = rotation_.GetValueState();
+        Q88::INTERNAL_STORAGE_TYPE stepSize = rotation_.GetStepSizeState();
+
+        uint8_t phaseOffset = (uint8_t)phaseOffset_;
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint8_t brad = (uint8_t)(phaseOffset + (uint8_t)(rotation >> 8));
+
+            fnOut(i, fnSource(brad));
+
+            rotation = (Q88::INTERNAL_STORAGE_TYPE)(rotation + stepSize);
+        }
+
+        rotation_.ReplaceValueState(rotation);
+    }
+
 private:
     double                  stepSizePerHz_;
     Q88                     stepSize_;
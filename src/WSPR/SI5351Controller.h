@@ -42,6 +42,82 @@ public:
         radio_.set_freq(freq_ * SI5351_FREQ_MULT, SI5351_CLK0);
     }
 
+    // Precomputes the registers for count tones, spacingHundredthsHz apart
+    // from the current frequency up, for SetTone() to switch between with
+    // a single burst write each.  Redo after changing frequency.
+    static bool PrepareTones(uint8_t count, uint32_t spacingHundredthsHz)
+    {
+        bool retVal = true;
+
+        toneBlockList_.resize(count);
+
+        for (uint8_t i = 0; i < count; ++i)
+        {
+            uint64_t freq = ((uint64_t)freq_ * SI5351_FREQ_MULT) + ((uint64_t)i * spacingHundredthsHz);
+
+            if (radio_.prepare_freq(freq, SI5351_CLK0, &toneBlockList_[i]) != 0)
+            {
+                retVal = false;
+            }
+        }
+
+        return retVal;
+    }
+
+    static bool SetTone(uint8_t idx)
+    {
+        bool retVal = false;
+
+        if (idx < toneBlockList_.size())
+        {
+            retVal = radio_.set_freq_prepared(SI5351_CLK0, toneBlockList_[idx]) == 0;
+        }
+
+        return retVal;
+    }
+
+    // times switching between the 4 WSPR tones by set_freq() against
+    // precomputed registers
+    static void ToneSwitchBench(uint32_t switchCount)
+    {
+        switchCount = max(switchCount, (uint32_t)1);
+
+        static const uint8_t  TONE_COUNT              = 4;
+        static const uint32_t TONE_SPACING_HUNDREDTHS = 146;
+
+        On();
+        PrepareTones(TONE_COUNT, TONE_SPACING_HUNDREDTHS);
+
+        auto fnBench = [&](const char *title, function<void(uint8_t tone)> fnSwitch){
+            uint64_t durationUsMax   = 0;
+            uint64_t durationUsTotal = 0;
+
+            for (uint32_t i = 0; i < switchCount; ++i)
+            {
+                uint8_t tone = (uint8_t)(i % TONE_COUNT);
+
+                uint64_t timeStartUs = PAL.Micros();
+                fnSwitch(tone);
+                uint64_t durationUs = PAL.Micros() - timeStartUs;
+
+                durationUsMax    = max(durationUsMax, durationUs);
+                durationUsTotal += durationUs;
+            }
+
+            Log(title, ": avg ", durationUsTotal / switchCount, " us, max ", durationUsMax, " us");
+        };
+
+        Log("Tone switching, ", Commas(switchCount), " switches");
+        fnBench("set_freq         ", [](uint8_t tone){
+            radio_.set_freq(((uint64_t)freq_ * SI5351_FREQ_MULT) + (tone * TONE_SPACING_HUNDREDTHS), SI5351_CLK0);
+        });
+        fnBench("set_freq_prepared", [](uint8_t tone){
+            SetTone(tone);
+        });
+
+        Off();
+    }
+
     static void Sweep()
     {
         On();
@@ -95,6 +171,23 @@ public:
             SetFrequency(freq);
         }, { .argCount = 1, .help = "si5351 set freq <MHz_float>"});
 
+        Shell::AddCommand(prefix + ".tones", [](vector<string> argList){
+            uint8_t  count   = (uint8_t)atoi(argList[0].c_str());
+            uint32_t spacing = (uint32_t)atoi(argList[1].c_str());
+
+            Log("Preparing ", count, " tones, ", spacing, " hundredths Hz apart: ", PrepareTones(count, spacing) ? "ok" : "err");
+        }, { .argCount = 2, .help = "si5351 prepare <count> tones <spacing> hundredths Hz apart"});
+
+        Shell::AddCommand(prefix + ".tone", [](vector<string> argList){
+            uint8_t idx = (uint8_t)atoi(argList[0].c_str());
+
+            Log("Setting tone ", idx, ": ", SetTone(idx) ? "ok" : "err");
+        }, { .argCount = 1, .help = "si5351 set prepared tone <idx>"});
+
+        Shell::AddCommand(prefix + ".tone.bench", [](vector<string> argList){
+            ToneSwitchBench(argList.size() ? (uint32_t)atoi(argList[0].c_str()) : 100);
+        }, { .argCount = -1, .help = "si5351 time tone switching [switchCount=100]"});
+
         Shell::AddCommand(prefix + ".corr", [](vector<string> argList){
             int32_t corr = atoi(argList[0].c_str());
 
@@ -108,5 +201,7 @@ private:
     inline static Si5351 radio_;
     inline static int32_t corr_ = DEFAULT_CORRECTION;
     inline static uint32_t freq_ = DEFAULT_FREQUENCY_HZ;
+
+    inline static vector<Si5351MsRegBlock> toneBlockList_;
 };
 
@@ -13,8 +13,9 @@
 #include <ctype.h>
 #include <string.h>
 
+#include <array>
+
 #include "PAL.h"
-#include "BitField.h"
 #include "nhash.h"
 
 
@@ -23,12 +24,26 @@
  * memory elimination techniques, as well as applying a generation approach to
  * the distribution from JTEncode.
  *
+ * The interleave (bit-reversal) order and the sync vector are tables built
+ * at compile time, so encoding is a single pass of the convolutional encoder
+ * writing each tone straight to its final position.
+ *
  */
 
 class WSPREncoder
 {
     static const uint8_t CALLSIGN_LEN = 6;
     static const uint8_t GRID_LEN     = 4;
+
+public:
+
+    static const uint8_t SYMBOL_COUNT = 162;
+
+private:
+
+    // convolutional encoder, rate 1/2, constraint length 32
+    static const uint32_t POLY_0 = 0xf2d05351;
+    static const uint32_t POLY_1 = 0xe4613c47;
     
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -40,8 +55,8 @@ class WSPREncoder
 public:
 
 static void
-EncodeType1(const string  callsignInput,
-            const string  gridInput,
+EncodeType1(const string &callsignInput,
+            const string &gridInput,
             uint8_t       powerDbmInput)
 {
     genmsg_type1(callsignInput.c_str(), gridInput.c_str(), powerDbmInput);
@@ -50,23 +65,14 @@ EncodeType1(const string  callsignInput,
 static void
 genmsg_type1(const char *call, const char *grid, const int power)
 {
-    uint32_t c = encodecallsign(call) ; // 28 bits
-    uint32_t g = encodegrid(grid) ;     // 15 bits
-    uint32_t p = encodepower(power) ;   //  7 bits
-    
-    // Convert the useful bits above into a bitfield for further processing
-    BitFieldOwned<50> bf;
-    uint8_t idx = 0;
-    
-    bf.SetBitRangeAt(idx, c, 28);
-    idx += 28;
+    uint64_t c = encodecallsign(call)         & 0xFFFFFFF; // 28 bits
+    uint64_t g = (uint64_t)encodegrid(grid)   & 0x7FFF;    // 15 bits
+    uint64_t p = (uint64_t)encodepower(power) & 0x7F;      //  7 bits
     
-    bf.SetBitRangeAt(idx, g, 15);
-    idx += 15;
+    // pack the useful bits above, first to be sent in the high bit
+    uint64_t bitList = (c << 22) | (g << 7) | p;
     
-    bf.SetBitRangeAt(idx, p, 7);
-    
-    EncodeTones(bf);
+    EncodeTones(bitList);
 }
 
 private:
@@ -99,28 +105,35 @@ static uint32_t
 encodecallsign(const char *callsign)
 {
     /* find the first digit... */
-    uint32_t i, rc ;
-    char call[6] ;
+    uint32_t i, rc, len, offset ;
+    char call[CALLSIGN_LEN] ;
+
+    for (i=0; i<CALLSIGN_LEN; i++) call[i] = ' ' ;
 
-    for (i=0; i<6; i++) call[i] = ' ' ;
+    len = (uint32_t)strnlen(callsign, CALLSIGN_LEN) ;
+    if (len < 3)
+    {
+        return 0 ;
+    }
 
     if (isdigit(callsign[1]) && !isdigit(callsign[2]))
     {
         /* 1x callsigns... */
-        for (i=0; i<strlen(callsign); i++)
-           call[1+i] = callsign[i] ;
+        offset = 1 ;
     }
     else if (isdigit(callsign[2]))
     {
         /* 2x callsigns... */
-        for (i=0; i<strlen(callsign); i++)
-           call[i] = callsign[i] ;
+        offset = 0 ;
     }
     else
     {
         return 0 ;
     }
 
+    for (i=0; i<len && offset+i<CALLSIGN_LEN; i++)
+       call[offset+i] = callsign[i] ;
+
     rc  = chval1(call[0]) ; rc *= 36 ; 
     rc += chval1(call[1]) ; rc *= 10 ;
     rc += chval1(call[2]) ; rc *= 27 ;
@@ -159,12 +172,7 @@ public:
 
 static uint8_t GetToneValForSymbol(uint8_t idx)
 {
-    uint16_t bitIdx = idx * 2;
-    
-    uint8_t val;
-    bfToneNumList_.GetBitRangeAt(bitIdx, val, 2);
-    
-    return val;
+    return idx < SYMBOL_COUNT ? toneNumList_[idx] : 0;
 }
 
 private:
@@ -176,7 +184,7 @@ private:
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-// Should have 50 bits of data in the buffer.
+// Should have 50 bits of data in bitList, first to send in bit 49.
 // This function will encode them into the final transmittable tone value form.
 //
 // We are replicating the encoding scheme seen in the genmsg function originally.
@@ -201,136 +209,112 @@ private:
 // So basically the bits in the accumulator are a mirror-image of the incoming
 // bit-stream within a rolling 32-bit window.
 //
+// The 50 bits are followed by 31 zeroes to flush the encoder, giving 162
+// symbols.  Each lands at its interleaved position as the upper bit of the
+// tone, the sync vector being the lower bit.
+//
 static void
-EncodeTones(BitField &bitFieldOf50Bits)
+EncodeTones(uint64_t bitList)
 {
-    uint32_t acc     = 0;
-    uint8_t  idxTone = 0;
-    
-    // Lay down the initial tone values from synchronization bits
-    for (uint8_t i = 0; i < 162; ++i)
-    {
-        uint8_t val;
-        bfSync_.GetBitAt(i, val);
-        
-        SetToneVal(i, val);
-    }
-    
+    static const uint8_t DATA_BIT_COUNT  = 50;
+    static const uint8_t FLUSH_BIT_COUNT = 31;
+
+    uint32_t acc       = 0;
+    uint8_t  symbolIdx = 0;
+
     // Generate the first 100 tone values from the input 50 bits
-    for (uint8_t i = 0; i < 50; ++i)
+    for (int8_t i = DATA_BIT_COUNT - 1; i >= 0; --i)
     {
-        acc <<= 1;
-        
-        uint8_t bitVal;
-        bitFieldOf50Bits.GetBitAt(i, bitVal);
-        
-        if (bitVal)
-        {
-            acc |= 1;
-        }
-        
-        IncrToneVal(GetRdx(idxTone++), 2 * parity(acc & 0xf2d05351L));
-        IncrToneVal(GetRdx(idxTone++), 2 * parity(acc & 0xe4613c47L));
+        acc = (acc << 1) | (uint32_t)((bitList >> i) & 1);
+
+        SetToneVal(symbolIdx++, Parity(acc & POLY_0));
+        SetToneVal(symbolIdx++, Parity(acc & POLY_1));
     }
     
     // Generate the remaining 62 tone values from zeroes
-    for (uint8_t i = 0; i < 31; ++i)
+    for (uint8_t i = 0; i < FLUSH_BIT_COUNT; ++i)
     {
         acc <<= 1;
         
-        IncrToneVal(GetRdx(idxTone++), 2 * parity(acc & 0xf2d05351L));
-        IncrToneVal(GetRdx(idxTone++), 2 * parity(acc & 0xe4613c47L));
+        SetToneVal(symbolIdx++, Parity(acc & POLY_0));
+        SetToneVal(symbolIdx++, Parity(acc & POLY_1));
     }
 }
 
-static void SetToneVal(uint8_t idx, uint8_t val)
+// every tone is written exactly once, its sync bit plus the data bit
+static void SetToneVal(uint8_t symbolIdx, uint8_t bitVal)
 {
-    uint16_t bitIdx = idx * 2;
-    
-    bfToneNumList_.SetBitRangeAt(bitIdx, val, 2);
-}
+    uint8_t toneIdx = interleaveList_[symbolIdx];
 
-static void IncrToneVal(uint8_t idx, uint8_t val)
-{
-    uint16_t bitIdx = idx * 2;
-    
-    uint8_t valCurr;
-    bfToneNumList_.GetBitRangeAt(bitIdx, valCurr, 2);
-    
-    valCurr += val;
-    
-    bfToneNumList_.SetBitRangeAt(bitIdx, valCurr, 2);
+    toneNumList_[toneIdx] = (uint8_t)(syncToneList_[toneIdx] | (bitVal << 1));
 }
 
-static int32_t
-parity(uint32_t x)
+// the Cortex-M0+ has no popcount instruction, and the libgcc one is a call
+// per symbol, so fold the word down to a nibble and look its parity up in
+// a 16-bit constant
+static uint8_t Parity(uint32_t x)
 {
-    int32_t even = 0 ;
-    while (x) {
-	even = 1-even ;
-	x = x & (x - 1) ;
-    }
-    return even ;
+    x ^= x >> 16;
+    x ^= x >> 8;
+    x ^= x >> 4;
+
+    return (uint8_t)((0x6996 >> (x & 0xF)) & 1);
 }
 
-// this (modified) function taken from JTEncode
-static uint8_t GetRdx(uint8_t idx)
+// The nth symbol goes to the nth of the 8-bit bit-reversed values which
+// are in range (JTEncode scans for these per symbol).
+static constexpr array<uint8_t, SYMBOL_COUNT> MakeInterleaveList()
 {
-    static const uint8_t WSPR_BIT_COUNT = 162;
-    
-	uint8_t rev, index_temp, i, j, k;
-
-	i = 0;
-
-	for(j = 0; j < 255; j++)
-	{
-		// Bit reverse the index
-		index_temp = j;
-		rev = 0;
-
-		for(k = 0; k < 8; k++)
-		{
-			if(index_temp & 0x01)
-			{
-				rev = rev | (1 << (7 - k));
-			}
-			index_temp = index_temp >> 1;
-		}
-
-		if(rev < WSPR_BIT_COUNT)
-		{
-            if (i == idx)
-            {
-                return rev;
-            }
-            else
+    array<uint8_t, SYMBOL_COUNT> retVal{};
+
+    uint8_t idx = 0;
+    for (uint16_t j = 0; j < 256 && idx < SYMBOL_COUNT; ++j)
+    {
+        uint8_t rev = 0;
+        for (uint8_t k = 0; k < 8; ++k)
+        {
+            if (j & (1 << k))
             {
-                i++;
+                rev = (uint8_t)(rev | (1 << (7 - k)));
             }
-		}
-	}
-    
-    return 0;
+        }
+
+        if (rev < SYMBOL_COUNT)
+        {
+            retVal[idx++] = rev;
+        }
+    }
+
+    return retVal;
 }
 
+static constexpr array<uint8_t, SYMBOL_COUNT> MakeSyncToneList()
+{
+    array<uint8_t, SYMBOL_COUNT> retVal{};
 
+    for (uint8_t i = 0; i < SYMBOL_COUNT; ++i)
+    {
+        retVal[i] = (uint8_t)((syncBitList_[i / 8] >> (7 - (i % 8))) & 1);
+    }
 
+    return retVal;
+}
 
 
 private:
 
 static const uint8_t syncBitList_[21];
-static const BitField bfSync_;
+static const array<uint8_t, SYMBOL_COUNT> syncToneList_;
+static const array<uint8_t, SYMBOL_COUNT> interleaveList_;
 
-static uint8_t toneNumListBuf_[41];
-static BitField bfToneNumList_;
+inline static uint8_t toneNumList_[SYMBOL_COUNT];
 };
 
 // need 162 bits, so pack into bytes
 //
 // 21 bytes * 8 bits = 168 (6 too many)
 // so just add 6 bits of zero at the end
-const uint8_t WSPREncoder::syncBitList_[21] = {
+inline constexpr uint8_t WSPREncoder::syncBitList_[21] = {
     0b11000000,
     0b10001110,
     0b00100101,
@@ -354,34 +338,10 @@ const uint8_t WSPREncoder::syncBitList_[21] = {
     0b00000000,
 };
 
-const BitField WSPREncoder::bfSync_((uint8_t *)WSPREncoder::syncBitList_, 21);
-
-
 // each of the 162 data bits is represented in 4FSK
-// meaning 4 possible values, so 2 bits to store the result.
-//
-// so need to store 162 * 2 = 324 bits
-// 324 bits / 8 bits-per-byte = 40.5 bytes, so call it 41 bytes
-uint8_t WSPREncoder::toneNumListBuf_[41];
-BitField WSPREncoder::bfToneNumList_(WSPREncoder::toneNumListBuf_, 41);
+// meaning 4 possible values, one byte each for direct access
+inline constexpr array<uint8_t, WSPREncoder::SYMBOL_COUNT> WSPREncoder::syncToneList_   = WSPREncoder::MakeSyncToneList();
+inline constexpr array<uint8_t, WSPREncoder::SYMBOL_COUNT> WSPREncoder::interleaveList_ = WSPREncoder::MakeInterleaveList();
 
 
 #endif  // __WSPR_ENCODER_H__
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
@@ -5,6 +5,7 @@
 #include "PAL.h"
 #include "si5351.h"
 #include "Timeline.h"
+#include "Timer.h"
 #include "WSPREncoder.h"
 
 class WSPRMessageTransmitter
@@ -14,8 +15,31 @@ public:
     static const uint32_t WSPR_DEFAULT_FREQ = 14'097'060ULL;  // 20 meter band, lane 2
     
     static const uint8_t  WSPR_SYMBOL_COUNT               = 162;
+    static const uint8_t  WSPR_TONE_COUNT                 = 4;
     static const uint16_t WSPR_TONE_SPACING_HUNDREDTHS_HZ = 146;  // 1.4648 Hz
     static const uint32_t WSPR_DELAY_US                   = 682'687;
+
+    // async symbols are timed by an Evm timer set this far ahead of when
+    // the symbol is due, the rest being waited out busy, so Evm wakeup
+    // latency doesn't show up as symbol jitter
+    static const uint32_t WSPR_ASYNC_LEAD_US = 2'000;
+
+    struct AsyncStats
+    {
+        uint16_t symbolsSent = 0;
+
+        // how far after its due time each symbol's frequency was set
+        uint32_t lateUsMin   = 0;
+        uint32_t lateUsMax   = 0;
+        uint64_t lateUsTotal = 0;
+
+        // symbols whose timer fired after they were already due
+        uint16_t symbolsTimerLate = 0;
+
+        // how long each tone switch (the Si5351 write) took
+        uint32_t switchUsMax   = 0;
+        uint64_t switchUsTotal = 0;
+    };
     
 public:
 
@@ -26,6 +50,8 @@ public:
         if (on_)
         {
             radio_.set_freq(frequency_ * 100, SI5351_CLK0);
+
+            PrepareTones();
         }
     }
     
@@ -93,19 +119,14 @@ public:
         radio_.set_clock_pwr(SI5351_CLK1, 1);
         radio_.output_enable(SI5351_CLK1, 1);
 
+        PrepareTones();
+
         on_ = true;
     }
 
     void Send(const string &callsign, const string &grid4, uint8_t powerDbm)
     {
-        Timeline::Global().Event("send start");
-
-        fnOnTxStart_();
-
-        // wow this is 34ms
-        wsprEncoder_.EncodeType1(callsign, grid4, powerDbm);
-
-        Timeline::Global().Event("msg encoded");
+        StartTx(callsign, grid4, powerDbm);
 
         uint64_t timeStartSendMs = PAL.Millis();
 
@@ -123,14 +144,8 @@ public:
             // Allow calling code to do something here
             fnOnBitChange_();
 
-            // Determine which bit to send next
-            uint32_t freqInHundrethds = 
-                (frequency_ * 100) + 
-                (wsprEncoder_.GetToneValForSymbol(i) * WSPR_TONE_SPACING_HUNDREDTHS_HZ) - 
-                (2 * WSPR_TONE_SPACING_HUNDREDTHS_HZ);
-
             // Actually change the frequency to indicate the bit value
-            radio_.set_freq(freqInHundrethds, SI5351_CLK0);
+            SetSymbolTone(i);
 
             // this moment is notionally when the bit starts
             timeNow = PAL.Micros();
@@ -153,6 +168,69 @@ public:
         // Allow calling code to do something here
         fnOnTxEnd_();
     }
+
+    // Transmits without blocking, the symbols clocked out from Evm timers
+    // while the rest of the system keeps running.
+    //
+    // Each symbol is scheduled at its absolute time from the start (WSPR
+    // symbols are 8192/12000 s), so lateness of one never pushes the rest
+    // out, and the message takes the same time however busy Evm is.
+    //
+    // timeStartUs is when the first symbol goes out, eg 1 second past an
+    // even minute, or 0 for now.  The callbacks are the same as Send(),
+    // with fnOnDone called after OnTxEnd, told whether every symbol was
+    // sent.
+    //
+    // Returns false, doing nothing, if already sending.
+    bool SendAsync(const string &callsign,
+                   const string &grid4,
+                   uint8_t       powerDbm,
+                   uint64_t      timeStartUs = 0,
+                   function<void(bool sentAll)> fnOnDone = [](bool){})
+    {
+        bool retVal = false;
+
+        if (sending_ == false)
+        {
+            retVal = true;
+
+            sending_ = true;
+
+            StartTx(callsign, grid4, powerDbm);
+
+            fnOnDone_ = fnOnDone;
+
+            asyncStats_  = AsyncStats{};
+            symbolIdx_   = 0;
+            timeStartUs_ = timeStartUs ? timeStartUs : PAL.Micros();
+
+            timerSymbol_.SetCallback([this]{ OnSymbolTimeout(); });
+            ScheduleSymbol();
+        }
+
+        return retVal;
+    }
+
+    // stops an async transmission before the next symbol, the done
+    // callback being told not all were sent
+    void SendAsyncCancel()
+    {
+        if (sending_)
+        {
+            EndTx(false);
+        }
+    }
+
+    bool IsSending() const
+    {
+        return sending_;
+    }
+
+    // of the current or last async transmission
+    const AsyncStats &GetAsyncStats() const
+    {
+        return asyncStats_;
+    }
     
     void RadioOff()
     {
@@ -167,7 +245,8 @@ public:
         radio_.output_enable(SI5351_CLK2, 0);
         radio_.set_clock_pwr(SI5351_CLK2, 0);
 
-        on_ = false;
+        on_            = false;
+        tonesPrepared_ = false;
     }
 
     void SetDrive(si5351_drive pwr)
@@ -181,11 +260,165 @@ public:
     void SetDrive8() { SetDrive(SI5351_DRIVE_8MA); }
     
     
+private:
+
+    void StartTx(const string &callsign, const string &grid4, uint8_t powerDbm)
+    {
+        Timeline::Global().Event("send start");
+
+        fnOnTxStart_();
+
+        wsprEncoder_.EncodeType1(callsign, grid4, powerDbm);
+
+        Timeline::Global().Event("msg encoded");
+    }
+
+    uint32_t GetFreqHundredthsForTone(uint8_t tone) const
+    {
+        return (frequency_ * 100) +
+               (tone * WSPR_TONE_SPACING_HUNDREDTHS_HZ) -
+               (2 * WSPR_TONE_SPACING_HUNDREDTHS_HZ);
+    }
+
+    // the Si5351 registers for each of the 4 tones are worked out once
+    // the radio is on, so each symbol is one burst write rather than a
+    // full set_freq
+    void PrepareTones()
+    {
+        tonesPrepared_ = true;
+
+        for (uint8_t tone = 0; tone < WSPR_TONE_COUNT; ++tone)
+        {
+            if (radio_.prepare_freq(GetFreqHundredthsForTone(tone), SI5351_CLK0, &toneBlockList_[tone]) != 0)
+            {
+                tonesPrepared_ = false;
+            }
+        }
+    }
+
+    // returns how long the switch took
+    uint32_t SetSymbolTone(uint8_t symbolIdx)
+    {
+        uint64_t timeStartUs = PAL.Micros();
+
+        uint8_t tone = wsprEncoder_.GetToneValForSymbol(symbolIdx);
+
+        if (tonesPrepared_)
+        {
+            radio_.set_freq_prepared(SI5351_CLK0, toneBlockList_[tone]);
+        }
+        else
+        {
+            radio_.set_freq(GetFreqHundredthsForTone(tone), SI5351_CLK0);
+        }
+
+        return (uint32_t)(PAL.Micros() - timeStartUs);
+    }
+
+    // from the first symbol, exact rather than stepped, so rounding
+    // never accumulates
+    uint64_t GetSymbolDueUs(uint16_t symbolIdx) const
+    {
+        return timeStartUs_ + (uint64_t)symbolIdx * 8'192'000'000ULL / 12'000;
+    }
+
+    // symbolIdx_ of WSPR_SYMBOL_COUNT is the end of the last symbol
+    void ScheduleSymbol()
+    {
+        uint64_t timeDueUs = GetSymbolDueUs(symbolIdx_);
+
+        timerSymbol_.TimeoutAtUs(timeDueUs > WSPR_ASYNC_LEAD_US ? timeDueUs - WSPR_ASYNC_LEAD_US : 0);
+    }
+
+    void OnSymbolTimeout()
+    {
+        uint64_t timeDueUs = GetSymbolDueUs(symbolIdx_);
+        uint64_t timeNowUs = PAL.Micros();
+
+        if (timeNowUs > timeDueUs)
+        {
+            Timeline::Global().Event("bit timer late");
+
+            ++asyncStats_.symbolsTimerLate;
+        }
+
+        if (symbolIdx_ == WSPR_SYMBOL_COUNT)
+        {
+            // the last symbol runs its full length
+            WaitUntilUs(timeDueUs);
+
+            EndTx(true);
+        }
+        else if (fnQuitEarly_((timeNowUs - timeStartUs_) / 1'000))
+        {
+            EndTx(false);
+        }
+        else
+        {
+            // Allow calling code to do something here
+            fnOnBitChange_();
+
+            WaitUntilUs(timeDueUs);
+
+            uint32_t switchUs = SetSymbolTone((uint8_t)symbolIdx_);
+
+            // this moment is notionally when the bit starts
+            timeNowUs = Timeline::Global().Event(symbolIdx_ == 0 ? "bit first" : "bit marker");
+
+            uint32_t lateUs = (uint32_t)(timeNowUs - timeDueUs);
+            if (asyncStats_.symbolsSent == 0 || lateUs < asyncStats_.lateUsMin)
+            {
+                asyncStats_.lateUsMin = lateUs;
+            }
+            if (lateUs > asyncStats_.lateUsMax)
+            {
+                asyncStats_.lateUsMax = lateUs;
+            }
+            asyncStats_.lateUsTotal += lateUs;
+            if (switchUs > asyncStats_.switchUsMax)
+            {
+                asyncStats_.switchUsMax = switchUs;
+            }
+            asyncStats_.switchUsTotal += switchUs;
+            ++asyncStats_.symbolsSent;
+
+            ++symbolIdx_;
+            ScheduleSymbol();
+        }
+    }
+
+    void WaitUntilUs(uint64_t timeAtUs)
+    {
+        uint64_t timeNowUs = PAL.Micros();
+
+        if (timeNowUs < timeAtUs)
+        {
+            PAL.DelayBusyUs(timeAtUs - timeNowUs);
+        }
+    }
+
+    void EndTx(bool sentAll)
+    {
+        timerSymbol_.Cancel();
+
+        sending_ = false;
+
+        Timeline::Global().Event("bit last");
+
+        // Allow calling code to do something here
+        fnOnTxEnd_();
+        fnOnDone_(sentAll);
+    }
+
+
 private:
 
     Si5351 radio_;
 
     bool on_ = false;
+
+    Si5351MsRegBlock toneBlockList_[WSPR_TONE_COUNT];
+    bool             tonesPrepared_ = false;
     
     WSPREncoder wsprEncoder_;
     
@@ -197,6 +430,15 @@ private:
     function<void()> fnOnTxEnd_     = []{};
 
     function<bool(uint64_t msSinceStart)> fnQuitEarly_ = [](uint64_t){ return false; };
+
+    // async sending
+    Timer      timerSymbol_{"TIMER_WSPR_SYMBOL"};
+    bool       sending_     = false;
+    uint16_t   symbolIdx_   = 0;
+    uint64_t   timeStartUs_ = 0;
+    AsyncStats asyncStats_;
+
+    function<void(bool sentAll)> fnOnDone_ = [](bool){};
 };
 
 
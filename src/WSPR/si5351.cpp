@@ -495,6 +495,101 @@ uint8_t Si5351::set_freq_manual(uint64_t freq, uint64_t pll_freq, enum si5351_cl
     return 0;
 }
 
+/*
+ * prepare_freq(uint64_t freq, enum si5351_clock clk, struct Si5351MsRegBlock *block)
+ *
+ * Calculates the multisynth registers for the clock frequency of the
+ * specified CLK output, without writing them, for set_freq_prepared() to
+ * switch to later.  Useful for FSK, where the same few tones are switched
+ * between many times, and the calculation and register reads of
+ * set_freq() would otherwise be done each time.
+ *
+ * Only for CLK0 through CLK5 at frequencies which don't need the PLL to be
+ * changed (up to 100 MHz).  The block stays good as long as the PLL
+ * driving the clock isn't changed.
+ *
+ * freq - Output frequency in Hz * 100
+ * clk - Clock output
+ *   (use the si5351_clock enum)
+ * block - Filled in with the register values
+ */
+uint8_t Si5351::prepare_freq(uint64_t freq, enum si5351_clock clk, struct Si5351MsRegBlock *block)
+{
+	struct Si5351RegSet ms_reg;
+	uint8_t r_div;
+
+	if((uint8_t)clk > (uint8_t)SI5351_CLK5 ||
+	   freq > (SI5351_MULTISYNTH_SHARE_MAX * SI5351_FREQ_MULT))
+	{
+		return 1;
+	}
+
+	// Lower bounds check
+	if(freq > 0 && freq < SI5351_CLKOUT_MIN_FREQ * SI5351_FREQ_MULT)
+	{
+		freq = SI5351_CLKOUT_MIN_FREQ * SI5351_FREQ_MULT;
+	}
+
+	block->freq = freq;
+
+	// Select the proper R div value
+	r_div = select_r_div(&freq);
+
+	// Calculate the synth parameters, as set_freq() does
+	if(pll_assignment[clk] == SI5351_PLLA)
+	{
+		multisynth_calc(freq, plla_freq, &ms_reg);
+	}
+	else
+	{
+		multisynth_calc(freq, pllb_freq, &ms_reg);
+	}
+
+	// Laid out as set_ms() does, with the R div (and no DIVBY4) in
+	// register 44, which ms_div() would otherwise write separately
+	block->reg[0] = (uint8_t)((ms_reg.p3 >> 8) & 0xFF);
+	block->reg[1] = (uint8_t)(ms_reg.p3  & 0xFF);
+	block->reg[2] = (uint8_t)((r_div << SI5351_OUTPUT_CLK_DIV_SHIFT) & SI5351_OUTPUT_CLK_DIV_MASK);
+	block->reg[2] |= (uint8_t)((ms_reg.p1 >> 16) & 0x03);
+	block->reg[3] = (uint8_t)((ms_reg.p1 >> 8) & 0xFF);
+	block->reg[4] = (uint8_t)(ms_reg.p1  & 0xFF);
+	block->reg[5] = (uint8_t)((ms_reg.p3 >> 12) & 0xF0);
+	block->reg[5] += (uint8_t)((ms_reg.p2 >> 16) & 0x0F);
+	block->reg[6] = (uint8_t)((ms_reg.p2 >> 8) & 0xFF);
+	block->reg[7] = (uint8_t)(ms_reg.p2  & 0xFF);
+
+	return 0;
+}
+
+/*
+ * set_freq_prepared(enum si5351_clock clk, const struct Si5351MsRegBlock &block)
+ *
+ * Switches the specified CLK output to a frequency calculated earlier by
+ * prepare_freq(), in one burst write of its multisynth registers, with no
+ * register reads.
+ *
+ * The clock must already be running from set_freq() at a frequency of the
+ * same range (not above 100 MHz), which leaves integer mode off and the
+ * output enabled.
+ *
+ * clk - Clock output
+ *   (use the si5351_clock enum)
+ * block - As filled in by prepare_freq() for the same clock
+ */
+uint8_t Si5351::set_freq_prepared(enum si5351_clock clk, const struct Si5351MsRegBlock &block)
+{
+	if((uint8_t)clk > (uint8_t)SI5351_CLK5)
+	{
+		return 1;
+	}
+
+	clk_freq[(uint8_t)clk] = block.freq;
+
+	si5351_write_bulk(SI5351_CLK0_PARAMETERS + ((uint8_t)clk * 8), sizeof(block.reg), (uint8_t *)block.reg);
+
+	return 0;
+}
+
 /*
  * set_pll(uint64_t pll_freq, enum si5351_pll target_pll)
  *
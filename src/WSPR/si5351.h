@@ -260,6 +260,14 @@ struct Si5351RegSet
 	uint32_t p3;
 };
 
+// Multisynth parameter registers (42-49 for CLK0) for one output
+// frequency, precomputed so switching to it is a single burst write
+struct Si5351MsRegBlock
+{
+	uint64_t freq;
+	uint8_t reg[8];
+};
+
 struct Si5351Status
 {
 	uint8_t SYS_INIT;
@@ -285,6 +293,8 @@ public:
 	void reset(void);
 	uint8_t set_freq(uint64_t, enum si5351_clock);
 	uint8_t set_freq_manual(uint64_t, uint64_t, enum si5351_clock);
+	uint8_t prepare_freq(uint64_t, enum si5351_clock, struct Si5351MsRegBlock *);
+	uint8_t set_freq_prepared(enum si5351_clock, const struct Si5351MsRegBlock &);
 	void set_pll(uint64_t, enum si5351_pll);
 	void set_ms(enum si5351_clock, struct Si5351RegSet, uint8_t, uint8_t, uint8_t);
 	void output_enable(enum si5351_clock, uint8_t);
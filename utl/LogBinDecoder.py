@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+
+import os
+import re
+import struct
+import sys
+
+
+# Decoder for the deferred-format binary log (src/App/Log/LogBin.h).
+#
+# The target records the address of each format string, a timestamp, and
+# the raw argument bytes.  Here the format strings (and any %s arguments)
+# are read back out of the ELF of the same build, and printf-formatted.
+#
+# Input is a console capture containing the "LOGBIN:<hex>" lines printed by
+# the log.bin.dump shell command (anything else in the capture is ignored),
+# or with --bin, the raw record bytes.
+#
+# Each dump starts with a sync record, whose format string is found in the
+# ELF by content.  The difference between where it was recorded and where
+# it is in the ELF is applied to every address, which is zero on target
+# but not for position-independent host builds.
+#
+# No dependencies beyond the standard library.
+
+
+SYNC_FMT   = b"LogBin sync, %u dropped, %u bytes\0"
+HEADER_LEN = 9
+
+# %[flags][width][.precision][length]conversion
+RE_SPEC = re.compile(r"%([-+ #0]*)(\d*)(\.\d+)?(hh|h|ll|l|j|z|t|L)?([diouxXcsfFeEgGaAp%])")
+
+
+def Commas(val):
+    return "{:,}".format(val)
+
+
+class Elf:
+    def __init__(self, file):
+        with open(file, "rb") as f:
+            self.data = f.read()
+
+        if self.data[0:4] != b"\x7fELF":
+            raise Exception(f"{file} is not an ELF file")
+
+        self.is64   = self.data[4] == 2
+        self.endian = "<" if self.data[5] == 1 else ">"
+        self.ptrSize = 8 if self.is64 else 4
+
+        if self.is64:
+            shoff,              = struct.unpack_from(self.endian + "Q", self.data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from(self.endian + "HHH", self.data, 0x3A)
+        else:
+            shoff,              = struct.unpack_from(self.endian + "I", self.data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from(self.endian + "HHH", self.data, 0x2E)
+
+        sectionList = []
+        for i in range(shnum):
+            off = shoff + i * shentsize
+
+            if self.is64:
+                name, type, flags, addr, offset, size = struct.unpack_from(self.endian + "IIQQQQ", self.data, off)
+            else:
+                name, type, flags, addr, offset, size = struct.unpack_from(self.endian + "IIIIII", self.data, off)
+
+            sectionList.append({
+                "nameIdx": name,
+                "type":    type,
+                "flags":   flags,
+                "addr":    addr,
+                "offset":  offset,
+                "size":    size,
+            })
+
+        SHT_PROGBITS = 1
+        SHF_ALLOC    = 2
+
+        # only sections with contents which are loaded into the image
+        # (flash or initialized RAM) can hold format strings
+        self.sectionList = [s for s in sectionList
+                            if s["type"] == SHT_PROGBITS and (s["flags"] & SHF_ALLOC) and s["size"]]
+
+        strtab = sectionList[shstrndx]
+        for s in self.sectionList:
+            start = strtab["offset"] + s["nameIdx"]
+            s["name"] = self.data[start:self.data.index(b"\0", start)].decode()
+
+    def FindString(self, content):
+        for s in self.sectionList:
+            sectionData = self.data[s["offset"]:s["offset"] + s["size"]]
+            idx = sectionData.find(content)
+            if idx != -1:
+                return s["addr"] + idx
+
+        return None
+
+    def ReadString(self, addr):
+        for s in self.sectionList:
+            if s["addr"] <= addr < s["addr"] + s["size"]:
+                start = s["offset"] + (addr - s["addr"])
+                end   = self.data.index(b"\0", start)
+                return self.data[start:end].decode(errors="replace")
+
+        return None
+
+
+class Decoder:
+    def __init__(self, elf):
+        self.elf  = elf
+        self.bias = None
+
+    def ArgSize(self, length, conv):
+        if conv in "fFeEgGaA":
+            return 8
+        elif conv in "sp":
+            return self.elf.ptrSize
+        elif length == "ll":
+            return 8
+        elif length in ("l", "j", "z", "t"):
+            return 8 if self.elf.is64 else 4
+        else:
+            return 4
+
+    def Format(self, fmt, argBytes):
+        out    = ""
+        idx    = 0
+        argIdx = 0
+
+        for m in RE_SPEC.finditer(fmt):
+            out += fmt[idx:m.start()]
+            idx = m.end()
+
+            flags, width, prec, length, conv = m.groups()
+            prec   = prec or ""
+            length = length or ""
+
+            if conv == "%":
+                out += "%"
+                continue
+
+            size = self.ArgSize(length, conv)
+            raw  = argBytes[argIdx:argIdx + size]
+            argIdx += size
+
+            if len(raw) != size:
+                return None
+
+            if conv in "fFeEgGaA":
+                val, = struct.unpack(self.elf.endian + "d", raw)
+                if conv in "aA":
+                    out += val.hex()
+                else:
+                    out += f"%{flags}{width}{prec}{conv}" % val
+            elif conv == "s":
+                addr = int.from_bytes(raw, "little" if self.elf.endian == "<" else "big")
+                s = self.elf.ReadString((addr - self.bias) & 0xFFFFFFFF)
+                out += f"%{flags}{width}{prec}s" % (s if s is not None else f"<str @0x{addr:X}>")
+            elif conv == "p":
+                addr = int.from_bytes(raw, "little" if self.elf.endian == "<" else "big")
+                out += f"0x{addr:X}"
+            else:
+                signed = conv in "di"
+                val = int.from_bytes(raw, "little" if self.elf.endian == "<" else "big", signed=signed)
+
+                if conv == "c":
+                    out += f"%{flags}{width}c" % chr(val & 0xFF)
+                else:
+                    pyConv = "d" if conv in "diu" else conv
+                    out += f"%{flags}{width}{prec}{pyConv}" % val
+
+        out += fmt[idx:]
+
+        # every argument byte should have been accounted for
+        if argIdx != len(argBytes):
+            return None
+
+        return out
+
+    def Decode(self, byteList):
+        idx = 0
+        while idx + HEADER_LEN <= len(byteList):
+            fmtAddr, timeUs, argLen = struct.unpack_from("<IIB", byteList, idx)
+            argBytes = byteList[idx + HEADER_LEN:idx + HEADER_LEN + argLen]
+            idx += HEADER_LEN + argLen
+
+            if len(argBytes) != argLen:
+                print(f"Truncated record at end of input")
+                break
+
+            if self.bias is None:
+                syncAddr = self.elf.FindString(SYNC_FMT)
+                if syncAddr is None:
+                    print("Sync format not found in ELF, is it the right build?")
+                    sys.exit(-1)
+
+                self.bias = (fmtAddr - syncAddr) & 0xFFFFFFFF
+
+            fmt = self.elf.ReadString((fmtAddr - self.bias) & 0xFFFFFFFF)
+
+            line = None
+            if fmt is not None:
+                line = self.Format(fmt, argBytes)
+
+            if line is None:
+                line = f"<fmt @0x{fmtAddr:08X}> {argBytes.hex()}"
+
+            print(f"{timeUs / 1000:13,.3f} ms  {line}")
+
+
+def ReadCapture(file, isBin):
+    with open(file, "rb") as f:
+        data = f.read()
+
+    if isBin:
+        return data
+
+    byteList = bytearray()
+    for line in data.decode(errors="replace").splitlines():
+        idx = line.find("LOGBIN:")
+        if idx != -1:
+            byteList += bytes.fromhex(line[idx + 7:].strip())
+
+    return bytes(byteList)
+
+
+def Main():
+    argList = [a for a in sys.argv[1:] if a != "--bin"]
+    isBin   = "--bin" in sys.argv[1:]
+
+    if len(argList) < 2:
+        print("Usage: " +
+              os.path.basename(sys.argv[0]) +
+              " [--bin] <elfFile> <captureFile>")
+        sys.exit(-1)
+
+    elf      = Elf(argList[0])
+    byteList = ReadCapture(argList[1], isBin)
+
+    print(f"{Commas(len(byteList))} bytes of binary log")
+
+    Decoder(elf).Decode(byteList)
+
+
+Main()
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+
+import json
+import os
+import struct
+import sys
+
+
+# Converter for the binary Timeline dump (src/App/Utl/Timeline.cpp) to the
+# Chrome trace event format, which chrome://tracing and ui.perfetto.dev open.
+#
+# Input is a console capture containing the "TIMELINE:<hex>" lines printed
+# by the t.dump (global) or evm.t.dump shell commands (anything else in the
+# capture is ignored), or with --bin, the raw dump bytes.
+#
+# Each core, and the ISRs on it, get a track of their own.  Events are
+# instants, except that a pair of names ending in _START and _END on the
+# same track (eg EVM_WORK_START / EVM_WORK_END) becomes a slice.
+#
+# No dependencies beyond the standard library.
+
+
+MAGIC = b"TLN1"
+
+
+def Commas(val):
+    return "{:,}".format(val)
+
+
+def ReadCapture(file, isBin):
+    with open(file, "rb") as f:
+        data = f.read()
+
+    if isBin:
+        return data
+
+    byteList = bytearray()
+    for line in data.decode(errors="replace").splitlines():
+        idx = line.find("TIMELINE:")
+        if idx != -1:
+            byteList += bytes.fromhex(line[idx + 9:].strip())
+
+    return bytes(byteList)
+
+
+def Parse(byteList):
+    if byteList[0:4] != MAGIC:
+        raise Exception("Not a Timeline dump, no TLN1 header found")
+
+    idx = 4
+    baseUs, eventsLost = struct.unpack_from("<QI", byteList, idx)
+    idx += 12
+
+    nameCount, = struct.unpack_from("<H", byteList, idx)
+    idx += 2
+
+    id__name = {}
+    for i in range(nameCount):
+        id, nameLen = struct.unpack_from("<HB", byteList, idx)
+        idx += 3
+        id__name[id] = byteList[idx:idx + nameLen].decode(errors="replace")
+        idx += nameLen
+
+    eventCount, = struct.unpack_from("<I", byteList, idx)
+    idx += 4
+
+    # event times are relative to baseUs, in 32 bits, and in order,
+    # so each step backwards is a wrap
+    eventList  = []
+    wrapUs     = 0
+    timeUsLast = 0
+    for i in range(eventCount):
+        if idx + 8 > len(byteList):
+            print(f"Truncated dump, {Commas(i)} of {Commas(eventCount)} events")
+            break
+
+        timeUs, id, core, isr = struct.unpack_from("<IHBB", byteList, idx)
+        idx += 8
+
+        if timeUs < timeUsLast:
+            wrapUs += 1 << 32
+        timeUsLast = timeUs
+
+        eventList.append({
+            "timeUs": wrapUs + timeUs,
+            "name":   id__name.get(id, f"<id {id}>"),
+            "core":   core,
+            "isr":    isr,
+        })
+
+    return baseUs, eventsLost, eventList
+
+
+def ToTrace(baseUs, eventsLost, eventList):
+    traceEventList = []
+
+    # one track per core, and per core's ISRs
+    def Tid(ev):
+        return ev["core"] * 2 + ev["isr"]
+
+    tidSet = sorted(set((ev["core"], ev["isr"]) for ev in eventList))
+    for core, isr in tidSet:
+        traceEventList.append({
+            "name": "thread_name",
+            "ph":   "M",
+            "pid":  0,
+            "tid":  core * 2 + isr,
+            "args": { "name": f"core{core}" + (" isr" if isr else "") },
+        })
+
+    for ev in eventList:
+        name = ev["name"]
+        rec  = {
+            "pid": 0,
+            "tid": Tid(ev),
+            "ts":  ev["timeUs"],
+        }
+
+        if name.endswith("_START"):
+            rec |= { "name": name[:-len("_START")], "ph": "B" }
+        elif name.endswith("_END"):
+            rec |= { "name": name[:-len("_END")], "ph": "E" }
+        else:
+            rec |= { "name": name, "ph": "i", "s": "t" }
+
+        traceEventList.append(rec)
+
+    return {
+        "traceEvents":     traceEventList,
+        "displayTimeUnit": "ms",
+        "otherData": {
+            "baseUs":     baseUs,
+            "eventsLost": eventsLost,
+        },
+    }
+
+
+def Main():
+    argList = [a for a in sys.argv[1:] if a != "--bin"]
+    isBin   = "--bin" in sys.argv[1:]
+
+    if len(argList) < 2:
+        print("Usage: " +
+              os.path.basename(sys.argv[0]) +
+              " [--bin] <captureFile> <outputJsonFile>")
+        sys.exit(-1)
+
+    byteList = ReadCapture(argList[0], isBin)
+
+    baseUs, eventsLost, eventList = Parse(byteList)
+
+    with open(argList[1], "w") as f:
+        json.dump(ToTrace(baseUs, eventsLost, eventList), f, indent=1)
+
+    print(f"{Commas(len(eventList))} events ({Commas(eventsLost)} lost) written to {argList[1]}")
+
+
+Main()